@@ -23,6 +23,7 @@ THE SOFTWARE.
 #include <math.h>
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 // User should not directly modify these
 Mtx       _GRR_view;  // Should be static as soon as all light functions needing this var will be in this file ;)
@@ -81,14 +82,16 @@ void GRRLIB_3dMode(f32 minDist, f32 maxDist, f32 fov, bool texturemode, bool nor
 
 	GX_SetCullMode(GX_CULL_NONE);
 
-	GX_ClearVtxDesc();
-	GX_SetVtxDesc(GX_VA_POS, GX_DIRECT);
+	GRRLIB_StateRestore();
+	GRRLIB_StateSetMode3D(true);
+	GRRLIB_StateClearVtxDesc();
+	GRRLIB_StateSetVtxDesc(GX_VA_POS, GX_DIRECT);
 	if(normalmode == true) {
-		GX_SetVtxDesc(GX_VA_NRM, GX_DIRECT);
+		GRRLIB_StateSetVtxDesc(GX_VA_NRM, GX_DIRECT);
 	}
-	GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+	GRRLIB_StateSetVtxDesc(GX_VA_CLR0, GX_DIRECT);
 	if(texturemode == true) {
-		GX_SetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+		GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_DIRECT);
 	}
 
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS, GX_POS_XYZ, GX_F32, 0);
@@ -101,10 +104,10 @@ void GRRLIB_3dMode(f32 minDist, f32 maxDist, f32 fov, bool texturemode, bool nor
 	}
 
 	if(texturemode == true) {
-		GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
+		GRRLIB_StateSetTevOp(GX_MODULATE);
 	}
 	else {
-		GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+		GRRLIB_StateSetTevOp(GX_PASSCLR);
 	}
 }
 
@@ -115,33 +118,39 @@ void GRRLIB_2dMode() {
 	Mtx view;
 	Mtx44 m;
 
+	GRRLIB_StateRestore();
+	GRRLIB_StateSetMode3D(false);
+
 	GX_SetZMode(GX_FALSE, GX_LEQUAL, GX_TRUE);
 
-	GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
+	GRRLIB_StateSetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
 
 	guOrtho(m, 0, GRRLIB_VideoMode->efbHeight, 0, GRRLIB_VideoMode->fbWidth, 0, 1000.0f);
 	GX_LoadProjectionMtx(m, GX_ORTHOGRAPHIC);
 
 	guMtxIdentity(view);
 	guMtxTransApply(view, view, 0, 0, -100.0F);
-	GX_LoadPosMtxImm(view, GX_PNMTX0);
+	GRRLIB_StateLoadPosMtx(view);
 
-	GX_ClearVtxDesc();
-	GX_SetVtxDesc(GX_VA_POS, GX_DIRECT);
-	GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
-	GX_SetVtxDesc(GX_VA_TEX0, GX_NONE);
+	GRRLIB_StateClearVtxDesc();
+	GRRLIB_StateSetVtxDesc(GX_VA_POS, GX_DIRECT);
+	GRRLIB_StateSetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+	GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_NONE);
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS, GX_POS_XYZ, GX_F32, 0);
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_TEX0, GX_TEX_ST, GX_F32, 0);
+	GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_POS, GX_POS_XY, GX_S16, 0);
+	GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_TEX0, GX_TEX_ST, GX_U16, GRRLIB_TEXCOORD_FRAC);
+	GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
 
 	GX_SetNumTexGens(1);  // One texture exists
-	GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+	GRRLIB_StateSetTevOp(GX_PASSCLR);
 	GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORD0, GX_TEXMAP0, GX_COLOR0A0);
 	GX_SetTexCoordGen(GX_TEXCOORD0, GX_TG_MTX2x4, GX_TG_TEX0, GX_IDENTITY);
 
 	GX_SetNumTevStages(1);
 
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_PASSCLR);
+	GRRLIB_StateSetTevOp(GX_PASSCLR);
 
 	GX_SetNumChans(1);
 	GX_SetChanCtrl(GX_COLOR0A0, GX_DISABLE, GX_SRC_VTX, GX_SRC_VTX, 0, GX_DF_NONE, GX_AF_NONE);
@@ -213,7 +222,7 @@ void GRRLIB_ObjectViewEnd(void) {
 	Mtx mv, mvi;
 
 	guMtxConcat(_GRR_view, _ObjTransformationMtx, mv);
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
+	GRRLIB_StateLoadPosMtx(mv);
 
 	guMtxInverse(mv, mvi);
 	guMtxTranspose(mvi, mv);
@@ -265,7 +274,7 @@ void GRRLIB_ObjectView(f32 posx, f32 posy, f32 posz, f32 angx, f32 angy, f32 ang
 	}
 
 	guMtxConcat(_GRR_view, ObjTransformationMtx, mv);
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
+	GRRLIB_StateLoadPosMtx(mv);
 
 	guMtxInverse(mv, mvi);
 	guMtxTranspose(mvi, mv);
@@ -317,7 +326,7 @@ void GRRLIB_ObjectViewInv(f32 posx, f32 posy, f32 posz, f32 angx, f32 angy, f32
 	}
 
 	guMtxConcat(_GRR_view, ObjTransformationMtx, mv);
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
+	GRRLIB_StateLoadPosMtx(mv);
 
 	guMtxInverse(mv, mvi);
 	guMtxTranspose(mvi, mv);
@@ -342,9 +351,35 @@ void GRRLIB_SetTexture(GRRLIB_texImg *tex, bool rep) {
 		GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f, 0, 0, GX_ANISO_1);
 	}
 
-	GX_LoadTexObj(&texObj,      GX_TEXMAP0);
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_MODULATE);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_DIRECT);
+	GRRLIB_StateLoadTexObj(&texObj);
+	GRRLIB_StateSetTevOp  (GX_MODULATE);
+	GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+}
+
+/**
+ * Set a texture to an object, using its mipmaps and levels of detail if it has some.
+ * @param tex The texture.
+ * @param rep Texture Repeat Mode, @c true will repeat it, @c false won't.
+ * @see GRRLIB_GenerateMipmaps
+ */
+void GRRLIB_SetTextureEx(const GRRLIB_texture *tex, bool rep) {
+	GXTexObj  texObj = tex->obj;
+
+	if (rep == true) {
+		GX_InitTexObjWrapMode(&texObj, GX_REPEAT, GX_REPEAT);
+	}
+	if (GRRLIB_Settings.antialias == false) {
+		if (tex->mipmap == true) {
+			GX_InitTexObjLOD(&texObj, GX_NEAR_MIP_NEAR, GX_NEAR, tex->minLod, tex->maxLod, tex->lodBias, GX_TRUE, GX_TRUE, GX_ANISO_1);
+		}
+		else {
+			GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f, 0, 0, GX_ANISO_1);
+		}
+	}
+
+	GRRLIB_StateLoadTexObj(&texObj);
+	GRRLIB_StateSetTevOp  (GX_MODULATE);
+	GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_DIRECT);
 }
 
 /**
@@ -357,48 +392,7 @@ void GRRLIB_SetTexture(GRRLIB_texImg *tex, bool rep) {
  * @param col Color of the torus.
  */
 void GRRLIB_DrawTorus(f32 r, f32 R, int nsides, int rings, bool filled, u32 col) {
-	int i, j;
-	f32 theta, phi, theta1;
-	f32 cosTheta, sinTheta;
-	f32 cosTheta1, sinTheta1;
-	f32 ringDelta, sideDelta;
-	f32 cosPhi, sinPhi, dist;
-
-	ringDelta = 2.0 * M_PI / rings;
-	sideDelta = 2.0 * M_PI / nsides;
-
-	theta = 0.0;
-	cosTheta = 1.0;
-	sinTheta = 0.0;
-	for (i = rings - 1; i >= 0; i--) {
-		theta1 = theta + ringDelta;
-		cosTheta1 = cos(theta1);
-		sinTheta1 = sin(theta1);
-		if(filled == true) {
-			GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT0, 2*(nsides+1));
-		}
-		else {
-			GX_Begin(GX_LINESTRIP, GX_VTXFMT0, 2*(nsides+1));
-		}
-		phi = 0.0;
-		for (j = nsides; j >= 0; j--) {
-			phi += sideDelta;
-			cosPhi = cos(phi);
-			sinPhi = sin(phi);
-			dist = R + r * cosPhi;
-
-			GX_Position3f32(cosTheta1 * dist, -sinTheta1 * dist, r * sinPhi);
-			GX_Normal3f32(cosTheta1 * cosPhi, -sinTheta1 * cosPhi, sinPhi);
-			GX_Color1u32(col);
-			GX_Position3f32(cosTheta * dist, -sinTheta * dist,  r * sinPhi);
-			GX_Normal3f32(cosTheta * cosPhi, -sinTheta * cosPhi, sinPhi);
-			GX_Color1u32(col);
-		}
-		GX_End();
-		theta = theta1;
-		cosTheta = cosTheta1;
-		sinTheta = sinTheta1;
-	}
+	GRRLIB_DrawCachedMesh(GRRLIB_MESH_TORUS, r, R, 0.0f, 0.0f, nsides, rings, filled, col);
 }
 
 /**
@@ -410,39 +404,7 @@ void GRRLIB_DrawTorus(f32 r, f32 R, int nsides, int rings, bool filled, u32 col)
  * @param col Color of the sphere.
  */
 void GRRLIB_DrawSphere(f32 r, int lats, int longs, bool filled, u32 col) {
-	int i, j;
-	f32 lat0, z0, zr0,
-		lat1, z1, zr1,
-		lng, x, y;
-
-	for(i = 0; i <= lats; i++) {
-		lat0 = M_PI * (-0.5F + (f32) (i - 1) / lats);
-		z0  = sin(lat0);
-		zr0 = cos(lat0);
-
-		lat1 = M_PI * (-0.5F + (f32) i / lats);
-		z1 = sin(lat1);
-		zr1 = cos(lat1);
-		if(filled == true) {
-			GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT0, 2*(longs+1));
-		}
-		else {
-			GX_Begin(GX_LINESTRIP, GX_VTXFMT0, 2*(longs+1));
-		}
-		for(j = 0; j <= longs; j++) {
-			lng = 2 * M_PI * (f32) (j - 1) / longs;
-			x = cos(lng);
-			y = sin(lng);
-
-			GX_Position3f32(x * zr0 * r, y * zr0 * r, z0 * r);
-			GX_Normal3f32(x * zr0 * r, y * zr0 * r, z0 * r);
-			GX_Color1u32(col);
-			GX_Position3f32(x * zr1 * r, y * zr1 * r, z1 * r);
-			GX_Normal3f32(x * zr1 * r, y * zr1 * r, z1 * r);
-			GX_Color1u32(col);
-		}
-		GX_End();
-	}
+	GRRLIB_DrawCachedMesh(GRRLIB_MESH_SPHERE, r, 0.0f, 0.0f, 0.0f, lats, longs, filled, col);
 }
 
 /**
@@ -479,12 +441,14 @@ void GRRLIB_DrawCube(f32 size, bool filled, u32 col) {
 	v[0][2] = v[3][2] = v[4][2] = v[7][2] = -size / 2;
 	v[1][2] = v[2][2] = v[5][2] = v[6][2] = size / 2;
 
+	GRRLIB_StateRestore();
+
 	for (int i = 5; i >= 0; i--) {
 		if(filled == true) {
-			GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+			GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 		}
 		else {
-			GX_Begin(GX_LINESTRIP, GX_VTXFMT0, 5);
+			GRRLIB_Begin(GX_LINESTRIP, GX_VTXFMT0, 5);
 		}
 		GX_Position3f32(v[faces[i][0]][0], v[faces[i][0]][1], v[faces[i][0]][2] );
 		GX_Normal3f32(n[i][0], n[i][1], n[i][2]);
@@ -516,58 +480,7 @@ void GRRLIB_DrawCube(f32 size, bool filled, u32 col) {
  * @param col Color of the cylinder.
  */
 void GRRLIB_DrawCylinder(f32 r, f32 h, int d, bool filled, u32 col) {
-	int i;
-	f32 dx, dy;
-
-	if(filled == true) {
-		GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT0, 2 * (d+1));
-	}
-	else {
-		GX_Begin(GX_LINESTRIP, GX_VTXFMT0, 2 * (d+1));
-	}
-	for(i = 0; i <= d; i++) {
-		dx = cosf( M_PI * 2.0f * i / d );
-		dy = sinf( M_PI * 2.0f * i / d );
-		GX_Position3f32( r * dx, -0.5f * h, r * dy );
-		GX_Normal3f32( dx, 0.0f, dy );
-		GX_Color1u32(col);
-		GX_Position3f32( r * dx, 0.5f * h, r * dy );
-		GX_Normal3f32( dx, 0.0f, dy );
-		GX_Color1u32(col);
-	}
-	GX_End();
-
-	if(filled == true) {
-		GX_Begin(GX_TRIANGLEFAN, GX_VTXFMT0, d+2);
-	}
-	else {
-		GX_Begin(GX_LINESTRIP, GX_VTXFMT0, d+2);
-	}
-	GX_Position3f32(0.0f, -0.5f * h, 0.0f);
-	GX_Normal3f32(0.0f, -1.0f, 0.0f);
-	GX_Color1u32(col);
-	for(i = 0; i <= d; i++) {
-		GX_Position3f32( r * cosf( M_PI * 2.0f * i / d ), -0.5f * h, r * sinf( M_PI * 2.0f * i / d ) );
-		GX_Normal3f32(0.0f, -1.0f, 0.0f);
-		GX_Color1u32(col);
-	}
-	GX_End();
-
-	if(filled == true) {
-		GX_Begin(GX_TRIANGLEFAN, GX_VTXFMT0, d+2);
-	}
-	else {
-		GX_Begin(GX_LINESTRIP, GX_VTXFMT0, d+2);
-	}
-	GX_Position3f32(0.0f, 0.5f * h, 0.0f);
-	GX_Normal3f32(0.0f, 1.0f, 0.0f);
-	GX_Color1u32(col);
-	for(i = 0; i <= d; i++) {
-		GX_Position3f32( r * cosf( M_PI * 2.0f * i / d ), 0.5f * h, r * sinf( M_PI * 2.0f * i / d ) );
-		GX_Normal3f32(0.0f, 1.0f, 0.0f);
-		GX_Color1u32(col);
-	}
-	GX_End();
+	GRRLIB_DrawCachedMesh(GRRLIB_MESH_CYLINDER, r, h, 0.0f, 0.0f, d, 0, filled, col);
 }
 
 /**
@@ -579,42 +492,7 @@ void GRRLIB_DrawCylinder(f32 r, f32 h, int d, bool filled, u32 col) {
  * @param col Color of the cone.
  */
 void GRRLIB_DrawCone(f32 r, f32 h, int d, bool filled, u32 col) {
-	int i;
-	f32 dx, dy;
-
-	if(filled == true) {
-		GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT0, 2 * (d+1));
-	}
-	else {
-		GX_Begin(GX_LINESTRIP, GX_VTXFMT0, 2 * (d+1));
-	}
-	for(i = 0; i <= d; i++) {
-		dx = cosf( M_PI * 2.0f * i / d );
-		dy = sinf( M_PI * 2.0f * i / d );
-		GX_Position3f32( 0, -0.5f * h,0);
-		GX_Normal3f32( dx, 0.0f, dy );
-		GX_Color1u32(col);
-		GX_Position3f32( r * dx, 0.5f * h, r * dy );
-		GX_Normal3f32( dx, 0.0f, dy );
-		GX_Color1u32(col);
-	}
-	GX_End();
-
-	if(filled == true) {
-		GX_Begin(GX_TRIANGLEFAN, GX_VTXFMT0, d+2);
-	}
-	else {
-		GX_Begin(GX_LINESTRIP, GX_VTXFMT0, d+2);
-	}
-	GX_Position3f32(0.0f, 0.5f * h, 0.0f);
-	GX_Normal3f32(0.0f, 1.0f, 0.0f);
-	GX_Color1u32(col);
-	for(i = 0; i <= d; i++) {
-		GX_Position3f32( r * cosf( M_PI * 2.0f * i / d ), 0.5f * h, r * sinf( M_PI * 2.0f * i / d ) );
-		GX_Normal3f32(0.0f, 1.0f, 0.0f);
-		GX_Color1u32(col);
-	}
-	GX_End();
+	GRRLIB_DrawCachedMesh(GRRLIB_MESH_CONE, r, h, 0.0f, 0.0f, d, 0, filled, col);
 }
 
 /**
@@ -627,30 +505,7 @@ void GRRLIB_DrawCone(f32 r, f32 h, int d, bool filled, u32 col) {
  * @param col Color in RGBA format.
  */
 void GRRLIB_DrawTessPanel(f32 w, f32 wstep, f32 h, f32 hstep, bool filled, u32 col) {
-	f32 x, y;
-
-	f32 tmpy = h/2.0f;
-	f32 tmpx = w/2.0f;
-	int tmp = ((w/wstep)*2)+2;
-	for ( y = -tmpy; y <= tmpy; y += hstep )
-	{
-		if(filled == true) {
-			GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT0, tmp);
-		}
-		else {
-			GX_Begin(GX_LINESTRIP, GX_VTXFMT0, tmp);
-		}
-		for ( x = -tmpx; x <= tmpx; x += wstep )
-		{
-			GX_Position3f32( x, y, 0.0f );
-			GX_Normal3f32( 0.0f, 0.0f, 1.0f);
-			GX_Color1u32(col);
-			GX_Position3f32( x, y+hstep, 0.0f );
-			GX_Normal3f32( 0.0f, 0.0f, 1.0f);
-			GX_Color1u32(col);
-		}
-		GX_End();
-	}
+	GRRLIB_DrawCachedMesh(GRRLIB_MESH_TESSPANEL, w, wstep, h, hstep, 0, 0, filled, col);
 }
 
 /**
@@ -723,7 +578,7 @@ void GRRLIB_SetLightSpec(u8 num, guVector dir, f32 shininess, u32 lightcolor, u3
 	GX_SetNumTevStages(2);
 	GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORDNULL, GX_TEXMAP_NULL, GX_COLOR0A0 );
 	GX_SetTevOrder(GX_TEVSTAGE1, GX_TEXCOORDNULL, GX_TEXMAP_NULL, GX_COLOR1A1 );
-	GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+	GRRLIB_StateSetTevOp(GX_PASSCLR);
 	GX_SetTevColorOp(GX_TEVSTAGE1, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_ENABLE, GX_TEVPREV );
 	GX_SetTevColorIn(GX_TEVSTAGE1, GX_CC_ZERO, GX_CC_RASC, GX_CC_ONE, GX_CC_CPREV );
 
@@ -778,7 +633,7 @@ void GRRLIB_SetLightSpot(u8 num, guVector pos, guVector lookat, f32 angAttn0, f3
 void GRRLIB_SetLightOff(void) {
 	GX_SetNumTevStages(1);
 
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_PASSCLR);
+	GRRLIB_StateSetTevOp(GX_PASSCLR);
 
 	GX_SetNumChans(1);
 	GX_SetChanCtrl(GX_COLOR0A0, GX_DISABLE, GX_SRC_VTX, GX_SRC_VTX, 0, GX_DF_NONE, GX_AF_NONE);
@@ -0,0 +1,430 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define ASSET_MIN_BUCKETS  (64)  /**< Initial size of the hash table of a cache. */
+
+/**
+ * Structure to hold a texture of an asset cache.
+ */
+typedef  struct GRRLIB_asset {
+	GRRLIB_texture        texture;       /**< The texture given to the application, must be the first member. */
+	char                 *key;           /**< The file name or the key given by the application. */
+	u32                   hash;          /**< Hash of the key. */
+	u32                   refs;          /**< Number of references held by the application. */
+	u32                   bytes;         /**< Memory used by the texture data. */
+	u32                   releaseFrame;  /**< Frame the last reference was released. */
+	struct GRRLIB_asset  *hashNext;      /**< Next asset in the same hash bucket. */
+	struct GRRLIB_asset  *prev;          /**< Previous asset in the cache, more recently used. */
+	struct GRRLIB_asset  *next;          /**< Next asset in the cache, less recently used. */
+} GRRLIB_asset;
+
+/**
+ * Structure to hold an asset cache, see GRRLIB_CreateAssetCache.
+ */
+struct GRRLIB_assetCache {
+	u32             fmt;          /**< Format the textures are loaded in. */
+	u32             budget;       /**< Memory above which textures not referenced are freed. */
+	GRRLIB_asset  **buckets;      /**< Hash table of the assets. */
+	u32             bucketCount;  /**< Size of the hash table, a power of two. */
+	GRRLIB_asset   *first;        /**< Most recently used asset. */
+	GRRLIB_asset   *last;         /**< Least recently used asset. */
+	GRRLIB_assetStats  stats;     /**< Counters reported by GRRLIB_GetAssetCacheStats. */
+};
+
+static u32  assetFrame = 0;
+
+/**
+ * Hash a key with FNV-1a.
+ * @param key The key.
+ * @return The hash of the key.
+ */
+static u32  AssetHash (const char *key) {
+	u32 hash = 2166136261u;
+
+	for (; *key != '\0'; key++) {
+		hash = (hash ^ (u8)*key) * 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Find an asset by its key.
+ * @param cache The cache.
+ * @param key The key.
+ * @param hash Hash of the key.
+ * @return The asset, NULL if it is not in the cache.
+ */
+static GRRLIB_asset*  AssetFind (const GRRLIB_assetCache *cache, const char *key, const u32 hash) {
+	GRRLIB_asset *asset;
+
+	for (asset = cache->buckets[hash & (cache->bucketCount - 1)]; asset != NULL; asset = asset->hashNext) {
+		if (asset->hash == hash && strcmp(asset->key, key) == 0) {
+			return asset;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Remove an asset from the list of a cache.
+ */
+static void  AssetUnlink (GRRLIB_assetCache *cache, GRRLIB_asset *asset) {
+	if (asset->prev != NULL)  asset->prev->next = asset->next;
+	else                      cache->first = asset->next;
+	if (asset->next != NULL)  asset->next->prev = asset->prev;
+	else                      cache->last = asset->prev;
+}
+
+/**
+ * Put an asset at the start of the list of a cache, as the most recently used one.
+ */
+static void  AssetLinkFirst (GRRLIB_assetCache *cache, GRRLIB_asset *asset) {
+	asset->prev = NULL;
+	asset->next = cache->first;
+	if (cache->first != NULL)  cache->first->prev = asset;
+	else                       cache->last = asset;
+	cache->first = asset;
+}
+
+/**
+ * Take a reference to an asset and mark it as the most recently used one.
+ * @return The texture of the asset.
+ */
+static GRRLIB_texture*  AssetAcquire (GRRLIB_assetCache *cache, GRRLIB_asset *asset) {
+	if (asset->refs++ == 0) {
+		cache->stats.referenced++;
+		cache->stats.idleBytes -= asset->bytes;
+	}
+	AssetUnlink(cache, asset);
+	AssetLinkFirst(cache, asset);
+	return &asset->texture;
+}
+
+/**
+ * Remove an asset from a cache and free it.
+ */
+static void  AssetFree (GRRLIB_assetCache *cache, GRRLIB_asset *asset) {
+	GRRLIB_asset **link = &cache->buckets[asset->hash & (cache->bucketCount - 1)];
+
+	while (*link != asset) {
+		link = &(*link)->hashNext;
+	}
+	*link = asset->hashNext;
+	AssetUnlink(cache, asset);
+
+	cache->stats.entries--;
+	cache->stats.bytes -= asset->bytes;
+	if (asset->refs == 0) {
+		cache->stats.idleBytes -= asset->bytes;
+	}
+	else {
+		cache->stats.referenced--;
+	}
+	// The texture may have been given mipmaps or dirty tracking since it was cached
+	if (asset->texture.dirtyRows != NULL) {
+		GRRLIB_TrackTextureDirty(&asset->texture, false);
+	}
+	GRRLIB_MemFree(asset->texture.data, GRRLIB_GetTextureDataSize(&asset->texture));
+	GRRLIB_MemFree(asset->key, strlen(asset->key) + 1);
+	GRRLIB_MemFree(asset, sizeof(GRRLIB_asset));
+}
+
+/**
+ * Free the least recently used textures not referenced until the cache fits in its budget.
+ * Waits for the GPU before freeing a texture released during the current or previous frame, which may still be drawn.
+ * @param cache The cache.
+ */
+static void  AssetCacheEvict (GRRLIB_assetCache *cache) {
+	bool waited = false;
+
+	while (cache->stats.bytes > cache->budget && cache->stats.idleBytes != 0) {
+		GRRLIB_asset *victim = cache->last;
+
+		while (victim->refs != 0) {
+			victim = victim->prev;
+		}
+		if (waited == false && assetFrame - victim->releaseFrame <= 1) {
+			GX_DrawDone();
+			waited = true;
+		}
+		AssetFree(cache, victim);
+		cache->stats.evictions++;
+	}
+}
+
+/**
+ * Add a decoded texture to a cache, with one reference.
+ * @param cache The cache.
+ * @param key The key of the texture.
+ * @param hash Hash of the key.
+ * @param texture The texture, its structure is freed.
+ * @return The texture of the new asset, NULL if memory is missing.
+ */
+static GRRLIB_texture*  AssetInsert (GRRLIB_assetCache *cache, const char *key, const u32 hash, GRRLIB_texture *texture) {
+	const size_t length = strlen(key) + 1;
+	GRRLIB_asset *asset = GRRLIB_MemCalloc(sizeof(GRRLIB_asset), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+	u32 i;
+
+	if (asset != NULL) {
+		asset->key = GRRLIB_MemAlloc(length, 1, GRRLIB_MEM_COLD);
+	}
+	if (asset == NULL || asset->key == NULL) {
+		GRRLIB_MemFree(asset, sizeof(GRRLIB_asset));
+		GRRLIB_FreeTexture(texture);
+		return NULL;
+	}
+
+	// Keep about one asset per bucket
+	if (cache->stats.entries >= cache->bucketCount) {
+		GRRLIB_asset **buckets = GRRLIB_MemCalloc(cache->bucketCount * 2 * sizeof(GRRLIB_asset*), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+
+		if (buckets != NULL) {
+			for (i = 0; i < cache->bucketCount; i++) {
+				while (cache->buckets[i] != NULL) {
+					GRRLIB_asset *moved = cache->buckets[i];
+
+					cache->buckets[i] = moved->hashNext;
+					moved->hashNext = buckets[moved->hash & (cache->bucketCount * 2 - 1)];
+					buckets[moved->hash & (cache->bucketCount * 2 - 1)] = moved;
+				}
+			}
+			GRRLIB_MemFree(cache->buckets, cache->bucketCount * sizeof(GRRLIB_asset*));
+			cache->buckets = buckets;
+			cache->bucketCount *= 2;
+		}
+	}
+
+	memcpy(&asset->texture, texture, sizeof(GRRLIB_texture));
+	GRRLIB_MemFree(texture, sizeof(GRRLIB_texture));
+	memcpy(asset->key, key, length);
+	asset->hash = hash;
+	asset->refs = 1;
+	asset->bytes = GRRLIB_GetTextureDataSize(&asset->texture);
+	asset->hashNext = cache->buckets[hash & (cache->bucketCount - 1)];
+	cache->buckets[hash & (cache->bucketCount - 1)] = asset;
+	AssetLinkFirst(cache, asset);
+
+	cache->stats.entries++;
+	cache->stats.referenced++;
+	cache->stats.bytes += asset->bytes;
+	return &asset->texture;
+}
+
+/**
+ * Create a cache of textures shared by reference counting.
+ * Textures are identified by their file name or by a key given with their data, and are decoded once while they stay in the cache.
+ * Textures no longer referenced are kept while the cache fits in its budget, then the least recently used ones are freed.
+ * Referenced textures are never freed, so the cache exceeds its budget when they do not fit.
+ * @param budget Maximum memory in bytes used by the textures of the cache.
+ * @param fmt Format the textures are loaded in, see GRRLIB_LoadTextureFmt.
+ * @return The cache, NULL if memory is missing.
+ */
+GRRLIB_assetCache*  GRRLIB_CreateAssetCache (const u32 budget, const u32 fmt) {
+	GRRLIB_assetCache *cache = GRRLIB_MemCalloc(sizeof(GRRLIB_assetCache), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+
+	if (cache != NULL) {
+		cache->fmt = fmt;
+		cache->budget = budget;
+		cache->bucketCount = ASSET_MIN_BUCKETS;
+		cache->buckets = GRRLIB_MemCalloc(cache->bucketCount * sizeof(GRRLIB_asset*), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+		if (cache->buckets == NULL) {
+			GRRLIB_MemFree(cache, sizeof(GRRLIB_assetCache));
+			return NULL;
+		}
+	}
+	return cache;
+}
+
+/**
+ * Get a texture from a cache, loading it from a file if it is not in the cache.
+ * Each call takes a reference, to give back with GRRLIB_AssetCacheRelease.
+ * @param cache The cache.
+ * @param filename The PNG, JPEG, BMP or TPL file name, also the key of the texture.
+ * @return The texture, NULL if the file cannot be loaded. It must not be freed with GRRLIB_FreeTexture.
+ */
+GRRLIB_texture*  GRRLIB_AssetCacheLoadFile (GRRLIB_assetCache *cache, const char *filename) {
+	const u32 hash = AssetHash(filename);
+	GRRLIB_asset *asset = AssetFind(cache, filename, hash);
+	GRRLIB_texture *texture;
+	u8 *data;
+	int len;
+
+	if (asset != NULL) {
+		cache->stats.hits++;
+		return AssetAcquire(cache, asset);
+	}
+
+	len = GRRLIB_LoadFile(filename, &data);
+	if (len <= 0) {
+		return NULL;
+	}
+	cache->stats.misses++;
+	texture = GRRLIB_LoadTextureFmt(data, len, cache->fmt);
+	free(data);
+	if (texture == NULL || texture->data == NULL) {
+		GRRLIB_FreeTexture(texture);
+		return NULL;
+	}
+	texture = AssetInsert(cache, filename, hash, texture);
+	AssetCacheEvict(cache);
+	return texture;
+}
+
+/**
+ * Get a texture from a cache, decoding it from a buffer if it is not in the cache.
+ * Each call takes a reference, to give back with GRRLIB_AssetCacheRelease.
+ * @param cache The cache.
+ * @param key The key of the texture.
+ * @param my_img The PNG, JPEG, BMP or TPL buffer, only read if the key is not in the cache.
+ * @param my_size Size of the buffer.
+ * @return The texture, NULL if the image cannot be loaded. It must not be freed with GRRLIB_FreeTexture.
+ */
+GRRLIB_texture*  GRRLIB_AssetCacheLoadBuffer (GRRLIB_assetCache *cache, const char *key, const u8 *my_img, const u32 my_size) {
+	const u32 hash = AssetHash(key);
+	GRRLIB_asset *asset = AssetFind(cache, key, hash);
+	GRRLIB_texture *texture;
+
+	if (asset != NULL) {
+		cache->stats.hits++;
+		return AssetAcquire(cache, asset);
+	}
+
+	cache->stats.misses++;
+	texture = GRRLIB_LoadTextureFmt(my_img, my_size, cache->fmt);
+	if (texture == NULL || texture->data == NULL) {
+		GRRLIB_FreeTexture(texture);
+		return NULL;
+	}
+	texture = AssetInsert(cache, key, hash, texture);
+	AssetCacheEvict(cache);
+	return texture;
+}
+
+/**
+ * Get a texture from a cache without loading it.
+ * Takes a reference when the texture is found, to give back with GRRLIB_AssetCacheRelease.
+ * @param cache The cache.
+ * @param key The file name or key of the texture.
+ * @return The texture, NULL if it is not in the cache.
+ */
+GRRLIB_texture*  GRRLIB_AssetCacheFind (GRRLIB_assetCache *cache, const char *key) {
+	GRRLIB_asset *asset = AssetFind(cache, key, AssetHash(key));
+
+	if (asset == NULL) {
+		return NULL;
+	}
+	cache->stats.hits++;
+	return AssetAcquire(cache, asset);
+}
+
+/**
+ * Give back a reference to a texture of a cache.
+ * The texture stays in the cache when its last reference is released, until the cache exceeds its budget.
+ * @param cache The cache.
+ * @param texture A texture returned by the cache.
+ */
+void  GRRLIB_AssetCacheRelease (GRRLIB_assetCache *cache, GRRLIB_texture *texture) {
+	GRRLIB_asset *asset = (GRRLIB_asset*)texture;
+
+	if (texture == NULL || asset->refs == 0) {
+		return;
+	}
+	if (--asset->refs == 0) {
+		asset->releaseFrame = assetFrame;
+		cache->stats.referenced--;
+		cache->stats.idleBytes += asset->bytes;
+		AssetCacheEvict(cache);
+	}
+}
+
+/**
+ * Set the maximum memory used by the textures of a cache.
+ * The least recently used textures not referenced are freed until the cache fits in the new budget.
+ * @param cache The cache.
+ * @param bytes The maximum memory in bytes, 0 to free textures as soon as they are released.
+ */
+void  GRRLIB_SetAssetCacheBudget (GRRLIB_assetCache *cache, const u32 bytes) {
+	cache->budget = bytes;
+	AssetCacheEvict(cache);
+}
+
+/**
+ * Free all the textures of a cache which are not referenced.
+ * @param cache The cache.
+ */
+void  GRRLIB_PurgeAssetCache (GRRLIB_assetCache *cache) {
+	const u32 budget = cache->budget;
+
+	cache->budget = 0;
+	AssetCacheEvict(cache);
+	cache->budget = budget;
+}
+
+/**
+ * Get the memory used by a cache and its counters since it was created or GRRLIB_ResetAssetCacheStats was called.
+ * @param cache The cache.
+ * @return A GRRLIB_assetStats structure.
+ */
+GRRLIB_assetStats  GRRLIB_GetAssetCacheStats (const GRRLIB_assetCache *cache) {
+	return cache->stats;
+}
+
+/**
+ * Reset the hit, miss and eviction counters of a cache.
+ * @param cache The cache.
+ */
+void  GRRLIB_ResetAssetCacheStats (GRRLIB_assetCache *cache) {
+	cache->stats.hits = 0;
+	cache->stats.misses = 0;
+	cache->stats.evictions = 0;
+}
+
+/**
+ * Free a cache and all its textures, including the ones still referenced.
+ * Waits for the GPU to finish drawing.
+ * @param cache The cache.
+ */
+void  GRRLIB_FreeAssetCache (GRRLIB_assetCache *cache) {
+	if (cache == NULL) {
+		return;
+	}
+	GX_DrawDone();
+	while (cache->first != NULL) {
+		AssetFree(cache, cache->first);
+	}
+	GRRLIB_MemFree(cache->buckets, cache->bucketCount * sizeof(GRRLIB_asset*));
+	GRRLIB_MemFree(cache, sizeof(GRRLIB_assetCache));
+}
+
+/**
+ * Tell the asset caches a frame was completed.
+ * The textures released before this call are no longer used by the GPU after the next frame.
+ */
+void  GRRLIB_AssetCacheNextFrame (void) {
+	assetFrame++;
+}
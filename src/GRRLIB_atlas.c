@@ -0,0 +1,548 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * Segment of the skyline of a page: the top of the images packed below it.
+ * Coordinates are in tiles.
+ */
+typedef  struct GRRLIB_skylineNode {
+	u16  x;      /**< Left of the segment. */
+	u16  y;      /**< Height of the skyline. */
+	u16  width;  /**< Width of the segment. */
+} GRRLIB_skylineNode;
+
+/**
+ * Structure to hold the free space of a page of an atlas.
+ */
+typedef  struct GRRLIB_atlasPage {
+	GRRLIB_skylineNode  *nodes;     /**< Segments from left to right. */
+	u32                  count;     /**< Number of segments. */
+	u32                  capacity;  /**< Number of segments allocated. */
+} GRRLIB_atlasPage;
+
+/**
+ * Find where a rectangle fits on the skyline starting at a segment.
+ * @param page The page.
+ * @param i Index of the segment holding the left of the rectangle.
+ * @param w Width of the rectangle in tiles.
+ * @param h Height of the rectangle in tiles.
+ * @param pageW Width of the page in tiles.
+ * @param pageH Height of the page in tiles.
+ * @return The top of the rectangle in tiles, -1 if it does not fit.
+ */
+static s32  SkylineFit (const GRRLIB_atlasPage *page, u32 i, const u32 w, const u32 h, const u32 pageW, const u32 pageH) {
+	s32 remaining = w;
+	u32 y = 0;
+
+	if (page->nodes[i].x + w > pageW) {
+		return -1;
+	}
+	while (remaining > 0) {
+		if (page->nodes[i].y > y) {
+			y = page->nodes[i].y;
+		}
+		if (y + h > pageH) {
+			return -1;
+		}
+		remaining -= page->nodes[i].width;
+		i++;
+	}
+	return y;
+}
+
+/**
+ * Place a rectangle on a page with the skyline bottom-left heuristic: lowest top, then tightest segment.
+ * @param page The page.
+ * @param w Width of the rectangle in tiles.
+ * @param h Height of the rectangle in tiles.
+ * @param pageW Width of the page in tiles.
+ * @param pageH Height of the page in tiles.
+ * @param x Set to the left of the rectangle in tiles.
+ * @param y Set to the top of the rectangle in tiles.
+ * @return @c true if the rectangle was placed, @c false if it does not fit or memory is missing.
+ */
+static bool  SkylinePlace (GRRLIB_atlasPage *page, const u32 w, const u32 h, const u32 pageW, const u32 pageH, u32 *x, u32 *y) {
+	u32 best = ~0u, bestBottom = ~0u, bestWidth = ~0u, i;
+	GRRLIB_skylineNode node;
+
+	for (i = 0; i < page->count; i++) {
+		const s32 top = SkylineFit(page, i, w, h, pageW, pageH);
+
+		if (top >= 0 && (top + h < bestBottom || (top + h == bestBottom && page->nodes[i].width < bestWidth))) {
+			best = i;
+			bestBottom = top + h;
+			bestWidth = page->nodes[i].width;
+		}
+	}
+	if (best == ~0u) {
+		return false;
+	}
+	if (page->count == page->capacity) {
+		GRRLIB_skylineNode *nodes = GRRLIB_MemRealloc(page->nodes, page->capacity * sizeof(GRRLIB_skylineNode),
+		                                             2 * page->capacity * sizeof(GRRLIB_skylineNode), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+
+		if (nodes == NULL) {
+			return false;
+		}
+		page->nodes = nodes;
+		page->capacity *= 2;
+	}
+
+	node.x = page->nodes[best].x;
+	node.y = bestBottom;
+	node.width = w;
+	*x = node.x;
+	*y = bestBottom - h;
+	memmove(&page->nodes[best + 1], &page->nodes[best], (page->count - best) * sizeof(GRRLIB_skylineNode));
+	page->nodes[best] = node;
+	page->count++;
+
+	// Shrink or remove the segments now below the rectangle
+	for (i = best + 1; i < page->count; i++) {
+		const u32 right = node.x + node.width;
+
+		if (page->nodes[i].x >= right) {
+			break;
+		}
+		if (page->nodes[i].x + page->nodes[i].width <= right) {
+			memmove(&page->nodes[i], &page->nodes[i + 1], (page->count - i - 1) * sizeof(GRRLIB_skylineNode));
+			page->count--;
+			i--;
+		}
+		else {
+			page->nodes[i].width -= right - page->nodes[i].x;
+			page->nodes[i].x = right;
+			break;
+		}
+	}
+	// Merge the segments at the same height
+	for (i = 0; i + 1 < page->count; i++) {
+		if (page->nodes[i].y == page->nodes[i + 1].y) {
+			page->nodes[i].width += page->nodes[i + 1].width;
+			memmove(&page->nodes[i + 1], &page->nodes[i + 2], (page->count - i - 2) * sizeof(GRRLIB_skylineNode));
+			page->count--;
+			i--;
+		}
+	}
+	return true;
+}
+
+/**
+ * Add an empty page to an atlas.
+ * @param atlas The atlas.
+ * @return @c true on success, @c false if memory is missing.
+ */
+static bool  AddPage (GRRLIB_atlas *atlas) {
+	GRRLIB_atlasPage *packing;
+	GRRLIB_texture *texture;
+	u32 tileW, tileH;
+
+	if (atlas->pageCount == atlas->pageCapacity) {
+		const u32 capacity = (atlas->pageCapacity != 0) ? 2 * atlas->pageCapacity : 2;
+		GRRLIB_texture **pages = GRRLIB_MemAlloc(capacity * sizeof(GRRLIB_texture*), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+
+		packing = GRRLIB_MemAlloc(capacity * sizeof(GRRLIB_atlasPage), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+		if (pages == NULL || packing == NULL) {
+			GRRLIB_MemFree(pages, capacity * sizeof(GRRLIB_texture*));
+			GRRLIB_MemFree(packing, capacity * sizeof(GRRLIB_atlasPage));
+			return false;
+		}
+		if (atlas->pageCount != 0) {
+			memcpy(pages, atlas->pages, atlas->pageCount * sizeof(GRRLIB_texture*));
+			memcpy(packing, atlas->packing, atlas->pageCount * sizeof(GRRLIB_atlasPage));
+		}
+		GRRLIB_MemFree(atlas->pages, atlas->pageCapacity * sizeof(GRRLIB_texture*));
+		GRRLIB_MemFree(atlas->packing, atlas->pageCapacity * sizeof(GRRLIB_atlasPage));
+		atlas->pages = pages;
+		atlas->packing = packing;
+		atlas->pageCapacity = capacity;
+	}
+
+	texture = GRRLIB_CreateEmptyTextureFmt(atlas->width, atlas->height, atlas->fmt);
+	if (texture == NULL || texture->data == NULL) {
+		GRRLIB_FreeTexture(texture);
+		return false;
+	}
+	packing = &atlas->packing[atlas->pageCount];
+	packing->capacity = 16;
+	packing->count = 1;
+	packing->nodes = GRRLIB_MemAlloc(packing->capacity * sizeof(GRRLIB_skylineNode), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (packing->nodes == NULL) {
+		GRRLIB_FreeTexture(texture);
+		return false;
+	}
+	GRRLIB_TileGeometry(texture->fmt, &tileW, &tileH);
+	packing->nodes[0].x = 0;
+	packing->nodes[0].y = 0;
+	packing->nodes[0].width = atlas->width / tileW;
+
+	atlas->pages[atlas->pageCount++] = texture;
+	return true;
+}
+
+/**
+ * Fill the padding around an image of a page.
+ * With extrusion, each pixel of the padding repeats the closest pixel of the image, otherwise it is cleared.
+ * @param atlas The atlas.
+ * @param page The page.
+ * @param x Left of the image in the page.
+ * @param y Top of the image in the page.
+ * @param w Width of the image.
+ * @param h Height of the image.
+ */
+static void  FillPadding (const GRRLIB_atlas *atlas, GRRLIB_texture *page, const s32 x, const s32 y, const s32 w, const s32 h) {
+	const s32 p = atlas->padding;
+	s32 px, py;
+
+	for (py = y - p; py < y + h + p; py++) {
+		for (px = x - p; px < x + w + p; px++) {
+			if (px >= x && px < x + w && py >= y && py < y + h) {
+				px = x + w - 1;  // Skip the image
+				continue;
+			}
+			if (px < 0 || py < 0 || px >= (s32)atlas->width || py >= (s32)atlas->height) {
+				continue;
+			}
+			if (atlas->extrude == true) {
+				const s32 sx = (px < x) ? x : (px >= x + w) ? x + w - 1 : px;
+				const s32 sy = (py < y) ? y : (py >= y + h) ? y + h - 1 : py;
+
+				GRRLIB_SetPixelToTexture(px, py, page, GRRLIB_GetPixelFromTexture(sx, sy, page));
+			}
+			else {
+				GRRLIB_SetPixelToTexture(px, py, page, 0);
+			}
+		}
+	}
+}
+
+/**
+ * Write the slot of an image on a GX_TF_CMPR page.
+ * The slot, the image and its padding, is built in RGBA then compressed as a whole, since the pixels of a block can not be set one by one.
+ * The blocks of a GX_TF_CMPR texture which only hold pixels of the image are copied as they are.
+ * @param atlas The atlas.
+ * @param texture The image.
+ * @param page The page.
+ * @param tx Left of the slot in tiles.
+ * @param ty Top of the slot in tiles.
+ * @param slotW Width of the slot in tiles.
+ * @param slotH Height of the slot in tiles.
+ * @param inset Offset of the image in the slot, a multiple of 4 pixels at least as large as the padding.
+ * @return @c true on success, @c false if memory is missing.
+ */
+static bool  WriteCMPRSlot (const GRRLIB_atlas *atlas, const GRRLIB_texture *texture, GRRLIB_texture *page,
+                            const u32 tx, const u32 ty, const u32 slotW, const u32 slotH, const s32 inset) {
+	const s32 p = atlas->padding, w = texture->width, h = texture->height;
+	const u32 sw = slotW * 8, sh = slotH * 8, rgbaSize = sw * sh * 4, encodedSize = sw * sh / 2;
+	const u32 srcRow = slotW * 32, dstRow = (atlas->width / 8) * 32;
+	u8 *rgba = GRRLIB_MemAlloc(rgbaSize, 32, GRRLIB_MEM_SCRATCH), *encoded = GRRLIB_MemAlloc(encodedSize, 32, GRRLIB_MEM_SCRATCH), *d;
+	GRRLIB_texture slot;
+	s32 x, y;
+	u32 row;
+
+	if (rgba == NULL || encoded == NULL) {
+		GRRLIB_MemFree(rgba, rgbaSize);
+		GRRLIB_MemFree(encoded, encodedSize);
+		return false;
+	}
+
+	// Pixels of the image, the padding around it, and transparent pixels for the rest of the slot
+	for (y = 0, d = rgba; y < (s32)sh; y++) {
+		for (x = 0; x < (s32)sw; x++, d += 4) {
+			const s32 ix = x - inset, iy = y - inset;
+			const bool image = ix >= 0 && ix < w && iy >= 0 && iy < h;
+			const bool padding = ix >= -p && ix < w + p && iy >= -p && iy < h + p;
+			u32 c = 0;
+
+			if (image == true || (padding == true && atlas->extrude == true)) {
+				c = GRRLIB_GetPixelFromTexture((ix < 0) ? 0 : (ix >= w) ? w - 1 : ix,
+				                               (iy < 0) ? 0 : (iy >= h) ? h - 1 : iy, texture);
+			}
+			d[0] = GRRLIB_R(c);
+			d[1] = GRRLIB_G(c);
+			d[2] = GRRLIB_B(c);
+			d[3] = GRRLIB_A(c);
+		}
+	}
+	GRRLIB_EncodeCMPR(rgba, sw * 4, GRRLIB_LAYOUT_RGBA, encoded, sw, sh, atlas->fmt == GRRLIB_TEXFMT_CMPR_HQ);
+	GRRLIB_MemFree(rgba, rgbaSize);
+
+	// Compressing the blocks again would lose quality
+	if (texture->fmt == GX_TF_CMPR) {
+		memset(&slot, 0, sizeof(slot));
+		slot.width = sw;
+		slot.height = sh;
+		slot.fmt = GX_TF_CMPR;
+		for (y = 0; y + 4 <= h; y += 4) {
+			for (x = 0; x + 4 <= w; x += 4) {
+				memcpy(encoded + GRRLIB_GetPixelOffset(x + inset, y + inset, &slot),
+				       (const u8*)texture->data + GRRLIB_GetPixelOffset(x, y, texture), 8);
+			}
+		}
+	}
+
+	// Copy the slot a row of tiles at a time
+	d = (u8*)page->data + ty * dstRow + tx * 32;
+	for (row = 0; row < slotH; row++) {
+		memcpy(d + row * dstRow, encoded + row * srcRow, srcRow);
+	}
+	GRRLIB_MemFree(encoded, encodedSize);
+	DCFlushRange((u8*)page->data + ty * dstRow, slotH * dstRow);
+	return true;
+}
+
+/**
+ * Create an empty texture atlas.
+ * Images added to the atlas are packed into pages, large textures created when the images do not fit in the previous ones.
+ * Drawing the images of a page one after another does not change the texture, so they can be drawn in a single sprite batch.
+ * Images are placed on the tiles of the texture format, so they are copied a tile at a time.
+ * On GX_TF_CMPR pages, an image is placed after its padding rounded to 4 pixels, and its slot is compressed with its padding.
+ * @param width Width of the pages in pixels, a multiple of 8 up to 1024.
+ * @param height Height of the pages in pixels, a multiple of 8 up to 1024.
+ * @param fmt Format of the pages (GX_TF_RGBA8, GX_TF_RGB565, GX_TF_RGB5A3, GX_TF_I8, GX_TF_IA8, GX_TF_IA4, GX_TF_CMPR or GRRLIB_TEXFMT_CMPR_HQ).
+ *            GX_TF_CI8 is not supported since the images do not share a palette.
+ * @param padding Number of pixels kept free around each image so that filtering does not blend the images together.
+ * @param extrude @c true to fill the padding with the edges of the images, @c false to leave it transparent.
+ * @return A new atlas, NULL if the parameters are not supported or memory is missing.
+ */
+GRRLIB_atlas*  GRRLIB_CreateAtlas (const u32 width, const u32 height, const u32 fmt, const u8 padding, const bool extrude) {
+	GRRLIB_atlas *atlas;
+
+	if (width == 0 || height == 0 || width > 1024 || height > 1024 || (width & 7) != 0 || (height & 7) != 0) {
+		return NULL;
+	}
+	switch (fmt) {
+		case GX_TF_RGBA8: case GX_TF_RGB565: case GX_TF_RGB5A3: case GX_TF_I8: case GX_TF_IA8: case GX_TF_IA4:
+		case GX_TF_CMPR: case GRRLIB_TEXFMT_CMPR_HQ:
+			break;
+		default:
+			return NULL;
+	}
+	atlas = GRRLIB_MemCalloc(sizeof(GRRLIB_atlas), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (atlas != NULL) {
+		atlas->fmt = fmt;
+		atlas->width = width;
+		atlas->height = height;
+		atlas->padding = padding;
+		atlas->extrude = extrude;
+	}
+	return atlas;
+}
+
+/**
+ * Add a texture to an atlas.
+ * The texture is copied, it can be freed afterwards.
+ * @param atlas The atlas.
+ * @param texture The texture to add, in any format. Only its base level is copied.
+ * @param page Set to the page holding the image, if not NULL.
+ * @return The coordinates of the image in its page, NULL if the image is larger than a page or memory is missing.
+ *         They are freed by GRRLIB_FreeAtlas.
+ */
+GRRLIB_texturePart*  GRRLIB_AtlasAddTexture (GRRLIB_atlas *atlas, const GRRLIB_texture *texture, GRRLIB_texture **page) {
+	const u32 pageFmt = (atlas->fmt == GRRLIB_TEXFMT_CMPR_HQ) ? GX_TF_CMPR : atlas->fmt;
+	const u32 w = texture->width, h = texture->height;
+	const u32 convertedSize = GX_GetTexBufferSize(w, h, pageFmt, GX_FALSE, 0);
+	u32 tileW, tileH, tileBytes, slotW, slotH, inset = 0, tx = 0, ty = 0, i, row;
+	GRRLIB_texturePart **parts, *part;
+	GRRLIB_texture *target;
+	const u8 *src;
+	u8 *converted = NULL;
+
+	tileBytes = GRRLIB_TileGeometry(pageFmt, &tileW, &tileH);
+	if (pageFmt == GX_TF_CMPR) {
+		// The blocks of the slot are compressed together, so the whole padding is in the slot
+		inset = (atlas->padding + 3) & ~3;
+		slotW = inset + w + atlas->padding;
+		slotH = inset + h + atlas->padding;
+	}
+	else {
+		// The image is at the top left of its slot, which ends at least 2 paddings after the image and 1 padding
+		// after its tiles: the padding on the left of and above an image is at the end of the slots next to it
+		slotW = w + 2 * atlas->padding;
+		if (slotW < ((w + tileW - 1) & ~(tileW - 1)) + atlas->padding) {
+			slotW = ((w + tileW - 1) & ~(tileW - 1)) + atlas->padding;
+		}
+		slotH = h + 2 * atlas->padding;
+		if (slotH < ((h + tileH - 1) & ~(tileH - 1)) + atlas->padding) {
+			slotH = ((h + tileH - 1) & ~(tileH - 1)) + atlas->padding;
+		}
+	}
+	slotW = (slotW + tileW - 1) / tileW;
+	slotH = (slotH + tileH - 1) / tileH;
+	if (w == 0 || h == 0 || slotW > atlas->width / tileW || slotH > atlas->height / tileH) {
+		return NULL;
+	}
+
+	// Find the first page with room for the image
+	for (i = 0; i < atlas->pageCount; i++) {
+		if (SkylinePlace(&atlas->packing[i], slotW, slotH, atlas->width / tileW, atlas->height / tileH, &tx, &ty) == true) {
+			break;
+		}
+	}
+	if (i == atlas->pageCount) {
+		if (AddPage(atlas) == false ||
+		    SkylinePlace(&atlas->packing[i], slotW, slotH, atlas->width / tileW, atlas->height / tileH, &tx, &ty) == false) {
+			return NULL;
+		}
+	}
+	target = atlas->pages[i];
+
+	if (atlas->partCount == atlas->partCapacity) {
+		const u32 capacity = (atlas->partCapacity != 0) ? 2 * atlas->partCapacity : 16;
+
+		parts = GRRLIB_MemRealloc(atlas->parts, atlas->partCapacity * sizeof(GRRLIB_texturePart*),
+		                          capacity * sizeof(GRRLIB_texturePart*), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+		if (parts == NULL) {
+			return NULL;
+		}
+		atlas->parts = parts;
+		atlas->partCapacity = capacity;
+	}
+	part = GRRLIB_CreateTexturePartEx(tx * tileW + inset, ty * tileH + inset, w, h, atlas->width, atlas->height);
+	if (part == NULL) {
+		return NULL;
+	}
+
+	if (pageFmt == GX_TF_CMPR) {
+		if (WriteCMPRSlot(atlas, texture, target, tx, ty, slotW, slotH, inset) == false) {
+			GRRLIB_FreeTexturePart(part);
+			return NULL;
+		}
+	}
+	else {
+		const u32 srcRow = ((w + tileW - 1) / tileW) * tileBytes;
+		const u32 dstRow = (atlas->width / tileW) * tileBytes;
+		const u32 rows = (h + tileH - 1) / tileH;
+		u8 *dst = (u8*)target->data + ty * dstRow + tx * tileBytes;
+
+		// Tiles of the image in the format of the page
+		if (texture->fmt == pageFmt) {
+			src = texture->data;
+		}
+		else {
+			u8 *rgba = GRRLIB_MemAlloc(w * h * 4, 32, GRRLIB_MEM_SCRATCH), *p = rgba;
+			u32 x, y;
+
+			converted = GRRLIB_MemAlloc(convertedSize, 32, GRRLIB_MEM_SCRATCH);
+			if (rgba == NULL || converted == NULL) {
+				GRRLIB_MemFree(rgba, w * h * 4);
+				GRRLIB_MemFree(converted, convertedSize);
+				GRRLIB_FreeTexturePart(part);
+				return NULL;
+			}
+			for (y = 0; y < h; y++) {
+				for (x = 0; x < w; x++, p += 4) {
+					const u32 c = GRRLIB_GetPixelFromTexture(x, y, texture);
+
+					p[0] = GRRLIB_R(c);
+					p[1] = GRRLIB_G(c);
+					p[2] = GRRLIB_B(c);
+					p[3] = GRRLIB_A(c);
+				}
+			}
+			GRRLIB_TileImage(rgba, w * 4, GRRLIB_LAYOUT_RGBA, converted, atlas->fmt, w, h);
+			GRRLIB_MemFree(rgba, w * h * 4);
+			src = converted;
+		}
+
+		// Copy the image a row of tiles at a time
+		for (row = 0; row < rows; row++) {
+			memcpy(dst + row * dstRow, src + row * srcRow, srcRow);
+		}
+		GRRLIB_MemFree(converted, convertedSize);
+		FillPadding(atlas, target, tx * tileW, ty * tileH, w, h);
+
+		// The padding above the image is in the rows of tiles above
+		row = (atlas->padding + tileH - 1) / tileH;
+		row = (ty > row) ? ty - row : 0;
+		DCFlushRange((u8*)target->data + row * dstRow, (ty + slotH - row) * dstRow);
+	}
+
+	atlas->parts[atlas->partCount++] = part;
+	atlas->usedPixels += w * h;
+	if (page != NULL) {
+		*page = target;
+	}
+	return part;
+}
+
+/**
+ * Add an image to an atlas.
+ * @param atlas The atlas.
+ * @param my_img The PNG, BMP, JPG or TPL buffer to load.
+ * @param my_size Size of the buffer to load.
+ * @param page Set to the page holding the image, if not NULL.
+ * @return The coordinates of the image in its page, NULL if the image can not be loaded, is larger than a page or memory is missing.
+ *         They are freed by GRRLIB_FreeAtlas.
+ */
+GRRLIB_texturePart*  GRRLIB_AtlasAddImage (GRRLIB_atlas *atlas, const u8 *my_img, const u32 my_size, GRRLIB_texture **page) {
+	GRRLIB_texture *texture = GRRLIB_LoadTextureFmt(my_img, my_size, atlas->fmt);
+	GRRLIB_texturePart *part = NULL;
+
+	if (texture != NULL && texture->data != NULL) {
+		part = GRRLIB_AtlasAddTexture(atlas, texture, page);
+	}
+	GRRLIB_FreeTexture(texture);
+	return part;
+}
+
+/**
+ * Get the fraction of the pages of an atlas covered by images.
+ * @param atlas The atlas.
+ * @return The number of pixels of the images divided by the number of pixels of the pages, 0 without pages.
+ */
+f32  GRRLIB_GetAtlasOccupancy (const GRRLIB_atlas *atlas) {
+	if (atlas->pageCount == 0) {
+		return 0.0f;
+	}
+	return (f32)atlas->usedPixels / ((f32)atlas->pageCount * atlas->width * atlas->height);
+}
+
+/**
+ * Free an atlas, its pages and the coordinates of its images.
+ * If \a atlas is a null pointer, the function does nothing.
+ * @param atlas The atlas.
+ */
+void  GRRLIB_FreeAtlas (GRRLIB_atlas *atlas) {
+	u32 i;
+
+	if (atlas == NULL) {
+		return;
+	}
+	for (i = 0; i < atlas->pageCount; i++) {
+		GRRLIB_FreeTexture(atlas->pages[i]);
+		GRRLIB_MemFree(atlas->packing[i].nodes, atlas->packing[i].capacity * sizeof(GRRLIB_skylineNode));
+	}
+	for (i = 0; i < atlas->partCount; i++) {
+		GRRLIB_FreeTexturePart(atlas->parts[i]);
+	}
+	GRRLIB_MemFree(atlas->pages, atlas->pageCapacity * sizeof(GRRLIB_texture*));
+	GRRLIB_MemFree(atlas->packing, atlas->pageCapacity * sizeof(GRRLIB_atlasPage));
+	GRRLIB_MemFree(atlas->parts, atlas->partCapacity * sizeof(GRRLIB_texturePart*));
+	GRRLIB_MemFree(atlas, sizeof(GRRLIB_atlas));
+}
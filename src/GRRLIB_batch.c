@@ -0,0 +1,204 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+
+#include <math.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define BATCH_MAX_SPRITES (1024) /**< Number of sprites queued before the batch is flushed. */
+
+/**
+ * Structure to hold a sprite transformed on the CPU.
+ */
+typedef  struct GRRLIB_batchSprite {
+	f32  x[4];   /**< X-coordinates of the four corners. */
+	f32  y[4];   /**< Y-coordinates of the four corners. */
+	f32  s1, t1; /**< Texture coordinates of the upper-left corner.  */
+	f32  s2, t2; /**< Texture coordinates of the lower-right corner. */
+	u32  color;  /**< Drawing color of the sprite. */
+} GRRLIB_batchSprite;
+
+/**
+ * Structure to hold a run of consecutive sprites sharing a texture and a blending mode.
+ */
+typedef  struct GRRLIB_batchRun {
+	const GRRLIB_texture  *tex;   /**< Texture used by the run. */
+	GRRLIB_blendMode      blend;  /**< Blending mode used by the run. */
+	u32                   count;  /**< Number of sprites in the run. */
+} GRRLIB_batchRun;
+
+static GRRLIB_batchSprite  batchSprites[BATCH_MAX_SPRITES];
+static GRRLIB_batchRun     batchRuns[BATCH_MAX_SPRITES];
+static u32                 batchSpriteCount = 0;
+static u32                 batchRunCount = 0;
+static bool                batchActive = false;
+
+/**
+ * Start collecting sprites.
+ * Until GRRLIB_SpriteBatchEnd is called, GRRLIB_DrawTexture and GRRLIB_DrawTexturePart are queued
+ * instead of being drawn, and consecutive sprites sharing a texture and a blending mode are sent to GX
+ * as a single run of quads.
+ * Other drawing functions are not queued, call GRRLIB_SpriteBatchFlush before them to keep the drawing order.
+ * Textures must stay valid until the batch is flushed.
+ * @see GRRLIB_SpriteBatchEnd
+ */
+void  GRRLIB_SpriteBatchBegin (void) {
+	batchActive = true;
+}
+
+/**
+ * Queue a part of a texture in the current batch.
+ * The corners are transformed on the CPU, the result matches GRRLIB_DrawTexturePart.
+ * @param xPos Specifies the x-coordinate of the upper-left corner.
+ * @param yPos Specifies the y-coordinate of the upper-left corner.
+ * @param tex The texture to draw.
+ * @param texPart The part of the texture to draw.
+ * @param degrees Angle of rotation.
+ * @param scaleX Specifies the x-coordinate scale. -1 could be used for flipping the texture horizontally.
+ * @param scaleY Specifies the y-coordinate scale. -1 could be used for flipping the texture vertically.
+ * @param offsetX Specifies the x-coordinate offset.
+ * @param offsetY Specifies the y-coordinate offset.
+ */
+void  GRRLIB_SpriteBatchDraw (const f32 xPos, const f32 yPos, const GRRLIB_texture *tex, const GRRLIB_texturePart *texPart, const f32 degrees, const f32 scaleX, const f32 scaleY, const f32 offsetX, const f32 offsetY) {
+	GRRLIB_batchSprite  *sprite;
+	GRRLIB_batchRun     *run;
+	f32  c = 1.0f, s = 0.0f;
+	f32  ax, ay, bx, by;
+	f32  x1, y1, x2, y2;
+
+	if ((tex == NULL) || (texPart == NULL))  return;
+
+	if (batchSpriteCount == BATCH_MAX_SPRITES) {
+		GRRLIB_SpriteBatchFlush();
+	}
+
+	// Start a new run whenever the texture or the blending mode changes
+	run = (batchRunCount > 0) ? &batchRuns[batchRunCount - 1] : NULL;
+	if ((run == NULL) || (run->tex != tex) || (run->blend != GRRLIB_Settings.blend)) {
+		run = &batchRuns[batchRunCount++];
+		run->tex   = tex;
+		run->blend = GRRLIB_Settings.blend;
+		run->count = 0;
+	}
+	run->count++;
+
+	// Same transformation as GRRLIB_DrawTexturePart: translate(offset), scale, rotate, translate(position)
+	if (degrees != 0.0f) {
+		c = cosf(DegToRad(degrees));
+		s = sinf(DegToRad(degrees));
+	}
+	ax =  c * scaleX;
+	ay =  s * scaleX;
+	bx = -s * scaleY;
+	by =  c * scaleY;
+
+	x1 = -offsetX;
+	y1 = -offsetY;
+	x2 = texPart->realWidth  - offsetX;
+	y2 = texPart->realHeight - offsetY;
+
+	sprite = &batchSprites[batchSpriteCount++];
+	sprite->x[0] = ax * x1 + bx * y1 + xPos;
+	sprite->y[0] = ay * x1 + by * y1 + yPos;
+	sprite->x[1] = ax * x2 + bx * y1 + xPos;
+	sprite->y[1] = ay * x2 + by * y1 + yPos;
+	sprite->x[2] = ax * x2 + bx * y2 + xPos;
+	sprite->y[2] = ay * x2 + by * y2 + yPos;
+	sprite->x[3] = ax * x1 + bx * y2 + xPos;
+	sprite->y[3] = ay * x1 + by * y2 + yPos;
+
+	sprite->s1 = texPart->x;
+	sprite->t1 = texPart->y;
+	sprite->s2 = texPart->width;
+	sprite->t2 = texPart->height;
+
+	sprite->color = GRRLIB_Settings.color;
+}
+
+/**
+ * Draw all the sprites queued in the current batch.
+ * The batch stays open, this is called automatically when the batch is full,
+ * when the current matrix or the clipping changes and by GRRLIB_Render.
+ */
+void  GRRLIB_SpriteBatchFlush (void) {
+	const GRRLIB_batchSprite  *sprite = batchSprites;
+	const GRRLIB_blendMode    blend = GRRLIB_Settings.blend;
+	u32  i, j;
+
+	if (batchSpriteCount == 0)  return;
+
+	for (i = 0; i < batchRunCount; i++) {
+		const GRRLIB_batchRun  *run = &batchRuns[i];
+
+		if (GRRLIB_Settings.blend != run->blend) {
+			GRRLIB_SetBlend(run->blend);
+		}
+		GRRLIB_StateTextured2D(&((GRRLIB_texture *) run->tex)->obj, GRRLIB_View2D);
+
+		GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, run->count << 2);
+		for (j = 0; j < run->count; j++, sprite++) {
+			GX_Position3f32(sprite->x[0], sprite->y[0], 0);
+			GX_Color1u32   (sprite->color);
+			GX_TexCoord2f32(sprite->s1, sprite->t1);
+
+			GX_Position3f32(sprite->x[1], sprite->y[1], 0);
+			GX_Color1u32   (sprite->color);
+			GX_TexCoord2f32(sprite->s2, sprite->t1);
+
+			GX_Position3f32(sprite->x[2], sprite->y[2], 0);
+			GX_Color1u32   (sprite->color);
+			GX_TexCoord2f32(sprite->s2, sprite->t2);
+
+			GX_Position3f32(sprite->x[3], sprite->y[3], 0);
+			GX_Color1u32   (sprite->color);
+			GX_TexCoord2f32(sprite->s1, sprite->t2);
+		}
+		GX_End();
+	}
+
+	if (GRRLIB_Settings.blend != blend) {
+		GRRLIB_SetBlend(blend);
+	}
+	GRRLIB_StateLeave();
+
+	batchSpriteCount = 0;
+	batchRunCount = 0;
+}
+
+/**
+ * Draw the sprites queued in the current batch and stop collecting sprites.
+ * @see GRRLIB_SpriteBatchBegin
+ */
+void  GRRLIB_SpriteBatchEnd (void) {
+	GRRLIB_SpriteBatchFlush();
+	batchActive = false;
+}
+
+/**
+ * Check if sprites are being collected.
+ * @return Returns @c true between GRRLIB_SpriteBatchBegin and GRRLIB_SpriteBatchEnd.
+ */
+bool  GRRLIB_SpriteBatchActive (void) {
+	return batchActive;
+}
@@ -24,6 +24,7 @@ THE SOFTWARE.
 #include <string.h>
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 /**
  * Load a ByteMap font structure from a buffer.
@@ -33,7 +34,7 @@ THE SOFTWARE.
  * @see GRRLIB_FreeBMF
  */
 GRRLIB_bytemapFont*  GRRLIB_LoadBMF (const u8 my_bmf[] ) {
-    GRRLIB_bytemapFont *fontArray = (struct GRRLIB_bytemapFont *)malloc(sizeof(GRRLIB_bytemapFont));
+    GRRLIB_bytemapFont *fontArray = (struct GRRLIB_bytemapFont *)GRRLIB_MemCalloc(sizeof(GRRLIB_bytemapFont), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
     u32 i, j = 1;
 
     if (fontArray != NULL && my_bmf[0]==0xE1 && my_bmf[1]==0xE6 && my_bmf[2]==0xD5 && my_bmf[3]==0x1A) {
@@ -47,12 +48,13 @@ GRRLIB_bytemapFont*  GRRLIB_LoadBMF (const u8 my_bmf[] ) {
         //u8 highestcolor = my_bmf[11];
         u8 nbPalette = my_bmf[16];
         short int numcolpal = 3 * nbPalette;
-        fontArray->palette = (u32 *)calloc(nbPalette + 1, sizeof(u32));
+        // Every index a pixel can hold has an entry, the palette is at most 255 colors after the transparent one
+        fontArray->palette = (u32 *)GRRLIB_MemCalloc(256 * sizeof(u32), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
         for (i=0; i < numcolpal; i+=3) {
             fontArray->palette[j++] = ((((my_bmf[i+17]<<2)+3)<<24) | (((my_bmf[i+18]<<2)+3)<<16) | (((my_bmf[i+19]<<2)+3)<<8) | 0xFF);
         }
         j = my_bmf[17 + numcolpal];
-        fontArray->name = (char *)calloc(j + 1, sizeof(char));
+        fontArray->name = (char *)GRRLIB_MemCalloc(j + 1, 1, GRRLIB_MEM_COLD);
         memcpy(fontArray->name, &my_bmf[18 + numcolpal], j);
         j = 18 + numcolpal + j;
         fontArray->nbChar = (my_bmf[j] | my_bmf[j+1]<<8);
@@ -66,7 +68,7 @@ GRRLIB_bytemapFont*  GRRLIB_LoadBMF (const u8 my_bmf[] ) {
             fontArray->charDef[c].rely = my_bmf[++j];
             fontArray->charDef[c].kerning = my_bmf[++j];
             const u16 nbPixels = fontArray->charDef[c].width * fontArray->charDef[c].height;
-            fontArray->charDef[c].data = (u8 *)malloc(nbPixels);
+            fontArray->charDef[c].data = (u8 *)GRRLIB_MemAlloc(nbPixels, 1, GRRLIB_MEM_HOT);
             if (nbPixels > 0 && fontArray->charDef[c].data != NULL) {
                 memcpy(fontArray->charDef[c].data, &my_bmf[++j], nbPixels);
                 j += (nbPixels - 1);
@@ -86,12 +88,14 @@ void  GRRLIB_FreeBMF (GRRLIB_bytemapFont *bmf) {
     if (bmf != NULL) {
         for (u16 i=0; i<256; i++) {
             if (bmf->charDef[i].data != NULL) {
-                free(bmf->charDef[i].data);
+                GRRLIB_MemFree(bmf->charDef[i].data, bmf->charDef[i].width * bmf->charDef[i].height);
             }
         }
-        free(bmf->palette);
-        free(bmf->name);
-        free(bmf);
+        GRRLIB_MemFree(bmf->palette, 256 * sizeof(u32));
+        if (bmf->name != NULL) {
+            GRRLIB_MemFree(bmf->name, strlen(bmf->name) + 1);
+        }
+        GRRLIB_MemFree(bmf, sizeof(GRRLIB_bytemapFont));
     }
 }
 
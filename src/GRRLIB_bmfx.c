@@ -21,12 +21,13 @@ THE SOFTWARE.
 ------------------------------------------------------------------------------*/
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <grrlib-mod.h>
 
 /**
  * Flip texture horizontal.
- * @see GRRLIB_FlushTex
+ * @see GRRLIB_FlushTextureDirty
  * @param texsrc The texture source.
  * @param texdest The texture destination.
  */
@@ -43,7 +44,7 @@ void  GRRLIB_BMFX_FlipH (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest)
 
 /**
  * Flip texture vertical.
- * @see GRRLIB_FlushTex
+ * @see GRRLIB_FlushTextureDirty
  * @param texsrc The texture source.
  * @param texdest The texture destination.
  */
@@ -59,132 +60,337 @@ void  GRRLIB_BMFX_FlipV (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest)
 }
 
 /**
- * Change a texture to gray scale.
- * @see GRRLIB_FlushTex
- * @param texsrc The texture source.
- * @param texdest The texture grayscaled destination.
+ * Color filters applied by PointFilter.
  */
-void  GRRLIB_BMFX_Grayscale (const GRRLIB_texture *texsrc,
-							 GRRLIB_texture *texdest) {
-	unsigned int x, y;
+enum {
+	FILTER_GRAYSCALE,
+	FILTER_SEPIA,
+	FILTER_INVERT,
+};
 
-	for (y = 0; y < texsrc->height; y++) {
-		for (x = 0; x < texsrc->width; x++) {
-			u32 color = GRRLIB_GetPixelFromTexture(x, y, texsrc);
+#define FILTER_CHUNK  (64)  /**< Pixels filtered at a time by PointFilter when the tiles cannot be used directly. */
+
+/**
+ * Filter the color of a pixel, alpha is kept.
+ * The divisions are done as multiplications and shifts, exact for sums of 8-bit components.
+ */
+static inline __attribute__((always_inline))
+void  FilterColor (const u32 filter, u8 *r, u8 *g, u8 *b) {
+	u32 gray, sr, sg, sb;
+
+	switch (filter) {
+		case FILTER_GRAYSCALE:
+			gray = *r * 77 + *g * 150 + *b * 28;
+			gray = (gray + 1 + (gray >> 8)) >> 8;  // gray / 255
+			*r = gray;
+			*g = gray;
+			*b = gray;
+			break;
+		case FILTER_SEPIA:
+			sr = *r * 393 + *g * 769 + *b * 189;
+			sg = *r * 349 + *g * 686 + *b * 168;
+			sb = *r * 272 + *g * 534 + *b * 131;
+			sr = ((sr >> 3) * 33555) >> 22;  // / 1000
+			sg = ((sg >> 3) * 33555) >> 22;
+			sb = ((sb >> 3) * 33555) >> 22;
+			*r = (sr > 255) ? 255 : sr;
+			*g = (sg > 255) ? 255 : sg;
+			*b = sb;
+			break;
+		default:
+			*r = 255 - *r;
+			*g = 255 - *g;
+			*b = 255 - *b;
+	}
+}
 
-			u8 gray = ((GRRLIB_R(color)* 77 +
-						GRRLIB_G(color)*150 +
-						GRRLIB_B(color)* 28 ) / 255);
+/**
+ * Filter the colors of a texture, pixel by pixel.
+ * Between GX_TF_RGBA8 textures of the same size, the tiles are filtered directly, 16 pixels at a time:
+ * red is the second byte of each pair of the first 32 bytes, green and blue the pairs of the next 32 bytes.
+ * Other textures are filtered in runs of pixels read and written with GRRLIB_ReadTextureSpan and GRRLIB_WriteTextureSpan.
+ * Each pixel is read before it is written, so texsrc may be texdest.
+ * Inlined for each filter so that the switch of FilterColor leaves the loops.
+ */
+static inline __attribute__((always_inline))
+void  PointFilter (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest, const u32 filter) {
+	u32 colors[FILTER_CHUNK];
+	u32 tiles, i, x, y, n;
+	const u8 *src;
+	u8 *dst, r, g, b;
 
-			GRRLIB_SetPixelToTexture(x, y, texdest,
-				(gray << 24) | (gray << 16) | (gray << 8) | (GRRLIB_A(color)));
+	if (texsrc->fmt == GX_TF_RGBA8 && texdest->fmt == GX_TF_RGBA8 &&
+	    texsrc->width == texdest->width && texsrc->height == texdest->height) {
+		tiles = ((texsrc->width + 3) >> 2) * ((texsrc->height + 3) >> 2);
+		src = texsrc->data;
+		dst = texdest->data;
+		for (; tiles > 0; tiles--, src += 64, dst += 64) {
+			for (i = 0; i < 32; i += 2) {
+				r = src[i + 1];
+				g = src[i + 32];
+				b = src[i + 33];
+				FilterColor(filter, &r, &g, &b);
+				dst[i] = src[i];
+				dst[i + 1] = r;
+				dst[i + 32] = g;
+				dst[i + 33] = b;
+			}
+		}
+		GRRLIB_MarkTextureDirty(texdest, 0, 0, texdest->width, texdest->height);
+		return;
+	}
+
+	for (y = 0; y < texsrc->height; y++) {
+		for (x = 0; x < texsrc->width; x += n) {
+			n = (texsrc->width - x < FILTER_CHUNK) ? texsrc->width - x : FILTER_CHUNK;
+			GRRLIB_ReadTextureSpan(texsrc, x, y, n, colors);
+			for (i = 0; i < n; i++) {
+				r = GRRLIB_R(colors[i]);
+				g = GRRLIB_G(colors[i]);
+				b = GRRLIB_B(colors[i]);
+				FilterColor(filter, &r, &g, &b);
+				colors[i] = GRRLIB_RGBA(r, g, b, GRRLIB_A(colors[i]));
+			}
+			GRRLIB_WriteTextureSpan(texdest, x, y, n, colors);
 		}
 	}
 }
 
+/**
+ * Change a texture to gray scale.
+ * The gray level is (77 * red + 150 * green + 28 * blue) / 255, alpha is kept.
+ * @see GRRLIB_FlushTextureDirty
+ * @param texsrc The texture source.
+ * @param texdest The texture grayscaled destination, may be texsrc.
+ */
+void  GRRLIB_BMFX_Grayscale (const GRRLIB_texture *texsrc,
+							 GRRLIB_texture *texdest) {
+	PointFilter(texsrc, texdest, FILTER_GRAYSCALE);
+}
+
 /**
  * Change a texture to sepia (old photo style).
- * @see GRRLIB_FlushTex
+ * The components are mixed with weights in thousandths and the sums rounded down, alpha is kept.
+ * These are the weights the filter always used, but computed in integers: colors whose mix is a whole number
+ * now give it, where floating point used to give one less (about 1 color in 20000).
+ * @see GRRLIB_FlushTextureDirty
  * @param texsrc The texture source.
- * @param texdest The texture destination.
+ * @param texdest The texture destination, may be texsrc.
  * @author elisherer
  */
 void  GRRLIB_BMFX_Sepia (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest) {
-	unsigned int  x, y;
-	u16           sr, sg, sb;
-	u32           color;
+	PointFilter(texsrc, texdest, FILTER_SEPIA);
+}
 
-	for (y = 0; y < texsrc->height; y++) {
-		for (x = 0; x < texsrc->width; x++) {
-			color = GRRLIB_GetPixelFromTexture(x, y, texsrc);
-			sr = GRRLIB_R(color)*0.393 + GRRLIB_G(color)*0.769 + GRRLIB_B(color)*0.189;
-			sg = GRRLIB_R(color)*0.349 + GRRLIB_G(color)*0.686 + GRRLIB_B(color)*0.168;
-			sb = GRRLIB_R(color)*0.272 + GRRLIB_G(color)*0.534 + GRRLIB_B(color)*0.131;
-			if (sr>255) sr=255;
-			if (sg>255) sg=255;
-			GRRLIB_SetPixelToTexture(x, y, texdest,
-									GRRLIB_RGBA(sr, sg, sb, GRRLIB_A(color)));
+/**
+ * Invert colors of the texture, alpha is kept.
+ * @see GRRLIB_FlushTextureDirty
+ * @param texsrc The texture source.
+ * @param texdest The texture destination, may be texsrc.
+ */
+void  GRRLIB_BMFX_Invert (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest) {
+	PointFilter(texsrc, texdest, FILTER_INVERT);
+}
+
+/**
+ * Scratch memory of a running-sum blur, see BoxBlur.
+ */
+typedef  struct GRRLIB_blurState {
+	const GRRLIB_texture  *src;     /**< The texture the rows are read from. */
+	u32                    width;   /**< Width of the blurred area. */
+	u32                    height;  /**< Height of the blurred area. */
+	u32                    radius;  /**< Pixels on each side of the center of the window. */
+	bool                   clamp;   /**< Samples outside of the texture repeat its edges, else they are left out of the sums. */
+	u32                   *ring;    /**< The last source rows read, row r at (r % ringRows) * width. */
+	u32                    ringRows;/**< Number of rows held by ring. */
+	u32                    loaded;  /**< Number of source rows read. */
+	u32                   *hsum;    /**< Red, green, blue and alpha sums of a row of windows. */
+	u32                   *vsum;    /**< Red, green, blue and alpha sums of the windows of the current row. */
+	u32                   *out;     /**< A row of blurred colors. */
+} GRRLIB_blurState;
+
+/**
+ * Return a source row, reading the rows up to it.
+ * The window never spans more rows than the ring holds, so a row is read once even when blurring in place.
+ */
+static const u32*  BlurRow (GRRLIB_blurState *st, const u32 row) {
+	for (; st->loaded <= row; st->loaded++) {
+		GRRLIB_ReadTextureSpan(st->src, 0, st->loaded, st->width, &st->ring[(st->loaded % st->ringRows) * st->width]);
+	}
+	return &st->ring[(row % st->ringRows) * st->width];
+}
+
+/**
+ * Sum the windows of a row of pixels, running from left to right.
+ * @param st The blur.
+ * @param p The colors of the row.
+ */
+static void  BlurSumRow (GRRLIB_blurState *st, const u32 *p) {
+	const s32 w = st->width, r = st->radius;
+	u32 sr = 0, sg = 0, sb = 0, sa = 0, c;
+	u32 *hs = st->hsum;
+	s32 k, x;
+
+	for (k = -r; k <= r; k++) {
+		if (k >= 0 && k < w) {
+			c = p[k];
+		}
+		else if (st->clamp == true) {
+			c = p[(k < 0) ? 0 : w - 1];
+		}
+		else {
+			continue;
+		}
+		sr += c >> 24;  sg += (c >> 16) & 0xFF;  sb += (c >> 8) & 0xFF;  sa += c & 0xFF;
+	}
+	for (x = 0; x < w; x++, hs += 4) {
+		hs[0] = sr;  hs[1] = sg;  hs[2] = sb;  hs[3] = sa;
+		// Slide: x + r + 1 enters the window, x - r leaves it
+		if (x + r + 1 < w || st->clamp == true) {
+			c = p[(x + r + 1 < w) ? x + r + 1 : w - 1];
+			sr += c >> 24;  sg += (c >> 16) & 0xFF;  sb += (c >> 8) & 0xFF;  sa += c & 0xFF;
+		}
+		if (x - r >= 0 || st->clamp == true) {
+			c = p[(x - r >= 0) ? x - r : 0];
+			sr -= c >> 24;  sg -= (c >> 16) & 0xFF;  sb -= (c >> 8) & 0xFF;  sa -= c & 0xFF;
 		}
 	}
 }
+
 /**
- * Invert colors of the texture.
- * @see GRRLIB_FlushTex
+ * Add or remove the row sums of a source row to the window sums.
+ * @param st The blur.
+ * @param row The source row, outside of the texture it is clamped or left out.
+ * @param add @c true to add the row, @c false to remove it.
+ */
+static void  BlurSlide (GRRLIB_blurState *st, s32 row, const bool add) {
+	u32 i;
+
+	if (row < 0 || row >= (s32)st->height) {
+		if (st->clamp == false) {
+			return;
+		}
+		row = (row < 0) ? 0 : st->height - 1;
+	}
+	BlurSumRow(st, BlurRow(st, row));
+	for (i = 0; i < st->width * 4; i++) {
+		st->vsum[i] = add ? st->vsum[i] + st->hsum[i] : st->vsum[i] - st->hsum[i];
+	}
+}
+
+/**
+ * Blur a texture with a square window, as a horizontal then vertical running sum.
+ * Each pixel costs the same whatever the radius. Rows go through GRRLIB_ReadTextureSpan and GRRLIB_WriteTextureSpan,
+ * and the scratch memory holds 2 * radius + 2 rows of the source at most, which allows blurring in place.
  * @param texsrc The texture source.
- * @param texdest The texture destination.
+ * @param texdest The texture destination, may be texsrc.
+ * @param radius Pixels on each side of the center of the window.
+ * @param clamp @c true to repeat the edges of the texture and round the averages,
+ *              @c false for GRRLIB_BMFX_Blur: samples outside of the texture take the color of the center, averages are truncated.
+ * @return @c false if memory is missing.
  */
-void  GRRLIB_BMFX_Invert (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest) {
-	unsigned int x, y;
-	u32 color;
+static bool  BoxBlur (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest, const u32 radius, const bool clamp) {
+	GRRLIB_blurState st;
+	const u32 n = (2 * radius + 1) * (2 * radius + 1);
+	u32 size, x, y, c, fill, cx, cy;
+	const u32 *center;
+	s32 k;
 
-	for (y = 0; y < texsrc->height; y++) {
-		for (x = 0; x < texsrc->width; x++) {
-			color = GRRLIB_GetPixelFromTexture(x, y, texsrc);
-			GRRLIB_SetPixelToTexture(x, y, texdest,
-				((0xFFFFFF - (color >> 8 & 0xFFFFFF)) << 8)  | (color & 0xFF));
+	st.src = texsrc;
+	st.width = texsrc->width;
+	st.height = texsrc->height;
+	st.radius = radius;
+	st.clamp = clamp;
+	st.ringRows = (2 * radius + 2 < st.height) ? 2 * radius + 2 : st.height;
+	st.loaded = 0;
+	if (st.width == 0 || st.height == 0) {
+		return true;
+	}
+	size = (st.ringRows + 9) * st.width * sizeof(u32);
+	st.ring = GRRLIB_MemAlloc(size, 32, GRRLIB_MEM_SCRATCH);
+	if (st.ring == NULL) {
+		return false;
+	}
+	st.hsum = st.ring + st.ringRows * st.width;
+	st.vsum = st.hsum + 4 * st.width;
+	st.out = st.vsum + 4 * st.width;
+
+	memset(st.vsum, 0, 4 * st.width * sizeof(u32));
+	for (k = -(s32)radius; k <= (s32)radius; k++) {
+		BlurSlide(&st, k, true);
+	}
+	for (y = 0; y < st.height; y++) {
+		const u32 *vs = st.vsum;
+
+		if (clamp == true) {
+			for (x = 0; x < st.width; x++, vs += 4) {
+				st.out[x] = GRRLIB_RGBA((vs[0] + n / 2) / n, (vs[1] + n / 2) / n, (vs[2] + n / 2) / n, (vs[3] + n / 2) / n);
+			}
 		}
+		else {
+			// The samples outside of the texture count as many times the center
+			center = BlurRow(&st, y);
+			cy = ((y + radius < st.height) ? y + radius : st.height - 1) - ((y > radius) ? y - radius : 0) + 1;
+			for (x = 0; x < st.width; x++, vs += 4) {
+				cx = ((x + radius < st.width) ? x + radius : st.width - 1) - ((x > radius) ? x - radius : 0) + 1;
+				fill = n - cx * cy;
+				c = center[x];
+				st.out[x] = GRRLIB_RGBA((vs[0] + fill * GRRLIB_R(c)) / n, (vs[1] + fill * GRRLIB_G(c)) / n,
+				                        (vs[2] + fill * GRRLIB_B(c)) / n, (vs[3] + fill * GRRLIB_A(c)) / n);
+			}
+		}
+		// Source rows up to y + radius are read before row y is written
+		BlurSlide(&st, y + radius + 1, true);
+		BlurSlide(&st, (s32)y - (s32)radius, false);
+		GRRLIB_WriteTextureSpan(texdest, 0, y, st.width, st.out);
 	}
+	GRRLIB_MemFree(st.ring, size);
+	return true;
 }
 
 /**
  * A texture effect (Blur).
- * @see GRRLIB_FlushTex
+ * Every pixel becomes the average of the (2 * factor + 1)^2 pixels around it.
+ * Pixels outside of the texture count as the pixel in the center.
+ * The cost of a pixel does not depend on the factor. Nothing is done if memory is missing.
+ * @see GRRLIB_BMFX_BoxBlur
+ * @see GRRLIB_FlushTextureDirty
  * @param texsrc The texture source.
- * @param texdest The texture destination.
+ * @param texdest The texture destination, may be texsrc.
  * @param factor The blur factor.
  */
 void  GRRLIB_BMFX_Blur (const GRRLIB_texture *texsrc,
 							  GRRLIB_texture *texdest, const u32 factor) {
-	int numba = (1+(factor<<1))*(1+(factor<<1));
-	u32 x, y;
-	s32 k, l;
-	int tmp;
-	int newr, newg, newb, newa;
-	u32 colours[numba];
-	u32 thiscol;
-
-	for (x = 0; x < texsrc->width; x++) {
-		for (y = 0; y < texsrc->height; y++) {
-			newr = 0;
-			newg = 0;
-			newb = 0;
-			newa = 0;
-
-			tmp = 0;
-			thiscol = GRRLIB_GetPixelFromTexture(x, y, texsrc);
-
-			for (k = x - factor; k <= x + factor; k++) {
-				for (l = y - factor; l <= y + factor; l++) {
-					if (k < 0 || k >= texsrc->width || l < 0 || l >= texsrc->height) {
-						colours[tmp] = thiscol;
-					}
-					else {
-						colours[tmp] = GRRLIB_GetPixelFromTexture(k, l, texsrc);
-					}
-					tmp++;
-				}
-			}
-
-			for (tmp = 0; tmp < numba; tmp++) {
-				newr += (colours[tmp] >> 24) & 0xFF;
-				newg += (colours[tmp] >> 16) & 0xFF;
-				newb += (colours[tmp] >> 8) & 0xFF;
-				newa += colours[tmp] & 0xFF;
-			}
+	BoxBlur(texsrc, texdest, factor, false);
+}
 
-			newr /= numba;
-			newg /= numba;
-			newb /= numba;
-			newa /= numba;
+/**
+ * Blur a texture with a box filter, repeating its edges.
+ * Every pixel becomes the rounded average of the (2 * radius + 1)^2 pixels around it, for each pass.
+ * Three passes approximate a Gaussian blur of standard deviation sqrt(radius * (radius + 1)).
+ * The cost of a pixel does not depend on the radius.
+ * @see GRRLIB_FlushTextureDirty
+ * @param texsrc The texture source.
+ * @param texdest The texture destination, may be texsrc.
+ * @param radius Pixels on each side of the center of the box.
+ * @param passes Number of times the box filter is applied, the passes after the first one blur texdest in place.
+ * @return @c false if memory is missing.
+ */
+bool  GRRLIB_BMFX_BoxBlur (const GRRLIB_texture *texsrc, GRRLIB_texture *texdest,
+                           const u32 radius, const u32 passes) {
+	u32 i;
 
-			GRRLIB_SetPixelToTexture(x, y, texdest, (newr<<24) | (newg<<16) | (newb<<8) | newa);
+	for (i = 0; i < passes; i++) {
+		if (BoxBlur((i == 0) ? texsrc : texdest, texdest, radius, true) == false) {
+			return false;
 		}
 	}
+	return true;
 }
 
 /**
  * A texture effect (Scatter).
- * @see GRRLIB_FlushTex
+ * @see GRRLIB_FlushTextureDirty
  * @param texsrc The texture source.
  * @param texdest The texture destination.
  * @param factor The factor level of the effect.
@@ -215,7 +421,7 @@ void  GRRLIB_BMFX_Scatter (const GRRLIB_texture *texsrc,
 
 /**
  * A texture effect (Pixelate).
- * @see GRRLIB_FlushTex
+ * @see GRRLIB_FlushTextureDirty
  * @param texsrc The texture source.
  * @param texdest The texture destination.
  * @param factor The factor level of the effect.
@@ -0,0 +1,475 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * This structure contains information about the type, size, and layout of a file that containing a device-independent bitmap (DIB).
+ */
+typedef  struct tagBITMAPFILEHEADER {
+	u16 bfType;             /**< Specifies the file type. It must be set to the signature word BM (0x4D42) to indicate bitmap. */
+	u32 bfSize;             /**< Specifies the size, in bytes, of the bitmap file. */
+	u16 bfReserved1;        /**< Reserved; set to zero. */
+	u16 bfReserved2;        /**< Reserved; set to zero. */
+	u32 bfOffBits;          /**< Specifies the offset, in bytes, from the BITMAPFILEHEADER structure to the bitmap bits. */
+} BITMAPFILEHEADER;
+/**
+ * This structure contains information about the dimensions and color format of a device-independent bitmap (DIB).
+ */
+typedef  struct tagBITMAPINFOHEADER {
+	u32 biSize;             /**< Specifies the size of the structure, in bytes. */
+	s32 biWidth;            /**< Specifies the width of the bitmap, in pixels. */
+	s32 biHeight;           /**< Specifies the height of the bitmap, in pixels. Negative for a top-down bitmap. */
+	u16 biPlanes;           /**< Specifies the number of planes for the target device. */
+	u16 biBitCount;         /**< Specifies the number of bits per pixel. */
+	u32 biCompression;      /**< Specifies the type of compression for a compressed bottom-up bitmap.*/
+	u32 biSizeImage;        /**< Specifies the size, in bytes, of the image. */
+	u32 biXPelsPerMeter;    /**< Specifies the horizontal resolution, in pixels per meter, of the target device for the bitmap. */
+	u32 biYPelsPerMeter;    /**< Specifies the vertical resolution, in pixels per meter, of the target device for the bitmap. */
+	u32 biClrUsed;          /**< Specifies the number of color indexes in the color table that are actually used by the bitmap. */
+	u32 biClrImportant;     /**< Specifies the number of color indexes required for displaying the bitmap. */
+} BITMAPINFOHEADER;
+
+#define BI_RGB             (0)  /**< Uncompressed pixels. */
+#define BI_RLE8            (1)  /**< 8-bit run-length encoded pixels. */
+#define BI_RLE4            (2)  /**< 4-bit run-length encoded pixels. */
+#define BI_BITFIELDS       (3)  /**< 16 or 32-bit pixels with color masks. */
+#define BI_ALPHABITFIELDS  (6)  /**< 16 or 32-bit pixels with color and alpha masks. */
+
+#define BMP_MAX_SIZE  (16384)  /**< Largest width and height, keeping the size of the pixels in 32 bits. */
+
+/**
+ * Read a little-endian 16-bit value.
+ * @param p The first byte.
+ * @return The value.
+ */
+static inline u16  BMPRead16 (const u8 *p) {
+	return p[0] | p[1] << 8;
+}
+
+/**
+ * Read a little-endian 32-bit value.
+ * @param p The first byte.
+ * @return The value.
+ */
+static inline u32  BMPRead32 (const u8 *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+/**
+ * Check that a part of the file is in the buffer.
+ * @param p The first byte of the part.
+ * @param size Size of the part in bytes.
+ * @param end End of the buffer, NULL if the size is not known.
+ * @return @c true if the part is in the buffer or the size of the buffer is not known.
+ */
+static inline bool  BMPInBuffer (const u8 *p, const u64 size, const u8 *end) {
+	return end == NULL || (p <= end && size <= (u64)(end - p));
+}
+
+/**
+ * Prepare the conversion of one channel of bitfield pixels to 8 bits.
+ * @param bmp The decoder.
+ * @param c The channel: 0 for blue, 1 for green, 2 for red, 3 for alpha.
+ * @param mask The mask of the channel in a pixel, 0 if the pixels do not have it.
+ */
+static void  BMPSetMask (GRRLIB_bmpDecoder *bmp, const u32 c, u32 mask) {
+	u32 shift = 0, bits = 0;
+
+	if (mask == 0) {
+		bmp->shift[c] = 0;
+		bmp->max[c] = 0;
+		bmp->mul[c] = 0;
+		bmp->bias[c] = (c == 3) ? 0xFF << 16 : 0;  // Opaque, black
+		return;
+	}
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		shift++;
+	}
+	while (bits < 32 && (mask >> bits) != 0) {
+		bits++;
+	}
+	if (bits > 8) {  // Only the 8 high bits are kept
+		shift += bits - 8;
+		bits = 8;
+	}
+	bmp->shift[c] = shift;
+	bmp->max[c] = (1 << bits) - 1;
+	bmp->mul[c] = ((0xFF << 16) + bmp->max[c] / 2) / bmp->max[c];
+	bmp->bias[c] = 0x8000;
+}
+
+/**
+ * Mark pixels left undefined by a run-length encoded bitmap, they are transparent.
+ * @param bmp The decoder.
+ * @param from First pixel, counted from the start of the bottom row.
+ * @param to End of the pixels, counted from the start of the bottom row.
+ * @return @c false if memory is missing.
+ */
+static bool  BMPSkipPixels (GRRLIB_bmpDecoder *bmp, u32 from, u32 to) {
+	const u32 count = bmp->width * bmp->height;
+
+	if (to > count) {
+		to = count;
+	}
+	if (from >= to) {
+		return true;
+	}
+	if (bmp->skipped == NULL) {
+		bmp->skipped = GRRLIB_MemCalloc((count + 7) >> 3, 1, GRRLIB_MEM_SCRATCH);
+		if (bmp->skipped == NULL) {
+			return false;
+		}
+	}
+	for (; from < to; from++) {
+		bmp->skipped[from >> 3] |= 0x80 >> (from & 7);
+	}
+	return true;
+}
+
+/**
+ * Decode run-length encoded pixels to one palette index per pixel, bottom-up.
+ * @param bmp The decoder, its width, height and compression are set.
+ * @param p The first byte of the pixels.
+ * @param end End of the buffer, NULL if the size is not known.
+ * @return @c false if the data is damaged or memory is missing.
+ */
+static bool  BMPDecodeRLE (GRRLIB_bmpDecoder *bmp, const u8 *p, const u8 *end) {
+	const u32 width = bmp->width, height = bmp->height;
+	const bool rle4 = bmp->compression == BI_RLE4;
+	u32 x = 0, y = 0, i;
+
+	bmp->indices = GRRLIB_MemCalloc(width * height, 1, GRRLIB_MEM_SCRATCH);
+	if (bmp->indices == NULL) {
+		return false;
+	}
+	while (y < height) {
+		u8 *row = &bmp->indices[y * width];
+		u32 count;
+
+		if (BMPInBuffer(p, 2, end) == false) {
+			return false;
+		}
+		count = p[0];
+		if (count != 0) {  // Run of one index, or two alternating indexes for RLE4
+			const u8 value = p[1];
+
+			for (i = 0; i < count && x < width; i++, x++) {
+				row[x] = rle4 ? ((i & 1) ? value & 0x0F : value >> 4) : value;
+			}
+			x += count - i;
+			p += 2;
+			continue;
+		}
+		switch (p[1]) {
+			case 0:  // End of line
+				if (BMPSkipPixels(bmp, y * width + (x < width ? x : width), (y + 1) * width) == false) {
+					return false;
+				}
+				x = 0;
+				y++;
+				p += 2;
+				break;
+			case 1:  // End of bitmap
+				return BMPSkipPixels(bmp, y * width + (x < width ? x : width), width * height);
+			case 2:  // Delta
+				if (BMPInBuffer(p, 4, end) == false) {
+					return false;
+				}
+				if (BMPSkipPixels(bmp, y * width + (x < width ? x : width), (y + p[3]) * width + x + p[2]) == false) {
+					return false;
+				}
+				x += p[2];
+				y += p[3];
+				p += 4;
+				break;
+			default: {  // Absolute run of indexes, padded to 16 bits
+				const u32 bytes = rle4 ? (p[1] + 1) >> 1 : p[1];
+
+				count = p[1];
+				p += 2;
+				if (BMPInBuffer(p, bytes, end) == false) {
+					return false;
+				}
+				for (i = 0; i < count && x < width; i++, x++) {
+					row[x] = rle4 ? ((i & 1) ? p[i >> 1] & 0x0F : p[i >> 1] >> 4) : p[i];
+				}
+				x += count - i;
+				p += (bytes + 1) & ~1;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Parse the headers of a bitmap and prepare the decoding of its rows.
+ * Supports Windows (BITMAPINFOHEADER to BITMAPV5HEADER) and OS/2 1.x bitmaps of 1, 4, 8, 16, 24 and 32 bits per pixel,
+ * bottom-up or top-down, uncompressed, run-length encoded (BI_RLE4, BI_RLE8) or with color masks (BI_BITFIELDS, BI_ALPHABITFIELDS).
+ * The fourth byte of uncompressed 32-bit pixels is read as alpha.
+ * @param bmp The decoder to prepare, GRRLIB_BMPClose must be called when it returns @c true.
+ * @param my_bmp The bitmap buffer.
+ * @param my_end End of the buffer, NULL if the size is not known.
+ * @return @c true on success, @c false if the bitmap is not supported, damaged or memory is missing.
+ */
+bool  GRRLIB_BMPOpen (GRRLIB_bmpDecoder *bmp, const u8 *my_bmp, const u8 *my_end) {
+	BITMAPFILEHEADER MyBitmapFileHeader;
+	BITMAPINFOHEADER MyBitmapHeader;
+	const u8 *palette, *pixels;
+	u32 masks = 0, entrySize = 4, colors, i;
+
+	memset(bmp, 0, sizeof(GRRLIB_bmpDecoder));
+	if (BMPInBuffer(my_bmp, 18, my_end) == false) {
+		return false;
+	}
+	// Fill file header structure
+	MyBitmapFileHeader.bfType    = BMPRead16(&my_bmp[0]);
+	MyBitmapFileHeader.bfSize    = BMPRead32(&my_bmp[2]);
+	MyBitmapFileHeader.bfOffBits = BMPRead32(&my_bmp[10]);
+	MyBitmapHeader.biSize        = BMPRead32(&my_bmp[14]);
+	if (MyBitmapFileHeader.bfType != 0x4D42 ||
+	    (MyBitmapHeader.biSize != 12 && MyBitmapHeader.biSize < 40) ||
+	    BMPInBuffer(my_bmp, 14 + (u64)MyBitmapHeader.biSize, my_end) == false) {
+		return false;
+	}
+	// Fill the bitmap structure
+	memset(&MyBitmapHeader.biWidth, 0, sizeof(BITMAPINFOHEADER) - sizeof(u32));
+	if (MyBitmapHeader.biSize == 12) {  // OS/2 BITMAPCOREHEADER
+		MyBitmapHeader.biWidth       = BMPRead16(&my_bmp[18]);
+		MyBitmapHeader.biHeight      = BMPRead16(&my_bmp[20]);
+		MyBitmapHeader.biPlanes      = BMPRead16(&my_bmp[22]);
+		MyBitmapHeader.biBitCount    = BMPRead16(&my_bmp[24]);
+		entrySize = 3;
+	}
+	else {
+		MyBitmapHeader.biWidth       = (s32)BMPRead32(&my_bmp[18]);
+		MyBitmapHeader.biHeight      = (s32)BMPRead32(&my_bmp[22]);
+		MyBitmapHeader.biPlanes      = BMPRead16(&my_bmp[26]);
+		MyBitmapHeader.biBitCount    = BMPRead16(&my_bmp[28]);
+		MyBitmapHeader.biCompression = BMPRead32(&my_bmp[30]);
+		MyBitmapHeader.biSizeImage   = BMPRead32(&my_bmp[34]);
+		MyBitmapHeader.biClrUsed     = BMPRead32(&my_bmp[46]);
+	}
+
+	bmp->width = MyBitmapHeader.biWidth;
+	bmp->height = (MyBitmapHeader.biHeight < 0) ? -MyBitmapHeader.biHeight : MyBitmapHeader.biHeight;
+	bmp->bits = MyBitmapHeader.biBitCount;
+	bmp->compression = MyBitmapHeader.biCompression;
+	if (MyBitmapHeader.biWidth <= 0 || MyBitmapHeader.biWidth > BMP_MAX_SIZE ||
+	    MyBitmapHeader.biHeight == 0 || bmp->height > BMP_MAX_SIZE) {
+		return false;
+	}
+	switch (bmp->compression) {
+		case BI_RGB:
+			if (bmp->bits != 1 && bmp->bits != 4 && bmp->bits != 8 && bmp->bits != 16 && bmp->bits != 24 && bmp->bits != 32) {
+				return false;
+			}
+			break;
+		case BI_RLE8:
+		case BI_RLE4:
+			if (bmp->bits != ((bmp->compression == BI_RLE8) ? 8 : 4) || MyBitmapHeader.biHeight < 0) {
+				return false;
+			}
+			break;
+		case BI_BITFIELDS:
+		case BI_ALPHABITFIELDS:
+			if (bmp->bits != 16 && bmp->bits != 32) {
+				return false;
+			}
+			// Masks follow a BITMAPINFOHEADER, later headers contain them
+			masks = (MyBitmapHeader.biSize > 40) ? 14 + 40 : 14 + MyBitmapHeader.biSize;
+			if (BMPInBuffer(my_bmp, masks + 16, my_end) == false) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+	}
+
+	// The palette, stored as BGRA
+	palette = &my_bmp[14 + MyBitmapHeader.biSize];
+	if (masks != 0 && MyBitmapHeader.biSize == 40) {
+		palette += (bmp->compression == BI_ALPHABITFIELDS) ? 16 : 12;
+	}
+	colors = (bmp->bits <= 8) ? 1 << bmp->bits : 0;
+	if (MyBitmapHeader.biClrUsed != 0 && MyBitmapHeader.biClrUsed < colors) {
+		colors = MyBitmapHeader.biClrUsed;
+	}
+	if (BMPInBuffer(palette, colors * entrySize, my_end) == false) {
+		return false;
+	}
+	for (i = 0; i < colors; i++) {
+		bmp->palette[i][0] = palette[i * entrySize];
+		bmp->palette[i][1] = palette[i * entrySize + 1];
+		bmp->palette[i][2] = palette[i * entrySize + 2];
+		bmp->palette[i][3] = 0xFF;
+	}
+	for (; i < 256; i++) {  // Indexes past the palette are black
+		bmp->palette[i][0] = bmp->palette[i][1] = bmp->palette[i][2] = 0;
+		bmp->palette[i][3] = 0xFF;
+	}
+
+	pixels = (MyBitmapFileHeader.bfOffBits != 0) ? &my_bmp[MyBitmapFileHeader.bfOffBits] : palette + colors * entrySize;
+	if (bmp->compression == BI_RLE8 || bmp->compression == BI_RLE4) {
+		if (BMPDecodeRLE(bmp, pixels, my_end) == false) {
+			GRRLIB_BMPClose(bmp);
+			return false;
+		}
+		bmp->stride = -(s32)bmp->width;
+		bmp->top = bmp->indices + (bmp->height - 1) * bmp->width;
+		return true;
+	}
+
+	bmp->stride = ((bmp->width * bmp->bits + 31) >> 3) & ~3;  // Rows are padded to 4 bytes
+	if (BMPInBuffer(pixels, (u64)bmp->stride * bmp->height, my_end) == false) {
+		return false;
+	}
+	if (MyBitmapHeader.biHeight > 0) {  // Bottom-up
+		bmp->top = pixels + (bmp->height - 1) * bmp->stride;
+		bmp->stride = -bmp->stride;
+	}
+	else {
+		bmp->top = pixels;
+	}
+
+	if (masks != 0) {
+		const u32 red = BMPRead32(&my_bmp[masks]), green = BMPRead32(&my_bmp[masks + 4]), blue = BMPRead32(&my_bmp[masks + 8]);
+		const u32 alpha = (bmp->compression == BI_ALPHABITFIELDS || MyBitmapHeader.biSize >= 56) ? BMPRead32(&my_bmp[masks + 12]) : 0;
+
+		BMPSetMask(bmp, 0, blue);
+		BMPSetMask(bmp, 1, green);
+		BMPSetMask(bmp, 2, red);
+		BMPSetMask(bmp, 3, alpha);
+		if (bmp->bits == 32 && red == 0x00FF0000 && green == 0x0000FF00 && blue == 0x000000FF && alpha == 0xFF000000) {
+			bmp->direct = true;
+			bmp->layout = GRRLIB_LAYOUT_BGRA;
+		}
+	}
+	else if (bmp->bits == 16) {  // 5 bits per color
+		BMPSetMask(bmp, 0, 0x001F);
+		BMPSetMask(bmp, 1, 0x03E0);
+		BMPSetMask(bmp, 2, 0x7C00);
+		BMPSetMask(bmp, 3, 0);
+	}
+	else if (bmp->bits >= 24) {
+		bmp->direct = true;
+		bmp->layout = (bmp->bits == 32) ? GRRLIB_LAYOUT_BGRA : GRRLIB_LAYOUT_BGR;
+	}
+	return true;
+}
+
+/**
+ * Get rows of a bitmap, from the top.
+ * Rows of 24 and 32-bit bitmaps are usually given as they are stored, others are converted to the buffer.
+ * @param bmp The decoder.
+ * @param y First row.
+ * @param rows Number of rows.
+ * @param buffer Room for the rows converted to 4 bytes per pixel, not used when @c bmp->direct is set.
+ * @param stride Set to the distance between two rows in bytes.
+ * @param layout Set to the layout of the pixels.
+ * @return The first pixel of the first row.
+ */
+const u8*  GRRLIB_BMPReadRows (const GRRLIB_bmpDecoder *bmp, const u32 y, const u32 rows, u8 *buffer,
+                               s32 *stride, GRRLIB_pixelLayout *layout) {
+	const u32 width = bmp->width;
+	const u8 (*palette)[4] = bmp->palette;
+	u32 r, x;
+
+	if (bmp->direct == true) {
+		*stride = bmp->stride;
+		*layout = bmp->layout;
+		return bmp->top + (s32)y * bmp->stride;
+	}
+
+	*stride = width * 4;
+	*layout = GRRLIB_LAYOUT_BGRA;
+	for (r = 0; r < rows; r++) {
+		const u8 *src = bmp->top + (s32)(y + r) * bmp->stride;
+		u8 *dst = &buffer[r * width * 4];
+
+		if (bmp->indices != NULL) {  // Run-length encoded
+			const u32 start = (bmp->height - 1 - y - r) * width;
+
+			for (x = 0; x < width; x++) {
+				memcpy(&dst[x * 4], palette[src[x]], 4);
+			}
+			if (bmp->skipped != NULL) {
+				for (x = 0; x < width; x++) {
+					if (bmp->skipped[(start + x) >> 3] & (0x80 >> ((start + x) & 7))) {
+						memset(&dst[x * 4], 0, 4);
+					}
+				}
+			}
+			continue;
+		}
+		switch (bmp->bits) {
+			case 1:
+				for (x = 0; x < width; x++) {
+					memcpy(&dst[x * 4], palette[(src[x >> 3] >> (7 - (x & 7))) & 1], 4);
+				}
+				break;
+			case 4:
+				for (x = 0; x + 1 < width; x += 2) {
+					memcpy(&dst[x * 4], palette[src[x >> 1] >> 4], 4);
+					memcpy(&dst[x * 4 + 4], palette[src[x >> 1] & 0x0F], 4);
+				}
+				if (x < width) {
+					memcpy(&dst[x * 4], palette[src[x >> 1] >> 4], 4);
+				}
+				break;
+			case 8:
+				for (x = 0; x < width; x++) {
+					memcpy(&dst[x * 4], palette[src[x]], 4);
+				}
+				break;
+			default: {  // Color masks
+				const u32 bpp = bmp->bits >> 3;
+				u32 c;
+
+				for (x = 0; x < width; x++, src += bpp, dst += 4) {
+					const u32 pixel = (bpp == 2) ? BMPRead16(src) : BMPRead32(src);
+
+					for (c = 0; c < 4; c++) {
+						dst[c] = (((pixel >> bmp->shift[c]) & bmp->max[c]) * bmp->mul[c] + bmp->bias[c]) >> 16;
+					}
+				}
+			}
+		}
+	}
+	return buffer;
+}
+
+/**
+ * Free the memory used by a bitmap decoder.
+ * @param bmp The decoder.
+ */
+void  GRRLIB_BMPClose (GRRLIB_bmpDecoder *bmp) {
+	GRRLIB_MemFree(bmp->indices, bmp->width * bmp->height);
+	GRRLIB_MemFree(bmp->skipped, (bmp->width * bmp->height + 7) >> 3);
+	bmp->indices = NULL;
+	bmp->skipped = NULL;
+}
@@ -0,0 +1,430 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/*
+ * A GX_TF_CMPR texture is made of 8x8 tiles of four DXT1 blocks (top left, top right, bottom left, bottom right).
+ * A block is two big-endian RGB565 colors followed by one byte of 2-bit indices per row, the first pixel in the high bits.
+ * When the first color is greater, indices 2 and 3 blend the colors at 5/8 and 3/8,
+ * otherwise index 2 is their average and index 3 is transparent.
+ */
+
+#define CMPR_ALPHA_CUT  (128)  /**< Pixels with a lower alpha are encoded transparent. */
+#define CMPR_REFINE     (2)    /**< Least-squares passes of the high quality mode. */
+
+/**
+ * A 4x4 block of pixels to encode.
+ */
+typedef  struct GRRLIB_cmprBlock {
+	s32  rgb[16][3];   /**< Red, green and blue of each pixel. */
+	bool clear[16];    /**< @c true for the pixels encoded transparent. */
+	u32  opaque;       /**< Number of opaque pixels. */
+} GRRLIB_cmprBlock;
+
+/**
+ * Compute the colors of a block, as decoded by GX.
+ * @param c0 The first color in RGB565 format.
+ * @param c1 The second color in RGB565 format.
+ * @param pal Set to the red, green and blue of the four colors.
+ */
+static void  BlockPalette (const u16 c0, const u16 c1, s32 pal[4][3]) {
+	const u32 a = GRRLIB_UnpackRGB565(c0), b = GRRLIB_UnpackRGB565(c1);
+	u32 i;
+
+	pal[0][0] = GRRLIB_R(a);  pal[0][1] = GRRLIB_G(a);  pal[0][2] = GRRLIB_B(a);
+	pal[1][0] = GRRLIB_R(b);  pal[1][1] = GRRLIB_G(b);  pal[1][2] = GRRLIB_B(b);
+	for (i = 0; i < 3; i++) {
+		if (c0 > c1) {
+			pal[2][i] = (pal[0][i] * 5 + pal[1][i] * 3) >> 3;
+			pal[3][i] = (pal[0][i] * 3 + pal[1][i] * 5) >> 3;
+		}
+		else {
+			pal[2][i] = (pal[0][i] + pal[1][i]) >> 1;
+			pal[3][i] = pal[2][i];
+		}
+	}
+}
+
+/**
+ * Choose the index of each pixel of a block.
+ * @param blk The block.
+ * @param c0 The first color in RGB565 format.
+ * @param c1 The second color in RGB565 format.
+ * @param idx Set to the index of each pixel.
+ * @return The sum of the squared errors of the opaque pixels.
+ */
+static u32  BlockIndices (const GRRLIB_cmprBlock *blk, const u16 c0, const u16 c1, u8 idx[16]) {
+	const u32 colors = (c0 > c1) ? 4 : 3;
+	s32 pal[4][3];
+	u32 i, j, err = 0;
+
+	BlockPalette(c0, c1, pal);
+	for (i = 0; i < 16; i++) {
+		u32 best = ~0u;
+
+		if (blk->clear[i]) {
+			idx[i] = 3;
+			continue;
+		}
+		for (j = 0; j < colors; j++) {
+			const s32 dr = pal[j][0] - blk->rgb[i][0];
+			const s32 dg = pal[j][1] - blk->rgb[i][1];
+			const s32 db = pal[j][2] - blk->rgb[i][2];
+			const u32 d = dr*dr + dg*dg + db*db;
+
+			if (d < best) {
+				best = d;
+				idx[i] = j;
+			}
+		}
+		err += best;
+	}
+	return err;
+}
+
+/**
+ * Convert a color with components from 0 to 255 to RGB565, rounding to the nearest value.
+ * @param c Red, green and blue.
+ * @return The color in RGB565 format.
+ */
+static u16  QuantizeRGB565 (const f32 c[3]) {
+	s32 r = (s32)(c[0] * 31.0f / 255.0f + 0.5f);
+	s32 g = (s32)(c[1] * 63.0f / 255.0f + 0.5f);
+	s32 b = (s32)(c[2] * 31.0f / 255.0f + 0.5f);
+
+	r = (r < 0) ? 0 : (r > 31) ? 31 : r;
+	g = (g < 0) ? 0 : (g > 63) ? 63 : g;
+	b = (b < 0) ? 0 : (b > 31) ? 31 : b;
+	return (r << 11) | (g << 5) | b;
+}
+
+/**
+ * Put two colors in the order selecting the 4 colors mode, or the 3 colors mode for blocks with transparent pixels.
+ * @param blk The block.
+ * @param c0 The first color in RGB565 format.
+ * @param c1 The second color in RGB565 format.
+ */
+static void  OrderColors (const GRRLIB_cmprBlock *blk, u16 *c0, u16 *c1) {
+	const u16 a = *c0, b = *c1;
+
+	if ((blk->opaque < 16) == (a > b)) {
+		*c0 = b;
+		*c1 = a;
+	}
+}
+
+/**
+ * Find the two colors of a block from the bounding box of its pixels, inset to reduce the error.
+ * @param blk The block.
+ * @param c0 Set to the first color.
+ * @param c1 Set to the second color.
+ */
+static void  FastEndpoints (const GRRLIB_cmprBlock *blk, u16 *c0, u16 *c1) {
+	s32 lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+	f32 a[3], b[3];
+	u32 i, j;
+
+	for (i = 0; i < 16; i++) {
+		if (blk->clear[i] == false) {
+			for (j = 0; j < 3; j++) {
+				if (blk->rgb[i][j] < lo[j])  lo[j] = blk->rgb[i][j];
+				if (blk->rgb[i][j] > hi[j])  hi[j] = blk->rgb[i][j];
+			}
+		}
+	}
+	for (j = 0; j < 3; j++) {
+		const s32 inset = (hi[j] - lo[j]) >> 4;
+
+		a[j] = hi[j] - inset;
+		b[j] = lo[j] + inset;
+	}
+	*c0 = QuantizeRGB565(a);
+	*c1 = QuantizeRGB565(b);
+}
+
+/**
+ * Find the two colors of a block on the principal axis of its pixels.
+ * @param blk The block.
+ * @param c0 Set to the first color.
+ * @param c1 Set to the second color.
+ */
+static void  AxisEndpoints (const GRRLIB_cmprBlock *blk, u16 *c0, u16 *c1) {
+	f32 mean[3] = { 0, 0, 0 }, cov[6] = { 0, 0, 0, 0, 0, 0 }, axis[3] = { 1, 1, 1 };
+	f32 lo = 1e9f, hi = -1e9f, n, a[3], b[3];
+	u32 i, j;
+
+	for (i = 0; i < 16; i++) {
+		if (blk->clear[i] == false) {
+			for (j = 0; j < 3; j++) {
+				mean[j] += blk->rgb[i][j];
+			}
+		}
+	}
+	for (j = 0; j < 3; j++) {
+		mean[j] /= blk->opaque;
+	}
+	for (i = 0; i < 16; i++) {
+		if (blk->clear[i] == false) {
+			const f32 r = blk->rgb[i][0] - mean[0], g = blk->rgb[i][1] - mean[1], bl = blk->rgb[i][2] - mean[2];
+
+			cov[0] += r * r;  cov[1] += r * g;  cov[2] += r * bl;
+			cov[3] += g * g;  cov[4] += g * bl; cov[5] += bl * bl;
+		}
+	}
+
+	// Power iteration on the covariance matrix
+	for (i = 0; i < 8; i++) {
+		const f32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		const f32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		const f32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		f32 m = (x < 0 ? -x : x);
+
+		if ((y < 0 ? -y : y) > m)  m = (y < 0 ? -y : y);
+		if ((z < 0 ? -z : z) > m)  m = (z < 0 ? -z : z);
+		if (m < 1e-6f) {
+			break;  // Flat block, any axis works
+		}
+		axis[0] = x / m;
+		axis[1] = y / m;
+		axis[2] = z / m;
+	}
+
+	for (i = 0; i < 16; i++) {
+		if (blk->clear[i] == false) {
+			const f32 t = (blk->rgb[i][0] - mean[0]) * axis[0] + (blk->rgb[i][1] - mean[1]) * axis[1] + (blk->rgb[i][2] - mean[2]) * axis[2];
+
+			if (t < lo)  lo = t;
+			if (t > hi)  hi = t;
+		}
+	}
+	n = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	for (j = 0; j < 3; j++) {
+		a[j] = mean[j] + axis[j] * hi / n;
+		b[j] = mean[j] + axis[j] * lo / n;
+	}
+	*c0 = QuantizeRGB565(a);
+	*c1 = QuantizeRGB565(b);
+}
+
+/**
+ * Move the two colors of a block to the least-squares fit of its pixels for the given indices.
+ * @param blk The block.
+ * @param idx Index of each pixel.
+ * @param four @c true for the 4 colors mode.
+ * @param c0 The first color, updated.
+ * @param c1 The second color, updated.
+ * @return @c false if the fit is degenerate and the colors are unchanged.
+ */
+static bool  FitEndpoints (const GRRLIB_cmprBlock *blk, const u8 idx[16], const bool four, u16 *c0, u16 *c1) {
+	static const f32 weights4[4] = { 1.0f, 0.0f, 5.0f / 8.0f, 3.0f / 8.0f };
+	static const f32 weights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+	const f32 *weights = four ? weights4 : weights3;
+	f32 aa = 0, ab = 0, bb = 0, ap[3] = { 0, 0, 0 }, bp[3] = { 0, 0, 0 }, a[3], b[3], det;
+	u32 i, j;
+
+	for (i = 0; i < 16; i++) {
+		if (blk->clear[i] == false) {
+			const f32 w = weights[idx[i]];
+
+			aa += w * w;
+			ab += w * (1.0f - w);
+			bb += (1.0f - w) * (1.0f - w);
+			for (j = 0; j < 3; j++) {
+				ap[j] += w * blk->rgb[i][j];
+				bp[j] += (1.0f - w) * blk->rgb[i][j];
+			}
+		}
+	}
+	det = aa * bb - ab * ab;
+	if (det < 1e-3f) {
+		return false;
+	}
+	for (j = 0; j < 3; j++) {
+		a[j] = (ap[j] * bb - bp[j] * ab) / det;
+		b[j] = (bp[j] * aa - ap[j] * ab) / det;
+	}
+	*c0 = QuantizeRGB565(a);
+	*c1 = QuantizeRGB565(b);
+	return true;
+}
+
+/**
+ * Write a block.
+ * @param dst Destination, 8 bytes.
+ * @param c0 The first color in RGB565 format.
+ * @param c1 The second color in RGB565 format.
+ * @param idx Index of each pixel.
+ */
+static void  WriteBlock (u8 *dst, const u16 c0, const u16 c1, const u8 idx[16]) {
+	u32 r;
+
+	dst[0] = c0 >> 8;
+	dst[1] = c0;
+	dst[2] = c1 >> 8;
+	dst[3] = c1;
+	for (r = 0; r < 4; r++) {
+		dst[4 + r] = (idx[r * 4] << 6) | (idx[r * 4 + 1] << 4) | (idx[r * 4 + 2] << 2) | idx[r * 4 + 3];
+	}
+}
+
+/**
+ * Encode a block.
+ * @param dst Destination, 8 bytes.
+ * @param blk The block.
+ * @param hq @c true for the high quality mode.
+ */
+static void  EncodeBlock (u8 *dst, const GRRLIB_cmprBlock *blk, const bool hq) {
+	u16 c0, c1, t0, t1;
+	u8 idx[16], tidx[16];
+	u32 err, terr, pass;
+
+	if (blk->opaque == 0) {
+		memset(idx, 3, sizeof(idx));
+		WriteBlock(dst, 0, 0, idx);
+		return;
+	}
+
+	if (hq == false) {
+		FastEndpoints(blk, &c0, &c1);
+		OrderColors(blk, &c0, &c1);
+		BlockIndices(blk, c0, c1, idx);
+		WriteBlock(dst, c0, c1, idx);
+		return;
+	}
+
+	AxisEndpoints(blk, &c0, &c1);
+	OrderColors(blk, &c0, &c1);
+	err = BlockIndices(blk, c0, c1, idx);
+	for (pass = 0; pass < CMPR_REFINE && err > 0; pass++) {
+		if (FitEndpoints(blk, idx, c0 > c1, &t0, &t1) == false) {
+			break;
+		}
+		OrderColors(blk, &t0, &t1);
+		terr = BlockIndices(blk, t0, t1, tidx);
+		if (terr >= err) {
+			break;
+		}
+		c0 = t0;
+		c1 = t1;
+		err = terr;
+		memcpy(idx, tidx, sizeof(idx));
+	}
+
+	// Opaque blocks may be closer with the average of the 3 colors mode
+	if (blk->opaque == 16 && err > 0 && c0 != c1) {
+		t0 = (c0 < c1) ? c0 : c1;
+		t1 = (c0 < c1) ? c1 : c0;
+		terr = BlockIndices(blk, t0, t1, tidx);
+		if (terr < err) {
+			c0 = t0;
+			c1 = t1;
+			memcpy(idx, tidx, sizeof(idx));
+		}
+	}
+	WriteBlock(dst, c0, c1, idx);
+}
+
+/**
+ * Read a 4x4 block of an image, repeating the last row and column past the edges.
+ * Called with constant channel offsets so that each pixel layout gets its own loop.
+ * @param blk Set to the block.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param x X-coordinate of the block.
+ * @param y Y-coordinate of the block.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param bpp Bytes per source pixel.
+ * @param ro Offset of the red channel.
+ * @param go Offset of the green channel.
+ * @param bo Offset of the blue channel.
+ * @param ao Offset of the alpha channel, -1 for opaque images.
+ */
+static inline __attribute__((always_inline))
+void  ReadBlock (GRRLIB_cmprBlock *blk, const u8 *src, const s32 stride, const u32 x, const u32 y,
+                 const u32 width, const u32 height,
+                 const u32 bpp, const u32 ro, const u32 go, const u32 bo, const s32 ao) {
+	u32 r, c;
+
+	blk->opaque = 0;
+	for (r = 0; r < 4; r++) {
+		const u8 *row = src + (s32)((y + r < height) ? y + r : height - 1) * stride;
+
+		for (c = 0; c < 4; c++) {
+			const u8 *p = row + ((x + c < width) ? x + c : width - 1) * bpp;
+			const u32 i = r * 4 + c;
+
+			blk->rgb[i][0] = p[ro];
+			blk->rgb[i][1] = p[go];
+			blk->rgb[i][2] = p[bo];
+			blk->clear[i] = (ao >= 0 && p[ao] < CMPR_ALPHA_CUT);
+			blk->opaque += (blk->clear[i] == false);
+		}
+	}
+}
+
+/**
+ * Compress an image to GX_TF_CMPR tiles.
+ * The fast mode takes the colors of each block from the bounding box of its pixels.
+ * The high quality mode takes them on the principal axis of the pixels, refines them by least squares
+ * and also tries the 3 colors mode. Pixels with an alpha below 128 become transparent, the others opaque.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the source pixels.
+ * @param dst Destination, GX_GetTexBufferSize(width, height, GX_TF_CMPR, GX_FALSE, 0) bytes are written.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param hq @c true for the high quality mode, @c false for the fast mode.
+ */
+void  GRRLIB_EncodeCMPR (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                         void *dst, const u32 width, const u32 height, const bool hq) {
+	GRRLIB_cmprBlock blk;
+	u8 *d = dst;
+	u32 x, y, b;
+
+	for (y = 0; y < height; y += 8) {
+		for (x = 0; x < width; x += 8) {
+			for (b = 0; b < 4; b++, d += 8) {
+				const u32 bx = x + ((b & 1) << 2), by = y + ((b & 2) << 1);
+
+				// Blocks past the edges of the image are padding
+				if (bx >= width || by >= height) {
+					memset(d, 0, 8);
+					continue;
+				}
+				switch (layout) {
+					case GRRLIB_LAYOUT_RGB:    ReadBlock(&blk, src, stride, bx, by, width, height, 3, 0, 1, 2, -1);  break;
+					case GRRLIB_LAYOUT_RGBA:   ReadBlock(&blk, src, stride, bx, by, width, height, 4, 0, 1, 2,  3);  break;
+					case GRRLIB_LAYOUT_BGR:    ReadBlock(&blk, src, stride, bx, by, width, height, 3, 2, 1, 0, -1);  break;
+					case GRRLIB_LAYOUT_BGRA:   ReadBlock(&blk, src, stride, bx, by, width, height, 4, 2, 1, 0,  3);  break;
+					case GRRLIB_LAYOUT_GRAY:   ReadBlock(&blk, src, stride, bx, by, width, height, 1, 0, 0, 0, -1);  break;
+					case GRRLIB_LAYOUT_GRAYA:  ReadBlock(&blk, src, stride, bx, by, width, height, 2, 0, 0, 0,  1);  break;
+				}
+				EncodeBlock(d, &blk, hq);
+			}
+		}
+	}
+}
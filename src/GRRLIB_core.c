@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include <ogc/conf.h>
 #include <stdio.h>
 #include <ogc/machine/processor.h>
+#include <ogc/lwp_watchdog.h>
 
 #include <grrlib-mod.h>
 #include "grrlib-mod/GRRLIB_private.h"
@@ -35,34 +36,289 @@ THE SOFTWARE.
 static void *gp_fifo = NULL;
 
 static bool is_setup = false;  // To control entry and exit
+static bool exit_scheduled = false;
+
+static GRRLIB_initOptions init_options;
+
+// Frame buffer ring
+#define XFB_NONE  0xFF
+
+static lwpq_t xfb_queue = LWP_TQUEUE_NULL;     // Threads waiting for a frame buffer or a frame
+static u8 xfb_count = 2;                       // Number of frame buffers
+static u32 xfb_interval = 1;                   // Vertical retraces per frame
+static volatile u8 xfb_shown = 0;              // Frame buffer on screen
+static volatile u8 xfb_next = XFB_NONE;        // Frame buffer on screen after the next retrace
+static volatile u8 xfb_drawing = XFB_NONE;     // Frame buffer the GPU is copying a frame to (pipelined mode)
+static volatile u8 xfb_ready[GRRLIB_MAX_XFB];  // Finished frames waiting for a retrace, oldest first
+static volatile u8 xfb_ready_count = 0;
+static volatile u32 flip_retrace = 0;          // Retrace count when the last frame was shown
 
 GRRLIB_drawSettings GRRLIB_Settings;
 GXRModeObj *GRRLIB_VideoMode;
-void *GRRLIB_XFB[2] = {NULL, NULL};
+void *GRRLIB_XFB[GRRLIB_MAX_XFB] = {NULL, NULL, NULL};
 u32 GRRLIB_FB = 0;
 
 Mtx GRRLIB_View2D;
 guVector GRRLIB_Axis2D = {0, 0, 1};
 
+/**
+ * Remove the oldest finished frame from the frames waiting for a retrace.
+ * Must be called with interrupts disabled.
+ * @return The frame buffer of the frame.
+ */
+static u8  PopReadyFrame (void) {
+	const u8 xfb = xfb_ready[0];
+	u8 i;
+
+	xfb_ready_count--;
+	for (i = 0; i < xfb_ready_count; i++) {
+		xfb_ready[i] = xfb_ready[i + 1];
+	}
+	return xfb;
+}
+
+/**
+ * Called after each vertical retrace.
+ * Selects the next finished frame to show, at most one per retrace interval.
+ * @param retraceCnt The current retrace count.
+ */
+static void  RetraceCallback (u32 retraceCnt) {
+	if (xfb_next != XFB_NONE) {
+		// The frame selected after the previous retrace is now on screen
+		xfb_shown = xfb_next;
+		xfb_next = XFB_NONE;
+		flip_retrace = retraceCnt;
+		LWP_ThreadBroadcast(xfb_queue);
+	}
+
+	if (xfb_ready_count == 0 || retraceCnt + 1 - flip_retrace < xfb_interval) {
+		return;
+	}
+	// Without vertical sync waits only the newest frame is worth showing
+	while (init_options.vsync == GRRLIB_VSYNC_NONBLOCKING && xfb_ready_count > 1) {
+		PopReadyFrame();
+	}
+	xfb_next = PopReadyFrame();
+	VIDEO_SetNextFramebuffer(GRRLIB_XFB[xfb_next]);
+	VIDEO_Flush();
+	LWP_ThreadBroadcast(xfb_queue);
+}
+
+/**
+ * Called when the GPU finished a frame in pipelined mode.
+ * Queues the frame for the next vertical retrace.
+ */
+static void  DrawDoneCallback (void) {
+	// GX_DrawDone also ends here, only handle frames sent by GRRLIB_Render
+	if (xfb_drawing == XFB_NONE) {
+		return;
+	}
+	xfb_ready[xfb_ready_count++] = xfb_drawing;
+	xfb_drawing = XFB_NONE;
+	LWP_ThreadBroadcast(xfb_queue);
+}
+
+/**
+ * Wait until the GPU finished the last frame sent by GRRLIB_Render in pipelined mode.
+ */
+static void  WaitFrameDone (void) {
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	while (xfb_drawing != XFB_NONE) {
+		LWP_ThreadSleep(xfb_queue);
+	}
+	_CPU_ISR_Restore(level);
+}
+
+/**
+ * Wait until every frame sent by GRRLIB_Render has been on screen.
+ */
+static void  WaitFramesShown (void) {
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	while (xfb_drawing != XFB_NONE || xfb_ready_count > 0 || xfb_next != XFB_NONE) {
+		LWP_ThreadSleep(xfb_queue);
+	}
+	_CPU_ISR_Restore(level);
+}
+
+/**
+ * Check whether a frame buffer is on screen, waiting to be, or being drawn.
+ * Must be called with interrupts disabled.
+ * @param xfb The frame buffer to check.
+ * @return @c true if the frame buffer is used, @c false otherwise.
+ */
+static bool  FramebufferUsed (const u8 xfb) {
+	u8 i;
+
+	if (xfb == xfb_shown || xfb == xfb_next || xfb == xfb_drawing) {
+		return true;
+	}
+	for (i = 0; i < xfb_ready_count; i++) {
+		if (xfb_ready[i] == xfb) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Wait for a frame buffer which is neither on screen nor waiting to be.
+ * Must be called with interrupts disabled.
+ * @param drop Reuse the frame buffer of the oldest frame waiting for a retrace rather than wait.
+ * @return The frame buffer.
+ */
+static u8  AcquireFramebuffer (const bool drop) {
+	u8 i;
+
+	for (;;) {
+		for (i = 1; i <= xfb_count; i++) {
+			const u8 xfb = (GRRLIB_FB + i) % xfb_count;
+			if (FramebufferUsed(xfb) == false) {
+				return xfb;
+			}
+		}
+		if (drop == true && xfb_ready_count > 0) {
+			return PopReadyFrame();
+		}
+		LWP_ThreadSleep(xfb_queue);
+	}
+}
+
+/**
+ * Get a frame buffer which is neither on screen nor waiting to be.
+ * This waits when all frame buffers are used.
+ * @return A pointer to the frame buffer.
+ */
+void*  GRRLIB_GetFreeFramebuffer (void) {
+	u32 level;
+	u8  xfb;
+
+	_CPU_ISR_Disable(level);
+	xfb = AcquireFramebuffer(false);
+	_CPU_ISR_Restore(level);
+	return GRRLIB_XFB[xfb];
+}
+
+/**
+ * Copy the embedded frame buffer to the next free frame buffer and queue it to be shown.
+ * Only waits when no frame buffer is free.
+ * In pipelined mode this returns once the copy is queued, and the frame is queued when the GPU is done with it.
+ */
+void  GRRLIB_PresentFrame (void) {
+	u32 level;
+	u64 start;
+
+	if (init_options.pipelined == true) {
+		start = gettime();
+		WaitFrameDone();  // Keep a single frame in flight
+		GRRLIB_FrameCounters.gpuWait += ticks_to_microsecs(gettime() - start);
+	}
+	GX_InvalidateTexAll();
+
+	start = gettime();
+	_CPU_ISR_Disable(level);
+	GRRLIB_FB = AcquireFramebuffer(init_options.vsync == GRRLIB_VSYNC_NONBLOCKING);
+	if (init_options.pipelined == true) {
+		xfb_drawing = GRRLIB_FB;
+	}
+	_CPU_ISR_Restore(level);
+	GRRLIB_FrameCounters.vsyncWait += ticks_to_microsecs(gettime() - start);
+
+	GX_SetZMode      (GX_TRUE, GX_LEQUAL, GX_TRUE);
+	GX_SetColorUpdate(GX_TRUE);
+	GX_CopyDisp      (GRRLIB_XFB[GRRLIB_FB], GX_TRUE);
+
+	if (init_options.pipelined == true) {
+		GX_SetDrawDone();  // DrawDoneCallback queues the frame
+		return;
+	}
+
+	start = gettime();
+	GX_DrawDone();  // Tell the GX engine we are done drawing
+	GRRLIB_FrameCounters.gpuWait += ticks_to_microsecs(gettime() - start);
+
+	_CPU_ISR_Disable(level);
+	xfb_ready[xfb_ready_count++] = GRRLIB_FB;
+	_CPU_ISR_Restore(level);
+}
+
+/**
+ * Get the memory used by one frame buffer.
+ * Each frame buffer of the ring chosen with GRRLIB_InitEx costs this much memory.
+ * @return The size of a frame buffer in bytes.
+ */
+u32  GRRLIB_GetFramebufferSize (void) {
+	return VIDEO_GetFrameBufferSize(GRRLIB_VideoMode);
+}
+
 /**
  * Initialize GRRLIB. Call this once at the beginning your code.
  * @return A integer representing a code:
  *         -     0 : The operation completed successfully.
  *         -    -1 : Not enough memory is available to initialize GRRLIB.
  *         -    -2 : Failed to initialize the font engine.
+ * @see GRRLIB_InitEx
  * @see GRRLIB_Exit
  */
 int  GRRLIB_Init (void) {
+	return GRRLIB_InitEx(NULL);
+}
+
+/**
+ * Initialize GRRLIB with options. Call this once at the beginning your code.
+ * In pipelined mode, textures and vertex data must not be modified while the GPU may still be drawing the previous frame with them.
+ * With three frame buffers GRRLIB_Render only waits for a vertical retrace when two frames are already waiting to be shown.
+ * Each extra frame buffer costs GRRLIB_GetFramebufferSize() bytes (614400 bytes for 640x480).
+ * @param options The options to use, or NULL for the default options.
+ * @return A integer representing a code:
+ *         -     0 : The operation completed successfully.
+ *         -    -1 : Not enough memory is available to initialize GRRLIB.
+ *         -    -2 : Failed to initialize the font engine.
+ * @see GRRLIB_Exit
+ */
+int  GRRLIB_InitEx (const GRRLIB_initOptions *options) {
 	f32 yscale;
 	u32 xfbHeight;
 	Mtx44 perspective;
 	s8 error_code = 0;
 
-	// Ensure this function is only ever called once
+	// Ensure this function is only called once until GRRLIB_Exit
 	if (is_setup == true) {
 		return 0;
 	}
 
+	if (options != NULL) {
+		init_options = *options;
+	}
+	else {
+		memset(&init_options, 0, sizeof(init_options));
+	}
+	if (init_options.fifoSize == 0) {
+		init_options.fifoSize = DEFAULT_FIFO_SIZE;
+	}
+	else if (init_options.fifoSize < GX_FIFO_MINSIZE) {
+		init_options.fifoSize = GX_FIFO_MINSIZE;
+	}
+	init_options.fifoSize = (init_options.fifoSize + 31) & ~31;
+	if (init_options.xfbCount == 0) {
+		init_options.xfbCount = 2;
+	}
+	else if (init_options.xfbCount > GRRLIB_MAX_XFB) {
+		init_options.xfbCount = GRRLIB_MAX_XFB;
+	}
+	else if (init_options.xfbCount < 2) {
+		init_options.xfbCount = 2;
+	}
+	xfb_count = init_options.xfbCount;
+	xfb_interval = 1;
+	xfb_next = XFB_NONE;
+	xfb_drawing = XFB_NONE;
+	xfb_ready_count = 0;
+	GRRLIB_FB = 0;
+
 	// Initialise the video subsystem
 	VIDEO_Init();
 	VIDEO_SetBlack(true);  // Disable video output during initialisation
@@ -111,12 +367,11 @@ int  GRRLIB_Init (void) {
 	// --
 	VIDEO_Configure(GRRLIB_VideoMode);
 
-	// Get some memory to use for a "double buffered" frame buffer
-	if ( !(GRRLIB_XFB[0] = MEM_K0_TO_K1(SYS_AllocateFramebuffer(GRRLIB_VideoMode))) ) {
-		return -1;
-	}
-	if ( !(GRRLIB_XFB[1] = MEM_K0_TO_K1(SYS_AllocateFramebuffer(GRRLIB_VideoMode))) ) {
-		return -1;
+	// Get some memory to use for a "double buffered" (or triple buffered) frame buffer
+	for (u8 i = 0; i < xfb_count; i++) {
+		if ( !(GRRLIB_XFB[i] = MEM_K0_TO_K1(SYS_AllocateFramebuffer(GRRLIB_VideoMode))) ) {
+			return -1;
+		}
 	}
 
 	VIDEO_SetNextFramebuffer(GRRLIB_XFB[GRRLIB_FB]);  // Choose a frame buffer to start with
@@ -126,14 +381,26 @@ int  GRRLIB_Init (void) {
 	// If the TV image is interlaced it takes two passes to display the image
 	if (GRRLIB_VideoMode->viTVMode & VI_NON_INTERLACE) {
 		VIDEO_WaitVSync();
+		xfb_interval = 2;
 	}
 
+	// Frames are shown by RetraceCallback as soon as they are finished
+	xfb_shown = GRRLIB_FB;
+	flip_retrace = VIDEO_GetRetraceCount();
+	LWP_InitQueue(&xfb_queue);
+	VIDEO_SetPostRetraceCallback(RetraceCallback);
+
 	// The FIFO is the buffer the CPU uses to send commands to the GPU
-	if ( !(gp_fifo = memalign(32, DEFAULT_FIFO_SIZE)) ) {
+	if ( !(gp_fifo = GRRLIB_MemAlloc(init_options.fifoSize, 32, GRRLIB_MEM_HOT)) ) {
 		return -1;
 	}
-	memset(gp_fifo, 0, DEFAULT_FIFO_SIZE);
-	GX_Init(gp_fifo, DEFAULT_FIFO_SIZE);
+	memset(gp_fifo, 0, init_options.fifoSize);
+	GX_Init(gp_fifo, init_options.fifoSize);
+
+	// In pipelined mode frames are queued when the GPU is done with them
+	if (init_options.pipelined == true) {
+		GX_SetDrawDoneCallback(DrawDoneCallback);
+	}
 
 	// Clear the background to opaque black and clears the z-buffer
 	GX_SetCopyClear((GXColor){ 0, 0, 0, 0 }, GX_MAX_Z24);
@@ -158,24 +425,29 @@ int  GRRLIB_Init (void) {
 	if (GRRLIB_VideoMode->fbWidth <= 0) { printf("GRRLIB " GRRLIB_VER_STRING); }
 
 	// Setup the vertex descriptor
-	GX_ClearVtxDesc();      // clear all the vertex descriptors
+	GRRLIB_StateInvalidate();   // Nothing is known about the GX state yet
+	GRRLIB_StateClearVtxDesc(); // clear all the vertex descriptors
 	GX_InvVtxCache();       // Invalidate the vertex cache
 	GX_InvalidateTexAll();  // Invalidate all textures
 
 	// Tells the flipper to expect direct data
-	GX_SetVtxDesc(GX_VA_TEX0, GX_NONE);
-	GX_SetVtxDesc(GX_VA_POS,  GX_DIRECT);
-	GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+	GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_NONE);
+	GRRLIB_StateSetVtxDesc(GX_VA_POS,  GX_DIRECT);
+	GRRLIB_StateSetVtxDesc(GX_VA_CLR0, GX_DIRECT);
 
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS,  GX_POS_XYZ,  GX_F32, 0);
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_TEX0, GX_TEX_ST,   GX_F32, 0);
 	// Colour 0 is 8bit RGBA format
 	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
+	// Compact format: 16 bit 2D positions and 1.15 fixed point texture coordinates
+	GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_POS,  GX_POS_XY,   GX_S16, 0);
+	GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_TEX0, GX_TEX_ST,   GX_U16, GRRLIB_TEXCOORD_FRAC);
+	GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
 	GX_SetZMode(GX_FALSE, GX_LEQUAL, GX_TRUE);
 
 	GX_SetNumChans(1);    // colour is the same as vertex colour
 	GX_SetNumTexGens(1);  // One texture exists
-	GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+	GRRLIB_StateSetTevOp(GX_PASSCLR);
 	GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORD0, GX_TEXMAP0, GX_COLOR0A0);
 	GX_SetTexCoordGen(GX_TEXCOORD0, GX_TG_MTX2x4, GX_TG_TEX0, GX_IDENTITY);
 
@@ -183,13 +455,13 @@ int  GRRLIB_Init (void) {
 	guMtxIdentity(GRRLIB_View2D);
 	guMtxTransApply(GRRLIB_View2D, GRRLIB_View2D, 0.0, 0.0, -100.0);
 
-	GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+	GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 
 	guOrtho(perspective, 0.0f, GRRLIB_VideoMode->efbHeight, 0.0f, GRRLIB_VideoMode->fbWidth, 0.0f, 1000.0f);
 	GX_LoadProjectionMtx(perspective, GX_ORTHOGRAPHIC);
 
 	GX_SetViewport(0.0f, 0.0f, GRRLIB_VideoMode->fbWidth, GRRLIB_VideoMode->efbHeight, 0.0f, 1.0f);
-	GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
+	GRRLIB_StateSetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
 	GX_SetAlphaUpdate(GX_TRUE);
 	GX_SetAlphaCompare(GX_GREATER, 0, GX_AOP_AND, GX_ALWAYS, 0);
 	GX_SetColorUpdate(GX_ENABLE);
@@ -202,14 +474,19 @@ int  GRRLIB_Init (void) {
 	GRRLIB_Settings.antialias = true;
 	GRRLIB_Settings.deflicker = true;
 	GRRLIB_Settings.lights    = 0;
+	GRRLIB_Settings.compactVertices = true;
+	GRRLIB_Settings.lazyState = false;
 
 	GRRLIB_SetPointSize(6);
 	GRRLIB_SetLineWidth(6);
 	GRRLIB_SetBlend(GRRLIB_BLEND_ALPHA);
 
 	// Schedule cleanup for when program exits
+	if (exit_scheduled == false) {
+		atexit(GRRLIB_Exit);
+		exit_scheduled = true;
+	}
 	is_setup = true;
-	atexit(GRRLIB_Exit);
 
 	// Initialise TTF
 	if (GRRLIB_InitTTF() != 0) {
@@ -222,45 +499,55 @@ int  GRRLIB_Init (void) {
 
 /**
  * Call this before exiting your application.
- * Ensure this function is only ever called once
- * and only if the setup function has been called.
+ * It does nothing if GRRLIB is not initialised, GRRLIB_Init can be called again afterwards.
  */
 void  GRRLIB_Exit (void) {
-	static  bool  done = false;
-	if (done == true || is_setup == false) {
+	if (is_setup == false) {
 		return;
 	}
-	else {
-		done = true;
-	}
 
 	// Allow write access to the full screen
 	GX_SetClipMode( GX_CLIP_DISABLE );
-	GX_SetScissor( 0, 0, GRRLIB_VideoMode->fbWidth, GRRLIB_VideoMode->efbHeight );
+	GRRLIB_StateSetScissor( 0, 0, GRRLIB_VideoMode->fbWidth, GRRLIB_VideoMode->efbHeight );
 
-	// We empty both frame buffers on our way out
+	// We empty every frame buffer on our way out
 	// otherwise dead frames are sometimes seen when starting the next app
-	GRRLIB_FillScreen( 0x000000FF );  GRRLIB_Render();
-	GRRLIB_FillScreen( 0x000000FF );  GRRLIB_Render();
+	for (u8 i = 0; i < GRRLIB_MAX_XFB; i++) {
+		GRRLIB_FillScreen( 0x000000FF );  GRRLIB_Render();
+	}
+
+	// Wait for the last frame before the GPU and the frame buffers are released
+	WaitFramesShown();
+	if (init_options.pipelined == true) {
+		GX_SetDrawDoneCallback(NULL);
+	}
+	VIDEO_SetPostRetraceCallback(NULL);
+	LWP_CloseQueue(xfb_queue);
+
+	// Free up memory allocated for cached meshes
+	GRRLIB_ClearMeshCache();
 
 	// Shut down the GX engine
 	GX_DrawDone();
 	GX_AbortFrame();
 
+	// Free up memory allocated for display lists
+	GRRLIB_FreeDisplayLists();
+
 	// Free up memory allocated for frame buffers & FIFOs
-	if (GRRLIB_XFB[0] != NULL) {
-		free(MEM_K1_TO_K0(GRRLIB_XFB[0]));
-		GRRLIB_XFB[0] = NULL;
-	}
-	if (GRRLIB_XFB[1] != NULL) {
-		free(MEM_K1_TO_K0(GRRLIB_XFB[1]));
-		GRRLIB_XFB[1] = NULL;
+	for (u8 i = 0; i < GRRLIB_MAX_XFB; i++) {
+		if (GRRLIB_XFB[i] != NULL) {
+			free(MEM_K1_TO_K0(GRRLIB_XFB[i]));
+			GRRLIB_XFB[i] = NULL;
+		}
 	}
 	if (gp_fifo != NULL) {
-		free(gp_fifo);
+		GRRLIB_MemFree(gp_fifo, init_options.fifoSize);
 		gp_fifo = NULL;
 	}
 
 	// Done with TTF
 	GRRLIB_ExitTTF();
+
+	is_setup = false;
 }
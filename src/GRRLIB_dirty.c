@@ -0,0 +1,177 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * Return the number of rows of tiles of a texture.
+ * @param texture The texture.
+ * @return The number of rows of tiles of its base level.
+ */
+static u32  DirtyRowCount (const GRRLIB_texture *texture) {
+	u32 tileW, tileH;
+
+	GRRLIB_TileGeometry(texture->fmt, &tileW, &tileH);
+	return (texture->height + tileH - 1) / tileH;
+}
+
+/**
+ * Start or stop tracking the parts of a texture written by the CPU.
+ * While writes are tracked, GRRLIB_SetPixelToTexture and GRRLIB_MarkTextureDirty record the tiles they touch,
+ * and GRRLIB_FlushTextureDirty flushes those tiles instead of the whole texture as GRRLIB_FinalizeTexture does.
+ * Tiles written before tracking started, or still dirty when it stops, are not flushed.
+ * @param texture The texture.
+ * @param track @c true to track writes, @c false to stop.
+ * @return @c true on success, @c false if memory is missing.
+ */
+bool  GRRLIB_TrackTextureDirty (GRRLIB_texture *texture, const bool track) {
+	const u32 size = DirtyRowCount(texture) * 2 * sizeof(u16);
+
+	if (track == false) {
+		GRRLIB_MemFree(texture->dirtyRows, size);
+		texture->dirtyRows = NULL;
+		texture->dirtyTop = 0;
+		texture->dirtyBottom = 0;
+		return true;
+	}
+	if (texture->dirtyRows == NULL) {
+		texture->dirtyRows = GRRLIB_MemCalloc(size, GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+		texture->dirtyTop = 0;
+		texture->dirtyBottom = 0;
+	}
+	return texture->dirtyRows != NULL;
+}
+
+/**
+ * Record that the CPU wrote a rectangle of a texture, for GRRLIB_FlushTextureDirty.
+ * Call it after writing to the data of a texture directly, GRRLIB_SetPixelToTexture calls it itself.
+ * Does nothing when the writes of the texture are not tracked.
+ * @param texture The texture.
+ * @param x Left of the rectangle in pixels.
+ * @param y Top of the rectangle in pixels.
+ * @param width Width of the rectangle, clipped to the texture.
+ * @param height Height of the rectangle, clipped to the texture.
+ */
+void  GRRLIB_MarkTextureDirty (GRRLIB_texture *texture, s32 x, s32 y, s32 width, s32 height) {
+	u32 tileW, tileH, first, end, top, bottom, row;
+
+	if (texture->dirtyRows == NULL) {
+		return;
+	}
+	if (x < 0) {
+		width += x;
+		x = 0;
+	}
+	if (y < 0) {
+		height += y;
+		y = 0;
+	}
+	if (x + width > (s32)texture->width) {
+		width = texture->width - x;
+	}
+	if (y + height > (s32)texture->height) {
+		height = texture->height - y;
+	}
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+
+	GRRLIB_TileGeometry(texture->fmt, &tileW, &tileH);
+	first = x / tileW;
+	end = (x + width - 1) / tileW + 1;
+	top = y / tileH;
+	bottom = (y + height - 1) / tileH + 1;
+	for (row = top; row < bottom; row++) {
+		u16 *span = &texture->dirtyRows[row * 2];
+
+		if (span[0] == span[1]) {
+			span[0] = first;
+			span[1] = end;
+		}
+		else {
+			if (first < span[0])  span[0] = first;
+			if (end > span[1])    span[1] = end;
+		}
+	}
+	if (texture->dirtyBottom == 0) {
+		texture->dirtyTop = top;
+		texture->dirtyBottom = bottom;
+	}
+	else {
+		if (top < texture->dirtyTop)        texture->dirtyTop = top;
+		if (bottom > texture->dirtyBottom)  texture->dirtyBottom = bottom;
+	}
+}
+
+/**
+ * Write the tiles of a texture written by the CPU since the last flush to main memory, for the GPU to see them.
+ * Only the cache lines of the dirty tiles are flushed, in one range per run of consecutive tiles,
+ * and the texture object is kept as it is. Use it in place of GRRLIB_FinalizeTexture after editing pixels.
+ * Without tracking, see GRRLIB_TrackTextureDirty, the whole texture is finalized.
+ * The texture cache of the GPU is invalidated when tiles were flushed, since it may hold the old ones.
+ * @param texture The texture.
+ * @return The number of bytes flushed.
+ */
+u32  GRRLIB_FlushTextureDirty (GRRLIB_texture *texture) {
+	u32 tileW, tileH, tileBytes, rowBytes, row, runStart = 0, runEnd = 0, flushed = 0;
+
+	if (texture->dirtyRows == NULL) {
+		GRRLIB_FinalizeTexture(texture);
+		return GRRLIB_GetTextureDataSize(texture);
+	}
+	if (texture->dirtyBottom == 0) {
+		return 0;
+	}
+
+	tileBytes = GRRLIB_TileGeometry(texture->fmt, &tileW, &tileH);
+	rowBytes = ((texture->width + tileW - 1) / tileW) * tileBytes;
+	for (row = texture->dirtyTop; row < texture->dirtyBottom; row++) {
+		u16 *span = &texture->dirtyRows[row * 2];
+		const u32 start = row * rowBytes + span[0] * tileBytes, end = row * rowBytes + span[1] * tileBytes;
+
+		if (span[0] == span[1]) {
+			continue;
+		}
+		// Rows of tiles follow each other, so a run continues when a row is dirty up to its end
+		if (start != runEnd) {
+			if (runEnd != runStart) {
+				DCFlushRange((u8*)texture->data + runStart, runEnd - runStart);
+				flushed += runEnd - runStart;
+			}
+			runStart = start;
+		}
+		runEnd = end;
+		span[0] = 0;
+		span[1] = 0;
+	}
+	if (runEnd != runStart) {
+		DCFlushRange((u8*)texture->data + runStart, runEnd - runStart);
+		flushed += runEnd - runStart;
+	}
+	texture->dirtyTop = 0;
+	texture->dirtyBottom = 0;
+
+	// GRRLIB does not choose the texture cache regions, so they are all invalidated
+	GX_InvalidateTexAll();
+	return flushed;
+}
@@ -0,0 +1,231 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * Structure to keep track of the display lists allocated by GRRLIB.
+ */
+typedef  struct GRRLIB_displayListNode {
+	GRRLIB_displayList              list;          /**< The display list, must be the first member. */
+	void                          **meshes;        /**< Cached meshes drawn by the display list, pinned until it is freed. */
+	u32                             meshCount;     /**< Number of meshes. */
+	u32                             meshCapacity;  /**< Number of meshes allocated. */
+	struct GRRLIB_displayListNode  *next;          /**< Next display list. */
+} GRRLIB_displayListNode;
+
+static GRRLIB_displayListNode  *displayLists = NULL;
+static GRRLIB_displayListNode  *recording = NULL;
+
+/**
+ * Free a display list and its node, and unpin the meshes it draws.
+ * @param node The node of the display list.
+ */
+static void  FreeNode (GRRLIB_displayListNode *node) {
+	u32  i;
+
+	for (i = 0; i < node->meshCount; i++) {
+		GRRLIB_MeshUnpin(node->meshes[i]);
+	}
+	GRRLIB_MemFree(node->meshes, node->meshCapacity * sizeof(void*));
+	GRRLIB_MemFree(node->list.data, node->list.capacity);
+	GRRLIB_MemFree(node, sizeof(GRRLIB_displayListNode));
+}
+
+/**
+ * Start recording GX commands in a display list instead of sending them to the GPU.
+ * Every GRRLIB drawing function called until GRRLIB_EndDisplayList is recorded.
+ * Display lists can not be nested.
+ * @param size The maximum size of the display list in bytes. It is rounded up to a multiple of 32.
+ * @return @c true if recording started, @c false otherwise.
+ */
+bool  GRRLIB_BeginDisplayList (const u32 size) {
+	GRRLIB_displayListNode  *node;
+	u32  capacity = (size + 31) & ~31;
+
+	if (recording != NULL || capacity == 0) {
+		return false;
+	}
+
+	node = GRRLIB_MemAlloc(sizeof(GRRLIB_displayListNode), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (node == NULL) {
+		return false;
+	}
+	node->list.data = GRRLIB_MemAlloc(capacity, 32, GRRLIB_MEM_HOT);
+	if (node->list.data == NULL) {
+		GRRLIB_MemFree(node, sizeof(GRRLIB_displayListNode));
+		return false;
+	}
+	node->list.size = 0;
+	node->list.capacity = capacity;
+	node->meshes = NULL;
+	node->meshCount = 0;
+	node->meshCapacity = 0;
+
+	// Send what is queued and the default 2D state to the GPU, not to the display list
+	GRRLIB_SpriteBatchFlush();
+	GRRLIB_StateRestore();
+
+	// The display list must not depend on the state it is called with
+	GRRLIB_StateInvalidate();
+
+	DCInvalidateRange(node->list.data, capacity);
+	GX_BeginDispList(node->list.data, capacity);
+	recording = node;
+
+	return true;
+}
+
+/**
+ * Stop recording GX commands.
+ * @return A pointer to the recorded display list, or NULL if the commands did not fit in the requested size.
+ * The display list is freed with GRRLIB_FreeDisplayList or when GRRLIB_Exit is called.
+ */
+GRRLIB_displayList*  GRRLIB_EndDisplayList (void) {
+	GRRLIB_displayListNode  *node = recording;
+
+	if (node == NULL) {
+		return NULL;
+	}
+
+	GRRLIB_SpriteBatchFlush();
+	node->list.size = GX_EndDispList();
+	recording = NULL;
+
+	// The state written while recording never reached the GPU
+	GRRLIB_StateInvalidate();
+
+	if (node->list.size == 0) {
+		FreeNode(node);
+		return NULL;
+	}
+
+	node->next = displayLists;
+	displayLists = node;
+
+	return &node->list;
+}
+
+/**
+ * Send a recorded display list to the GPU.
+ * @param list The display list to call.
+ */
+void  GRRLIB_CallDisplayList (const GRRLIB_displayList *list) {
+	if (list == NULL || list->size == 0 || recording != NULL) {
+		return;
+	}
+
+	GRRLIB_SpriteBatchFlush();
+	GX_CallDispList(list->data, list->size);
+
+	// The display list leaves the state it last set
+	GRRLIB_StateInvalidate();
+}
+
+/**
+ * Free memory allocated for a display list.
+ * @param list A display list returned by GRRLIB_EndDisplayList.
+ */
+void  GRRLIB_FreeDisplayList (GRRLIB_displayList *list) {
+	GRRLIB_displayListNode  **link;
+
+	if (list == NULL) {
+		return;
+	}
+
+	for (link = &displayLists; *link != NULL; link = &(*link)->next) {
+		if (&(*link)->list == list) {
+			GRRLIB_displayListNode  *node = *link;
+
+			*link = node->next;
+			FreeNode(node);
+			return;
+		}
+	}
+}
+
+/**
+ * Tell if GX commands are being recorded in a display list.
+ * @return @c true between GRRLIB_BeginDisplayList and GRRLIB_EndDisplayList, @c false otherwise.
+ */
+bool  GRRLIB_DisplayListRecording (void) {
+	return recording != NULL;
+}
+
+/**
+ * Record that the display list being recorded draws a cached mesh, and pin the mesh until the display list is freed.
+ * @param mesh The mesh.
+ * @return @c true if the mesh is recorded, @c false if memory is missing.
+ */
+bool  GRRLIB_DisplayListUseMesh (void *mesh) {
+	GRRLIB_displayListNode  *node = recording;
+	u32  i;
+
+	for (i = 0; i < node->meshCount; i++) {
+		if (node->meshes[i] == mesh) {
+			return true;
+		}
+	}
+	if (node->meshCount == node->meshCapacity) {
+		const u32  capacity = (node->meshCapacity != 0) ? 2 * node->meshCapacity : 4;
+		void  **meshes = GRRLIB_MemRealloc(node->meshes, node->meshCapacity * sizeof(void*),
+		                                   capacity * sizeof(void*), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+
+		if (meshes == NULL) {
+			return false;
+		}
+		node->meshes = meshes;
+		node->meshCapacity = capacity;
+	}
+	node->meshes[node->meshCount++] = mesh;
+	GRRLIB_MeshPin(mesh);
+	return true;
+}
+
+/**
+ * Forget the meshes drawn by the display lists, when the mesh cache frees them all.
+ */
+void  GRRLIB_DisplayListsForgetMeshes (void) {
+	GRRLIB_displayListNode  *node;
+
+	for (node = displayLists; node != NULL; node = node->next) {
+		node->meshCount = 0;
+	}
+	if (recording != NULL) {
+		recording->meshCount = 0;
+	}
+}
+
+/**
+ * Free all the display lists which were not freed yet.
+ */
+void  GRRLIB_FreeDisplayLists (void) {
+	while (displayLists != NULL) {
+		GRRLIB_displayListNode  *node = displayLists;
+
+		displayLists = node->next;
+		FreeNode(node);
+	}
+}
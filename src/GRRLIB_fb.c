@@ -23,6 +23,7 @@ THE SOFTWARE.
 #include <math.h>
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 /**
  * Draws a vector.
@@ -33,7 +34,39 @@ THE SOFTWARE.
  */
 void  GRRLIB_GXEngine (const guVector v[], const u32 color[], const long n,
                        const u8 fmt) {
-	GX_Begin(fmt, GX_VTXFMT0, n);
+	long i;
+
+	// Use 16-bit coordinates when every vertex is on an integer position of the 2D plane
+	if (GRRLIB_StateCompactAllowed() == true) {
+		for (i = 0; i < n; i++) {
+			if (v[i].z != 0.0f || GRRLIB_CompactPos(v[i].x) == false || GRRLIB_CompactPos(v[i].y) == false) {
+				break;
+			}
+		}
+		if (i == n) {
+			if (color == NULL) {
+				GRRLIB_StateUntextured2DKonst(GRRLIB_Settings.color);
+				GRRLIB_Begin(fmt, GX_VTXFMT1, n);
+				for (i = 0; i < n; i++) {
+					GX_Position2s16(v[i].x, v[i].y);
+				}
+			} else {
+				GRRLIB_StateRestore();
+				GRRLIB_Begin(fmt, GX_VTXFMT1, n);
+				for (i = 0; i < n; i++) {
+					GX_Position2s16(v[i].x, v[i].y);
+					GX_Color1u32(GRRLIB_Settings.color * ((double) color[i] / 0xFFFFFFFF));
+				}
+			}
+			GX_End();
+			GRRLIB_StateLeave();
+			return;
+		}
+	}
+
+	GRRLIB_StateRestore();
+
+	GRRLIB_Begin(fmt, GX_VTXFMT0, n);
 	if (color == NULL) {
 		for (int i = 0; i < n; i++) {
 			GX_Position3f32(v[i].x, v[i].y, v[i].z);
@@ -61,7 +94,9 @@ void  GRRLIB_FillScreen (const u32 color) {
 	// Backup matrix
 	GRRLIB_matrix matrixObject = GRRLIB_GetMatrix();
 
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	GRRLIB_StateRestore();
+
+	GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 		GX_Position3f32(x, y, 0.0f);
 		GX_Color1u32(color);
 		GX_Position3f32(x2, y, 0.0f);
@@ -82,7 +117,9 @@ void  GRRLIB_FillScreen (const u32 color) {
  * @author Jespa
  */
 void  GRRLIB_Point (const f32 x, const f32 y) {
-	GX_Begin(GX_POINTS, GX_VTXFMT0, 1);
+	GRRLIB_StateRestore();
+
+	GRRLIB_Begin(GX_POINTS, GX_VTXFMT0, 1);
 		GX_Position3f32(x, y, 0.0f);
 		GX_Color1u32(GRRLIB_Settings.color);
 	GX_End();
@@ -100,7 +137,21 @@ void  GRRLIB_Line (const f32 x1, const f32 y1,
 				   const f32 x2, const f32 y2) {
 	u32 color = GRRLIB_Settings.color;
 
-	GX_Begin(GX_LINES, GX_VTXFMT0, 2);
+	if (GRRLIB_StateCompactAllowed() == true &&
+	    GRRLIB_CompactPos(x1) == true && GRRLIB_CompactPos(y1) == true &&
+	    GRRLIB_CompactPos(x2) == true && GRRLIB_CompactPos(y2) == true) {
+		GRRLIB_StateUntextured2DKonst(color);
+		GRRLIB_Begin(GX_LINES, GX_VTXFMT1, 2);
+			GX_Position2s16(x1, y1);
+			GX_Position2s16(x2, y2);
+		GX_End();
+		GRRLIB_StateLeave();
+		return;
+	}
+
+	GRRLIB_StateRestore();
+
+	GRRLIB_Begin(GX_LINES, GX_VTXFMT0, 2);
 		GX_Position3f32(x1, y1, 0.0f);
 		GX_Color1u32(color);
 		GX_Position3f32(x2, y2, 0.0f);
@@ -123,8 +174,35 @@ void  GRRLIB_Rectangle (const f32 x,      const f32 y,
 	f32 y2 = y + height;
 	u32 color = GRRLIB_Settings.color;
 
+	if (GRRLIB_StateCompactAllowed() == true &&
+	    GRRLIB_CompactPos(x)  == true && GRRLIB_CompactPos(y)  == true &&
+	    GRRLIB_CompactPos(x2) == true && GRRLIB_CompactPos(y2) == true) {
+		GRRLIB_StateUntextured2DKonst(color);
+		if (filled == true) {
+			GRRLIB_Begin(GX_QUADS, GX_VTXFMT1, 4);
+				GX_Position2s16(x, y);
+				GX_Position2s16(x2, y);
+				GX_Position2s16(x2, y2);
+				GX_Position2s16(x, y2);
+			GX_End();
+		}
+		else {
+			GRRLIB_Begin(GX_LINESTRIP, GX_VTXFMT1, 5);
+				GX_Position2s16(x, y);
+				GX_Position2s16(x2, y);
+				GX_Position2s16(x2, y2);
+				GX_Position2s16(x, y2);
+				GX_Position2s16(x, y);
+			GX_End();
+		}
+		GRRLIB_StateLeave();
+		return;
+	}
+
+	GRRLIB_StateRestore();
+
 	if (filled == true) {
-		GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+		GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 			GX_Position3f32(x, y, 0.0f);
 			GX_Color1u32(color);
 			GX_Position3f32(x2, y, 0.0f);
@@ -136,7 +214,7 @@ void  GRRLIB_Rectangle (const f32 x,      const f32 y,
 		GX_End();
 	}
 	else {
-		GX_Begin(GX_LINESTRIP, GX_VTXFMT0, 5);
+		GRRLIB_Begin(GX_LINESTRIP, GX_VTXFMT0, 5);
 			GX_Position3f32(x, y, 0.0f);
 			GX_Color1u32(color);
 			GX_Position3f32(x2, y, 0.0f);
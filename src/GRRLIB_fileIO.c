@@ -117,11 +117,13 @@ GRRLIB_ttfFont*  GRRLIB_LoadTTFFromFile(const char *filename) {
 		return NULL;
 	}
 
-	// Convert to TTF
+	// Convert to TTF, the font keeps the buffer
 	ttf = GRRLIB_LoadTTF(data, size);
-
-	// Free up the buffer
-	free(data);
+	if (ttf == NULL) {
+		free(data);
+		return NULL;
+	}
+	ttf->data = data;
 
 	return ttf;
 }
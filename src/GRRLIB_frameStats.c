@@ -0,0 +1,177 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include <ogc/lwp_watchdog.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define FRAME_STATS_WINDOW    (60)  /**< Number of frames kept for the minimum, average and maximum values. */
+#define FRAME_STATS_COUNTERS  (sizeof(GRRLIB_frameCounters) / sizeof(u32))  /**< Number of counters in GRRLIB_frameCounters. */
+
+GRRLIB_frameCounters  GRRLIB_FrameCounters;
+
+static GRRLIB_frameCounters  window[FRAME_STATS_WINDOW];  // Counters of the last frames
+static u32  windowNext = 0;    // Next frame to write in window
+static u32  windowCount = 0;   // Number of frames in window
+
+static u64  frameStart = 0;    // Time GRRLIB_Render was called for the previous frame
+static u64  frameEnd = 0;      // Time GRRLIB_Render returned for the previous frame
+
+static u32  gpMetric0 = GX_PERF0_NONE;
+static u32  gpMetric1 = GX_PERF1_NONE;
+
+/**
+ * Start measuring the end of a frame. Called when GRRLIB_Render is entered.
+ */
+void  GRRLIB_FrameStatsBegin (void) {
+	const u64 now = gettime();
+
+	if (frameEnd != 0) {
+		GRRLIB_FrameCounters.frameTime = ticks_to_microsecs(now - frameStart);
+		GRRLIB_FrameCounters.cpuTime = ticks_to_microsecs(now - frameEnd);
+	}
+	frameStart = now;
+}
+
+/**
+ * Store the counters of the frame and start counting the next one. Called when GRRLIB_Render returns.
+ */
+void  GRRLIB_FrameStatsEnd (void) {
+	if (gpMetric0 != GX_PERF0_NONE || gpMetric1 != GX_PERF1_NONE) {
+		GX_ReadGPMetric(&GRRLIB_FrameCounters.gpMetric0, &GRRLIB_FrameCounters.gpMetric1);
+		GX_ClearGPMetric();
+	}
+
+	window[windowNext] = GRRLIB_FrameCounters;
+	windowNext = (windowNext + 1) % FRAME_STATS_WINDOW;
+	if (windowCount < FRAME_STATS_WINDOW) {
+		windowCount++;
+	}
+
+	memset(&GRRLIB_FrameCounters, 0, sizeof(GRRLIB_FrameCounters));
+	frameEnd = gettime();
+}
+
+/**
+ * Get the counters of the last frame, and their minimum, average and maximum values over the last 60 frames.
+ * Times are in microseconds. GX_Begin and vertex counts only include GRRLIB drawing, and draws recorded in a display list are counted when recorded.
+ * In pipelined mode the GX performance metrics may include part of the next frame.
+ * @return A GRRLIB_frameStats structure.
+ */
+GRRLIB_frameStats  GRRLIB_GetFrameStats (void) {
+	GRRLIB_frameStats  stats;
+	u32  *min = (u32*)&stats.min;
+	u32  *avg = (u32*)&stats.avg;
+	u32  *max = (u32*)&stats.max;
+	u64  sum[FRAME_STATS_COUNTERS] = {0};
+
+	memset(&stats, 0, sizeof(stats));
+	stats.frames = windowCount;
+	if (windowCount == 0) {
+		return stats;
+	}
+	stats.last = window[(windowNext + FRAME_STATS_WINDOW - 1) % FRAME_STATS_WINDOW];
+
+	memset(min, 0xFF, sizeof(stats.min));
+	for (u32 i = 0; i < windowCount; i++) {
+		const u32  *v = (const u32*)&window[i];
+		for (u32 j = 0; j < FRAME_STATS_COUNTERS; j++) {
+			if (v[j] < min[j]) {
+				min[j] = v[j];
+			}
+			if (v[j] > max[j]) {
+				max[j] = v[j];
+			}
+			sum[j] += v[j];
+		}
+	}
+	for (u32 j = 0; j < FRAME_STATS_COUNTERS; j++) {
+		avg[j] = sum[j] / windowCount;
+	}
+	return stats;
+}
+
+/**
+ * Forget the counters of the previous frames.
+ */
+void  GRRLIB_ResetFrameStats (void) {
+	windowNext = 0;
+	windowCount = 0;
+}
+
+/**
+ * Choose the GX performance counters stored in gpMetric0 and gpMetric1 for each frame.
+ * For example GX_PERF0_VERTICES, GX_PERF0_CLOCKS or GX_PERF1_TC_MISS.
+ * Both counters are off by default.
+ * @param perf0 A GX_PERF0 metric, or GX_PERF0_NONE.
+ * @param perf1 A GX_PERF1 metric, or GX_PERF1_NONE.
+ */
+void  GRRLIB_SetFrameStatsMetric (const u32 perf0, const u32 perf1) {
+	gpMetric0 = perf0;
+	gpMetric1 = perf1;
+	GX_SetGPMetric(perf0, perf1);
+	GX_ClearGPMetric();
+}
+
+/**
+ * Draw the times of the last frame as a bar, in 2D mode.
+ * The bar is 256 pixels wide for two frames, and shows the application time in green, the time waiting for the GPU in yellow and the time waiting for a frame buffer in blue.
+ * The white mark is the length of one frame and the red mark is the longest frame of the last 60 frames.
+ * @param xpos Specifies the x-coordinate of the upper-left corner of the bar.
+ * @param ypos Specifies the y-coordinate of the upper-left corner of the bar.
+ */
+void  GRRLIB_DrawFrameStats (const f32 xpos, const f32 ypos) {
+	const u32 tvMode = VIDEO_GetCurrentTvMode();
+	const f32 budget = (tvMode == VI_PAL || tvMode == VI_DEBUG_PAL) ? 20000.0f : 16683.0f;
+	const f32 scale = 128.0f / budget;
+	const f32 x = (s32)xpos, y = (s32)ypos;
+	const GRRLIB_frameStats stats = GRRLIB_GetFrameStats();
+	const u32 color = GRRLIB_Settings.color;
+	f32 cpu, gpu, vsync, worst;
+
+	// The bars stop at the end of the graph
+	cpu   = (s32)(stats.last.cpuTime   * scale);
+	gpu   = (s32)(stats.last.gpuWait   * scale);
+	vsync = (s32)(stats.last.vsyncWait * scale);
+	worst = (s32)(stats.max.frameTime  * scale);
+	cpu   = (cpu > 256) ? 256 : cpu;
+	gpu   = (cpu + gpu > 256) ? 256 - cpu : gpu;
+	vsync = (cpu + gpu + vsync > 256) ? 256 - cpu - gpu : vsync;
+
+	GRRLIB_Settings.color = 0x000000A0;
+	GRRLIB_Rectangle(x, y, 256, 12, true);
+	GRRLIB_Settings.color = 0x40FF40FF;
+	GRRLIB_Rectangle(x, y + 2, cpu, 8, true);
+	GRRLIB_Settings.color = 0xFFFF40FF;
+	GRRLIB_Rectangle(x + cpu, y + 2, gpu, 8, true);
+	GRRLIB_Settings.color = 0x4080FFFF;
+	GRRLIB_Rectangle(x + cpu + gpu, y + 2, vsync, 8, true);
+	GRRLIB_Settings.color = 0xFFFFFFFF;
+	GRRLIB_Rectangle(x + 128, y, 1, 12, true);
+	if (worst < 256) {
+		GRRLIB_Settings.color = 0xFF4040FF;
+		GRRLIB_Rectangle(x + worst, y, 1, 12, true);
+	}
+	GRRLIB_Settings.color = color;
+}
@@ -0,0 +1,417 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define LOADER_MAX_THREADS   (4)                     /**< Maximum number of threads of a loader. */
+#define LOADER_STACK_SIZE    (64 * 1024)             /**< Stack size of the threads of a loader. */
+#define LOADER_THREAD_PRIO   (LWP_PRIO_NORMAL - 16)  /**< Below the main thread, which runs at LWP_PRIO_NORMAL. */
+
+/**
+ * Structure to hold a request of a loader.
+ */
+typedef  struct GRRLIB_loadJob {
+	u32                     id;        /**< Identifier returned to the application. */
+	GRRLIB_loadType         type;      /**< The kind of request. */
+	s32                     priority;  /**< Requests with a higher priority are loaded first. */
+	u32                     fmt;       /**< Format of a texture. */
+	GRRLIB_loadCallback     callback;  /**< Function called by GRRLIB_LoaderPoll, can be NULL. */
+	void                   *userData;  /**< Pointer given to the callback. */
+	bool                    canceled;  /**< The request was canceled while it was being loaded. */
+	GRRLIB_texture         *texture;   /**< The loaded texture. */
+	u8                     *data;      /**< The file of a font. */
+	s32                     size;      /**< Size of the file of a font. */
+	struct GRRLIB_loadJob  *next;      /**< Next request in the same list. */
+	char                    filename[];  /**< The file to load. */
+} GRRLIB_loadJob;
+
+/**
+ * Structure to hold a loader, see GRRLIB_CreateLoader.
+ */
+struct GRRLIB_loader {
+	mutex_t          lock;                         /**< Protects the lists and the counters. */
+	cond_t           work;                         /**< Signaled when a request is queued or the loader is freed. */
+	cond_t           idle;                         /**< Signaled when a request is loaded. */
+	lwp_t            threads[LOADER_MAX_THREADS];  /**< The threads. */
+	u32              threadCount;                  /**< Number of threads. */
+	bool             quit;                         /**< The threads must return. */
+	u32              nextId;                       /**< Identifier of the next request. */
+	GRRLIB_loadJob  *queued;                       /**< Requests waiting for a thread, by decreasing priority. */
+	GRRLIB_loadJob  *running;                      /**< Requests being loaded. */
+	GRRLIB_loadJob  *done;                         /**< Loaded requests, in the order they completed. */
+	GRRLIB_loadJob  *doneLast;                     /**< Last loaded request. */
+};
+
+/**
+ * Free a request and what it loaded.
+ */
+static void  LoadJobFree (GRRLIB_loadJob *job) {
+	GRRLIB_FreeTexture(job->texture);
+	free(job->data);
+	GRRLIB_MemFree(job, sizeof(GRRLIB_loadJob) + strlen(job->filename) + 1);
+}
+
+/**
+ * Remove a request from a list.
+ * @param list The first request of the list.
+ * @param id The identifier of the request.
+ * @return The request, NULL if it is not in the list.
+ */
+static GRRLIB_loadJob*  LoadJobRemove (GRRLIB_loadJob **list, const u32 id) {
+	GRRLIB_loadJob *job;
+
+	for (; *list != NULL; list = &(*list)->next) {
+		if ((*list)->id == id) {
+			job = *list;
+			*list = job->next;
+			return job;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Read and decode the file of a request, without holding the lock of the loader.
+ * Textures are finalized here, GRRLIB_FinalizeTexture only writes to the texture itself.
+ * Fonts are only read, the FreeType library can not be used by several threads.
+ */
+static void  LoadJobRun (GRRLIB_loadJob *job) {
+	u8 *data;
+	const s32 size = GRRLIB_LoadFile(job->filename, &data);
+
+	if (size <= 0) {
+		return;
+	}
+	if (job->type == GRRLIB_LOAD_TTF) {
+		job->data = data;
+		job->size = size;
+		return;
+	}
+	job->texture = GRRLIB_LoadTextureFmt(data, size, job->fmt);
+	free(data);
+}
+
+/**
+ * Entry of the threads of a loader: load requests, highest priority first, until the loader is freed.
+ */
+static void*  LoaderThread (void *arg) {
+	GRRLIB_loader *loader = arg;
+	GRRLIB_loadJob *job;
+
+	LWP_MutexLock(loader->lock);
+	while (loader->quit == false) {
+		if (loader->queued == NULL) {
+			LWP_CondWait(loader->work, loader->lock);
+			continue;
+		}
+		job = loader->queued;
+		loader->queued = job->next;
+		job->next = loader->running;
+		loader->running = job;
+		LWP_MutexUnlock(loader->lock);
+
+		LoadJobRun(job);
+
+		LWP_MutexLock(loader->lock);
+		LoadJobRemove(&loader->running, job->id);
+		if (job->canceled == true) {
+			LoadJobFree(job);
+		}
+		else {
+			job->next = NULL;
+			if (loader->doneLast != NULL)  loader->doneLast->next = job;
+			else                           loader->done = job;
+			loader->doneLast = job;
+		}
+		LWP_CondBroadcast(loader->idle);
+	}
+	LWP_MutexUnlock(loader->lock);
+	return NULL;
+}
+
+/**
+ * Create a loader, which reads and decodes textures and fonts on background threads.
+ * The threads run below the priority of the main thread, using the time it spends waiting for the GPU or the retrace.
+ * Loaded requests are handed back by GRRLIB_LoaderPoll, on the thread calling it.
+ * @param threads Number of threads, from 1 to 4.
+ * @return The loader, NULL if it could not be created.
+ * @see GRRLIB_FreeLoader
+ */
+GRRLIB_loader*  GRRLIB_CreateLoader (const u32 threads) {
+	GRRLIB_loader *loader;
+	u32 i;
+
+	if (threads == 0 || threads > LOADER_MAX_THREADS) {
+		return NULL;
+	}
+	loader = GRRLIB_MemCalloc(sizeof(GRRLIB_loader), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (loader == NULL) {
+		return NULL;
+	}
+	loader->nextId = 1;
+	if (LWP_MutexInit(&loader->lock, false) < 0) {
+		GRRLIB_MemFree(loader, sizeof(GRRLIB_loader));
+		return NULL;
+	}
+	if (LWP_CondInit(&loader->work) < 0 || LWP_CondInit(&loader->idle) < 0) {
+		LWP_MutexDestroy(loader->lock);
+		GRRLIB_MemFree(loader, sizeof(GRRLIB_loader));
+		return NULL;
+	}
+	for (i = 0; i < threads; i++) {
+		if (LWP_CreateThread(&loader->threads[i], LoaderThread, loader, NULL, LOADER_STACK_SIZE, LOADER_THREAD_PRIO) < 0) {
+			break;
+		}
+		loader->threadCount++;
+	}
+	if (loader->threadCount == 0) {
+		GRRLIB_FreeLoader(loader);
+		return NULL;
+	}
+	return loader;
+}
+
+/**
+ * Queue a request in a loader.
+ * @return The identifier of the request, 0 if it could not be queued.
+ */
+static u32  LoaderQueue (GRRLIB_loader *loader, const GRRLIB_loadType type, const char *filename, const u32 fmt,
+                         const s32 priority, GRRLIB_loadCallback callback, void *userData) {
+	GRRLIB_loadJob *job, **at;
+	const size_t length = strlen(filename);
+
+	job = GRRLIB_MemCalloc(sizeof(GRRLIB_loadJob) + length + 1, GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (job == NULL) {
+		return 0;
+	}
+	job->type = type;
+	job->priority = priority;
+	job->fmt = fmt;
+	job->callback = callback;
+	job->userData = userData;
+	memcpy(job->filename, filename, length + 1);
+
+	LWP_MutexLock(loader->lock);
+	job->id = loader->nextId++;
+	if (loader->nextId == 0) {
+		loader->nextId = 1;
+	}
+	// After the requests of the same priority
+	for (at = &loader->queued; *at != NULL && (*at)->priority >= priority; at = &(*at)->next) {
+	}
+	job->next = *at;
+	*at = job;
+	LWP_CondSignal(loader->work);
+	LWP_MutexUnlock(loader->lock);
+	return job->id;
+}
+
+/**
+ * Queue a texture to be loaded from a file.
+ * @param loader The loader.
+ * @param filename The JPEG, PNG, Bitmap or TPL file to load.
+ * @param fmt The format of the texture, see GRRLIB_LoadTextureFmt.
+ * @param priority Requests with a higher priority are loaded first, requests of the same priority in order.
+ * @param callback Function called by GRRLIB_LoaderPoll once the texture is loaded, can be NULL.
+ * @param userData Pointer given back with the texture.
+ * @return The identifier of the request, 0 if it could not be queued.
+ */
+u32  GRRLIB_LoaderQueueTexture (GRRLIB_loader *loader, const char *filename, const u32 fmt, const s32 priority,
+                                GRRLIB_loadCallback callback, void *userData) {
+	return LoaderQueue(loader, GRRLIB_LOAD_TEXTURE, filename, fmt, priority, callback, userData);
+}
+
+/**
+ * Queue a TTF font to be loaded from a file.
+ * The file is read by the loader and the font is opened by GRRLIB_LoaderPoll.
+ * @param loader The loader.
+ * @param filename The TTF file to load.
+ * @param priority Requests with a higher priority are loaded first, requests of the same priority in order.
+ * @param callback Function called by GRRLIB_LoaderPoll once the font is loaded, can be NULL.
+ * @param userData Pointer given back with the font.
+ * @return The identifier of the request, 0 if it could not be queued.
+ */
+u32  GRRLIB_LoaderQueueTTF (GRRLIB_loader *loader, const char *filename, const s32 priority,
+                            GRRLIB_loadCallback callback, void *userData) {
+	return LoaderQueue(loader, GRRLIB_LOAD_TTF, filename, 0, priority, callback, userData);
+}
+
+/**
+ * Cancel a request which has not been handed back by GRRLIB_LoaderPoll.
+ * A request being loaded completes in the background and what it loaded is freed.
+ * @param loader The loader.
+ * @param id The identifier of the request.
+ * @return true if the request was canceled, false if it is unknown or was already handed back.
+ */
+bool  GRRLIB_LoaderCancel (GRRLIB_loader *loader, const u32 id) {
+	GRRLIB_loadJob *job, *prev = NULL;
+	bool found = false;
+
+	LWP_MutexLock(loader->lock);
+	if ((job = LoadJobRemove(&loader->queued, id)) != NULL) {
+		LoadJobFree(job);
+		found = true;
+	}
+	else {
+		for (job = loader->running; job != NULL && job->id != id; job = job->next) {
+		}
+		if (job != NULL) {
+			job->canceled = true;
+			found = true;
+		}
+		else {
+			for (job = loader->done; job != NULL && job->id != id; prev = job, job = job->next) {
+			}
+			if (job != NULL) {
+				if (job == loader->doneLast)  loader->doneLast = prev;
+				LoadJobRemove(&loader->done, id);
+				LoadJobFree(job);
+				found = true;
+			}
+		}
+	}
+	LWP_MutexUnlock(loader->lock);
+	return found;
+}
+
+/**
+ * Hand back the next request loaded by a loader.
+ * Fonts are opened here, and the callback of the request is called before this function returns.
+ * The texture or font then belongs to the application. Call it once per frame from the thread drawing,
+ * until it returns false.
+ * @param loader The loader.
+ * @param result Receives the request, can be NULL when callbacks are used.
+ * @return true if a request was handed back, false if none is loaded yet.
+ */
+bool  GRRLIB_LoaderPoll (GRRLIB_loader *loader, GRRLIB_loadResult *result) {
+	GRRLIB_loadResult res;
+	GRRLIB_loadCallback callback;
+	GRRLIB_loadJob *job;
+
+	LWP_MutexLock(loader->lock);
+	job = loader->done;
+	if (job != NULL) {
+		loader->done = job->next;
+		if (loader->done == NULL) {
+			loader->doneLast = NULL;
+		}
+	}
+	LWP_MutexUnlock(loader->lock);
+	if (job == NULL) {
+		return false;
+	}
+
+	res.id = job->id;
+	res.type = job->type;
+	res.userData = job->userData;
+	res.texture = job->texture;
+	res.font = NULL;
+	callback = job->callback;
+	if (job->data != NULL) {
+		res.font = GRRLIB_LoadTTF(job->data, job->size);
+		if (res.font != NULL) {
+			res.font->data = job->data;
+		}
+		else {
+			free(job->data);
+		}
+	}
+	GRRLIB_MemFree(job, sizeof(GRRLIB_loadJob) + strlen(job->filename) + 1);
+
+	if (callback != NULL) {
+		callback(&res);
+	}
+	if (result != NULL) {
+		*result = res;
+	}
+	return true;
+}
+
+/**
+ * Return the number of requests of a loader not handed back yet, queued, being loaded or loaded.
+ * @param loader The loader.
+ * @return The number of requests.
+ */
+u32  GRRLIB_LoaderPending (GRRLIB_loader *loader) {
+	GRRLIB_loadJob *job;
+	u32 count = 0;
+
+	LWP_MutexLock(loader->lock);
+	for (job = loader->queued; job != NULL; job = job->next)   count++;
+	for (job = loader->running; job != NULL; job = job->next)  count += (job->canceled == false);
+	for (job = loader->done; job != NULL; job = job->next)     count++;
+	LWP_MutexUnlock(loader->lock);
+	return count;
+}
+
+/**
+ * Wait until every request queued in a loader is loaded.
+ * The requests still have to be handed back with GRRLIB_LoaderPoll.
+ * @param loader The loader.
+ */
+void  GRRLIB_LoaderWait (GRRLIB_loader *loader) {
+	LWP_MutexLock(loader->lock);
+	while (loader->queued != NULL || loader->running != NULL) {
+		LWP_CondWait(loader->idle, loader->lock);
+	}
+	LWP_MutexUnlock(loader->lock);
+}
+
+/**
+ * Free a loader and its threads.
+ * Queued requests are canceled, the function waits for the requests being loaded,
+ * and requests not handed back are freed without calling their callback.
+ * If \a loader is a null pointer, the function does nothing.
+ * @param loader The loader.
+ */
+void  GRRLIB_FreeLoader (GRRLIB_loader *loader) {
+	GRRLIB_loadJob *job;
+	u32 i;
+
+	if (loader == NULL) {
+		return;
+	}
+	LWP_MutexLock(loader->lock);
+	loader->quit = true;
+	while ((job = loader->queued) != NULL) {
+		loader->queued = job->next;
+		LoadJobFree(job);
+	}
+	LWP_CondBroadcast(loader->work);
+	LWP_MutexUnlock(loader->lock);
+
+	for (i = 0; i < loader->threadCount; i++) {
+		LWP_JoinThread(loader->threads[i], NULL);
+	}
+	while ((job = loader->done) != NULL) {
+		loader->done = job->next;
+		LoadJobFree(job);
+	}
+	LWP_CondDestroy(loader->idle);
+	LWP_CondDestroy(loader->work);
+	LWP_MutexDestroy(loader->lock);
+	GRRLIB_MemFree(loader, sizeof(GRRLIB_loader));
+}
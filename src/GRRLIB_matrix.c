@@ -40,8 +40,10 @@ GRRLIB_matrix GRRLIB_GetMatrix (void) {
  * @param matrixObject The matrix object to set the matrix with.
  */
 void GRRLIB_SetMatrix (GRRLIB_matrix *matrixObject) {
+    GRRLIB_SpriteBatchFlush();
+
     guMtxCopy(matrixObject->matrix, GRRLIB_View2D);
-    GX_LoadPosMtxImm(matrixObject->matrix, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(matrixObject->matrix);
 }
 
 /**
@@ -52,11 +54,13 @@ void GRRLIB_SetMatrix (GRRLIB_matrix *matrixObject) {
 void GRRLIB_Scale (f32 scaleX, f32 scaleY) {
     Mtx m;
 
+    GRRLIB_SpriteBatchFlush();
+
     guMtxIdentity(m);
     guMtxScaleApply(m, m, scaleX, scaleY, 1.0);
 
     guMtxConcat(GRRLIB_View2D, m, GRRLIB_View2D);
-    GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 }
 
 /**
@@ -66,10 +70,12 @@ void GRRLIB_Scale (f32 scaleX, f32 scaleY) {
 void GRRLIB_Rotate (f32 degrees) {
     Mtx m;
 
+    GRRLIB_SpriteBatchFlush();
+
     guMtxRotAxisDeg(m, &GRRLIB_Axis2D, degrees);
 
     guMtxConcat(GRRLIB_View2D, m, GRRLIB_View2D);
-    GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 }
 
 /**
@@ -80,11 +86,13 @@ void GRRLIB_Rotate (f32 degrees) {
 void GRRLIB_Translate (f32 posX, f32 posY) {
     Mtx m;
 
+    GRRLIB_SpriteBatchFlush();
+
     guMtxIdentity(m);
     guMtxTransApply(m, m, posX, posY, 0.0);
 
     guMtxConcat(GRRLIB_View2D, m, GRRLIB_View2D);
-    GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 }
 
 /**
@@ -98,6 +106,8 @@ void GRRLIB_Translate (f32 posX, f32 posY) {
 void GRRLIB_Transform (f32 scaleX, f32 scaleY, f32 degrees, f32 posX, f32 posY) {
     Mtx m1, m2, m;
 
+    GRRLIB_SpriteBatchFlush();
+
     guMtxIdentity(m1);
     guMtxScaleApply(m1, m1, scaleX, scaleY, 1.0);
     guMtxRotAxisDeg(m2, &GRRLIB_Axis2D, degrees);
@@ -105,7 +115,7 @@ void GRRLIB_Transform (f32 scaleX, f32 scaleY, f32 degrees, f32 posX, f32 posY)
     guMtxTransApply(m, m, posX, posY, 0.0);
 
     guMtxConcat(GRRLIB_View2D, m, GRRLIB_View2D);
-    GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 }
 
 /**
@@ -119,6 +129,8 @@ void GRRLIB_Transform (f32 scaleX, f32 scaleY, f32 degrees, f32 posX, f32 posY)
 void GRRLIB_TransformInv (f32 scaleX, f32 scaleY, f32 posX, f32 posY, f32 degrees) {
     Mtx m1, m2, m;
 
+    GRRLIB_SpriteBatchFlush();
+
     guMtxIdentity(m1);
     guMtxScaleApply(m1, m1, scaleX, scaleY, 1.0);
     guMtxTransApply(m2, m2, posX, posY, 0.0);
@@ -126,14 +138,16 @@ void GRRLIB_TransformInv (f32 scaleX, f32 scaleY, f32 posX, f32 posY, f32 degree
     guMtxRotAxisDeg(m, &GRRLIB_Axis2D, degrees);
 
     guMtxConcat(GRRLIB_View2D, m, GRRLIB_View2D);
-    GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 }
 
 /**
  * Reset the current matrix.
  */
 void GRRLIB_Origin (void) {
+    GRRLIB_SpriteBatchFlush();
+
     guMtxIdentity(GRRLIB_View2D);
     guMtxTransApply(GRRLIB_View2D, GRRLIB_View2D, 0.0, 0.0, -100.0);
-    GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
+    GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
 }
@@ -0,0 +1,538 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+
+#define POOL_CLASSES     (6)          /**< Block sizes of a pool: 8, 16, 32, 64, 128 and 256 bytes. */
+#define POOL_CHUNK_SIZE  (16 * 1024)  /**< Memory taken from the backing allocator at a time by a pool. */
+
+/**
+ * Memory owned by an arena or a pool.
+ * GRRLIB_MemFree gives memory in a region back to its owner, whichever allocator is installed.
+ */
+typedef  struct GRRLIB_memRegion {
+	u8                       *start;  /**< First byte of the region. */
+	u8                       *end;    /**< Byte after the region. */
+	void                    (*free)(struct GRRLIB_memRegion *region, void *ptr, const u32 size);  /**< Free a block of the region. */
+	void                     *owner;  /**< The arena or pool. */
+	u32                       block;  /**< Block size of a pool chunk. */
+	struct GRRLIB_memRegion  *next;   /**< Next region. */
+} GRRLIB_memRegion;
+
+/**
+ * Structure to hold an arena, see GRRLIB_CreateArena.
+ */
+struct GRRLIB_arena {
+	GRRLIB_memRegion  region;      /**< The memory of the arena. */
+	GRRLIB_allocator  backing;     /**< Allocator of scratch buffers and of blocks not fitting in the arena. */
+	bool              owned;       /**< The memory was allocated by GRRLIB_CreateArena. */
+	u32               used;        /**< Bytes used from the start of the arena. */
+	u32               liveBytes;   /**< Bytes of the blocks of the arena not freed. */
+	u32               liveBlocks;  /**< Number of blocks of the arena not freed. */
+};
+
+/**
+ * Structure to hold a pool, see GRRLIB_CreatePool.
+ */
+struct GRRLIB_pool {
+	GRRLIB_allocator   backing;                /**< Allocator of the chunks and of the blocks too large for the pool. */
+	void              *freeList[POOL_CLASSES];  /**< Free blocks of each size. */
+};
+
+static void*  DefaultAlloc (u32 size, u32 align, GRRLIB_memHint hint, void *user);
+static void   DefaultFree (void *ptr, u32 size, void *user);
+static void   PoolFree (GRRLIB_memRegion *region, void *ptr, const u32 size);
+
+static const GRRLIB_allocator  defaultAllocator = { DefaultAlloc, DefaultFree, NULL };
+
+static GRRLIB_allocator   allocator = { DefaultAlloc, DefaultFree, NULL };
+static GRRLIB_memRegion  *regions = NULL;
+static GRRLIB_memStats    memStats;
+static mutex_t            memLock = LWP_MUTEX_NULL;
+
+/**
+ * Lock the allocator, the loader threads allocate too.
+ * The lock is created by the first allocation, which happens on the main thread.
+ */
+static void  MemLock (void) {
+	if (memLock == LWP_MUTEX_NULL) {
+		LWP_MutexInit(&memLock, true);
+	}
+	LWP_MutexLock(memLock);
+}
+
+/**
+ * Unlock the allocator.
+ */
+static inline void  MemUnlock (void) {
+	LWP_MutexUnlock(memLock);
+}
+
+/**
+ * Allocate memory from the heap, the placement hint is ignored.
+ */
+static void*  DefaultAlloc (u32 size, u32 align, GRRLIB_memHint hint, void *user) {
+	return memalign((align < sizeof(void*)) ? sizeof(void*) : align, size);
+}
+
+/**
+ * Give memory back to the heap.
+ */
+static void  DefaultFree (void *ptr, u32 size, void *user) {
+	free(ptr);
+}
+
+/**
+ * Add a region to the list searched by GRRLIB_MemFree.
+ */
+static void  RegionAdd (GRRLIB_memRegion *region) {
+	region->next = regions;
+	regions = region;
+}
+
+/**
+ * Remove a region from the list searched by GRRLIB_MemFree.
+ */
+static void  RegionRemove (GRRLIB_memRegion *region) {
+	GRRLIB_memRegion **at;
+
+	for (at = &regions; *at != NULL; at = &(*at)->next) {
+		if (*at == region) {
+			*at = region->next;
+			return;
+		}
+	}
+}
+
+/**
+ * Install the allocator GRRLIB allocates its memory with.
+ * Memory is given back to the allocator installed when it is freed, except memory of arenas and pools,
+ * which always goes back to them. Install other allocators before GRRLIB_Init and keep them.
+ * Memory the application frees itself, like the buffer of GRRLIB_LoadFile, is still allocated with malloc.
+ * @param alloc The allocator, copied. NULL to go back to memalign and free.
+ * @see GRRLIB_CreateArena, GRRLIB_CreatePool
+ */
+void  GRRLIB_SetAllocator (const GRRLIB_allocator *alloc) {
+	MemLock();
+	allocator = (alloc != NULL) ? *alloc : defaultAllocator;
+	MemUnlock();
+}
+
+/**
+ * Return the allocator installed with GRRLIB_SetAllocator.
+ * @return A copy of the allocator.
+ */
+GRRLIB_allocator  GRRLIB_GetAllocator (void) {
+	GRRLIB_allocator alloc;
+
+	MemLock();
+	alloc = allocator;
+	MemUnlock();
+	return alloc;
+}
+
+/**
+ * Allocate memory with the installed allocator.
+ * @param size Number of bytes.
+ * @param align Alignment of the memory, a power of two.
+ * @param hint The kind of memory, for the allocator to place it.
+ * @return The memory, NULL if it could not be allocated.
+ */
+void*  GRRLIB_MemAlloc (const u32 size, const u32 align, const GRRLIB_memHint hint) {
+	void *ptr;
+
+	MemLock();
+	ptr = allocator.alloc(size, align, hint, allocator.user);
+	if (ptr == NULL) {
+		memStats.failures++;
+	}
+	else {
+		memStats.allocations++;
+		memStats.liveBlocks++;
+		memStats.liveBytes += size;
+		if (memStats.liveBytes > memStats.peakBytes) {
+			memStats.peakBytes = memStats.liveBytes;
+		}
+	}
+	MemUnlock();
+	return ptr;
+}
+
+/**
+ * Allocate memory set to zero with the installed allocator.
+ * @param size Number of bytes.
+ * @param align Alignment of the memory, a power of two.
+ * @param hint The kind of memory, for the allocator to place it.
+ * @return The memory, NULL if it could not be allocated.
+ */
+void*  GRRLIB_MemCalloc (const u32 size, const u32 align, const GRRLIB_memHint hint) {
+	void *ptr = GRRLIB_MemAlloc(size, align, hint);
+
+	if (ptr != NULL) {
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+/**
+ * Move memory to a new allocation of another size, like realloc.
+ * Allocators have no resize hook, so the memory is always copied.
+ * @param ptr The memory, NULL to allocate new memory.
+ * @param oldSize The size it was allocated with.
+ * @param newSize The new number of bytes.
+ * @param align Alignment of the memory, a power of two.
+ * @param hint The kind of memory, for the allocator to place it.
+ * @return The new memory, NULL if it could not be allocated: \a ptr is then left untouched.
+ */
+void*  GRRLIB_MemRealloc (void *ptr, const u32 oldSize, const u32 newSize, const u32 align, const GRRLIB_memHint hint) {
+	void *moved = GRRLIB_MemAlloc(newSize, align, hint);
+
+	if (moved != NULL && ptr != NULL) {
+		memcpy(moved, ptr, (oldSize < newSize) ? oldSize : newSize);
+		GRRLIB_MemFree(ptr, oldSize);
+	}
+	return moved;
+}
+
+/**
+ * Free memory allocated with GRRLIB_MemAlloc or GRRLIB_MemCalloc.
+ * If \a ptr is a null pointer, the function does nothing.
+ * @param ptr The memory.
+ * @param size The size it was allocated with.
+ */
+void  GRRLIB_MemFree (void *ptr, const u32 size) {
+	GRRLIB_memRegion *region;
+
+	if (ptr == NULL) {
+		return;
+	}
+	MemLock();
+	memStats.liveBlocks--;
+	memStats.liveBytes -= size;
+	for (region = regions; region != NULL; region = region->next) {
+		if ((u8*)ptr >= region->start && (u8*)ptr < region->end) {
+			break;
+		}
+	}
+	if (region != NULL)  region->free(region, ptr, size);
+	else                 allocator.free(ptr, size, allocator.user);
+	MemUnlock();
+}
+
+/**
+ * Return the memory allocated by GRRLIB and not freed, and its peak.
+ * @return The counters.
+ */
+GRRLIB_memStats  GRRLIB_GetMemStats (void) {
+	GRRLIB_memStats stats;
+
+	MemLock();
+	stats = memStats;
+	MemUnlock();
+	return stats;
+}
+
+/**
+ * Reset the peak to the memory in use and clear the allocation and failure counts.
+ */
+void  GRRLIB_ResetMemStats (void) {
+	MemLock();
+	memStats.peakBytes = memStats.liveBytes;
+	memStats.allocations = 0;
+	memStats.failures = 0;
+	MemUnlock();
+}
+
+//------------------------------------------------------------------------------
+// Arenas
+
+/**
+ * Allocate from an arena by moving its end, scratch buffers and blocks not fitting go to the backing allocator.
+ */
+static void*  ArenaAlloc (u32 size, u32 align, GRRLIB_memHint hint, void *user) {
+	GRRLIB_arena *arena = user;
+	const u32 start = (arena->used + align - 1) & ~(align - 1);
+	const u32 capacity = arena->region.end - arena->region.start;
+
+	if (hint == GRRLIB_MEM_SCRATCH || start > capacity || size > capacity - start) {
+		return arena->backing.alloc(size, align, hint, arena->backing.user);
+	}
+	arena->used = start + size;
+	arena->liveBytes += size;
+	arena->liveBlocks++;
+	return arena->region.start + start;
+}
+
+/**
+ * Free memory allocated from the backing allocator while the arena was installed.
+ */
+static void  ArenaFreeForeign (void *ptr, u32 size, void *user) {
+	GRRLIB_arena *arena = user;
+
+	arena->backing.free(ptr, size, arena->backing.user);
+}
+
+/**
+ * Free a block of an arena, its memory is only reused when it is the last block or the arena becomes empty.
+ */
+static void  ArenaFree (GRRLIB_memRegion *region, void *ptr, const u32 size) {
+	GRRLIB_arena *arena = region->owner;
+
+	arena->liveBytes -= size;
+	arena->liveBlocks--;
+	if (arena->liveBlocks == 0) {
+		arena->used = 0;
+	}
+	else if ((u8*)ptr + size == arena->region.start + arena->used) {
+		arena->used = (u8*)ptr - arena->region.start;
+	}
+}
+
+/**
+ * Create an arena: memory given out by moving a pointer and taken back all at once by GRRLIB_ResetArena.
+ * Install it with GRRLIB_SetAllocator while loading the assets of a level, free them with one reset.
+ * Scratch buffers and blocks not fitting in the arena are allocated with the allocator installed
+ * when the arena is created.
+ * @param memory The memory of the arena, for instance in MEM2. NULL to allocate it.
+ * @param size Size of the memory.
+ * @return The arena, NULL if it could not be created.
+ * @see GRRLIB_ArenaAllocator, GRRLIB_FreeArena
+ */
+GRRLIB_arena*  GRRLIB_CreateArena (void *memory, const u32 size) {
+	GRRLIB_arena *arena;
+
+	MemLock();
+	arena = allocator.alloc(sizeof(GRRLIB_arena), sizeof(void*), GRRLIB_MEM_HOT, allocator.user);
+	if (arena != NULL) {
+		memset(arena, 0, sizeof(GRRLIB_arena));
+		arena->backing = allocator;
+		arena->owned = (memory == NULL);
+		if (memory == NULL) {
+			memory = allocator.alloc(size, 32, GRRLIB_MEM_COLD, allocator.user);
+		}
+		if (memory == NULL) {
+			allocator.free(arena, sizeof(GRRLIB_arena), allocator.user);
+			arena = NULL;
+		}
+		else {
+			arena->region.start = memory;
+			arena->region.end = (u8*)memory + size;
+			arena->region.free = ArenaFree;
+			arena->region.owner = arena;
+			RegionAdd(&arena->region);
+		}
+	}
+	MemUnlock();
+	return arena;
+}
+
+/**
+ * Return the allocator of an arena, to install with GRRLIB_SetAllocator.
+ * @param arena The arena.
+ * @return The allocator.
+ */
+GRRLIB_allocator  GRRLIB_ArenaAllocator (GRRLIB_arena *arena) {
+	const GRRLIB_allocator alloc = { ArenaAlloc, ArenaFreeForeign, arena };
+
+	return alloc;
+}
+
+/**
+ * Return the bytes used from the start of an arena, including blocks freed out of order.
+ * @param arena The arena.
+ * @return The bytes used.
+ */
+u32  GRRLIB_GetArenaUsed (const GRRLIB_arena *arena) {
+	u32 used;
+
+	MemLock();
+	used = arena->used;
+	MemUnlock();
+	return used;
+}
+
+/**
+ * Take back all the memory of an arena.
+ * Textures and other objects allocated in the arena become invalid and must not be freed.
+ * @param arena The arena.
+ */
+void  GRRLIB_ResetArena (GRRLIB_arena *arena) {
+	MemLock();
+	memStats.liveBytes -= arena->liveBytes;
+	memStats.liveBlocks -= arena->liveBlocks;
+	arena->liveBytes = 0;
+	arena->liveBlocks = 0;
+	arena->used = 0;
+	MemUnlock();
+}
+
+/**
+ * Reset and free an arena, and its memory if it was allocated by GRRLIB_CreateArena.
+ * The arena must not be installed.
+ * If \a arena is a null pointer, the function does nothing.
+ * @param arena The arena.
+ */
+void  GRRLIB_FreeArena (GRRLIB_arena *arena) {
+	if (arena == NULL) {
+		return;
+	}
+	GRRLIB_ResetArena(arena);
+	MemLock();
+	RegionRemove(&arena->region);
+	if (arena->owned == true) {
+		arena->backing.free(arena->region.start, arena->region.end - arena->region.start, arena->backing.user);
+	}
+	arena->backing.free(arena, sizeof(GRRLIB_arena), arena->backing.user);
+	MemUnlock();
+}
+
+//------------------------------------------------------------------------------
+// Pools
+
+/**
+ * Return the size class of a block, POOL_CLASSES if it is too large for a pool.
+ */
+static u32  PoolClass (const u32 size, const u32 align) {
+	u32 c = 0;
+
+	while (c < POOL_CLASSES && ((8u << c) < size || (8u << c) < align)) {
+		c++;
+	}
+	return c;
+}
+
+/**
+ * Allocate a small block from the free list of its size, cutting a new chunk when it is empty.
+ */
+static void*  PoolAlloc (u32 size, u32 align, GRRLIB_memHint hint, void *user) {
+	GRRLIB_pool *pool = user;
+	const u32 c = PoolClass(size, align);
+	GRRLIB_memRegion *chunk;
+	void *block;
+	u8 *p;
+
+	if (c == POOL_CLASSES || align > 32) {
+		return pool->backing.alloc(size, align, hint, pool->backing.user);
+	}
+	if (pool->freeList[c] == NULL) {
+		chunk = pool->backing.alloc(POOL_CHUNK_SIZE, 32, GRRLIB_MEM_HOT, pool->backing.user);
+		if (chunk == NULL) {
+			return NULL;
+		}
+		// The region header takes the first blocks of the chunk
+		p = (u8*)chunk + ((sizeof(GRRLIB_memRegion) + (8u << c) - 1) & ~((8u << c) - 1));
+		chunk->start = p;
+		chunk->end = (u8*)chunk + POOL_CHUNK_SIZE;
+		chunk->free = PoolFree;
+		chunk->owner = pool;
+		chunk->block = 8u << c;
+		for (; p + chunk->block <= chunk->end; p += chunk->block) {
+			*(void**)p = pool->freeList[c];
+			pool->freeList[c] = p;
+		}
+		RegionAdd(chunk);
+	}
+	block = pool->freeList[c];
+	pool->freeList[c] = *(void**)block;
+	return block;
+}
+
+/**
+ * Free memory allocated from the backing allocator while the pool was installed.
+ */
+static void  PoolFreeForeign (void *ptr, u32 size, void *user) {
+	GRRLIB_pool *pool = user;
+
+	pool->backing.free(ptr, size, pool->backing.user);
+}
+
+/**
+ * Put a block back in the free list of its chunk.
+ */
+static void  PoolFree (GRRLIB_memRegion *region, void *ptr, const u32 size) {
+	GRRLIB_pool *pool = region->owner;
+	const u32 c = PoolClass(region->block, 0);
+
+	*(void**)ptr = pool->freeList[c];
+	pool->freeList[c] = ptr;
+}
+
+/**
+ * Create a pool, which serves blocks of up to 256 bytes from free lists of fixed sizes,
+ * for the many small structures of GRRLIB like GRRLIB_texture and GRRLIB_texturePart.
+ * Chunks of 16 KiB and larger blocks are allocated with the allocator installed when the pool is created.
+ * @return The pool, NULL if it could not be created.
+ * @see GRRLIB_PoolAllocator, GRRLIB_FreePool
+ */
+GRRLIB_pool*  GRRLIB_CreatePool (void) {
+	GRRLIB_pool *pool;
+
+	MemLock();
+	pool = allocator.alloc(sizeof(GRRLIB_pool), sizeof(void*), GRRLIB_MEM_HOT, allocator.user);
+	if (pool != NULL) {
+		memset(pool, 0, sizeof(GRRLIB_pool));
+		pool->backing = allocator;
+	}
+	MemUnlock();
+	return pool;
+}
+
+/**
+ * Return the allocator of a pool, to install with GRRLIB_SetAllocator.
+ * @param pool The pool.
+ * @return The allocator.
+ */
+GRRLIB_allocator  GRRLIB_PoolAllocator (GRRLIB_pool *pool) {
+	const GRRLIB_allocator alloc = { PoolAlloc, PoolFreeForeign, pool };
+
+	return alloc;
+}
+
+/**
+ * Free a pool and its chunks.
+ * The pool must not be installed, and every block allocated from it must have been freed.
+ * If \a pool is a null pointer, the function does nothing.
+ * @param pool The pool.
+ */
+void  GRRLIB_FreePool (GRRLIB_pool *pool) {
+	GRRLIB_memRegion **at = &regions, *chunk;
+
+	if (pool == NULL) {
+		return;
+	}
+	MemLock();
+	while (*at != NULL) {
+		chunk = *at;
+		if (chunk->owner == pool) {
+			*at = chunk->next;
+			pool->backing.free(chunk, POOL_CHUNK_SIZE, pool->backing.user);
+		}
+		else {
+			at = &chunk->next;
+		}
+	}
+	pool->backing.free(pool, sizeof(GRRLIB_pool), pool->backing.user);
+	MemUnlock();
+}
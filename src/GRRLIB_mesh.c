@@ -0,0 +1,569 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define MESH_DEFAULT_BUDGET  (512 * 1024)  /**< Default size of the mesh cache in bytes. */
+#define MESH_MAX_VERTICES    (65536)       /**< Number of vertices which can be referenced with 16-bit indices. */
+#define MESH_PINNED_FOREVER  (0xFFFFFFFF)  /**< Pins of a mesh used by a display list which could not record it. */
+
+/**
+ * Structure to identify a mesh by the primitive and the parameters used to build it.
+ */
+typedef  struct GRRLIB_meshKey {
+	u8   type;  /**< The primitive. */
+	int  n[2];  /**< Integer parameters of the primitive. */
+	f32  f[4];  /**< Float parameters of the primitive. */
+} GRRLIB_meshKey;
+
+/**
+ * Structure to hold one GX_Begin/GX_End block of a mesh.
+ */
+typedef  struct GRRLIB_meshGroup {
+	u8   primitive;  /**< Primitive used when the mesh is filled. */
+	u16  count;      /**< Vertex count given to GX_Begin. */
+	u32  first;      /**< Index of the first vertex reference. */
+	u32  length;     /**< Number of vertex references. */
+} GRRLIB_meshGroup;
+
+/**
+ * Structure to hold a mesh built from a 3D primitive.
+ */
+typedef  struct GRRLIB_mesh {
+	GRRLIB_meshKey     key;          /**< The primitive and its parameters. */
+	f32                *positions;   /**< Vertex positions (x, y, z). */
+	f32                *normals;     /**< Vertex normals (x, y, z). */
+	u32                vertexCount;  /**< Number of vertices. */
+	u16                *indices;     /**< Vertex references of a cached mesh. */
+	u32                *indices32;   /**< Vertex references of a mesh drawn once. */
+	u32                indexCount;   /**< Number of vertex references. */
+	GRRLIB_meshGroup   *groups;      /**< GX_Begin/GX_End blocks. */
+	u32                groupCount;   /**< Number of GX_Begin/GX_End blocks. */
+	u32                bytes;        /**< Memory used by the mesh. */
+	u32                lastFrame;    /**< Last frame the mesh was drawn. */
+	u32                pins;         /**< Number of display lists using the mesh, MESH_PINNED_FOREVER if one could not be recorded. */
+	struct GRRLIB_mesh *next;        /**< Next mesh in the cache, most recently used first. */
+} GRRLIB_mesh;
+
+static GRRLIB_mesh  *meshCache = NULL;
+static u32          meshCacheBytes = 0;
+static u32          meshCacheBudget = MESH_DEFAULT_BUDGET;
+static u32          meshFrame = 0;
+
+/**
+ * Add a vertex to a mesh.
+ * Only counts the vertex while the arrays are not allocated.
+ * @return The index of the vertex.
+ */
+static u32  MeshVertex (GRRLIB_mesh *mesh, const f32 px, const f32 py, const f32 pz,
+                        const f32 nx, const f32 ny, const f32 nz) {
+	if (mesh->positions != NULL) {
+		f32  *p = &mesh->positions[mesh->vertexCount * 3];
+		f32  *n = &mesh->normals[mesh->vertexCount * 3];
+
+		p[0] = px;  p[1] = py;  p[2] = pz;
+		n[0] = nx;  n[1] = ny;  n[2] = nz;
+	}
+	return mesh->vertexCount++;
+}
+
+/**
+ * Start a GX_Begin/GX_End block in a mesh.
+ * @param primitive The primitive used when the mesh is filled.
+ * @param count The vertex count given to GX_Begin.
+ */
+static void  MeshBegin (GRRLIB_mesh *mesh, const u8 primitive, const u16 count) {
+	if (mesh->groups != NULL) {
+		GRRLIB_meshGroup  *group = &mesh->groups[mesh->groupCount];
+
+		group->primitive = primitive;
+		group->count = count;
+		group->first = mesh->indexCount;
+		group->length = 0;
+	}
+	mesh->groupCount++;
+}
+
+/**
+ * Add a vertex reference to the current block of a mesh.
+ */
+static void  MeshIndex (GRRLIB_mesh *mesh, const u32 index) {
+	if (mesh->indices != NULL) {
+		mesh->indices[mesh->indexCount] = index;
+	}
+	else if (mesh->indices32 != NULL) {
+		mesh->indices32[mesh->indexCount] = index;
+	}
+	if (mesh->groups != NULL) {
+		mesh->groups[mesh->groupCount - 1].length++;
+	}
+	mesh->indexCount++;
+}
+
+/**
+ * Build a torus, see GRRLIB_DrawTorus.
+ */
+static void  MeshTorus (GRRLIB_mesh *mesh, const f32 r, const f32 R, const int nsides, const int rings) {
+	int i, j;
+	u32 first = mesh->vertexCount;
+	f32 theta, theta1;
+	f32 cosTheta, sinTheta;
+	f32 ringDelta, sideDelta;
+	f32 phi, cosPhi, sinPhi, dist;
+
+	if (rings <= 0) {
+		return;
+	}
+
+	ringDelta = 2.0 * M_PI / rings;
+	sideDelta = 2.0 * M_PI / nsides;
+
+	// One ring of vertices per angle, the first one is theta = 0
+	theta = 0.0;
+	cosTheta = 1.0;
+	sinTheta = 0.0;
+	for (i = 0; i <= rings; i++) {
+		phi = 0.0;
+		for (j = nsides; j >= 0; j--) {
+			phi += sideDelta;
+			cosPhi = cos(phi);
+			sinPhi = sin(phi);
+			dist = R + r * cosPhi;
+
+			MeshVertex(mesh, cosTheta * dist, -sinTheta * dist, r * sinPhi,
+			                 cosTheta * cosPhi, -sinTheta * cosPhi, sinPhi);
+		}
+		theta1 = theta + ringDelta;
+		cosTheta = cos(theta1);
+		sinTheta = sin(theta1);
+		theta = theta1;
+	}
+
+	for (i = 0; i < rings; i++) {
+		MeshBegin(mesh, GX_TRIANGLESTRIP, 2*(nsides+1));
+		for (j = 0; j <= nsides; j++) {
+			MeshIndex(mesh, first + (i + 1) * (nsides + 1) + j);
+			MeshIndex(mesh, first + i * (nsides + 1) + j);
+		}
+	}
+}
+
+/**
+ * Build a sphere, see GRRLIB_DrawSphere.
+ */
+static void  MeshSphere (GRRLIB_mesh *mesh, const f32 r, const int lats, const int longs) {
+	int i, j;
+	u32 first = mesh->vertexCount;
+	f32 lat, z, zr,
+		lng, x, y;
+
+	if (lats < 0) {
+		return;
+	}
+
+	// Latitudes go from (-1 / lats) to (lats / lats)
+	for (i = 0; i <= lats + 1; i++) {
+		lat = M_PI * (-0.5F + (f32) (i - 1) / lats);
+		z  = sin(lat);
+		zr = cos(lat);
+		for (j = 0; j <= longs; j++) {
+			lng = 2 * M_PI * (f32) (j - 1) / longs;
+			x = cos(lng);
+			y = sin(lng);
+
+			MeshVertex(mesh, x * zr * r, y * zr * r, z * r,
+			                 x * zr * r, y * zr * r, z * r);
+		}
+	}
+
+	for (i = 0; i <= lats; i++) {
+		MeshBegin(mesh, GX_TRIANGLESTRIP, 2*(longs+1));
+		for (j = 0; j <= longs; j++) {
+			MeshIndex(mesh, first + i * (longs + 1) + j);
+			MeshIndex(mesh, first + (i + 1) * (longs + 1) + j);
+		}
+	}
+}
+
+/**
+ * Build a disc as a triangle fan, used by the cylinder and the cone.
+ */
+static void  MeshDisc (GRRLIB_mesh *mesh, const f32 r, const f32 y, const f32 ny, const int d) {
+	int i;
+
+	MeshBegin(mesh, GX_TRIANGLEFAN, d+2);
+	MeshIndex(mesh, MeshVertex(mesh, 0.0f, y, 0.0f, 0.0f, ny, 0.0f));
+	for (i = 0; i <= d; i++) {
+		MeshIndex(mesh, MeshVertex(mesh, r * cosf( M_PI * 2.0f * i / d ), y, r * sinf( M_PI * 2.0f * i / d ),
+		                                 0.0f, ny, 0.0f));
+	}
+}
+
+/**
+ * Build a cylinder, see GRRLIB_DrawCylinder.
+ */
+static void  MeshCylinder (GRRLIB_mesh *mesh, const f32 r, const f32 h, const int d) {
+	int i;
+	f32 dx, dy;
+
+	MeshBegin(mesh, GX_TRIANGLESTRIP, 2 * (d+1));
+	for (i = 0; i <= d; i++) {
+		dx = cosf( M_PI * 2.0f * i / d );
+		dy = sinf( M_PI * 2.0f * i / d );
+		MeshIndex(mesh, MeshVertex(mesh, r * dx, -0.5f * h, r * dy, dx, 0.0f, dy));
+		MeshIndex(mesh, MeshVertex(mesh, r * dx,  0.5f * h, r * dy, dx, 0.0f, dy));
+	}
+
+	MeshDisc(mesh, r, -0.5f * h, -1.0f, d);
+	MeshDisc(mesh, r,  0.5f * h,  1.0f, d);
+}
+
+/**
+ * Build a cone, see GRRLIB_DrawCone.
+ */
+static void  MeshCone (GRRLIB_mesh *mesh, const f32 r, const f32 h, const int d) {
+	int i;
+	f32 dx, dy;
+
+	MeshBegin(mesh, GX_TRIANGLESTRIP, 2 * (d+1));
+	for (i = 0; i <= d; i++) {
+		dx = cosf( M_PI * 2.0f * i / d );
+		dy = sinf( M_PI * 2.0f * i / d );
+		MeshIndex(mesh, MeshVertex(mesh, 0, -0.5f * h, 0, dx, 0.0f, dy));
+		MeshIndex(mesh, MeshVertex(mesh, r * dx, 0.5f * h, r * dy, dx, 0.0f, dy));
+	}
+
+	MeshDisc(mesh, r, 0.5f * h, 1.0f, d);
+}
+
+/**
+ * Build a tesselated panel, see GRRLIB_DrawTessPanel.
+ */
+static void  MeshTessPanel (GRRLIB_mesh *mesh, const f32 w, const f32 wstep, const f32 h, const f32 hstep) {
+	f32 x, y;
+
+	f32 tmpy = h/2.0f;
+	f32 tmpx = w/2.0f;
+	int tmp = ((w/wstep)*2)+2;
+	for ( y = -tmpy; y <= tmpy; y += hstep ) {
+		MeshBegin(mesh, GX_TRIANGLESTRIP, tmp);
+		for ( x = -tmpx; x <= tmpx; x += wstep ) {
+			MeshIndex(mesh, MeshVertex(mesh, x, y, 0.0f, 0.0f, 0.0f, 1.0f));
+			MeshIndex(mesh, MeshVertex(mesh, x, y+hstep, 0.0f, 0.0f, 0.0f, 1.0f));
+		}
+	}
+}
+
+/**
+ * Build the geometry of a mesh, or only count it while the arrays are not allocated.
+ */
+static void  MeshBuild (GRRLIB_mesh *mesh) {
+	const GRRLIB_meshKey  *key = &mesh->key;
+
+	mesh->vertexCount = 0;
+	mesh->indexCount = 0;
+	mesh->groupCount = 0;
+
+	switch (key->type) {
+		case GRRLIB_MESH_TORUS:
+			MeshTorus(mesh, key->f[0], key->f[1], key->n[0], key->n[1]);
+			break;
+		case GRRLIB_MESH_SPHERE:
+			MeshSphere(mesh, key->f[0], key->n[0], key->n[1]);
+			break;
+		case GRRLIB_MESH_CYLINDER:
+			MeshCylinder(mesh, key->f[0], key->f[1], key->n[0]);
+			break;
+		case GRRLIB_MESH_CONE:
+			MeshCone(mesh, key->f[0], key->f[1], key->n[0]);
+			break;
+		case GRRLIB_MESH_TESSPANEL:
+			MeshTessPanel(mesh, key->f[0], key->f[1], key->f[2], key->f[3]);
+			break;
+	}
+}
+
+/**
+ * Get the size of the position or normal array of a mesh, the normals start at the next 32 bytes.
+ */
+static u32  MeshArrayBytes (const GRRLIB_mesh *mesh) {
+	return ((mesh->vertexCount * 3 * sizeof(f32)) + 31) & ~31;
+}
+
+/**
+ * Free memory allocated for a mesh.
+ */
+static void  MeshFree (GRRLIB_mesh *mesh) {
+	GRRLIB_MemFree(mesh->positions, MeshArrayBytes(mesh) * 2);
+	GRRLIB_MemFree(mesh->indices, mesh->indexCount * sizeof(u16) + 1);
+	GRRLIB_MemFree(mesh->indices32, mesh->indexCount * sizeof(u32) + 1);
+	GRRLIB_MemFree(mesh->groups, mesh->groupCount * sizeof(GRRLIB_meshGroup) + 1);
+	GRRLIB_MemFree(mesh, sizeof(GRRLIB_mesh));
+}
+
+/**
+ * Free the least recently used meshes until some memory is available.
+ * Meshes drawn during the current or previous frame, which the GPU may still be drawing, or used by a display list are kept.
+ * @param bytes The memory needed.
+ * @return @c true if the memory is available, @c false otherwise.
+ */
+static bool  MeshCacheEvict (const u32 bytes) {
+	while (meshCacheBytes + bytes > meshCacheBudget) {
+		GRRLIB_mesh  **link, **victim = NULL;
+
+		for (link = &meshCache; *link != NULL; link = &(*link)->next) {
+			if ((*link)->pins == 0 && meshFrame - (*link)->lastFrame > 1) {
+				victim = link;
+			}
+		}
+		if (victim == NULL) {
+			return false;
+		}
+
+		GRRLIB_mesh  *mesh = *victim;
+		*victim = mesh->next;
+		meshCacheBytes -= mesh->bytes;
+		MeshFree(mesh);
+	}
+	return true;
+}
+
+/**
+ * Pin a mesh drawn while a display list is recorded, so that it is kept until the display list is freed.
+ */
+static void  MeshUse (GRRLIB_mesh *mesh) {
+	if (GRRLIB_DisplayListRecording() == true && GRRLIB_DisplayListUseMesh(mesh) == false) {
+		mesh->pins = MESH_PINNED_FOREVER;
+	}
+}
+
+/**
+ * Send a mesh to GX.
+ * Cached meshes use 16-bit indices into vertex arrays, other meshes send their vertices directly.
+ */
+static void  MeshDraw (const GRRLIB_mesh *mesh, const bool filled, const u32 col) {
+	u32  i, j;
+	u8   posDesc, nrmDesc;
+
+	if (mesh->indices != NULL) {
+		GX_GetVtxDesc(GX_VA_POS, &posDesc);
+		GX_GetVtxDesc(GX_VA_NRM, &nrmDesc);
+		GRRLIB_StateSetVtxDesc(GX_VA_POS, GX_INDEX16);
+		GRRLIB_StateSetVtxDesc(GX_VA_NRM, GX_INDEX16);
+		GX_SetArray(GX_VA_POS, mesh->positions, 3 * sizeof(f32));
+		GX_SetArray(GX_VA_NRM, mesh->normals,   3 * sizeof(f32));
+	}
+
+	for (i = 0; i < mesh->groupCount; i++) {
+		const GRRLIB_meshGroup  *group = &mesh->groups[i];
+
+		GRRLIB_Begin(filled == true ? group->primitive : GX_LINESTRIP, GX_VTXFMT0, group->count);
+		if (mesh->indices != NULL) {
+			const u16  *index = &mesh->indices[group->first];
+
+			for (j = 0; j < group->length; j++, index++) {
+				GX_Position1x16(*index);
+				GX_Normal1x16(*index);
+				GX_Color1u32(col);
+			}
+		}
+		else {
+			const u32  *index = &mesh->indices32[group->first];
+
+			for (j = 0; j < group->length; j++, index++) {
+				const f32  *p = &mesh->positions[*index * 3];
+				const f32  *n = &mesh->normals[*index * 3];
+
+				GX_Position3f32(p[0], p[1], p[2]);
+				GX_Normal3f32(n[0], n[1], n[2]);
+				GX_Color1u32(col);
+			}
+		}
+		GX_End();
+	}
+
+	if (mesh->indices != NULL) {
+		GRRLIB_StateSetVtxDesc(GX_VA_POS, posDesc);
+		GRRLIB_StateSetVtxDesc(GX_VA_NRM, nrmDesc);
+	}
+}
+
+/**
+ * Draw a 3D primitive from the mesh cache, building the mesh if needed.
+ * A mesh which does not fit in the cache is built and drawn without being kept.
+ * @param type The primitive.
+ * @param f0 First float parameter.
+ * @param f1 Second float parameter.
+ * @param f2 Third float parameter.
+ * @param f3 Fourth float parameter.
+ * @param n0 First integer parameter.
+ * @param n1 Second integer parameter.
+ * @param filled Wired or not.
+ * @param col Color in RGBA format.
+ */
+void  GRRLIB_DrawCachedMesh (const GRRLIB_meshType type, const f32 f0, const f32 f1, const f32 f2, const f32 f3,
+                             const int n0, const int n1, const bool filled, const u32 col) {
+	GRRLIB_mesh     **link, *mesh;
+	GRRLIB_meshKey  key;
+	u32             arrayBytes;
+
+	GRRLIB_StateRestore();
+
+	memset(&key, 0, sizeof(key));
+	key.type = type;
+	key.f[0] = f0;  key.f[1] = f1;  key.f[2] = f2;  key.f[3] = f3;
+	key.n[0] = n0;  key.n[1] = n1;
+
+	for (link = &meshCache; *link != NULL; link = &(*link)->next) {
+		if (memcmp(&(*link)->key, &key, sizeof(key)) == 0) {
+			mesh = *link;
+
+			// Move the mesh to the front of the cache
+			*link = mesh->next;
+			mesh->next = meshCache;
+			meshCache = mesh;
+
+			mesh->lastFrame = meshFrame;
+			MeshUse(mesh);
+			MeshDraw(mesh, filled, col);
+			return;
+		}
+	}
+
+	mesh = GRRLIB_MemCalloc(sizeof(GRRLIB_mesh), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (mesh == NULL) {
+		return;
+	}
+	mesh->key = key;
+
+	// Count the vertices, then build the mesh
+	MeshBuild(mesh);
+	arrayBytes = MeshArrayBytes(mesh);
+	mesh->bytes = sizeof(GRRLIB_mesh) + (arrayBytes * 2)
+	            + (mesh->indexCount * sizeof(u16))
+	            + (mesh->groupCount * sizeof(GRRLIB_meshGroup));
+
+	if (mesh->vertexCount <= MESH_MAX_VERTICES && MeshCacheEvict(mesh->bytes) == true) {
+		mesh->positions = GRRLIB_MemAlloc(arrayBytes * 2, 32, GRRLIB_MEM_HOT);
+		mesh->indices = GRRLIB_MemAlloc(mesh->indexCount * sizeof(u16) + 1, GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+	}
+	else {
+		mesh->positions = GRRLIB_MemAlloc(arrayBytes * 2, 32, GRRLIB_MEM_SCRATCH);
+		mesh->indices32 = GRRLIB_MemAlloc(mesh->indexCount * sizeof(u32) + 1, GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	}
+	mesh->groups = GRRLIB_MemAlloc(mesh->groupCount * sizeof(GRRLIB_meshGroup) + 1, GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (mesh->positions == NULL || (mesh->indices == NULL && mesh->indices32 == NULL) || mesh->groups == NULL) {
+		MeshFree(mesh);
+		return;
+	}
+	mesh->normals = mesh->positions + (arrayBytes / sizeof(f32));
+	MeshBuild(mesh);
+
+	if (mesh->indices == NULL) {
+		MeshDraw(mesh, filled, col);
+		MeshFree(mesh);
+		return;
+	}
+
+	// The arrays are read by the GPU
+	DCFlushRange(mesh->positions, arrayBytes * 2);
+	GX_InvVtxCache();
+
+	mesh->lastFrame = meshFrame;
+	mesh->next = meshCache;
+	meshCache = mesh;
+	meshCacheBytes += mesh->bytes;
+	MeshUse(mesh);
+
+	MeshDraw(mesh, filled, col);
+}
+
+/**
+ * Tell the mesh cache a frame was completed.
+ * The meshes drawn before this call are no longer used by the GPU.
+ */
+void  GRRLIB_MeshCacheNextFrame (void) {
+	meshFrame++;
+}
+
+/**
+ * Count a display list using a mesh.
+ * @param mesh The mesh.
+ */
+void  GRRLIB_MeshPin (void *mesh) {
+	GRRLIB_mesh  *m = mesh;
+
+	if (m->pins != MESH_PINNED_FOREVER) {
+		m->pins++;
+	}
+}
+
+/**
+ * Count a display list using a mesh being freed. The mesh can be evicted once no display list uses it.
+ * @param mesh The mesh.
+ */
+void  GRRLIB_MeshUnpin (void *mesh) {
+	GRRLIB_mesh  *m = mesh;
+
+	if (m->pins != MESH_PINNED_FOREVER && m->pins != 0) {
+		m->pins--;
+	}
+}
+
+/**
+ * Set the maximum memory used by the mesh cache.
+ * Least recently used meshes are freed when a new mesh does not fit.
+ * @param bytes The maximum memory in bytes (Default: 512 KiB).
+ */
+void  GRRLIB_SetMeshCacheBudget (const u32 bytes) {
+	meshCacheBudget = bytes;
+}
+
+/**
+ * Get the memory used by the mesh cache.
+ * @return The memory used in bytes.
+ */
+u32  GRRLIB_GetMeshCacheMemory (void) {
+	return meshCacheBytes;
+}
+
+/**
+ * Free all the meshes of the mesh cache.
+ * Waits for the GPU to finish drawing. Display lists recorded with cached meshes must not be called afterwards.
+ */
+void  GRRLIB_ClearMeshCache (void) {
+	GX_DrawDone();
+	GRRLIB_DisplayListsForgetMeshes();
+
+	while (meshCache != NULL) {
+		GRRLIB_mesh  *mesh = meshCache;
+
+		meshCache = mesh->next;
+		MeshFree(mesh);
+	}
+	meshCacheBytes = 0;
+}
@@ -0,0 +1,422 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <math.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define MIP_MAX_SIZE     (1024)  /**< Largest texture size supported by GX. */
+#define MIP_KAISER_TAPS  (8)     /**< Source pixels weighted by the Kaiser filter for each destination pixel. */
+#define MIP_KAISER_BETA  (4.0f)  /**< Shape of the Kaiser window. */
+
+/**
+ * Read the pixel of a GX_TF_RGBA8 level, clamping a coordinate equal to the size.
+ * @param src The level.
+ * @param x X-coordinate.
+ * @param y Y-coordinate.
+ * @param w Width of the level.
+ * @param h Height of the level.
+ * @param ar Set to the alpha and red.
+ * @param gb Set to the green and blue.
+ */
+static inline void  ReadRGBA8 (const u8 *src, u32 x, u32 y, const u32 w, const u32 h, u32 ar[2], u32 gb[2]) {
+	u32 offs;
+
+	if (x >= w)  x = w - 1;
+	if (y >= h)  y = h - 1;
+	offs = (((y&(~3))<<2)*((w+3)&(~3))) + ((x&(~3))<<4) + ((((y&3)<<2) + (x&3)) <<1);
+	ar[0] += src[offs];
+	ar[1] += src[offs + 1];
+	gb[0] += src[offs + 32];
+	gb[1] += src[offs + 33];
+}
+
+/**
+ * Build a GX_TF_RGBA8 level from the previous one with a 2x2 box filter, working on the tiles directly.
+ * @param dst The level to build.
+ * @param src The previous level.
+ * @param w Width of the previous level.
+ * @param h Height of the previous level.
+ */
+static void  BoxRGBA8 (u8 *dst, const u8 *src, const u32 w, const u32 h) {
+	const u32 dw = (w > 1) ? w >> 1 : 1, dh = (h > 1) ? h >> 1 : 1;
+	const u32 sx = (w > 1) ? 1 : 0, sy = (h > 1) ? 1 : 0;
+	u32 tx, ty, r, c;
+
+	for (ty = 0; ty < dh; ty += 4) {
+		for (tx = 0; tx < dw; tx += 4, dst += 64) {
+			for (r = 0; r < 4; r++) {
+				for (c = 0; c < 4; c++) {
+					const u32 x = tx + c, y = ty + r, i = ((r << 2) + c) << 1;
+					u32 ar[2] = { 2, 2 }, gb[2] = { 2, 2 };  // Rounding
+
+					if (x >= dw || y >= dh) {
+						dst[i] = dst[i + 1] = dst[i + 32] = dst[i + 33] = 0;
+						continue;
+					}
+					ReadRGBA8(src, 2 * x,      2 * y,      w, h, ar, gb);
+					ReadRGBA8(src, 2 * x + sx, 2 * y,      w, h, ar, gb);
+					ReadRGBA8(src, 2 * x,      2 * y + sy, w, h, ar, gb);
+					ReadRGBA8(src, 2 * x + sx, 2 * y + sy, w, h, ar, gb);
+					dst[i]      = ar[0] >> 2;
+					dst[i + 1]  = ar[1] >> 2;
+					dst[i + 32] = gb[0] >> 2;
+					dst[i + 33] = gb[1] >> 2;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Downsample RGBA pixels by 2 with a 2x2 box filter.
+ * @param dst Destination pixels.
+ * @param src Source pixels.
+ * @param w Width of the source.
+ * @param h Height of the source.
+ */
+static void  BoxLinear (u8 *dst, const u8 *src, const u32 w, const u32 h) {
+	const u32 dw = (w > 1) ? w >> 1 : 1, dh = (h > 1) ? h >> 1 : 1;
+	const u32 sx = (w > 1) ? 4 : 0, sy = (h > 1) ? w * 4 : 0;
+	u32 x, y, i;
+
+	for (y = 0; y < dh; y++) {
+		const u8 *p = src + (2 * y) * w * 4;
+
+		for (x = 0; x < dw; x++, p += 2 * sx, dst += 4) {
+			for (i = 0; i < 4; i++) {
+				dst[i] = (p[i] + p[sx + i] + p[sy + i] + p[sy + sx + i] + 2) >> 2;
+			}
+		}
+	}
+}
+
+/**
+ * Return the weights of the Kaiser filter, computed on first use.
+ * Source pixels are 0.5, 1.5, 2.5 and 3.5 pixels away from the center of a destination pixel on each side.
+ * @return MIP_KAISER_TAPS weights, summing to 1.
+ */
+static const f32*  KaiserWeights (void) {
+	static f32 weights[MIP_KAISER_TAPS];
+	static bool ready = false;
+	f32 sum = 0.0f;
+	u32 i, k;
+
+	if (ready == true) {
+		return weights;
+	}
+	for (i = 0; i < MIP_KAISER_TAPS; i++) {
+		const f32 d = (f32)i - (MIP_KAISER_TAPS - 1) / 2.0f;
+		const f32 t = d / (MIP_KAISER_TAPS / 2);
+		const f32 s = (f32)M_PI * d / 2.0f;
+		f32 i0 = 1.0f, i0beta = 1.0f, term = 1.0f, termBeta = 1.0f;
+		const f32 x = MIP_KAISER_BETA * sqrtf(1.0f - t * t) / 2.0f;
+
+		// Modified Bessel function of the first kind, order 0, by its series
+		for (k = 1; k < 16; k++) {
+			term *= (x / k) * (x / k);
+			termBeta *= (MIP_KAISER_BETA / 2.0f / k) * (MIP_KAISER_BETA / 2.0f / k);
+			i0 += term;
+			i0beta += termBeta;
+		}
+		weights[i] = (sinf(s) / s) * (i0 / i0beta);
+		sum += weights[i];
+	}
+	for (i = 0; i < MIP_KAISER_TAPS; i++) {
+		weights[i] /= sum;
+	}
+	ready = true;
+	return weights;
+}
+
+/**
+ * Downsample RGBA pixels by 2 with a separable Kaiser filter, repeating the edges.
+ * @param dst Destination pixels.
+ * @param src Source pixels.
+ * @param w Width of the source.
+ * @param h Height of the source.
+ * @param tmp Work buffer of (w / 2) * h * 4 floats.
+ */
+static void  KaiserLinear (u8 *dst, const u8 *src, const u32 w, const u32 h, f32 *tmp) {
+	const u32 dw = (w > 1) ? w >> 1 : 1, dh = (h > 1) ? h >> 1 : 1;
+	const f32 *weights = KaiserWeights();
+	u32 x, y, i, k;
+
+	// Horizontal pass, to dw x h
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < dw; x++) {
+			f32 *t = &tmp[(y * dw + x) * 4];
+
+			if (w == 1) {
+				for (i = 0; i < 4; i++)  t[i] = src[y * 4 + i];
+				continue;
+			}
+			t[0] = t[1] = t[2] = t[3] = 0.0f;
+			for (k = 0; k < MIP_KAISER_TAPS; k++) {
+				s32 sx = (s32)(2 * x + k) - (MIP_KAISER_TAPS / 2 - 1);
+				const u8 *p;
+
+				sx = (sx < 0) ? 0 : (sx >= (s32)w) ? (s32)w - 1 : sx;
+				p = &src[(y * w + sx) * 4];
+				for (i = 0; i < 4; i++)  t[i] += weights[k] * p[i];
+			}
+		}
+	}
+
+	// Vertical pass, to dw x dh
+	for (y = 0; y < dh; y++) {
+		for (x = 0; x < dw; x++, dst += 4) {
+			f32 v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			if (h == 1) {
+				for (i = 0; i < 4; i++)  v[i] = tmp[x * 4 + i];
+			}
+			else {
+				for (k = 0; k < MIP_KAISER_TAPS; k++) {
+					s32 sy = (s32)(2 * y + k) - (MIP_KAISER_TAPS / 2 - 1);
+
+					sy = (sy < 0) ? 0 : (sy >= (s32)h) ? (s32)h - 1 : sy;
+					for (i = 0; i < 4; i++)  v[i] += weights[k] * tmp[(sy * dw + x) * 4 + i];
+				}
+			}
+			for (i = 0; i < 4; i++) {
+				const s32 c = (s32)(v[i] + 0.5f);
+				dst[i] = (c < 0) ? 0 : (c > 255) ? 255 : c;
+			}
+		}
+	}
+}
+
+/**
+ * Store RGBA pixels in a GX_TF_CI8 level, using the closest colors of the palette.
+ * @param dst The level.
+ * @param src Source pixels.
+ * @param w Width of the level.
+ * @param h Height of the level.
+ * @param palette The palette of the texture.
+ * @param cache Index of each GX_TF_RGB5A3 color already matched, 0xFFFF if not matched yet.
+ */
+static void  IndexLinear (u8 *dst, const u8 *src, const u32 w, const u32 h, const u8 *palette, u16 *cache) {
+	u32 x, y, i;
+
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			const u8 *p = &src[(y * w + x) * 4];
+			const u32 color = GRRLIB_RGBA(p[0], p[1], p[2], p[3]);
+			const u16 key = GRRLIB_PackRGB5A3(color);
+			const u32 offs = (((y&(~3))<<3)*((w+7)>>3)) + ((x&(~7))<<2) + ((y&3)<<3) + (x&7);
+
+			if (cache[key] == 0xFFFF) {
+				u32 best = 0, bestDist = ~0u;
+
+				for (i = 0; i < 256 && bestDist != 0; i++) {
+					const u32 c = GRRLIB_UnpackRGB5A3(((u16)palette[i * 2] << 8) | palette[i * 2 + 1]);
+					const s32 dr = (s32)GRRLIB_R(c) - p[0], dg = (s32)GRRLIB_G(c) - p[1];
+					const s32 db = (s32)GRRLIB_B(c) - p[2], da = (s32)GRRLIB_A(c) - p[3];
+					const u32 d = dr*dr + dg*dg + db*db + da*da;
+
+					if (d < bestDist) {
+						bestDist = d;
+						best = i;
+					}
+				}
+				cache[key] = best;
+			}
+			dst[offs] = cache[key];
+		}
+	}
+	// Pixels padding the tiles
+	for (y = 0; y < ((h + 3) & ~3); y++) {
+		for (x = (y < h) ? w : 0; x < ((w + 7) & ~7); x++) {
+			dst[(((y&(~3))<<3)*((w+7)>>3)) + ((x&(~7))<<2) + ((y&3)<<3) + (x&7)] = 0;
+		}
+	}
+}
+
+/**
+ * Build the levels of a mipmap chain from the base level, for any format but GX_TF_RGBA8 with the box filter.
+ * The base level is decoded once and each level is filtered from the unquantized previous one.
+ * @param texture The texture, with the chain allocated.
+ * @param filter The filter.
+ * @return @c true on success, @c false if memory is missing.
+ */
+static bool  BuildLevelsLinear (GRRLIB_texture *texture, const GRRLIB_mipFilter filter) {
+	const u32 fmt = texture->fmt;
+	u32 w = texture->width, h = texture->height, x, y, level;
+	const u32 prevSize = w * h * 4;
+	const u32 nextSize = ((w > 1) ? w >> 1 : 1) * ((h > 1) ? h >> 1 : 1) * 4;
+	const u32 tmpSize = ((w > 1) ? w >> 1 : 1) * h * 4 * sizeof(f32);
+	u8 *prev = GRRLIB_MemAlloc(prevSize, 32, GRRLIB_MEM_SCRATCH);
+	u8 *next = GRRLIB_MemAlloc(nextSize, 32, GRRLIB_MEM_SCRATCH);
+	u8 *first = prev;
+	f32 *tmp = (filter == GRRLIB_MIPFILTER_KAISER) ? GRRLIB_MemAlloc(tmpSize, 32, GRRLIB_MEM_SCRATCH) : NULL;
+	u16 *cache = (fmt == GX_TF_CI8) ? GRRLIB_MemAlloc(65536 * sizeof(u16), 32, GRRLIB_MEM_SCRATCH) : NULL;
+	bool ok = prev != NULL && next != NULL && (filter != GRRLIB_MIPFILTER_KAISER || tmp != NULL) && (fmt != GX_TF_CI8 || cache != NULL);
+
+	if (ok == true) {
+		u8 *p = prev;
+
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++, p += 4) {
+				const u32 c = GRRLIB_GetPixelFromTexture(x, y, texture);
+
+				p[0] = GRRLIB_R(c);
+				p[1] = GRRLIB_G(c);
+				p[2] = GRRLIB_B(c);
+				p[3] = GRRLIB_A(c);
+			}
+		}
+		if (cache != NULL) {
+			memset(cache, 0xFF, 65536 * sizeof(u16));
+		}
+
+		for (level = 1; level <= texture->maxLevel; level++) {
+			u8 *dst = (u8*)texture->data + GX_GetTexBufferSize(texture->width, texture->height, fmt, GX_TRUE, level);
+			u8 *swap;
+
+			if (filter == GRRLIB_MIPFILTER_KAISER) {
+				KaiserLinear(next, prev, w, h, tmp);
+			}
+			else {
+				BoxLinear(next, prev, w, h);
+			}
+			w = (w > 1) ? w >> 1 : 1;
+			h = (h > 1) ? h >> 1 : 1;
+
+			switch (fmt) {
+				case GX_TF_CI8:
+					IndexLinear(dst, next, w, h, GRRLIB_GetTexturePalette(texture), cache);
+					break;
+				case GX_TF_CMPR:
+					GRRLIB_EncodeCMPR(next, w * 4, GRRLIB_LAYOUT_RGBA, dst, w, h, true);
+					break;
+				default:
+					GRRLIB_TileImage(next, w * 4, GRRLIB_LAYOUT_RGBA, dst, fmt, w, h);
+			}
+			swap = prev;
+			prev = next;
+			next = swap;
+		}
+	}
+
+	// The buffers were swapped once per level
+	if (prev != first) {
+		next = prev;
+		prev = first;
+	}
+	GRRLIB_MemFree(prev, prevSize);
+	GRRLIB_MemFree(next, nextSize);
+	GRRLIB_MemFree(tmp, tmpSize);
+	GRRLIB_MemFree(cache, 65536 * sizeof(u16));
+	return ok;
+}
+
+/**
+ * Build the mipmap chain of a texture and finalize it.
+ * Each level is half the size of the previous one, down to 1x1, and is filtered from the previous one.
+ * The data is reallocated with the levels after the base level, as GX expects, and the palette of a GX_TF_CI8 texture after them.
+ * Call it again after modifying the base level.
+ * Works with all the formats created by GRRLIB, the width and height must be powers of two.
+ * @param texture The texture.
+ * @param filter The filter: GRRLIB_MIPFILTER_BOX or GRRLIB_MIPFILTER_KAISER.
+ * @return @c true on success, @c false if the size is not a power of two or memory is missing.
+ */
+bool  GRRLIB_GenerateMipmaps (GRRLIB_texture *texture, const GRRLIB_mipFilter filter) {
+	const u32 w = texture->width, h = texture->height;
+	const u32 baseSize = GX_GetTexBufferSize(w, h, texture->fmt, GX_FALSE, 0);
+	const bool hadMipmap = texture->mipmap;
+	const u8 oldMaxLevel = texture->maxLevel;
+	const u32 oldSize = GRRLIB_GetTextureDataSize(texture);
+	const u8 *palette;
+	u8 maxLevel = 0, *data;
+	bool ok;
+
+	if (texture->data == NULL || w == 0 || h == 0 || w > MIP_MAX_SIZE || h > MIP_MAX_SIZE ||
+	    (w & (w - 1)) != 0 || (h & (h - 1)) != 0) {
+		return false;
+	}
+	while (((w | h) >> (maxLevel + 1)) != 0) {
+		maxLevel++;
+	}
+
+	palette = (texture->fmt == GX_TF_CI8) ? GRRLIB_GetTexturePalette(texture) : NULL;
+	texture->mipmap = true;
+	texture->maxLevel = maxLevel;
+	data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(texture), 32, GRRLIB_MEM_COLD);
+	if (data == NULL) {
+		texture->mipmap = hadMipmap;
+		texture->maxLevel = oldMaxLevel;
+		return false;
+	}
+	memcpy(data, texture->data, baseSize);
+	if (palette != NULL) {
+		// Move the palette after the chain
+		memcpy(data + GRRLIB_GetTextureDataSize(texture) - 256 * 2, palette, 256 * 2);
+	}
+	GRRLIB_MemFree(texture->data, oldSize);
+	texture->data = data;
+	if (hadMipmap == false) {
+		texture->minLod = 0.0f;
+		texture->maxLod = maxLevel;
+		texture->lodBias = 0.0f;
+	}
+
+	if (texture->fmt == GX_TF_RGBA8 && filter == GRRLIB_MIPFILTER_BOX) {
+		u32 lw = w, lh = h, level;
+
+		for (level = 1; level <= maxLevel; level++) {
+			BoxRGBA8(data + GX_GetTexBufferSize(w, h, GX_TF_RGBA8, GX_TRUE, level),
+			         data + GX_GetTexBufferSize(w, h, GX_TF_RGBA8, GX_TRUE, level - 1), lw, lh);
+			lw = (lw > 1) ? lw >> 1 : 1;
+			lh = (lh > 1) ? lh >> 1 : 1;
+		}
+		ok = true;
+	}
+	else {
+		ok = BuildLevelsLinear(texture, filter);
+	}
+
+	GRRLIB_FinalizeTexture(texture);
+	return ok;
+}
+
+/**
+ * Set the range of levels of detail of a texture and the bias added to the computed level.
+ * A positive bias selects smaller levels (blurrier), a negative bias larger ones (sharper, more aliasing).
+ * Only textures with mipmaps use them.
+ * @param texture The texture.
+ * @param minLod Minimum level of detail, 0 for the base level.
+ * @param maxLod Maximum level of detail, at most texture->maxLevel.
+ * @param lodBias Bias added to the level of detail, from -4.0 to 3.99.
+ */
+void  GRRLIB_SetTextureLOD (GRRLIB_texture *texture, const f32 minLod, const f32 maxLod, const f32 lodBias) {
+	texture->minLod = minLod;
+	texture->maxLod = (maxLod > texture->maxLevel) ? texture->maxLevel : maxLod;
+	texture->lodBias = lodBias;
+	if (texture->mipmap == true) {
+		GX_InitTexObjLOD(&texture->obj, GX_LIN_MIP_LIN, GX_LINEAR, texture->minLod, texture->maxLod,
+		                 texture->lodBias, GX_TRUE, GX_TRUE, GX_ANISO_1);
+	}
+}
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #include <stdio.h>
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 /**
  * Print formatted output.
@@ -80,13 +81,15 @@ void  GRRLIB_PrintBMF (const f32 xpos, const f32 ypos,
 	size = vsnprintf(tmp, sizeof(tmp), text, argp);
 	va_end(argp);
 
+	GRRLIB_StateRestore();
+
 	for (i=0; i<size; i++) {
 		pchar = &bmf->charDef[(u8)tmp[i]];
 		u8 *pdata = pchar->data;
 		for (y=0; y<pchar->height; y++) {
 			for (x=0; x<pchar->width; x++) {
 				if (*pdata) {
-					GX_Begin(GX_POINTS, GX_VTXFMT0, 1);
+					GRRLIB_Begin(GX_POINTS, GX_VTXFMT0, 1);
 						GX_Position3f32(xoff + x + pchar->relx, ypos + y + pchar->rely, 0.0f);
 						GX_Color1u32(bmf->palette[*pdata]);
 					GX_End();
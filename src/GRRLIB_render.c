@@ -23,6 +23,7 @@ THE SOFTWARE.
 #include <math.h>
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 /**
  * Draw a texture.
@@ -39,8 +40,30 @@ void  GRRLIB_DrawTexture (const f32 xPos, const f32 yPos, const GRRLIB_texture *
 	GRRLIB_DrawTexturePart(xPos, yPos, tex, &tex->part, degrees, scaleX, scaleY, offsetX, offsetY);
 }
 
+/**
+ * Convert a range of texture coordinates to the fixed point format of GX_VTXFMT1.
+ * Only exact conversions are done, so the compact format samples the same texels as the f32 one.
+ * @param lo The lower texture coordinate.
+ * @param hi The upper texture coordinate.
+ * @param qlo Returns the lower fixed point texture coordinate.
+ * @param qhi Returns the upper fixed point texture coordinate.
+ * @return @c true if the range is exactly representable, @c false otherwise.
+ */
+static bool  CompactTexCoord (const f32 lo, const f32 hi, u16 *qlo, u16 *qhi) {
+	const f32  l = lo * (1 << GRRLIB_TEXCOORD_FRAC);
+	const f32  h = hi * (1 << GRRLIB_TEXCOORD_FRAC);
+
+	if (!(l >= 0.0f && l <= h && h <= 65535.0f) || l != floorf(l) || h != floorf(h)) {
+		return false;
+	}
+	*qlo = l;
+	*qhi = h;
+	return true;
+}
+
 /**
  * Draw a part of a texture.
+ * Between GRRLIB_SpriteBatchBegin and GRRLIB_SpriteBatchEnd the texture is queued in the batch instead.
  * @param xPos Specifies the x-coordinate of the upper-left corner.
  * @param yPos Specifies the y-coordinate of the upper-left corner.
  * @param tex The texture to draw.
@@ -53,12 +76,14 @@ void  GRRLIB_DrawTexture (const f32 xPos, const f32 yPos, const GRRLIB_texture *
  */
 void  GRRLIB_DrawTexturePart (const f32 xPos, const f32 yPos, const GRRLIB_texture *tex, const GRRLIB_texturePart *texPart, const f32 degrees, const f32 scaleX, const f32 scaleY, const f32 offsetX, const f32 offsetY) {
 	Mtx  m, m1, m2, mv;
+	u16  s1, s2, t1, t2;
 
 	if ((tex == NULL) || (texPart == NULL))  return;
 
-	GX_LoadTexObj(&((GRRLIB_texture *) tex)->obj, GX_TEXMAP0);
-	GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
-	GX_SetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+	if (GRRLIB_SpriteBatchActive() == true) {
+		GRRLIB_SpriteBatchDraw(xPos, yPos, tex, texPart, degrees, scaleX, scaleY, offsetX, offsetY);
+		return;
+	}
 
 	guMtxRotAxisDeg(m1, &GRRLIB_Axis2D, degrees);
 	guMtxIdentity(m2);
@@ -69,8 +94,31 @@ void  GRRLIB_DrawTexturePart (const f32 xPos, const f32 yPos, const GRRLIB_textu
 	guMtxTransApply(m, m, xPos, yPos, 0.0);
 	guMtxConcat(GRRLIB_View2D, m, mv);
 
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	// 8 bytes per vertex instead of 24 when the size and the texture coordinates fit
+	if (GRRLIB_StateCompactAllowed() == true &&
+	    GRRLIB_CompactPos(texPart->realWidth) == true && GRRLIB_CompactPos(texPart->realHeight) == true &&
+	    CompactTexCoord(texPart->x, texPart->width,  &s1, &s2) == true &&
+	    CompactTexCoord(texPart->y, texPart->height, &t1, &t2) == true) {
+		GRRLIB_StateTextured2DKonst(&((GRRLIB_texture *) tex)->obj, mv, GRRLIB_Settings.color);
+		GRRLIB_Begin(GX_QUADS, GX_VTXFMT1, 4);
+			GX_Position2s16(0, 0);
+			GX_TexCoord2u16(s1, t1);
+
+			GX_Position2s16(texPart->realWidth, 0);
+			GX_TexCoord2u16(s2, t1);
+
+			GX_Position2s16(texPart->realWidth, texPart->realHeight);
+			GX_TexCoord2u16(s2, t2);
+
+			GX_Position2s16(0, texPart->realHeight);
+			GX_TexCoord2u16(s1, t2);
+		GX_End();
+		GRRLIB_StateLeave();
+		return;
+	}
+
+	GRRLIB_StateTextured2D(&((GRRLIB_texture *) tex)->obj, mv);
+	GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 		GX_Position3f32(0, 0, 0);
 		GX_Color1u32   (GRRLIB_Settings.color);
 		GX_TexCoord2f32(texPart->x, texPart->y);
@@ -87,10 +135,7 @@ void  GRRLIB_DrawTexturePart (const f32 xPos, const f32 yPos, const GRRLIB_textu
 		GX_Color1u32   (GRRLIB_Settings.color);
 		GX_TexCoord2f32(texPart->x, texPart->height);
 	GX_End();
-	GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
-
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_PASSCLR);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_NONE);
+	GRRLIB_StateLeave();
 }
 
 /**
@@ -112,18 +157,14 @@ void  GRRLIB_DrawTextureQuad (const guVector pos[4], GRRLIB_texImg *tex) {
 		GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f, 0, 0, GX_ANISO_1);
 	}
 
-	GX_LoadTexObj(&texObj,      GX_TEXMAP0);
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_MODULATE);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_DIRECT);
-
 	guMtxIdentity  (m1);
 	guMtxScaleApply(m1, m1, 1, 1, 1.0);
 	guMtxRotAxisDeg(m2, &GRRLIB_Axis2D, 0);
 	guMtxConcat    (m2, m1, m);
 	guMtxConcat    (GRRLIB_View2D, m, mv);
 
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	GRRLIB_StateTextured2D(&texObj, mv);
+	GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 		GX_Position3f32(pos[0].x, pos[0].y, 0);
 		GX_Color1u32   (color);
 		GX_TexCoord2f32(0, 0);
@@ -140,10 +181,7 @@ void  GRRLIB_DrawTextureQuad (const guVector pos[4], GRRLIB_texImg *tex) {
 		GX_Color1u32   (color);
 		GX_TexCoord2f32(0, 1);
 	GX_End();
-	GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
-
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_PASSCLR);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_NONE);
+	GRRLIB_StateLeave();
 }
 
 /**
@@ -181,10 +219,6 @@ void  GRRLIB_DrawTile (const f32 xpos, const f32 ypos, const GRRLIB_texImg *tex,
 		GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f, 0, 0, GX_ANISO_1);
 	}
 
-	GX_LoadTexObj(&texObj,      GX_TEXMAP0);
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_MODULATE);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_DIRECT);
-
 	width  = tex->tilew * 0.5f - offsetX;
 	height = tex->tileh * 0.5f - offsetY;
 
@@ -196,8 +230,8 @@ void  GRRLIB_DrawTile (const f32 xpos, const f32 ypos, const GRRLIB_texImg *tex,
 	guMtxTransApply(m, m, xpos, ypos, 0);
 	guMtxConcat(GRRLIB_View2D, m, mv);
 
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	GRRLIB_StateTextured2D(&texObj, mv);
+	GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 		GX_Position3f32(-offsetX, -offsetY, 0);
 		GX_Color1u32   (color);
 		GX_TexCoord2f32(s1, t1);
@@ -214,10 +248,7 @@ void  GRRLIB_DrawTile (const f32 xpos, const f32 ypos, const GRRLIB_texImg *tex,
 		GX_Color1u32   (color);
 		GX_TexCoord2f32(s1, t2);
 	GX_End();
-	GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
-
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_PASSCLR);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_NONE);
+	GRRLIB_StateLeave();
 }
 
 /**
@@ -248,18 +279,14 @@ void  GRRLIB_DrawTileQuad (const guVector pos[4], GRRLIB_texImg *tex, const int
 		GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f, 0, 0, GX_ANISO_1);
 	}
 
-	GX_LoadTexObj(&texObj,      GX_TEXMAP0);
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_MODULATE);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_DIRECT);
-
 	guMtxIdentity  (m1);
 	guMtxScaleApply(m1, m1, 1, 1, 1.0f);
 	guMtxRotAxisDeg(m2, &GRRLIB_Axis2D, 0);
 	guMtxConcat    (m2, m1, m);
 	guMtxConcat    (GRRLIB_View2D, m, mv);
 
-	GX_LoadPosMtxImm(mv, GX_PNMTX0);
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	GRRLIB_StateTextured2D(&texObj, mv);
+	GRRLIB_Begin(GX_QUADS, GX_VTXFMT0, 4);
 		GX_Position3f32(pos[0].x, pos[0].y, 0);
 		GX_Color1u32   (color);
 		GX_TexCoord2f32(s1, t1);
@@ -276,30 +303,19 @@ void  GRRLIB_DrawTileQuad (const guVector pos[4], GRRLIB_texImg *tex, const int
 		GX_Color1u32   (color);
 		GX_TexCoord2f32(s1, t2);
 	GX_End();
-	GX_LoadPosMtxImm(GRRLIB_View2D, GX_PNMTX0);
-
-	GX_SetTevOp  (GX_TEVSTAGE0, GX_PASSCLR);
-	GX_SetVtxDesc(GX_VA_TEX0,   GX_NONE);
+	GRRLIB_StateLeave();
 }
 
 /**
  * Call this function after drawing.
  */
 void  GRRLIB_Render (void) {
-	GX_DrawDone();          // Tell the GX engine we are done drawing
-	GX_InvalidateTexAll();
-
-	GRRLIB_FB ^= 1;  // Toggle framebuffer index
-
-	GX_SetZMode      (GX_TRUE, GX_LEQUAL, GX_TRUE);
-	GX_SetColorUpdate(GX_TRUE);
-	GX_CopyDisp      (GRRLIB_XFB[GRRLIB_FB], GX_TRUE);
-
-	VIDEO_SetNextFramebuffer(GRRLIB_XFB[GRRLIB_FB]);  // Select eXternal Frame Buffer
-	VIDEO_Flush();                      // Flush video buffer to screen
-	VIDEO_WaitVSync();                  // Wait for screen to update
-	// Interlaced screens require two frames to update
-	if (GRRLIB_VideoMode->viTVMode &VI_NON_INTERLACE) {
-		VIDEO_WaitVSync();
-	}
+	GRRLIB_FrameStatsBegin();
+	GRRLIB_SpriteBatchFlush();  // Draw sprites still queued in a batch
+	GRRLIB_StateRestore();      // Start the next frame in the default 2D state
+
+	GRRLIB_PresentFrame();      // Copy the frame to a frame buffer and show it
+	GRRLIB_MeshCacheNextFrame();
+	GRRLIB_AssetCacheNextFrame();
+	GRRLIB_FrameStatsEnd();
 }
@@ -0,0 +1,249 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * Compute the size of an image fitted in a box, keeping its aspect ratio.
+ * The box is also limited to 1024x1024, the largest texture GX can sample. Images are never enlarged.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param maxWidth Width of the box, 0 for 1024.
+ * @param maxHeight Height of the box, 0 for 1024.
+ * @param scaledWidth Set to the width of the fitted image, at least 1.
+ * @param scaledHeight Set to the height of the fitted image, at least 1.
+ */
+void  GRRLIB_FitImageSize (const u32 width, const u32 height, u32 maxWidth, u32 maxHeight, u32 *scaledWidth, u32 *scaledHeight) {
+	maxWidth = (maxWidth == 0 || maxWidth > 1024) ? 1024 : maxWidth;
+	maxHeight = (maxHeight == 0 || maxHeight > 1024) ? 1024 : maxHeight;
+
+	if (width <= maxWidth && height <= maxHeight) {
+		*scaledWidth = width;
+		*scaledHeight = height;
+	}
+	else if ((u64)width * maxHeight <= (u64)height * maxWidth) {
+		*scaledHeight = maxHeight;
+		*scaledWidth = (u32)((u64)width * maxHeight / height);
+	}
+	else {
+		*scaledWidth = maxWidth;
+		*scaledHeight = (u32)((u64)height * maxWidth / width);
+	}
+	if (*scaledWidth == 0)   *scaledWidth = 1;
+	if (*scaledHeight == 0)  *scaledHeight = 1;
+}
+
+/**
+ * Prepare the scaling of an image into a texture, its rows being given from the top with GRRLIB_ScalerPush.
+ * @param scaler The scaler to prepare.
+ * @param texture The destination: its width, height and format are the scaled size and format, its data is allocated.
+ * @param encoding The format given to GRRLIB_TileImage, GRRLIB_TEXFMT_CMPR_HQ for high quality GX_TF_CMPR.
+ * @param srcWidth Width of the image, at least the width of the texture.
+ * @param srcHeight Height of the image, at least the height of the texture.
+ * @param filter The filter.
+ * @return @c true on success, @c false if memory is missing.
+ */
+bool  GRRLIB_ScalerInit (GRRLIB_scaler *scaler, GRRLIB_texture *texture, const u32 encoding,
+                         const u32 srcWidth, const u32 srcHeight, const GRRLIB_scaleFilter filter) {
+	const u32 dw = texture->width;
+	u32 x;
+
+	memset(scaler, 0, sizeof(GRRLIB_scaler));
+	scaler->texture = texture;
+	scaler->encoding = encoding;
+	scaler->filter = filter;
+	scaler->srcWidth = srcWidth;
+	scaler->srcHeight = srcHeight;
+	scaler->stripeHeight = (texture->fmt == GX_TF_CMPR) ? 8 : 4;
+
+	scaler->stripe = GRRLIB_MemAlloc(dw * 4 * scaler->stripeHeight, 32, GRRLIB_MEM_SCRATCH);
+	if (filter == GRRLIB_SCALE_NEAREST) {
+		scaler->column = GRRLIB_MemAlloc(dw * sizeof(u32), GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+		if (scaler->stripe == NULL || scaler->column == NULL) {
+			GRRLIB_ScalerFree(scaler);
+			return false;
+		}
+		// Source pixel at the center of each destination pixel
+		for (x = 0; x < dw; x++) {
+			scaler->column[x] = (u32)(((u64)(2 * x + 1) * srcWidth) / (2 * dw));
+		}
+		return true;
+	}
+
+	scaler->column = GRRLIB_MemAlloc(srcWidth * sizeof(u32), GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	scaler->weight = GRRLIB_MemAlloc(srcWidth * sizeof(u32), GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	scaler->row = GRRLIB_MemAlloc(dw * 4 * sizeof(u32), GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	scaler->acc = GRRLIB_MemCalloc(dw * 4 * 2 * sizeof(u64), GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	if (scaler->stripe == NULL || scaler->column == NULL || scaler->weight == NULL || scaler->row == NULL || scaler->acc == NULL) {
+		GRRLIB_ScalerFree(scaler);
+		return false;
+	}
+	// Source pixel x covers [x * dw, (x + 1) * dw) and destination pixel i covers [i * srcWidth, (i + 1) * srcWidth):
+	// each source pixel gives weight[x] to its first destination pixel and the rest of dw to the next one
+	for (x = 0; x < srcWidth; x++) {
+		const u32 start = x * dw, i = start / srcWidth, boundary = (i + 1) * srcWidth;
+
+		scaler->column[x] = i;
+		scaler->weight[x] = (start + dw <= boundary) ? dw : boundary - start;
+	}
+	return true;
+}
+
+/**
+ * Store a finished destination row in the stripe, and tile the stripe when it is complete.
+ * @param scaler The scaler.
+ */
+static void  EmitRow (GRRLIB_scaler *scaler) {
+	GRRLIB_texture *texture = scaler->texture;
+	const u32 rows = scaler->dstY % scaler->stripeHeight + 1;
+
+	scaler->dstY++;
+	if (rows == scaler->stripeHeight || scaler->dstY == texture->height) {
+		const u32 top = scaler->dstY - rows;
+
+		GRRLIB_TileImage(scaler->stripe, texture->width * 4, GRRLIB_LAYOUT_RGBA,
+		                 (u8*)texture->data + GX_GetTexBufferSize(texture->width, top, texture->fmt, GX_FALSE, 0),
+		                 scaler->encoding, texture->width, rows);
+	}
+}
+
+/**
+ * Give rows of the image to a scaler.
+ * @param scaler The scaler.
+ * @param src The first pixel of the first row.
+ * @param stride Distance between two rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the pixels.
+ * @param rows Number of rows.
+ */
+void  GRRLIB_ScalerPush (GRRLIB_scaler *scaler, const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout, const u32 rows) {
+	const u32 dw = scaler->texture->width, dh = scaler->texture->height;
+	const u32 sw = scaler->srcWidth, sh = scaler->srcHeight;
+	s32 bpp = 4, ro = 0, go = 1, bo = 2, ao = 3;
+	u32 r, x, c;
+
+	switch (layout) {
+		case GRRLIB_LAYOUT_RGB:    bpp = 3;  ao = -1;                    break;
+		case GRRLIB_LAYOUT_RGBA:                                         break;
+		case GRRLIB_LAYOUT_BGR:    bpp = 3;  ro = 2;  bo = 0;  ao = -1;  break;
+		case GRRLIB_LAYOUT_BGRA:             ro = 2;  bo = 0;            break;
+		case GRRLIB_LAYOUT_GRAY:   bpp = 1;  go = 0;  bo = 0;  ao = -1;  break;
+		case GRRLIB_LAYOUT_GRAYA:  bpp = 2;  go = 0;  bo = 0;  ao = 1;   break;
+	}
+
+	for (r = 0; r < rows && scaler->dstY < dh; r++, src += stride, scaler->srcY++) {
+		const u32 y = scaler->srcY;
+
+		if (scaler->filter == GRRLIB_SCALE_NEAREST) {
+			// Emit every destination row whose center is in this source row
+			while (scaler->dstY < dh && (u32)(((u64)(2 * scaler->dstY + 1) * sh) / (2 * dh)) == y) {
+				u8 *dst = &scaler->stripe[(scaler->dstY % scaler->stripeHeight) * dw * 4];
+
+				for (x = 0; x < dw; x++, dst += 4) {
+					const u8 *p = &src[scaler->column[x] * bpp];
+
+					dst[0] = p[ro];
+					dst[1] = p[go];
+					dst[2] = p[bo];
+					dst[3] = (ao < 0) ? 0xFF : p[ao];
+				}
+				EmitRow(scaler);
+			}
+			continue;
+		}
+
+		// Horizontal pass: sums of the source pixels weighted by their coverage
+		{
+			u32 *h = scaler->row;
+			const u8 *p = src;
+
+			memset(h, 0, dw * 4 * sizeof(u32));
+			for (x = 0; x < sw; x++, p += bpp) {
+				const u32 i = scaler->column[x] * 4, w0 = scaler->weight[x], w1 = dw - w0;
+				const u32 a = (ao < 0) ? 0xFF : p[ao];
+
+				h[i]     += w0 * p[ro];
+				h[i + 1] += w0 * p[go];
+				h[i + 2] += w0 * p[bo];
+				h[i + 3] += w0 * a;
+				if (w1 != 0) {
+					h[i + 4] += w1 * p[ro];
+					h[i + 5] += w1 * p[go];
+					h[i + 6] += w1 * p[bo];
+					h[i + 7] += w1 * a;
+				}
+			}
+		}
+
+		// Vertical pass: source row y covers [y * dh, (y + 1) * dh), destination row dstY covers [dstY * sh, (dstY + 1) * sh)
+		{
+			const u32 start = y * dh, boundary = (scaler->dstY + 1) * sh;
+			const u32 w0 = (start + dh <= boundary) ? dh : boundary - start, w1 = dh - w0;
+			const u64 total = (u64)sw * sh;
+			u64 *acc = scaler->acc, *next = scaler->acc + dw * 4;
+
+			for (c = 0; c < dw * 4; c++) {
+				acc[c] += (u64)scaler->row[c] * w0;
+				next[c] += (u64)scaler->row[c] * w1;
+			}
+			if (start + dh >= boundary) {
+				u8 *dst = &scaler->stripe[(scaler->dstY % scaler->stripeHeight) * dw * 4];
+
+				for (c = 0; c < dw * 4; c++) {
+					dst[c] = (u8)((acc[c] + total / 2) / total);
+				}
+				// The next row becomes the current one
+				memcpy(acc, next, dw * 4 * sizeof(u64));
+				memset(next, 0, dw * 4 * sizeof(u64));
+				EmitRow(scaler);
+			}
+		}
+	}
+}
+
+/**
+ * Free the buffers of a scaler.
+ * @param scaler The scaler.
+ */
+void  GRRLIB_ScalerFree (GRRLIB_scaler *scaler) {
+	u32 dw, columns;
+
+	if (scaler->texture == NULL) {
+		return;  // Cleared but never prepared
+	}
+	dw = scaler->texture->width;
+	columns = (scaler->filter == GRRLIB_SCALE_NEAREST) ? dw : scaler->srcWidth;
+
+	GRRLIB_MemFree(scaler->stripe, dw * 4 * scaler->stripeHeight);
+	GRRLIB_MemFree(scaler->column, columns * sizeof(u32));
+	GRRLIB_MemFree(scaler->weight, scaler->srcWidth * sizeof(u32));
+	GRRLIB_MemFree(scaler->row, dw * 4 * sizeof(u32));
+	GRRLIB_MemFree(scaler->acc, dw * 4 * 2 * sizeof(u64));
+	scaler->stripe = NULL;
+	scaler->column = NULL;
+	scaler->weight = NULL;
+	scaler->row = NULL;
+	scaler->acc = NULL;
+}
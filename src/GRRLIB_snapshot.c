@@ -21,6 +21,7 @@ THE SOFTWARE.
 ------------------------------------------------------------------------------*/
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 /**
  * Make a snapshot of the screen in a texture WITHOUT ALPHA LAYER.
@@ -34,13 +35,15 @@ void  GRRLIB_Screen2Texture (int posx, int posy, GRRLIB_texture *tex, bool clear
         return;
     }
 
+	GRRLIB_SpriteBatchFlush();
+
 	GX_SetTexCopySrc(posx, posy, tex->width, tex->height);
 	GX_SetTexCopyDst(tex->width, tex->height, tex->fmt, GX_FALSE);
 	GX_CopyTex(tex->data, GX_FALSE);
 	GX_PixModeSync();
 	GRRLIB_FinalizeTexture(tex);
 	if(clear == true) {
-		GX_CopyDisp(GRRLIB_XFB[!GRRLIB_FB], GX_TRUE);
+		GX_CopyDisp(GRRLIB_GetFreeFramebuffer(), GX_TRUE);
 	}
 }
 
@@ -0,0 +1,350 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+#define STATE_MAX_ATTR  (32)    /**< Number of vertex attributes tracked. */
+#define STATE_UNKNOWN   (0xFF)  /**< Value used for a TEV operation or a vertex descriptor that is not known. */
+
+/**
+ * Structure to hold the GX state as last written by GRRLIB.
+ */
+typedef  struct GRRLIB_stateShadow {
+	u8        tevOp;                    /**< TEV operation of stage 0. */
+	u8        vtxDesc[STATE_MAX_ATTR];  /**< Vertex descriptors. */
+
+	bool      texObjValid;              /**< @c true if texObj holds the texture loaded in GX_TEXMAP0. */
+	GXTexObj  texObj;                   /**< Texture object loaded in GX_TEXMAP0. */
+
+	bool      tlutValid;                /**< @c true if tlut holds the palette loaded in GX_TLUT0. */
+	GXTlutObj tlut;                     /**< Palette loaded in GX_TLUT0. */
+
+	bool      posMtxValid;              /**< @c true if posMtx holds the matrix loaded in GX_PNMTX0. */
+	Mtx       posMtx;                   /**< Matrix loaded in GX_PNMTX0. */
+
+	bool      blendValid;               /**< @c true if blend holds the blending mode. */
+	u8        blend[4];                 /**< Blending mode (type, source factor, destination factor, logic operation). */
+
+	bool      scissorValid;             /**< @c true if scissor holds the clipping rectangle. */
+	u32       scissor[4];               /**< Clipping rectangle (x, y, width, height). */
+
+	bool      konstValid;               /**< @c true if konst holds the TEV constant colour. */
+	u32       konst;                    /**< TEV constant colour in RGBA format. */
+
+	bool      restorePending;           /**< @c true if a 2D draw changed the default 2D state. */
+	bool      mode3D;                   /**< @c true between GRRLIB_3dMode and GRRLIB_2dMode. */
+} GRRLIB_stateShadow;
+
+static GRRLIB_stateShadow  state;
+static GRRLIB_stateStats   stats = {0, 0};
+
+/**
+ * Forget the GX state known by GRRLIB.
+ * Call this after changing the TEV, the vertex descriptors, the texture, the position matrix,
+ * the blending mode or the clipping directly with GX, so that the next GRRLIB call writes them again.
+ * In 2D mode, the next untextured draw also restores the default 2D state.
+ */
+void  GRRLIB_StateInvalidate (void) {
+	state.tevOp = STATE_UNKNOWN;
+	memset(state.vtxDesc, STATE_UNKNOWN, sizeof(state.vtxDesc));
+	state.texObjValid = false;
+	state.tlutValid = false;
+	state.posMtxValid = false;
+	state.blendValid = false;
+	state.scissorValid = false;
+	state.konstValid = false;
+	state.restorePending = !state.mode3D;
+}
+
+/**
+ * Set the TEV operation of stage 0, unless it is already set.
+ * @param mode The TEV operation (GX_MODULATE, GX_PASSCLR, ...).
+ */
+void  GRRLIB_StateSetTevOp (const u8 mode) {
+	if (state.tevOp == mode) {
+		stats.elided++;
+		return;
+	}
+	if (mode == GRRLIB_TEV_KMODULATE || mode == GRRLIB_TEV_KPASSCLR) {
+		// Same as GX_MODULATE and GX_PASSCLR with the constant colour instead of the rasterized colour
+		GX_SetTevKColorSel(GX_TEVSTAGE0, GX_TEV_KCSEL_K0);
+		GX_SetTevKAlphaSel(GX_TEVSTAGE0, GX_TEV_KASEL_K0_A);
+		if (mode == GRRLIB_TEV_KMODULATE) {
+			GX_SetTevColorIn(GX_TEVSTAGE0, GX_CC_ZERO, GX_CC_TEXC, GX_CC_KONST, GX_CC_ZERO);
+			GX_SetTevAlphaIn(GX_TEVSTAGE0, GX_CA_ZERO, GX_CA_TEXA, GX_CA_KONST, GX_CA_ZERO);
+		}
+		else {
+			GX_SetTevColorIn(GX_TEVSTAGE0, GX_CC_ZERO, GX_CC_ZERO, GX_CC_ZERO, GX_CC_KONST);
+			GX_SetTevAlphaIn(GX_TEVSTAGE0, GX_CA_ZERO, GX_CA_ZERO, GX_CA_ZERO, GX_CA_KONST);
+		}
+		GX_SetTevColorOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+		GX_SetTevAlphaOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+	}
+	else {
+		GX_SetTevOp(GX_TEVSTAGE0, mode);
+	}
+	state.tevOp = mode;
+	stats.issued++;
+}
+
+/**
+ * Set a vertex descriptor, unless it is already set.
+ * @param attr The vertex attribute (GX_VA_POS, GX_VA_TEX0, ...).
+ * @param type The type of the attribute (GX_NONE, GX_DIRECT, GX_INDEX8, GX_INDEX16).
+ */
+void  GRRLIB_StateSetVtxDesc (const u8 attr, const u8 type) {
+	if (attr >= STATE_MAX_ATTR) {
+		GX_SetVtxDesc(attr, type);
+		stats.issued++;
+		return;
+	}
+	if (state.vtxDesc[attr] == type) {
+		stats.elided++;
+		return;
+	}
+	GX_SetVtxDesc(attr, type);
+	state.vtxDesc[attr] = type;
+	stats.issued++;
+}
+
+/**
+ * Clear all the vertex descriptors.
+ */
+void  GRRLIB_StateClearVtxDesc (void) {
+	GX_ClearVtxDesc();
+	memset(state.vtxDesc, GX_NONE, sizeof(state.vtxDesc));
+	stats.issued++;
+}
+
+/**
+ * Load a texture object in GX_TEXMAP0, unless the same texture is already loaded.
+ * The palette of a GX_TF_CI8 texture, given as user data by GRRLIB_FinalizeTexture, is loaded in GX_TLUT0.
+ * @param obj The texture object to load.
+ */
+void  GRRLIB_StateLoadTexObj (GXTexObj *obj) {
+	GXTlutObj *tlut;
+
+	if (GX_GetTexObjFmt(obj) == GX_TF_CI8 && (tlut = GX_GetTexObjUserData(obj)) != NULL) {
+		if (state.tlutValid == true && memcmp(&state.tlut, tlut, sizeof(GXTlutObj)) == 0) {
+			stats.elided++;
+		}
+		else {
+			GX_LoadTlut(tlut, GX_TLUT0);
+			memcpy(&state.tlut, tlut, sizeof(GXTlutObj));
+			state.tlutValid = true;
+			stats.issued++;
+		}
+	}
+	if (state.texObjValid == true && memcmp(&state.texObj, obj, sizeof(GXTexObj)) == 0) {
+		stats.elided++;
+		return;
+	}
+	GX_LoadTexObj(obj, GX_TEXMAP0);
+	GRRLIB_FrameCounters.textureLoads++;
+	memcpy(&state.texObj, obj, sizeof(GXTexObj));
+	state.texObjValid = true;
+	stats.issued++;
+}
+
+/**
+ * Load a matrix in GX_PNMTX0, unless the same matrix is already loaded.
+ * @param mtx The matrix to load.
+ */
+void  GRRLIB_StateLoadPosMtx (Mtx mtx) {
+	if (state.posMtxValid == true && memcmp(state.posMtx, mtx, sizeof(Mtx)) == 0) {
+		stats.elided++;
+		return;
+	}
+	GX_LoadPosMtxImm(mtx, GX_PNMTX0);
+	guMtxCopy(mtx, state.posMtx);
+	state.posMtxValid = true;
+	stats.issued++;
+}
+
+/**
+ * Set the blending mode, unless it is already set.
+ * @param type The blending type (GX_BM_BLEND, GX_BM_SUBTRACT, ...).
+ * @param srcFact The source factor.
+ * @param dstFact The destination factor.
+ * @param op The logic operation.
+ */
+void  GRRLIB_StateSetBlendMode (const u8 type, const u8 srcFact, const u8 dstFact, const u8 op) {
+	if (state.blendValid == true &&
+	    state.blend[0] == type && state.blend[1] == srcFact && state.blend[2] == dstFact && state.blend[3] == op) {
+		stats.elided++;
+		return;
+	}
+	GX_SetBlendMode(type, srcFact, dstFact, op);
+	state.blend[0] = type;
+	state.blend[1] = srcFact;
+	state.blend[2] = dstFact;
+	state.blend[3] = op;
+	state.blendValid = true;
+	stats.issued++;
+}
+
+/**
+ * Set the TEV constant colour used by GRRLIB_TEV_KMODULATE and GRRLIB_TEV_KPASSCLR, unless it is already set.
+ * @param color The colour in RGBA format.
+ */
+void  GRRLIB_StateSetKonstColor (const u32 color) {
+	if (state.konstValid == true && state.konst == color) {
+		stats.elided++;
+		return;
+	}
+	GX_SetTevKColor(GX_KCOLOR0, (GXColor) { GRRLIB_R(color), GRRLIB_G(color), GRRLIB_B(color), GRRLIB_A(color) });
+	state.konst = color;
+	state.konstValid = true;
+	stats.issued++;
+}
+
+/**
+ * Set the clipping rectangle, unless it is already set.
+ * @param x The x-coordinate of the rectangle.
+ * @param y The y-coordinate of the rectangle.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle.
+ */
+void  GRRLIB_StateSetScissor (const u32 x, const u32 y, const u32 width, const u32 height) {
+	if (state.scissorValid == true &&
+	    state.scissor[0] == x && state.scissor[1] == y && state.scissor[2] == width && state.scissor[3] == height) {
+		stats.elided++;
+		return;
+	}
+	GX_SetScissor(x, y, width, height);
+	state.scissor[0] = x;
+	state.scissor[1] = y;
+	state.scissor[2] = width;
+	state.scissor[3] = height;
+	state.scissorValid = true;
+	stats.issued++;
+}
+
+/**
+ * Set up GX for a textured 2D draw.
+ * GRRLIB_StateLeave restores the default 2D state after the draw, or the next untextured draw does with GRRLIB_SetLazyState.
+ * @param obj The texture object to load.
+ * @param mtx The position matrix to load.
+ */
+void  GRRLIB_StateTextured2D (GXTexObj *obj, Mtx mtx) {
+	GRRLIB_StateLoadTexObj(obj);
+	GRRLIB_StateSetTevOp  (GX_MODULATE);
+	GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+	GRRLIB_StateSetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+	GRRLIB_StateLoadPosMtx(mtx);
+
+	state.restorePending = true;
+}
+
+/**
+ * Set up GX for a textured 2D draw without vertex colours.
+ * @param obj The texture object to load.
+ * @param mtx The position matrix to load.
+ * @param color The colour of the vertices in RGBA format.
+ */
+void  GRRLIB_StateTextured2DKonst (GXTexObj *obj, Mtx mtx, const u32 color) {
+	GRRLIB_StateLoadTexObj   (obj);
+	GRRLIB_StateSetTevOp     (GRRLIB_TEV_KMODULATE);
+	GRRLIB_StateSetKonstColor(color);
+	GRRLIB_StateSetVtxDesc   (GX_VA_TEX0, GX_DIRECT);
+	GRRLIB_StateSetVtxDesc   (GX_VA_CLR0, GX_NONE);
+	GRRLIB_StateLoadPosMtx   (mtx);
+
+	state.restorePending = true;
+}
+
+/**
+ * Set up GX for an untextured 2D draw without vertex colours.
+ * @param color The colour of the vertices in RGBA format.
+ */
+void  GRRLIB_StateUntextured2DKonst (const u32 color) {
+	if (state.restorePending == true) {
+		GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
+	}
+	GRRLIB_StateSetTevOp     (GRRLIB_TEV_KPASSCLR);
+	GRRLIB_StateSetKonstColor(color);
+	GRRLIB_StateSetVtxDesc   (GX_VA_TEX0, GX_NONE);
+	GRRLIB_StateSetVtxDesc   (GX_VA_CLR0, GX_NONE);
+
+	state.restorePending = true;
+}
+
+/**
+ * Tell the state cache if GRRLIB is in 3D mode.
+ * @param enabled @c true in 3D mode, @c false in 2D mode.
+ */
+void  GRRLIB_StateSetMode3D (const bool enabled) {
+	state.mode3D = enabled;
+}
+
+/**
+ * Tell if the compact vertex format (GX_VTXFMT1) can be used.
+ * @return @c true if it is enabled and GRRLIB is in 2D mode, @c false otherwise.
+ */
+bool  GRRLIB_StateCompactAllowed (void) {
+	return GRRLIB_Settings.compactVertices == true && state.mode3D == false;
+}
+
+/**
+ * Restore the default 2D state (GX_PASSCLR, vertex colours, no texture coordinates and the current matrix) if a 2D draw changed it.
+ * With GRRLIB_SetLazyState, call this before sending vertices directly with GX after drawing with GRRLIB.
+ */
+void  GRRLIB_StateRestore (void) {
+	if (state.restorePending == false) {
+		return;
+	}
+	GRRLIB_StateSetTevOp  (GX_PASSCLR);
+	GRRLIB_StateSetVtxDesc(GX_VA_TEX0, GX_NONE);
+	GRRLIB_StateSetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+	GRRLIB_StateLoadPosMtx(GRRLIB_View2D);
+
+	state.restorePending = false;
+}
+
+/**
+ * End a GRRLIB draw: restore the default 2D state, unless GRRLIB_SetLazyState leaves it to the next draw.
+ */
+void  GRRLIB_StateLeave (void) {
+	if (GRRLIB_Settings.lazyState == false) {
+		GRRLIB_StateRestore();
+	}
+}
+
+/**
+ * Get the number of state changes sent to GX and skipped since the last reset.
+ * @return A GRRLIB_stateStats structure.
+ */
+GRRLIB_stateStats  GRRLIB_GetStateStats (void) {
+	return stats;
+}
+
+/**
+ * Reset the state change counters.
+ */
+void  GRRLIB_ResetStateStats (void) {
+	stats.issued = 0;
+	stats.elided = 0;
+}
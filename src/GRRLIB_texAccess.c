@@ -0,0 +1,362 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * Find the first byte of a row of pixels of a texture.
+ * Within a tile, a row of pixels always takes 8 bytes: 8 pixels of 1 byte, or 4 pixels of 2 bytes.
+ * GX_TF_RGBA8 pixels take 2 more bytes 32 bytes further.
+ * @param tex The texture, not GX_TF_CMPR.
+ * @param y The row.
+ * @return The first byte of the row in the first tile.
+ */
+static u8*  SpanRow (const GRRLIB_texture *tex, const u32 y) {
+	u32 tileW, tileH;
+	const u32 tileBytes = GRRLIB_TileGeometry(tex->fmt, &tileW, &tileH);
+
+	return (u8*)tex->data + (y / tileH) * ((tex->width + tileW - 1) / tileW) * tileBytes + (y % tileH) * 8;
+}
+
+/**
+ * Decode a span of pixels, one tile at a time.
+ * Inlined for each format so that the switch leaves the inner loop.
+ */
+static inline __attribute__((always_inline))
+void  ReadSpan (u32 *colors, const u8 *row, const u32 x, const u32 width, const u32 fmt,
+                const u32 tileBytes, const u32 tileW, const u8 *pal) {
+	const u32 pixelBytes = 8 / tileW;
+	const u8 *bp = row + (x / tileW) * tileBytes + (x % tileW) * pixelBytes;
+	u32 n = tileW - (x % tileW), left = width;
+
+	while (left > 0) {
+		if (n > left) {
+			n = left;
+		}
+		left -= n;
+		for (; n > 0; n--, bp += pixelBytes) {
+			switch (fmt) {
+				case GX_TF_I8:
+					*colors++ = (u32)bp[0] * 0x01010101;
+					break;
+				case GX_TF_IA4:
+					*colors++ = ((u32)(bp[0] & 0xF) * 0x11111100) | ((bp[0] >> 4) * 0x11);
+					break;
+				case GX_TF_IA8:
+					*colors++ = ((u32)bp[1] * 0x01010100) | bp[0];
+					break;
+				case GX_TF_RGB565:
+					*colors++ = GRRLIB_UnpackRGB565(((u16)bp[0] <<8) | bp[1]);
+					break;
+				case GX_TF_RGB5A3:
+					*colors++ = GRRLIB_UnpackRGB5A3(((u16)bp[0] <<8) | bp[1]);
+					break;
+				case GX_TF_CI8:
+					*colors++ = GRRLIB_UnpackRGB5A3(((u16)pal[bp[0] <<1] <<8) | pal[(bp[0] <<1) + 1]);
+					break;
+				default:
+					*colors++ = ((u32)bp[1] <<24) | ((u32)bp[32] <<16) | ((u32)bp[33] <<8) | bp[0];
+			}
+		}
+		// Next tile, from its first pixel
+		bp += tileBytes - 8;
+		n = tileW;
+	}
+}
+
+/**
+ * Encode a span of pixels, one tile at a time.
+ * Inlined for each format so that the switch leaves the inner loop.
+ */
+static inline __attribute__((always_inline))
+void  WriteSpan (const u32 *colors, u8 *row, const u32 x, const u32 width, const u32 fmt,
+                 const u32 tileBytes, const u32 tileW) {
+	const u32 pixelBytes = 8 / tileW;
+	u8 *bp = row + (x / tileW) * tileBytes + (x % tileW) * pixelBytes;
+	u32 n = tileW - (x % tileW), left = width, color;
+	u16 v;
+
+	while (left > 0) {
+		if (n > left) {
+			n = left;
+		}
+		left -= n;
+		for (; n > 0; n--, bp += pixelBytes) {
+			color = *colors++;
+			switch (fmt) {
+				case GX_TF_I8:
+					bp[0] = GRRLIB_LUMA(color);
+					break;
+				case GX_TF_IA4:
+					bp[0] = (GRRLIB_A(color) & 0xF0) | (GRRLIB_LUMA(color) >> 4);
+					break;
+				case GX_TF_IA8:
+					bp[0] = GRRLIB_A(color);
+					bp[1] = GRRLIB_LUMA(color);
+					break;
+				case GX_TF_RGB565:
+				case GX_TF_RGB5A3:
+					v = (fmt == GX_TF_RGB565) ? GRRLIB_PackRGB565(color) : GRRLIB_PackRGB5A3(color);
+					bp[0] = v >> 8;
+					bp[1] = v;
+					break;
+				default:
+					bp[0 ] = (u8)(color      );
+					bp[1 ] = (u8)(color >>24);
+					bp[32] = (u8)(color >>16);
+					bp[33] = (u8)(color >> 8);
+			}
+		}
+		bp += tileBytes - 8;
+		n = tileW;
+	}
+}
+
+/**
+ * Read a horizontal span of pixels of a texture.
+ * Gives the same colors as GRRLIB_GetPixelFromTexture, but walks the tiles once instead of locating each pixel.
+ * @param tex The texture, any format GRRLIB_GetPixelFromTexture works with.
+ * @param x Left of the span, the span must lie in the texture.
+ * @param y Row of the span.
+ * @param width Number of pixels to read.
+ * @param colors Set to the colors of the pixels in RGBA format.
+ */
+void  GRRLIB_ReadTextureSpan (const GRRLIB_texture *tex, const u32 x, const u32 y, const u32 width, u32 *colors) {
+	u32 i;
+	const u8 *row;
+
+	if (tex->fmt == GX_TF_CMPR) {
+		for (i = 0; i < width; i++) {
+			colors[i] = GRRLIB_GetPixelFromTexture(x + i, y, tex);
+		}
+		return;
+	}
+
+	row = SpanRow(tex, y);
+	switch (tex->fmt) {
+		case GX_TF_I8:
+			ReadSpan(colors, row, x, width, GX_TF_I8, 32, 8, NULL);
+			break;
+		case GX_TF_IA4:
+			ReadSpan(colors, row, x, width, GX_TF_IA4, 32, 8, NULL);
+			break;
+		case GX_TF_CI8:
+			ReadSpan(colors, row, x, width, GX_TF_CI8, 32, 8, GRRLIB_GetTexturePalette(tex));
+			break;
+		case GX_TF_IA8:
+			ReadSpan(colors, row, x, width, GX_TF_IA8, 32, 4, NULL);
+			break;
+		case GX_TF_RGB565:
+			ReadSpan(colors, row, x, width, GX_TF_RGB565, 32, 4, NULL);
+			break;
+		case GX_TF_RGB5A3:
+			ReadSpan(colors, row, x, width, GX_TF_RGB5A3, 32, 4, NULL);
+			break;
+		default:
+			ReadSpan(colors, row, x, width, GX_TF_RGBA8, 64, 4, NULL);
+	}
+}
+
+/**
+ * Write a horizontal span of pixels of a texture.
+ * Stores the same values as GRRLIB_SetPixelToTexture, but walks the tiles once instead of locating each pixel.
+ * GX_TF_CI8 pixels go through GRRLIB_SetPixelToTexture, GX_TF_CMPR textures are not modified.
+ * When the writes of the texture are tracked, the span is recorded for GRRLIB_FlushTextureDirty.
+ * @param tex The texture.
+ * @param x Left of the span, the span must lie in the texture.
+ * @param y Row of the span.
+ * @param width Number of pixels to write.
+ * @param colors The colors of the pixels in RGBA format.
+ */
+void  GRRLIB_WriteTextureSpan (GRRLIB_texture *tex, const u32 x, const u32 y, const u32 width, const u32 *colors) {
+	u32 i;
+	u8 *row;
+
+	switch (tex->fmt) {
+		case GX_TF_CMPR:
+			return;
+		case GX_TF_CI8:
+			for (i = 0; i < width; i++) {
+				GRRLIB_SetPixelToTexture(x + i, y, tex, colors[i]);
+			}
+			return;
+	}
+
+	row = SpanRow(tex, y);
+	switch (tex->fmt) {
+		case GX_TF_I8:
+			WriteSpan(colors, row, x, width, GX_TF_I8, 32, 8);
+			break;
+		case GX_TF_IA4:
+			WriteSpan(colors, row, x, width, GX_TF_IA4, 32, 8);
+			break;
+		case GX_TF_IA8:
+			WriteSpan(colors, row, x, width, GX_TF_IA8, 32, 4);
+			break;
+		case GX_TF_RGB565:
+			WriteSpan(colors, row, x, width, GX_TF_RGB565, 32, 4);
+			break;
+		case GX_TF_RGB5A3:
+			WriteSpan(colors, row, x, width, GX_TF_RGB5A3, 32, 4);
+			break;
+		default:
+			WriteSpan(colors, row, x, width, GX_TF_RGBA8, 64, 4);
+	}
+	if (tex->dirtyRows != NULL) {
+		GRRLIB_MarkTextureDirty(tex, x, y, width, 1);
+	}
+}
+
+/**
+ * Start walking the tiles of a texture in the order they are stored, row of tiles by row of tiles.
+ * Call GRRLIB_NextTextureBlock to get each tile:
+ * @code
+ * GRRLIB_textureBlock block;
+ *
+ * GRRLIB_BeginTextureBlocks(tex, &block);
+ * while (GRRLIB_NextTextureBlock(&block)) {
+ *     for (i = 0; i < 32; i += 2) {
+ *         block.ar[i + 1] = 255 - block.ar[i + 1];  // Invert the red of the 16 pixels
+ *     }
+ * }
+ * @endcode
+ * Writes through the blocks are not tracked, call GRRLIB_MarkTextureDirty or GRRLIB_FlushTextureDirty after them.
+ * Only the base level of a mipmapped texture is walked.
+ * @param tex The texture.
+ * @param block Set to the start of the walk.
+ * @return @c false if the texture has no data.
+ */
+bool  GRRLIB_BeginTextureBlocks (GRRLIB_texture *tex, GRRLIB_textureBlock *block) {
+	u32 tileH;
+
+	block->tileBytes = GRRLIB_TileGeometry(tex->fmt, &block->tileW, &tileH);
+	block->tileH = tileH;
+	block->rowWidth = (tex->width + block->tileW - 1) & ~(block->tileW - 1);
+	block->remaining = (tex->data == NULL) ? 0 : (block->rowWidth / block->tileW) * ((tex->height + tileH - 1) / tileH);
+	block->next = tex->data;
+	block->x = 0;
+	block->y = 0;
+	block->ar = NULL;
+	block->gb = NULL;
+	return block->remaining != 0;
+}
+
+/**
+ * Move to the next tile of a texture, see GRRLIB_BeginTextureBlocks.
+ * @param block The walk.
+ * @return @c true if block points to the next tile, @c false once all the tiles were visited.
+ */
+bool  GRRLIB_NextTextureBlock (GRRLIB_textureBlock *block) {
+	if (block->remaining == 0) {
+		return false;
+	}
+	if (block->ar != NULL) {
+		block->x += block->tileW;
+		if (block->x == block->rowWidth) {
+			block->x = 0;
+			block->y += block->tileH;
+		}
+	}
+	block->ar = block->next;
+	block->gb = (block->tileBytes == 64) ? block->next + 32 : NULL;
+	block->next += block->tileBytes;
+	block->remaining--;
+	return true;
+}
+
+/**
+ * Get a linear copy of a rectangle of a texture, to edit its pixels without dealing with tiles.
+ * The pixels are stored in RGBA format in lock->pixels, row after row, until GRRLIB_UnlockTexture.
+ * With GRRLIB_LOCK_WRITE only, they are not read and hold random values: write them all.
+ * Do not draw the texture nor lock the same pixels again before unlocking it.
+ * @param tex The texture.
+ * @param x Left of the rectangle in pixels.
+ * @param y Top of the rectangle in pixels.
+ * @param width Width of the rectangle, clipped to the texture.
+ * @param height Height of the rectangle, clipped to the texture.
+ * @param mode Whether the pixels are read, written or both.
+ * @param lock Set to the copy.
+ * @return @c false if the rectangle is outside of the texture or memory is missing.
+ */
+bool  GRRLIB_LockTexture (GRRLIB_texture *tex, s32 x, s32 y, s32 width, s32 height,
+                          const GRRLIB_lockMode mode, GRRLIB_textureLock *lock) {
+	u32 row;
+
+	lock->texture = tex;
+	lock->pixels = NULL;
+	lock->width = 0;
+	lock->height = 0;
+	lock->mode = mode;
+	if (x < 0) {
+		width += x;
+		x = 0;
+	}
+	if (y < 0) {
+		height += y;
+		y = 0;
+	}
+	if (x + width > (s32)tex->width) {
+		width = tex->width - x;
+	}
+	if (y + height > (s32)tex->height) {
+		height = tex->height - y;
+	}
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+
+	lock->pixels = GRRLIB_MemAlloc(width * height * sizeof(u32), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+	if (lock->pixels == NULL) {
+		return false;
+	}
+	lock->x = x;
+	lock->y = y;
+	lock->width = width;
+	lock->height = height;
+	if (mode & GRRLIB_LOCK_READ) {
+		for (row = 0; row < lock->height; row++) {
+			GRRLIB_ReadTextureSpan(tex, lock->x, lock->y + row, lock->width, &lock->pixels[row * lock->width]);
+		}
+	}
+	return true;
+}
+
+/**
+ * Free the copy made by GRRLIB_LockTexture, after tiling it back into the texture if it was locked for writing.
+ * Call GRRLIB_FlushTextureDirty before drawing the texture.
+ * @param lock The copy, nothing is done if locking failed.
+ */
+void  GRRLIB_UnlockTexture (GRRLIB_textureLock *lock) {
+	u32 row;
+
+	if (lock->pixels == NULL) {
+		return;
+	}
+	if (lock->mode & GRRLIB_LOCK_WRITE) {
+		for (row = 0; row < lock->height; row++) {
+			GRRLIB_WriteTextureSpan(lock->texture, lock->x, lock->y + row, lock->width, &lock->pixels[row * lock->width]);
+		}
+	}
+	GRRLIB_MemFree(lock->pixels, lock->width * lock->height * sizeof(u32));
+	lock->pixels = NULL;
+}
@@ -24,89 +24,355 @@ THE SOFTWARE.
 #include <pngu-mod.h>
 #include <stdio.h>
 #include <jpeglib.h>
+#include <jerror.h>
+#include <setjmp.h>
 #include <string.h>
 
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 
 /**
- * This structure contains information about the type, size, and layout of a file that containing a device-independent bitmap (DIB).
+ * Convert decoded pixels to the data of a texture and finalize it.
+ * @param my_texture The texture to fill.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the source pixels.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param fmt The texture format, or GRRLIB_TEXFMT_AUTO for the smallest format storing the image without loss.
  */
-typedef  struct tagBITMAPFILEHEADER {
-	u16 bfType;             /**< Specifies the file type. It must be set to the signature word BM (0x4D42) to indicate bitmap. */
-	u32 bfSize;             /**< Specifies the size, in bytes, of the bitmap file. */
-	u16 bfReserved1;        /**< Reserved; set to zero. */
-	u16 bfReserved2;        /**< Reserved; set to zero. */
-	u32 bfOffBits;          /**< Specifies the offset, in bytes, from the BITMAPFILEHEADER structure to the bitmap bits. */
-} BITMAPFILEHEADER;
+static void  GRRLIB_TextureFromPixels (GRRLIB_texture *my_texture, const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                                       const u32 width, const u32 height, const u32 fmt) {
+	const u32 encoding = GRRLIB_ChooseTextureFormat(src, stride, layout, width, height, fmt);
+
+	my_texture->fmt = (encoding == GRRLIB_TEXFMT_CMPR_HQ) ? GX_TF_CMPR : encoding;
+	my_texture->width = width;
+	my_texture->height = height;
+	my_texture->data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(my_texture), 32, GRRLIB_MEM_COLD);
+	if (my_texture->data != NULL) {
+		if (GRRLIB_TileImage(src, stride, layout, my_texture->data, encoding, width, height) == false) {
+			GRRLIB_ClearTexture(my_texture);
+		}
+		GRRLIB_FinalizeTexture(my_texture);
+	}
+}
+
+/**
+ * libjpeg error manager returning to GRRLIB_DecodeJPG instead of exiting.
+ */
+typedef  struct GRRLIB_jpegError {
+	struct jpeg_error_mgr  pub;   /**< The libjpeg error manager, must be the first member. */
+	jmp_buf                jump;  /**< Where to return on error. */
+} GRRLIB_jpegError;
+
+/**
+ * libjpeg source manager reading a buffer in memory.
+ */
+typedef  struct GRRLIB_jpegSource {
+	struct jpeg_source_mgr  pub;   /**< The libjpeg source manager, must be the first member. */
+	const u8               *next;  /**< Data not given to libjpeg yet. */
+	const u8               *end;   /**< End of the buffer, NULL if the size is not known. */
+	bool                    eoiInserted;  /**< The buffer ended and an end of image marker was given instead. */
+} GRRLIB_jpegSource;
+
+#define JPEG_CHUNK_SIZE  (4096)  /**< Bytes given to libjpeg at a time when the size of the buffer is not known. */
+
+/**
+ * Leave the decoding on a libjpeg error.
+ * @param cinfo The decompressor.
+ */
+static void  JPEGErrorExit (j_common_ptr cinfo) {
+	longjmp(((GRRLIB_jpegError*)cinfo->err)->jump, 1);
+}
+
+/**
+ * Count the libjpeg warnings without printing them.
+ * @param cinfo The decompressor.
+ * @param msg_level Level of the message, negative for warnings.
+ */
+static void  JPEGEmitMessage (j_common_ptr cinfo, int msg_level) {
+	if (msg_level < 0) {
+		cinfo->err->num_warnings++;
+	}
+}
+
+/**
+ * Nothing to do before decoding.
+ * @param cinfo The decompressor.
+ */
+static void  JPEGInitSource (j_decompress_ptr cinfo) {
+	(void)cinfo;
+}
+
+/**
+ * Give the next chunk of the buffer to libjpeg.
+ * At the end of a buffer of known size, an end of image marker is given, so that an image missing only its
+ * marker can be decoded; libjpeg warns if image data is missing. Reading past the marker is an error.
+ * @param cinfo The decompressor.
+ * @return TRUE, errors do not return.
+ */
+static boolean  JPEGFillInputBuffer (j_decompress_ptr cinfo) {
+	static const JOCTET eoi[2] = { 0xFF, JPEG_EOI };
+	GRRLIB_jpegSource *src = (GRRLIB_jpegSource*)cinfo->src;
+
+	if (src->end != NULL) {
+		if (src->next == eoi) {
+			cinfo->err->msg_code = JERR_INPUT_EOF;
+			cinfo->err->error_exit((j_common_ptr)cinfo);
+		}
+		src->pub.next_input_byte = src->next = eoi;
+		src->pub.bytes_in_buffer = 2;
+		src->eoiInserted = true;
+		return TRUE;
+	}
+	src->pub.next_input_byte = src->next;
+	src->pub.bytes_in_buffer = JPEG_CHUNK_SIZE;
+	src->next += JPEG_CHUNK_SIZE;
+	return TRUE;
+}
+
 /**
- * This structure contains information about the dimensions and color format of a device-independent bitmap (DIB).
+ * Skip data of the buffer.
+ * @param cinfo The decompressor.
+ * @param num_bytes Number of bytes to skip.
  */
-typedef  struct tagBITMAPINFOHEADER {
-	u32 biSize;             /**< Specifies the size of the structure, in bytes. */
-	u32 biWidth;            /**< Specifies the width of the bitmap, in pixels. */
-	u32 biHeight;           /**< Specifies the height of the bitmap, in pixels. */
-	u16 biPlanes;           /**< Specifies the number of planes for the target device. */
-	u16 biBitCount;         /**< Specifies the number of bits per pixel. */
-	u32 biCompression;      /**< Specifies the type of compression for a compressed bottom-up bitmap.*/
-	u32 biSizeImage;        /**< Specifies the size, in bytes, of the image. */
-	u32 biXPelsPerMeter;    /**< Specifies the horizontal resolution, in pixels per meter, of the target device for the bitmap. */
-	u32 biYPelsPerMeter;    /**< Specifies the vertical resolution, in pixels per meter, of the target device for the bitmap. */
-	u32 biClrUsed;          /**< Specifies the number of color indexes in the color table that are actually used by the bitmap. */
-	u32 biClrImportant;     /**< Specifies the number of color indexes required for displaying the bitmap. */
-} BITMAPINFOHEADER;
+static void  JPEGSkipInputData (j_decompress_ptr cinfo, long num_bytes) {
+	struct jpeg_source_mgr *src = cinfo->src;
+
+	if (num_bytes <= 0) {
+		return;
+	}
+	while (num_bytes > (long)src->bytes_in_buffer) {
+		num_bytes -= src->bytes_in_buffer;
+		src->fill_input_buffer(cinfo);
+	}
+	src->next_input_byte += num_bytes;
+	src->bytes_in_buffer -= num_bytes;
+}
+
 /**
- * The RGBQUAD structure describes a color consisting of relative intensities of
- * red, green, and blue. The bmiColors member of the BITMAPINFO structure
- * consists of an array of RGBQUAD structures.
+ * Nothing to do after decoding.
+ * @param cinfo The decompressor.
  */
-typedef  struct tagRGBQUAD {
-	u8 rgbBlue;             /**< Specifies the intensity of blue in the color. */
-	u8 rgbGreen;            /**< Specifies the intensity of green in the color. */
-	u8 rgbRed;              /**< Specifies the intensity of red in the color. */
-	u8 rgbReserved;         /**< Not used; must be set to zero. */
-} RGBQUAD;
+static void  JPEGTermSource (j_decompress_ptr cinfo) {
+	(void)cinfo;
+}
 
 /**
- * Convert a raw BMP (RGB, no alpha) to 4x4RGBA.
- * @author DragonMinded
- * @param src Source.
- * @param dst Destination.
- * @param width Width.
- * @param height Height.
-*/
-static
-void  RawTo4x4RGBA (const u8 *src, void *dst,
-					const u32 width, const u32 height) {
-	u32   block;
-	u32   i;
-	u8    c;
-	u8    argb;
-
-	u8    *p = (u8*)dst;
-
-	for (block = 0; block < height; block += 4) {
-		for (i = 0; i < width; i += 4) {
-			// Alpha and Red
-			for (c = 0; c < 4; ++c) {
-				for (argb = 0; argb < 4; ++argb) {
-					// Alpha pixels
-					*p++ = 255;
-					// Red pixels
-					*p++ = src[((i + argb) + ((block + c) * width)) * 3];
+ * Decode a JPEG image to a texture.
+ * In the formats that do not depend on the whole image, each stripe of scanlines as high as a row of tiles
+ * is converted to tiles as soon as it is decoded, so only the stripe is held besides the texture.
+ * GRRLIB_TEXFMT_AUTO and GX_TF_CI8 need the whole image, which is decoded to one buffer first.
+ * An image larger than the given size is shrunk by the IDCT of libjpeg by 2, 4 or 8 while it is decoded,
+ * then by the scaler to the exact size; the scaler is only used in the formats converted a stripe at a time.
+ * @param my_jpg The JPEG buffer to load.
+ * @param my_end End of the buffer, NULL if the size is not known.
+ * @param fmt Format of the texture, see GRRLIB_LoadTextureFmt.
+ * @param maxWidth Maximum width of the texture, 0 to keep the size of the image.
+ * @param maxHeight Maximum height of the texture, 0 to keep the size of the image.
+ * @param filter Filter used to shrink the image.
+ * @return A GRRLIB_texture structure filled with texture information, NULL if the image is not valid or memory is missing.
+ */
+static GRRLIB_texture*  GRRLIB_DecodeJPG (const u8 *my_jpg, const u8 *my_end, const u32 fmt,
+                                          const u32 maxWidth, const u32 maxHeight, const GRRLIB_scaleFilter filter) {
+	struct jpeg_decompress_struct cinfo;
+	GRRLIB_jpegError jerr;
+	GRRLIB_jpegSource src;
+	GRRLIB_scaler scaler;
+	GRRLIB_texture * volatile my_texture = GRRLIB_MemCalloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+	u8 * volatile pixels = NULL;
+	volatile u32 pixelsSize = 0;
+	JSAMPROW rows[8];
+	GRRLIB_pixelLayout layout;
+	u32 width = 0, height = 0, stride, stripe, y, i, denom;
+	bool scaled;
+
+	if (my_texture == NULL) {
+		return NULL;
+	}
+	memset(&scaler, 0, sizeof(GRRLIB_scaler));
+
+	cinfo.err = jpeg_std_error(&jerr.pub);
+	jerr.pub.error_exit = JPEGErrorExit;
+	jerr.pub.emit_message = JPEGEmitMessage;
+	if (setjmp(jerr.jump) != 0) {
+		jpeg_destroy_decompress(&cinfo);
+		GRRLIB_ScalerFree(&scaler);
+		GRRLIB_MemFree(pixels, pixelsSize);
+		GRRLIB_FreeTexture(my_texture);
+		return NULL;
+	}
+	jpeg_create_decompress(&cinfo);
+	cinfo.progress = NULL;
+
+	src.pub.init_source = JPEGInitSource;
+	src.pub.fill_input_buffer = JPEGFillInputBuffer;
+	src.pub.skip_input_data = JPEGSkipInputData;
+	src.pub.resync_to_restart = jpeg_resync_to_restart;
+	src.pub.term_source = JPEGTermSource;
+	src.pub.next_input_byte = my_jpg;
+	src.pub.bytes_in_buffer = (my_end != NULL) ? (size_t)(my_end - my_jpg) : JPEG_CHUNK_SIZE;
+	src.next = my_jpg + JPEG_CHUNK_SIZE;
+	src.end = my_end;
+	src.eoiInserted = false;
+	cinfo.src = &src.pub;
+
+	jpeg_read_header(&cinfo, TRUE);
+	if (cinfo.num_components != 1 && cinfo.num_components != 3) {
+		jerr.pub.error_exit((j_common_ptr)&cinfo);  // CMYK
+	}
+	cinfo.out_color_space = (cinfo.num_components == 1) ? JCS_GRAYSCALE : JCS_RGB;
+	if (maxWidth != 0 && maxHeight != 0) {
+		GRRLIB_FitImageSize(cinfo.image_width, cinfo.image_height, maxWidth, maxHeight, &width, &height);
+		// Largest reduction by the IDCT not going below the fitted size
+		for (denom = 8; denom > 1; denom >>= 1) {
+			if ((cinfo.image_width + denom - 1) / denom >= width && (cinfo.image_height + denom - 1) / denom >= height) {
+				break;
+			}
+		}
+		cinfo.scale_num = 1;
+		cinfo.scale_denom = denom;
+	}
+	jpeg_start_decompress(&cinfo);
+
+	if (maxWidth == 0 || maxHeight == 0) {
+		width = cinfo.output_width;
+		height = cinfo.output_height;
+	}
+	scaled = width != cinfo.output_width || height != cinfo.output_height;
+	stride = cinfo.output_width * cinfo.output_components;
+	layout = (cinfo.output_components == 1) ? GRRLIB_LAYOUT_GRAY : GRRLIB_LAYOUT_RGB;
+
+	switch (fmt) {
+		case GX_TF_RGBA8: case GX_TF_RGB565: case GX_TF_RGB5A3: case GX_TF_I8: case GX_TF_IA8: case GX_TF_IA4:
+		case GX_TF_CMPR: case GRRLIB_TEXFMT_CMPR_HQ:
+			my_texture->fmt = (fmt == GRRLIB_TEXFMT_CMPR_HQ) ? GX_TF_CMPR : fmt;
+			my_texture->width = width;
+			my_texture->height = height;
+			my_texture->data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(my_texture), 32, GRRLIB_MEM_COLD);
+			stripe = (my_texture->fmt == GX_TF_CMPR) ? 8 : 4;
+			pixelsSize = stride * stripe;
+			pixels = GRRLIB_MemAlloc(pixelsSize, 32, GRRLIB_MEM_SCRATCH);
+			if (my_texture->data == NULL || pixels == NULL ||
+			    (scaled == true && GRRLIB_ScalerInit(&scaler, my_texture, fmt, cinfo.output_width, cinfo.output_height, filter) == false)) {
+				jerr.pub.error_exit((j_common_ptr)&cinfo);
+			}
+			for (i = 0; i < stripe; i++) {
+				rows[i] = pixels + i * stride;
+			}
+			for (y = 0; y < cinfo.output_height; y += stripe) {
+				const u32 count = (cinfo.output_height - y < stripe) ? cinfo.output_height - y : stripe;
+
+				while (cinfo.output_scanline < y + count) {
+					jpeg_read_scanlines(&cinfo, &rows[cinfo.output_scanline - y], y + count - cinfo.output_scanline);
+				}
+				if (scaled == true) {
+					GRRLIB_ScalerPush(&scaler, pixels, stride, layout, count);
 				}
+				else {
+					GRRLIB_TileImage(pixels, stride, layout,
+					                 (u8*)my_texture->data + GX_GetTexBufferSize(width, y, my_texture->fmt, GX_FALSE, 0),
+					                 fmt, width, count);
+				}
+			}
+			GRRLIB_ScalerFree(&scaler);
+			GRRLIB_FinalizeTexture(my_texture);
+			break;
+
+		default:
+			pixelsSize = stride * cinfo.output_height;
+			pixels = GRRLIB_MemAlloc(pixelsSize, 32, GRRLIB_MEM_SCRATCH);
+			if (pixels == NULL) {
+				jerr.pub.error_exit((j_common_ptr)&cinfo);
+			}
+			while (cinfo.output_scanline < cinfo.output_height) {
+				rows[0] = pixels + cinfo.output_scanline * stride;
+				jpeg_read_scanlines(&cinfo, rows, 1);
+			}
+			GRRLIB_TextureFromPixels(my_texture, pixels, stride, layout, cinfo.output_width, cinfo.output_height, fmt);
+	}
+
+	if (src.eoiInserted == true && jerr.pub.num_warnings != 0) {
+		jerr.pub.error_exit((j_common_ptr)&cinfo);  // Image data missing
+	}
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	GRRLIB_MemFree(pixels, pixelsSize);
+
+	return my_texture;
+}
+
+/**
+ * Decode a bitmap to a texture.
+ * The fixed formats are tiled 4 rows at a time (8 for GX_TF_CMPR), others need the whole image.
+ * @param my_bmp The bitmap buffer to load.
+ * @param my_end End of the buffer, NULL if the size is not known.
+ * @param fmt Format of the texture, see GRRLIB_LoadTextureFmt.
+ * @return The texture, NULL if the bitmap is not supported or memory is missing.
+ */
+static GRRLIB_texture*  GRRLIB_DecodeBMP (const u8 *my_bmp, const u8 *my_end, const u32 fmt) {
+	GRRLIB_bmpDecoder bmp;
+	GRRLIB_texture *my_texture;
+	GRRLIB_pixelLayout layout;
+	const u8 *rows;
+	u8 *pixels = NULL;
+	u32 pixelsSize = 0, stripe, y;
+	s32 stride;
+
+	if (GRRLIB_BMPOpen(&bmp, my_bmp, my_end) == false) {
+		return NULL;
+	}
+	my_texture = GRRLIB_MemCalloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+	if (my_texture == NULL) {
+		GRRLIB_BMPClose(&bmp);
+		return NULL;
+	}
+
+	switch (fmt) {
+		case GX_TF_RGBA8: case GX_TF_RGB565: case GX_TF_RGB5A3: case GX_TF_I8: case GX_TF_IA8: case GX_TF_IA4:
+		case GX_TF_CMPR: case GRRLIB_TEXFMT_CMPR_HQ:
+			my_texture->fmt = (fmt == GRRLIB_TEXFMT_CMPR_HQ) ? GX_TF_CMPR : fmt;
+			my_texture->width = bmp.width;
+			my_texture->height = bmp.height;
+			my_texture->data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(my_texture), 32, GRRLIB_MEM_COLD);
+			stripe = (my_texture->fmt == GX_TF_CMPR) ? 8 : 4;
+			if (bmp.direct == false) {
+				pixelsSize = bmp.width * 4 * stripe;
+				pixels = GRRLIB_MemAlloc(pixelsSize, 32, GRRLIB_MEM_SCRATCH);
+			}
+			if (my_texture->data == NULL || (bmp.direct == false && pixels == NULL)) {
+				GRRLIB_FreeTexture(my_texture);
+				my_texture = NULL;
+				break;
 			}
+			for (y = 0; y < bmp.height; y += stripe) {
+				const u32 count = (bmp.height - y < stripe) ? bmp.height - y : stripe;
 
-			// Green and Blue
-			for (c = 0; c < 4; ++c) {
-				for (argb = 0; argb < 4; ++argb) {
-					// Green pixels
-					*p++ = src[(((i + argb) + ((block + c) * width)) * 3) + 1];
-					// Blue pixels
-					*p++ = src[(((i + argb) + ((block + c) * width)) * 3) + 2];
+				rows = GRRLIB_BMPReadRows(&bmp, y, count, pixels, &stride, &layout);
+				GRRLIB_TileImage(rows, stride, layout,
+				                 (u8*)my_texture->data + GX_GetTexBufferSize(bmp.width, y, my_texture->fmt, GX_FALSE, 0),
+				                 fmt, bmp.width, count);
+			}
+			GRRLIB_FinalizeTexture(my_texture);
+			break;
+
+		default:
+			if (bmp.direct == false) {
+				pixelsSize = bmp.width * 4 * bmp.height;
+				pixels = GRRLIB_MemAlloc(pixelsSize, 32, GRRLIB_MEM_SCRATCH);
+				if (pixels == NULL) {
+					GRRLIB_MemFree(my_texture, sizeof(GRRLIB_texture));
+					my_texture = NULL;
+					break;
 				}
 			}
-		}
+			rows = GRRLIB_BMPReadRows(&bmp, 0, bmp.height, pixels, &stride, &layout);
+			GRRLIB_TextureFromPixels(my_texture, rows, stride, layout, bmp.width, bmp.height, fmt);
 	}
+
+	GRRLIB_MemFree(pixels, pixelsSize);
+	GRRLIB_BMPClose(&bmp);
+	return my_texture;
 }
 
 /**
@@ -115,19 +381,29 @@ void  RawTo4x4RGBA (const u8 *src, void *dst,
  * @param h Height of the new texture to create.
  * @return A GRRLIB_texture structure newly created.
  */
-GRRLIB_texture*  GRRLIB_CreateEmptyTexture (const u32 width, const u32 height)
-{
-	GRRLIB_texture *my_texture = malloc(sizeof(GRRLIB_texture));
+GRRLIB_texture*  GRRLIB_CreateEmptyTexture (const u32 width, const u32 height) {
+	return GRRLIB_CreateEmptyTextureFmt(width, height, GX_TF_RGBA8);
+}
 
-	if (my_texture != NULL) {
-		my_texture->data = memalign(32, width * height * 4);
+/**
+ * Create an empty texture in a given format.
+ * @param width Width of the new texture to create.
+ * @param height Height of the new texture to create.
+ * @param fmt Format of the texture (GX_TF_RGBA8, GX_TF_RGB565, GX_TF_RGB5A3, GX_TF_I8, GX_TF_IA8, GX_TF_IA4, GX_TF_CI8, ...).
+ *            GRRLIB_TEXFMT_AUTO gives GX_TF_RGBA8, GRRLIB_TEXFMT_CMPR_HQ gives GX_TF_CMPR.
+ * @return A GRRLIB_texture structure newly created.
+ */
+GRRLIB_texture*  GRRLIB_CreateEmptyTextureFmt (const u32 width, const u32 height, const u32 fmt) {
+	GRRLIB_texture *my_texture = GRRLIB_MemCalloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
 
-		my_texture->fmt = GX_TF_RGBA8;
+	if (my_texture != NULL) {
+		my_texture->fmt = (fmt == GRRLIB_TEXFMT_AUTO) ? GX_TF_RGBA8 : (fmt == GRRLIB_TEXFMT_CMPR_HQ) ? GX_TF_CMPR : fmt;
 		my_texture->width = width;
 		my_texture->height = height;
+		my_texture->data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(my_texture), 32, GRRLIB_MEM_COLD);
 
 		// Initialize the texture
-		memset(my_texture->data, '\0', (width * height) << 2);
+		GRRLIB_ClearTexture(my_texture);
 
 		GRRLIB_FinalizeTexture(my_texture);
 	}
@@ -165,6 +441,30 @@ GRRLIB_texture*  GRRLIB_LoadTextureEx (const u8 *my_img, const u32 my_size) {
 		return (NULL);
 }
 
+/**
+ * Load a texture from a buffer in a given format.
+ * Images are converted to the format, which can lose colors. TPL textures keep their own format.
+ * @param my_img The PNG, BMP, JPG or TPL buffer to load.
+ * @param my_size Size of the buffer to load, only used for BMP, JPG and TPL.
+ * @param fmt Format of the texture (GX_TF_RGBA8, GX_TF_RGB565, GX_TF_RGB5A3, GX_TF_I8, GX_TF_IA8, GX_TF_IA4, GX_TF_CI8 or GX_TF_CMPR),
+ *            or GRRLIB_TEXFMT_AUTO for the smallest format storing the image without loss.
+ *            GX_TF_CI8 gives GX_TF_RGB5A3 for images of more than 256 colors.
+ *            GX_TF_CMPR takes 4 bits per pixel: GX_TF_CMPR compresses fast, GRRLIB_TEXFMT_CMPR_HQ compresses better but slower.
+ * @return A GRRLIB_texture structure filled with image information.
+ */
+GRRLIB_texture*  GRRLIB_LoadTextureFmt (const u8 *my_img, const u32 my_size, const u32 fmt) {
+	if (my_img[0]==0x89 && my_img[1]=='P' && my_img[2]=='N' && my_img[3]=='G')
+		return (GRRLIB_LoadTexturePNGFmt(my_img, fmt));
+	else if (my_img[0]=='B' && my_img[1]=='M')
+		return (GRRLIB_DecodeBMP(my_img, my_img + my_size, fmt));
+	else if (my_img[0]==0xFF && my_img[1]==0xD8 && my_img[2]==0xFF)
+		return (GRRLIB_LoadTextureJPGFmt(my_img, my_size, fmt));
+	else if (my_img[0]==0x00 && my_img[1]==0x20 && my_img[2]==0xAF && my_img[3]==0x30)
+		return (GRRLIB_LoadTextureTPL(my_img, my_size, 0)); // Load first texture in TPL
+	else
+		return (NULL);
+}
+
 /**
  * Load a texture from a buffer.
  * @param my_png the PNG buffer to load.
@@ -172,16 +472,52 @@ GRRLIB_texture*  GRRLIB_LoadTextureEx (const u8 *my_img, const u32 my_size) {
  *         If image size is not correct, the texture will be completely transparent.
  */
 GRRLIB_texture*  GRRLIB_LoadTexturePNG (const u8 *my_png) {
+	return GRRLIB_LoadTexturePNGFmt(my_png, GX_TF_RGBA8);
+}
+
+/**
+ * Load a texture from a buffer in a given format.
+ * @param my_png the PNG buffer to load.
+ * @param fmt Format of the texture, see GRRLIB_LoadTextureFmt.
+ * @return A GRRLIB_texture structure filled with image information.
+ *         If image size is not correct, the texture will be completely transparent.
+ */
+GRRLIB_texture*  GRRLIB_LoadTexturePNGFmt (const u8 *my_png, const u32 fmt) {
 	int width = 0, height = 0;
 	PNGUPROP imgProp;
 	IMGCTX ctx;
-	GRRLIB_texture *my_texture = malloc(sizeof(GRRLIB_texture));
+	u8 *pixels, *data;
+	u32 size;
+	GRRLIB_texture *my_texture = GRRLIB_MemCalloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
 
 	if (my_texture != NULL) {
 		ctx = PNGU_SelectImageFromBuffer(my_png);
 		PNGU_GetImageProperties(ctx, &imgProp);
-		// TODO: Add support for other texture formats.
-		my_texture->data = PNGU_DecodeTo4x4RGBA8(ctx, imgProp.imgWidth, imgProp.imgHeight, &width, &height, NULL);
+		if (fmt != GX_TF_RGBA8) {
+			// Decode to plain RGBA pixels, then convert them to the tiles of the format
+			size = imgProp.imgWidth * imgProp.imgHeight * 4;
+			if (imgProp.imgWidth != 0 && imgProp.imgHeight > 0xFFFFFFFF / 4 / imgProp.imgWidth) {
+				size = 0;
+			}
+			pixels = (size != 0) ? GRRLIB_MemAlloc(size, 32, GRRLIB_MEM_SCRATCH) : NULL;
+			my_texture->data = NULL;
+			if (pixels != NULL) {
+				if (PNGU_DecodeToRGBA8(ctx, imgProp.imgWidth, imgProp.imgHeight, &width, &height, pixels) != NULL) {
+					GRRLIB_TextureFromPixels(my_texture, pixels, width * 4, GRRLIB_LAYOUT_RGBA, width, height, fmt);
+				}
+				GRRLIB_MemFree(pixels, size);
+			}
+			PNGU_ReleaseImageContext(ctx);
+			return my_texture;
+		}
+		// PNGU writes whole tiles, as many as the texture holds
+		size = GX_GetTexBufferSize(imgProp.imgWidth, imgProp.imgHeight, GX_TF_RGBA8, GX_FALSE, 0);
+		data = (size != 0) ? GRRLIB_MemAlloc(size, 32, GRRLIB_MEM_COLD) : NULL;
+		if (data != NULL && PNGU_DecodeTo4x4RGBA8(ctx, imgProp.imgWidth, imgProp.imgHeight, &width, &height, data) == NULL) {
+			GRRLIB_MemFree(data, size);
+			data = NULL;
+		}
+		my_texture->data = data;
 		if (my_texture->data != NULL) {
 			my_texture->fmt = GX_TF_RGBA8;
 			my_texture->width = width;
@@ -198,182 +534,37 @@ GRRLIB_texture*  GRRLIB_LoadTexturePNG (const u8 *my_png) {
 }
 
 /**
- * Create an array of palette.
- * @param my_bmp Bitmap buffer to parse.
- * @param Size The number of palette to add.
- * @return An array of palette. Memory must be deleted.
+ * Load a texture from a buffer.
+ * Supports Windows and OS/2 bitmaps of 1, 4, 8, 16, 24 and 32 bits per pixel,
+ * uncompressed, run-length encoded (BI_RLE4, BI_RLE8) or with color masks (BI_BITFIELDS).
+ * Pixels skipped by a run-length encoded bitmap are transparent.
+ * @param my_bmp The bitmap buffer to load.
+ * @return A GRRLIB_texture structure filled with image information, NULL if the bitmap is not supported.
  */
-static RGBQUAD*  GRRLIB_CreatePalette (const u8 *my_bmp, u32 Size) {
-	u32 i = 0;
-	RGBQUAD *Palette = calloc(Size, sizeof(RGBQUAD));
-	for(u32 n=0; n<Size; n++) {
-		Palette[n].rgbBlue = my_bmp[i];
-		Palette[n].rgbGreen = my_bmp[i+1];
-		Palette[n].rgbRed = my_bmp[i+2];
-		Palette[n].rgbReserved = 0;
-		i += 4;
-	}
-	return Palette;
+GRRLIB_texture*  GRRLIB_LoadTextureBMP (const u8 *my_bmp) {
+	return GRRLIB_DecodeBMP(my_bmp, NULL, GX_TF_RGBA8);
 }
 
 /**
- * Load a texture from a buffer.
- * It only works for the Microsoft standard format uncompressed (1-bit, 4-bit, 8-bit, 24-bit and 32-bit).
+ * Load a texture from a buffer in a given format.
+ * Supports the same bitmaps as GRRLIB_LoadTextureBMP.
  * @param my_bmp The bitmap buffer to load.
- * @return A GRRLIB_texture structure filled with image information.
+ * @param fmt Format of the texture, see GRRLIB_LoadTextureFmt.
+ * @return A GRRLIB_texture structure filled with image information, NULL if the bitmap is not supported.
  */
-GRRLIB_texture*  GRRLIB_LoadTextureBMP (const u8 *my_bmp) {
-	BITMAPFILEHEADER MyBitmapFileHeader;
-	BITMAPINFOHEADER MyBitmapHeader;
-	u16 pal_ref;
-	u32 BufferSize;
-	s32 y, x, i;
-	GRRLIB_texture *my_texture = malloc(sizeof(GRRLIB_texture));
-
-	if (my_texture != NULL) {
-		// Fill file header structure
-		MyBitmapFileHeader.bfType      = (my_bmp[0]  | my_bmp[1]<<8);
-		MyBitmapFileHeader.bfSize      = (my_bmp[2]  | my_bmp[3]<<8  | my_bmp[4]<<16 | my_bmp[5]<<24);
-		MyBitmapFileHeader.bfReserved1 = (my_bmp[6]  | my_bmp[7]<<8);
-		MyBitmapFileHeader.bfReserved2 = (my_bmp[8]  | my_bmp[9]<<8);
-		MyBitmapFileHeader.bfOffBits   = (my_bmp[10] | my_bmp[11]<<8 | my_bmp[12]<<16 | my_bmp[13]<<24);
-		// Fill the bitmap structure
-		MyBitmapHeader.biSize          = (my_bmp[14] | my_bmp[15]<<8 | my_bmp[16]<<16 | my_bmp[17]<<24);
-		MyBitmapHeader.biWidth         = (my_bmp[18] | my_bmp[19]<<8 | my_bmp[20]<<16 | my_bmp[21]<<24);
-		MyBitmapHeader.biHeight        = (my_bmp[22] | my_bmp[23]<<8 | my_bmp[24]<<16 | my_bmp[25]<<24);
-		MyBitmapHeader.biPlanes        = (my_bmp[26] | my_bmp[27]<<8);
-		MyBitmapHeader.biBitCount      = (my_bmp[28] | my_bmp[29]<<8);
-		MyBitmapHeader.biCompression   = (my_bmp[30] | my_bmp[31]<<8 | my_bmp[32]<<16 | my_bmp[33]<<24);
-		MyBitmapHeader.biSizeImage     = (my_bmp[34] | my_bmp[35]<<8 | my_bmp[36]<<16 | my_bmp[37]<<24);
-		MyBitmapHeader.biXPelsPerMeter = (my_bmp[38] | my_bmp[39]<<8 | my_bmp[40]<<16 | my_bmp[41]<<24);
-		MyBitmapHeader.biYPelsPerMeter = (my_bmp[42] | my_bmp[43]<<8 | my_bmp[44]<<16 | my_bmp[45]<<24);
-		MyBitmapHeader.biClrUsed       = (my_bmp[46] | my_bmp[47]<<8 | my_bmp[48]<<16 | my_bmp[49]<<24);
-		MyBitmapHeader.biClrImportant  = (my_bmp[50] | my_bmp[51]<<8 | my_bmp[52]<<16 | my_bmp[53]<<24);
-
-		my_texture->data = memalign(32, MyBitmapHeader.biWidth * MyBitmapHeader.biHeight * 4);
-		if (my_texture->data != NULL && MyBitmapFileHeader.bfType == 0x4D42) {
-			RGBQUAD *Palette;
-			my_texture->width = MyBitmapHeader.biWidth;
-			my_texture->height = MyBitmapHeader.biHeight;
-			my_texture->fmt = GX_TF_RGBA8;
-			switch(MyBitmapHeader.biBitCount) {
-				case 32:    // RGBA images
-					i = 54;
-					for(y=MyBitmapHeader.biHeight-1; y>=0; y--) {
-						for(x=0; x<MyBitmapHeader.biWidth; x++) {
-							GRRLIB_SetPixelToTexture(x, y, my_texture,
-							                         GRRLIB_RGBA(my_bmp[i+2], my_bmp[i+1], my_bmp[i], my_bmp[i+3]));
-							i += 4;
-						}
-					}
-					break;
-				case 24:    // truecolor images
-					BufferSize = (MyBitmapHeader.biWidth % 4);
-					i = 54;
-					for(y=MyBitmapHeader.biHeight-1; y>=0; y--) {
-						for(x=0; x<MyBitmapHeader.biWidth; x++) {
-							GRRLIB_SetPixelToTexture(x, y, my_texture,
-							                         GRRLIB_RGBA(my_bmp[i+2], my_bmp[i+1], my_bmp[i], 0xFF));
-							i += 3;
-						}
-						i += BufferSize;   // Padding
-					}
-					break;
-				case 8:     // 256 color images
-					BufferSize = (int) MyBitmapHeader.biWidth;
-					while(BufferSize % 4) {
-						BufferSize++;
-					}
-					BufferSize -= MyBitmapHeader.biWidth;
-					Palette = GRRLIB_CreatePalette(&my_bmp[54], 256);
-					i = 1078; // 54 + (MyBitmapHeader.biBitCount * 4)
-					for(y=MyBitmapHeader.biHeight-1; y>=0; y--) {
-						for(x=0; x<MyBitmapHeader.biWidth; x++) {
-							GRRLIB_SetPixelToTexture(x, y, my_texture,
-							                         GRRLIB_RGBA(Palette[my_bmp[i]].rgbRed,
-							                                     Palette[my_bmp[i]].rgbGreen,
-							                                     Palette[my_bmp[i]].rgbBlue,
-							                                     0xFF));
-							i++;
-						}
-						i += BufferSize;   // Padding
-					}
-					free(Palette);
-					break;
-				case 4:     // 16 color images
-					BufferSize = (int)((MyBitmapHeader.biWidth*4) / 8.0);
-					while(8*BufferSize < MyBitmapHeader.biWidth*4) {
-						BufferSize++;
-					}
-					while(BufferSize % 4) {
-						BufferSize++;
-					}
-					Palette = GRRLIB_CreatePalette(&my_bmp[54], 16);
-					i = 118; // 54 + (MyBitmapHeader.biBitCount * 4)
-					for(y=MyBitmapHeader.biHeight-1; y>=0; y--) {
-						for(x=0; x<MyBitmapHeader.biWidth; x++) {
-							pal_ref = (my_bmp[i + (x / 2)] >> ((x % 2) ? 0 : 4)) & 0x0F;
-							GRRLIB_SetPixelToTexture(x, y, my_texture,
-							                         GRRLIB_RGBA(Palette[pal_ref].rgbRed,
-							                                     Palette[pal_ref].rgbGreen,
-							                                     Palette[pal_ref].rgbBlue,
-							                                     0xFF));
-						}
-						i += BufferSize;   // Padding
-					}
-					free(Palette);
-					break;
-				case 1:     // black & white images
-					BufferSize = (int)(MyBitmapHeader.biWidth / 8.0);
-					while(8*BufferSize < MyBitmapHeader.biWidth) {
-						BufferSize++;
-					}
-					while(BufferSize % 4) {
-						BufferSize++;
-					}
-					Palette = GRRLIB_CreatePalette(&my_bmp[54], 2);
-					i = 62; // 54 + (MyBitmapHeader.biBitCount * 4)
-					for(y=MyBitmapHeader.biHeight-1; y>=0; y--) {
-						for(x=0; x<MyBitmapHeader.biWidth; x++) {
-							pal_ref = (my_bmp[i + (x / 8)] >> (-x%8+7)) & 0x01;
-							GRRLIB_SetPixelToTexture(x, y, my_texture,
-							                         GRRLIB_RGBA(Palette[pal_ref].rgbRed,
-								                                 Palette[pal_ref].rgbGreen,
-								                                 Palette[pal_ref].rgbBlue,
-								                                 0xFF));
-						}
-						i += BufferSize;   // Padding
-					}
-					free(Palette);
-					break;
-				default:
-					GRRLIB_ClearTexture(my_texture);
-			}
-			GRRLIB_FinalizeTexture(my_texture);
-		}
-	}
-	return my_texture;
+GRRLIB_texture*  GRRLIB_LoadTextureBMPFmt (const u8 *my_bmp, const u32 fmt) {
+	return GRRLIB_DecodeBMP(my_bmp, NULL, fmt);
 }
 
 /**
  * Load a texture from a buffer.
- * Take care to have the JPG finish with 0xFF 0xD9!
+ * The decoder stops at the end of the image (0xFF 0xD9), the data after it is never read.
+ * A damaged JPEG may be read past its end, use GRRLIB_LoadTextureJPGEx when the size is known.
  * @param my_jpg The JPEG buffer to load.
- * @return A GRRLIB_texture structure filled with image information.
+ * @return A GRRLIB_texture structure filled with image information, NULL if the image is not valid.
  */
 GRRLIB_texture*  GRRLIB_LoadTextureJPG (const u8 *my_jpg) {
-	int n = 0;
-
-	if ((my_jpg[0]==0xFF) && (my_jpg[1]==0xD8) && (my_jpg[2]==0xFF)) {
-		while(true) {
-			if ((my_jpg[n]==0xFF) && (my_jpg[n+1]==0xD9))
-				break;
-			n++;
-		}
-		n+=2;
-	}
-
-	return GRRLIB_LoadTextureJPGEx(my_jpg, n);
+	return GRRLIB_DecodeJPG(my_jpg, NULL, GX_TF_RGBA8, 0, 0, GRRLIB_SCALE_AREA);
 }
 
 /**
@@ -381,84 +572,173 @@ GRRLIB_texture*  GRRLIB_LoadTextureJPG (const u8 *my_jpg) {
  * @author DrTwox
  * @param my_jpg The JPEG buffer to load.
  * @param my_size Size of the JPEG buffer to load.
- * @return A GRRLIB_texture structure filled with texture information.
+ * @return A GRRLIB_texture structure filled with texture information, NULL if the image is not valid or ends before the end of the buffer.
  */
 GRRLIB_texture*  GRRLIB_LoadTextureJPGEx (const u8 *my_jpg, const u32 my_size) {
-	struct jpeg_decompress_struct cinfo;
-	struct jpeg_error_mgr jerr;
-	GRRLIB_texture *my_texture = malloc(sizeof(GRRLIB_texture));
+	return GRRLIB_LoadTextureJPGFmt(my_jpg, my_size, GX_TF_RGBA8);
+}
 
-	if (my_texture == NULL) {
-		return NULL;
-	}
+/**
+ * Load a texture from a buffer in a given format.
+ * @param my_jpg The JPEG buffer to load.
+ * @param my_size Size of the JPEG buffer to load.
+ * @param fmt Format of the texture, see GRRLIB_LoadTextureFmt.
+ * @return A GRRLIB_texture structure filled with texture information, NULL if the image is not valid or ends before the end of the buffer.
+ */
+GRRLIB_texture*  GRRLIB_LoadTextureJPGFmt (const u8 *my_jpg, const u32 my_size, const u32 fmt) {
+	return GRRLIB_DecodeJPG(my_jpg, my_jpg + my_size, fmt, 0, 0, GRRLIB_SCALE_AREA);
+}
 
-	jpeg_create_decompress(&cinfo);
-	cinfo.err = jpeg_std_error(&jerr);
-	cinfo.progress = NULL;
-	jpeg_mem_src(&cinfo, (unsigned char *)my_jpg, my_size);
-	jpeg_read_header(&cinfo, TRUE);
-	if (cinfo.jpeg_color_space == JCS_GRAYSCALE) {
-		cinfo.out_color_space = JCS_RGB;
-	}
-	jpeg_start_decompress(&cinfo);
-	unsigned char *tempBuffer = malloc(cinfo.output_width * cinfo.output_height * cinfo.output_components);
-	JSAMPROW row_pointer[1];
-	row_pointer[0] = malloc(cinfo.output_width * cinfo.output_components);
-	size_t location = 0;
-	while (cinfo.output_scanline < cinfo.output_height) {
-		jpeg_read_scanlines(&cinfo, row_pointer, 1);
-		for (unsigned int i = 0; i < cinfo.image_width * cinfo.output_components; i++) {
-			/* Put the decoded scanline into the tempBuffer */
-			tempBuffer[ location++ ] = row_pointer[0][i];
+/**
+ * Create a GX_TF_RGBA8 texture for an image shrunk to fit in a box, and the scaler filling it.
+ * @param scaler The scaler to prepare.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param maxWidth Maximum width of the texture.
+ * @param maxHeight Maximum height of the texture.
+ * @param filter Filter used to shrink the image.
+ * @return The texture, NULL if memory is missing.
+ */
+static GRRLIB_texture*  GRRLIB_CreateScaledTexture (GRRLIB_scaler *scaler, const u32 width, const u32 height,
+                                                    const u32 maxWidth, const u32 maxHeight, const GRRLIB_scaleFilter filter) {
+	GRRLIB_texture *my_texture = GRRLIB_MemCalloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+
+	if (my_texture != NULL) {
+		my_texture->fmt = GX_TF_RGBA8;
+		GRRLIB_FitImageSize(width, height, maxWidth, maxHeight, &my_texture->width, &my_texture->height);
+		my_texture->data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(my_texture), 32, GRRLIB_MEM_COLD);
+		if (my_texture->data == NULL ||
+		    GRRLIB_ScalerInit(scaler, my_texture, GX_TF_RGBA8, width, height, filter) == false) {
+			GRRLIB_FreeTexture(my_texture);
+			return NULL;
 		}
 	}
+	return my_texture;
+}
 
-	/* Create a buffer to hold the final texture */
-	my_texture->data = memalign(32, cinfo.output_width * cinfo.output_height * 4);
-	RawTo4x4RGBA(tempBuffer, my_texture->data, cinfo.output_width, cinfo.output_height);
-
-	/* Done - Do cleanup and release allocated memory */
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-	free(row_pointer[0]);
-	free(tempBuffer);
-
-	my_texture->fmt = GX_TF_RGBA8;
-	my_texture->width = cinfo.output_width;
-	my_texture->height = cinfo.output_height;
+/**
+ * Load a texture from a buffer, shrinking the image to fit in a given size.
+ * The aspect ratio of the image is kept and images are never enlarged.
+ * Besides the given size, textures are limited to 1024x1024, the largest size GX can sample.
+ * JPEG images are shrunk by 2, 4 or 8 by libjpeg while they are decoded, then to the exact size.
+ * BMP images are shrunk while they are converted to tiles, 4 rows at a time.
+ * PNGU can not decode a PNG image by rows, so PNG images are decoded whole then shrunk:
+ * they need 4 bytes per pixel of the full image, and images larger than 4 GB in RGBA are rejected.
+ * @param my_img The PNG, BMP or JPG buffer to load.
+ * @param my_size Size of the buffer to load.
+ * @param maxWidth Maximum width of the texture, 0 for 1024.
+ * @param maxHeight Maximum height of the texture, 0 for 1024.
+ * @param filter Filter used to shrink the image: GRRLIB_SCALE_AREA or GRRLIB_SCALE_NEAREST.
+ * @return A GX_TF_RGBA8 GRRLIB_texture structure filled with image information, NULL if the image is not supported.
+ */
+GRRLIB_texture*  GRRLIB_LoadTextureScaled (const u8 *my_img, const u32 my_size, const u32 maxWidth, const u32 maxHeight,
+                                           const GRRLIB_scaleFilter filter) {
+	const u32 boxWidth = (maxWidth == 0 || maxWidth > 1024) ? 1024 : maxWidth;
+	const u32 boxHeight = (maxHeight == 0 || maxHeight > 1024) ? 1024 : maxHeight;
+	GRRLIB_texture *my_texture = NULL;
+	GRRLIB_scaler scaler;
+
+	if (my_img[0]==0x89 && my_img[1]=='P' && my_img[2]=='N' && my_img[3]=='G') {
+		PNGUPROP imgProp;
+		IMGCTX ctx = PNGU_SelectImageFromBuffer(my_img);
+		int width = 0, height = 0;
+		u32 size;
+		u8 *pixels;
 
-	GRRLIB_FinalizeTexture(my_texture);
+		PNGU_GetImageProperties(ctx, &imgProp);
+		// PNGU only decodes whole images, so a PNG is decoded before it is shrunk
+		size = imgProp.imgWidth * imgProp.imgHeight * 4;
+		if (imgProp.imgWidth != 0 && imgProp.imgHeight > 0xFFFFFFFF / 4 / imgProp.imgWidth) {
+			size = 0;
+		}
+		pixels = (size != 0) ? GRRLIB_MemAlloc(size, 32, GRRLIB_MEM_SCRATCH) : NULL;
+		if (pixels != NULL && PNGU_DecodeToRGBA8(ctx, imgProp.imgWidth, imgProp.imgHeight, &width, &height, pixels) != NULL) {
+			my_texture = GRRLIB_CreateScaledTexture(&scaler, width, height, boxWidth, boxHeight, filter);
+			if (my_texture != NULL) {
+				GRRLIB_ScalerPush(&scaler, pixels, width * 4, GRRLIB_LAYOUT_RGBA, height);
+				GRRLIB_ScalerFree(&scaler);
+				GRRLIB_FinalizeTexture(my_texture);
+			}
+		}
+		GRRLIB_MemFree(pixels, size);
+		PNGU_ReleaseImageContext(ctx);
+	}
+	else if (my_img[0]=='B' && my_img[1]=='M') {
+		GRRLIB_bmpDecoder bmp;
+		GRRLIB_pixelLayout layout;
+		const u8 *rows;
+		u8 *pixels = NULL;
+		s32 stride;
+		u32 y;
+
+		if (GRRLIB_BMPOpen(&bmp, my_img, my_img + my_size) == false) {
+			return NULL;
+		}
+		if (bmp.direct == false) {
+			pixels = GRRLIB_MemAlloc(bmp.width * 4 * 4, 32, GRRLIB_MEM_SCRATCH);
+		}
+		if (bmp.direct == true || pixels != NULL) {
+			my_texture = GRRLIB_CreateScaledTexture(&scaler, bmp.width, bmp.height, boxWidth, boxHeight, filter);
+		}
+		if (my_texture != NULL) {
+			for (y = 0; y < bmp.height; y += 4) {
+				const u32 count = (bmp.height - y < 4) ? bmp.height - y : 4;
 
+				rows = GRRLIB_BMPReadRows(&bmp, y, count, pixels, &stride, &layout);
+				GRRLIB_ScalerPush(&scaler, rows, stride, layout, count);
+			}
+			GRRLIB_ScalerFree(&scaler);
+			GRRLIB_FinalizeTexture(my_texture);
+		}
+		GRRLIB_MemFree(pixels, bmp.width * 4 * 4);
+		GRRLIB_BMPClose(&bmp);
+	}
+	else if (my_img[0]==0xFF && my_img[1]==0xD8 && my_img[2]==0xFF) {
+		my_texture = GRRLIB_DecodeJPG(my_img, my_img + my_size, GX_TF_RGBA8, boxWidth, boxHeight, filter);
+	}
 	return my_texture;
 }
 
 /**
  * Load a texture from a buffer.
+ * The texture gets its own copy of the image, use GRRLIB_OpenTPLSet to share the data of a TPL between several textures.
+ * It keeps the wrap modes, filters and levels of detail stored in the file.
  * @param my_tpl The TPL buffer to load.
  * @param my_size Size of the TPL buffer to load.
  * @param my_id Texture ID to load.
  * @return A GRRLIB_texture structure filled with texture information.
+ *         If an error occurs NULL will be returned.
  */
 GRRLIB_texture*  GRRLIB_LoadTextureTPL (const u8 *my_tpl, const u32 my_size, const s32 my_id) {
-	void *tplData = memalign(32, my_size);
-	TPLFile *tdf = malloc(sizeof(TPLFile));
-	u16 w, h;
-	GRRLIB_texture *my_texture = malloc(sizeof(GRRLIB_texture));
+	GRRLIB_texture *my_texture = NULL;
+	const GRRLIB_texture *source;
+	GRRLIB_tplSet *set;
+	u8 *tplData = GRRLIB_MemAlloc(my_size, 32, GRRLIB_MEM_SCRATCH);  // libogc rewrites the headers of the file it opens
 
-	memcpy(tplData, (const void *) my_tpl, my_size);
-
-	if (TPL_OpenTPLFromMemory(tdf, tplData, my_size) < 0) {
+	if (tplData == NULL) {
 		return NULL;
 	}
-
-	TPL_GetTextureInfo(tdf, my_id, &my_texture->fmt, &w, &h);
-	my_texture->width = (u32) w;
-	my_texture->height = (u32) h;
-
-	TPL_GetTexture(tdf, my_id, &my_texture->obj); // No need to finalize texture
-
-	GRRLIB_SetTexturePart(my_texture);
-
+	memcpy(tplData, my_tpl, my_size);
+	set = GRRLIB_OpenTPLSet(tplData, my_size);
+	if (set != NULL && (source = GRRLIB_GetTPLSetTexture(set, my_id)) != NULL) {
+		my_texture = GRRLIB_MemAlloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+		if (my_texture != NULL) {
+			*my_texture = *source;
+			my_texture->data = GRRLIB_MemAlloc(GRRLIB_GetTextureDataSize(source), 32, GRRLIB_MEM_COLD);
+			if (my_texture->data == NULL) {
+				GRRLIB_MemFree(my_texture, sizeof(GRRLIB_texture));
+				my_texture = NULL;
+			}
+			else {
+				// Keep the wrap modes, filters and levels of detail of the file, only the data moves
+				memcpy(my_texture->data, source->data, GRRLIB_GetTextureDataSize(source));
+				DCFlushRange(my_texture->data, GRRLIB_GetTextureDataSize(my_texture));
+				GX_InitTexObjData(&my_texture->obj, my_texture->data);
+			}
+		}
+	}
+	GRRLIB_FreeTPLSet(set);
+	GRRLIB_MemFree(tplData, my_size);
 	return my_texture;
 }
 
@@ -484,7 +764,7 @@ GRRLIB_texturePart*  GRRLIB_CreateTexturePart (const f32 x, const f32 y, const f
  * @param textureHeight Height of the texture.
  */
 GRRLIB_texturePart*  GRRLIB_CreateTexturePartEx (const f32 x, const f32 y, const f32 width, const f32 height, const u32 textureWidth, const u32 textureHeight) {
-	GRRLIB_texturePart *texPart = malloc(sizeof(GRRLIB_texturePart));
+	GRRLIB_texturePart *texPart = GRRLIB_MemAlloc(sizeof(GRRLIB_texturePart), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
 
 	// The 0.001f/x is the frame correction formula by spiffen
 	texPart->x = (x /textureWidth) +(0.001f /textureWidth);
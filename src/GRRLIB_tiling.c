@@ -0,0 +1,450 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/*
+ * Each 4x4 tile of a GX_TF_RGBA8 texture is 64 bytes: 16 alpha/red pairs followed by 16 green/blue pairs,
+ * both in row order. A row of a tile is written as one 64-bit word of four pairs.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TILE_PAIR(hi, lo)          ((u64)(lo) << 8 | (u64)(hi))
+#define TILE_ROW(p0, p1, p2, p3)   ((p0) | (p1) << 16 | (p2) << 32 | (p3) << 48)
+#else
+#define TILE_PAIR(hi, lo)          ((u64)(hi) << 8 | (u64)(lo))
+#define TILE_ROW(p0, p1, p2, p3)   ((p0) << 48 | (p1) << 32 | (p2) << 16 | (p3))
+#endif
+
+/**
+ * Convert a stripe of up to 4 rows to RGBA8 tiles.
+ * Called with constant channel offsets so that each pixel layout gets its own unrolled loop.
+ * @param dst Destination, the first tile of the stripe.
+ * @param src Source, the first pixel of the stripe.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param width Width of the image in pixels.
+ * @param rows Number of rows in the stripe, at most 4.
+ * @param bpp Bytes per source pixel.
+ * @param ro Offset of the red channel.
+ * @param go Offset of the green channel.
+ * @param bo Offset of the blue channel.
+ * @param ao Offset of the alpha channel, -1 for opaque images.
+ */
+static inline __attribute__((always_inline))
+void  TileStripe (u64 *dst, const u8 *src, const s32 stride, const u32 width, const u32 rows,
+                  const u32 bpp, const u32 ro, const u32 go, const u32 bo, const s32 ao) {
+	const u32 full = (rows == 4) ? (width & ~3) : 0;
+	u32 x, r, c;
+
+#define TILE_A(p)  ((ao < 0) ? 0xFF : (p)[ao])
+
+	// Whole tiles
+	for (x = 0; x < full; x += 4, dst += 8) {
+		for (r = 0; r < 4; r++) {
+			const u8 *p = src + (s32)r * stride + x * bpp;
+
+			dst[r]     = TILE_ROW(TILE_PAIR(TILE_A(p          ), p[          ro]),
+			                      TILE_PAIR(TILE_A(p +     bpp), p[    bpp + ro]),
+			                      TILE_PAIR(TILE_A(p + 2 * bpp), p[2 * bpp + ro]),
+			                      TILE_PAIR(TILE_A(p + 3 * bpp), p[3 * bpp + ro]));
+			dst[4 + r] = TILE_ROW(TILE_PAIR(p[          go], p[          bo]),
+			                      TILE_PAIR(p[    bpp + go], p[    bpp + bo]),
+			                      TILE_PAIR(p[2 * bpp + go], p[2 * bpp + bo]),
+			                      TILE_PAIR(p[3 * bpp + go], p[3 * bpp + bo]));
+		}
+	}
+
+	// Tiles crossing the right or the bottom edge, padded with transparent black
+	for (; x < width; x += 4, dst += 8) {
+		u8 *d = (u8*)dst;
+
+		for (r = 0; r < 4; r++) {
+			for (c = 0; c < 4; c++) {
+				const u32 i = ((r << 2) + c) << 1;
+
+				if (r < rows && x + c < width) {
+					const u8 *p = src + (s32)r * stride + (x + c) * bpp;
+
+					d[i]      = TILE_A(p);
+					d[i + 1]  = p[ro];
+					d[i + 32] = p[go];
+					d[i + 33] = p[bo];
+				}
+				else {
+					d[i] = d[i + 1] = d[i + 32] = d[i + 33] = 0;
+				}
+			}
+		}
+	}
+
+#undef TILE_A
+}
+
+/**
+ * Convert a stripe of up to 4 rows of an image to GX_TF_RGBA8 tiles.
+ * Used by loaders which decode a few rows at a time.
+ * @param src The first pixel of the stripe.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the source pixels.
+ * @param dst The first tile of the stripe, (width + 3) / 4 * 64 bytes are written.
+ * @param width Width of the image in pixels.
+ * @param rows Number of rows in the stripe, 1 to 4.
+ */
+void  GRRLIB_TileStripeRGBA8 (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                              void *dst, const u32 width, const u32 rows) {
+	switch (layout) {
+		case GRRLIB_LAYOUT_RGB:    TileStripe(dst, src, stride, width, rows, 3, 0, 1, 2, -1);  break;
+		case GRRLIB_LAYOUT_RGBA:   TileStripe(dst, src, stride, width, rows, 4, 0, 1, 2,  3);  break;
+		case GRRLIB_LAYOUT_BGR:    TileStripe(dst, src, stride, width, rows, 3, 2, 1, 0, -1);  break;
+		case GRRLIB_LAYOUT_BGRA:   TileStripe(dst, src, stride, width, rows, 4, 2, 1, 0,  3);  break;
+		case GRRLIB_LAYOUT_GRAY:   TileStripe(dst, src, stride, width, rows, 1, 0, 0, 0, -1);  break;
+		case GRRLIB_LAYOUT_GRAYA:  TileStripe(dst, src, stride, width, rows, 2, 0, 0, 0,  1);  break;
+	}
+}
+
+/**
+ * Convert an image to GX_TF_RGBA8 tiles.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the source pixels.
+ * @param dst Destination, GX_GetTexBufferSize(width, height, GX_TF_RGBA8, GX_FALSE, 0) bytes are written.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ */
+void  GRRLIB_TileRGBA8 (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                        void *dst, const u32 width, const u32 height) {
+	const u32 stripeSize = ((width + 3) & ~3) << 4;
+	u8 *d = dst;
+	u32 y;
+
+	for (y = 0; y < height; y += 4, src += 4 * stride, d += stripeSize) {
+		GRRLIB_TileStripeRGBA8(src, stride, layout, d, width, (height - y < 4) ? height - y : 4);
+	}
+}
+
+/**
+ * Table used to build the palette of a GX_TF_CI8 texture.
+ */
+typedef  struct GRRLIB_paletteBuilder {
+	u8   used[65536 / 8];  /**< One bit per GX_TF_RGB5A3 color already in the palette. */
+	u8   index[65536];     /**< Index of each GX_TF_RGB5A3 color in the palette. */
+	u8  *palette;          /**< The palette, 256 big-endian GX_TF_RGB5A3 colors. */
+	u32  colors;           /**< Number of colors in the palette. */
+} GRRLIB_paletteBuilder;
+
+/**
+ * Return the index of a color in a palette, adding the color if it is new.
+ * Colors beyond the 256th get the index 0.
+ * @param pb The palette being built.
+ * @param v The color in GX_TF_RGB5A3 format.
+ * @return The index of the color.
+ */
+static inline u8  PaletteIndex (GRRLIB_paletteBuilder *pb, const u16 v) {
+	if ((pb->used[v >> 3] & (1 << (v & 7))) == 0) {
+		pb->used[v >> 3] |= 1 << (v & 7);
+		pb->index[v] = 0;
+		if (pb->colors < 256) {
+			pb->index[v] = pb->colors;
+			pb->palette[pb->colors << 1]       = v >> 8;
+			pb->palette[(pb->colors << 1) + 1] = v;
+			pb->colors++;
+		}
+	}
+	return pb->index[v];
+}
+
+/**
+ * Convert an image to the tiles of a 1 or 2 bytes per pixel format.
+ * Called with constant channel offsets so that each pixel layout gets its own loop.
+ * @param dst Destination, the first tile.
+ * @param src Source, the first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param fmt The texture format: GX_TF_I8, GX_TF_IA4, GX_TF_CI8, GX_TF_IA8, GX_TF_RGB565 or GX_TF_RGB5A3.
+ * @param pb The palette being built for GX_TF_CI8, NULL for the other formats.
+ * @param bpp Bytes per source pixel.
+ * @param ro Offset of the red channel.
+ * @param go Offset of the green channel.
+ * @param bo Offset of the blue channel.
+ * @param ao Offset of the alpha channel, -1 for opaque images.
+ */
+static inline __attribute__((always_inline))
+void  EncodeTiles (u8 *dst, const u8 *src, const s32 stride, const u32 width, const u32 height,
+                   const u32 fmt, GRRLIB_paletteBuilder *pb,
+                   const u32 bpp, const u32 ro, const u32 go, const u32 bo, const s32 ao) {
+	// 8x4 tiles of 1 byte per pixel, or 4x4 tiles of 2 bytes per pixel
+	const u32 tw = (fmt == GX_TF_I8 || fmt == GX_TF_IA4 || fmt == GX_TF_CI8) ? 8 : 4;
+	u32 x, y, r, c;
+	u16 v;
+
+	for (y = 0; y < height; y += 4) {
+		for (x = 0; x < width; x += tw) {
+			for (r = 0; r < 4; r++) {
+				const u8 *row = src + (s32)(y + r) * stride;
+
+				for (c = 0; c < tw; c++, dst += 32 / (tw * 4)) {
+					const u8 *p = row + (x + c) * bpp;
+					u32 color;
+
+					// Padding is transparent black
+					if (y + r >= height || x + c >= width) {
+						dst[0] = 0;
+						if (tw == 4) {
+							dst[1] = 0;
+						}
+						continue;
+					}
+					color = GRRLIB_RGBA(p[ro], p[go], p[bo], (ao < 0) ? 0xFF : p[ao]);
+					switch (fmt) {
+						case GX_TF_I8:
+							dst[0] = GRRLIB_LUMA(color);
+							break;
+						case GX_TF_IA4:
+							dst[0] = (GRRLIB_A(color) & 0xF0) | (GRRLIB_LUMA(color) >> 4);
+							break;
+						case GX_TF_CI8:
+							dst[0] = PaletteIndex(pb, GRRLIB_PackRGB5A3(color));
+							break;
+						case GX_TF_IA8:
+							dst[0] = GRRLIB_A(color);
+							dst[1] = GRRLIB_LUMA(color);
+							break;
+						default:
+							v = (fmt == GX_TF_RGB565) ? GRRLIB_PackRGB565(color) : GRRLIB_PackRGB5A3(color);
+							dst[0] = v >> 8;
+							dst[1] = v;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Convert an image to the tiles of a texture format.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the source pixels.
+ * @param dst Destination, GX_GetTexBufferSize(width, height, fmt, GX_FALSE, 0) bytes are written,
+ *            followed by the 256 entries palette for GX_TF_CI8.
+ * @param fmt The texture format, as returned by GRRLIB_ChooseTextureFormat (GRRLIB_TEXFMT_CMPR_HQ for GX_TF_CMPR in high quality mode).
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @return @c true on success, @c false if the format is not supported or memory is missing.
+ */
+bool  GRRLIB_TileImage (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                        void *dst, const u32 fmt, const u32 width, const u32 height) {
+	GRRLIB_paletteBuilder *pb = NULL;
+
+	switch (fmt) {
+		case GX_TF_RGBA8:
+			GRRLIB_TileRGBA8(src, stride, layout, dst, width, height);
+			return true;
+		case GX_TF_CMPR:
+		case GRRLIB_TEXFMT_CMPR_HQ:
+			GRRLIB_EncodeCMPR(src, stride, layout, dst, width, height, fmt == GRRLIB_TEXFMT_CMPR_HQ);
+			return true;
+		case GX_TF_CI8:
+			pb = GRRLIB_MemAlloc(sizeof(GRRLIB_paletteBuilder), GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+			if (pb == NULL) {
+				return false;
+			}
+			memset(pb->used, 0, sizeof(pb->used));
+			pb->palette = (u8*)dst + GX_GetTexBufferSize(width, height, GX_TF_CI8, GX_FALSE, 0);
+			pb->colors = 0;
+			memset(pb->palette, 0, 256 * 2);
+			break;
+		case GX_TF_I8:
+		case GX_TF_IA4:
+		case GX_TF_IA8:
+		case GX_TF_RGB565:
+		case GX_TF_RGB5A3:
+			break;
+		default:
+			return false;
+	}
+
+	switch (layout) {
+		case GRRLIB_LAYOUT_RGB:    EncodeTiles(dst, src, stride, width, height, fmt, pb, 3, 0, 1, 2, -1);  break;
+		case GRRLIB_LAYOUT_RGBA:   EncodeTiles(dst, src, stride, width, height, fmt, pb, 4, 0, 1, 2,  3);  break;
+		case GRRLIB_LAYOUT_BGR:    EncodeTiles(dst, src, stride, width, height, fmt, pb, 3, 2, 1, 0, -1);  break;
+		case GRRLIB_LAYOUT_BGRA:   EncodeTiles(dst, src, stride, width, height, fmt, pb, 4, 2, 1, 0,  3);  break;
+		case GRRLIB_LAYOUT_GRAY:   EncodeTiles(dst, src, stride, width, height, fmt, pb, 1, 0, 0, 0, -1);  break;
+		case GRRLIB_LAYOUT_GRAYA:  EncodeTiles(dst, src, stride, width, height, fmt, pb, 2, 0, 0, 0,  1);  break;
+	}
+
+	GRRLIB_MemFree(pb, sizeof(GRRLIB_paletteBuilder));
+	return true;
+}
+
+/**
+ * Properties of an image which decide the formats able to store it without loss.
+ */
+enum {
+	IMAGE_GRAY   = 1 << 0,  /**< Red, green and blue are equal. */
+	IMAGE_I8     = 1 << 1,  /**< Gray and alpha equals the intensity, as GX samples GX_TF_I8. */
+	IMAGE_IA4    = 1 << 2,  /**< Intensity and alpha have 4 significant bits. */
+	IMAGE_RGB565 = 1 << 3,  /**< Colors are exact in GX_TF_RGB565. */
+	IMAGE_RGB5A3 = 1 << 4,  /**< Colors are exact in GX_TF_RGB5A3. */
+};
+
+/**
+ * Find the properties of an image and count its GX_TF_RGB5A3 colors.
+ * Called with constant channel offsets so that each pixel layout gets its own loop.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param used One bit per GX_TF_RGB5A3 color, cleared by the caller.
+ * @param colors Set to the number of GX_TF_RGB5A3 colors, counting stops after 256.
+ * @param bpp Bytes per source pixel.
+ * @param ro Offset of the red channel.
+ * @param go Offset of the green channel.
+ * @param bo Offset of the blue channel.
+ * @param ao Offset of the alpha channel, -1 for opaque images.
+ * @return The properties of the image (IMAGE_GRAY, ...).
+ */
+static inline __attribute__((always_inline))
+u32  AnalyzeImage (const u8 *src, const s32 stride, const u32 width, const u32 height, u8 *used, u32 *colors,
+                   const u32 bpp, const u32 ro, const u32 go, const u32 bo, const s32 ao) {
+	u32 flags = IMAGE_GRAY | IMAGE_I8 | IMAGE_IA4 | IMAGE_RGB565 | IMAGE_RGB5A3;
+	u32 x, y;
+	u16 v;
+
+	*colors = 0;
+	for (y = 0; y < height; y++, src += stride) {
+		const u8 *p = src;
+
+		for (x = 0; x < width; x++, p += bpp) {
+			const u32 color = GRRLIB_RGBA(p[ro], p[go], p[bo], (ao < 0) ? 0xFF : p[ao]);
+
+			if (p[ro] != p[go] || p[go] != p[bo]) {
+				flags &= ~(IMAGE_GRAY | IMAGE_I8 | IMAGE_IA4);
+			}
+			if ((p[ro] >> 4) != (p[ro] & 0xF) || (GRRLIB_A(color) >> 4) != (GRRLIB_A(color) & 0xF)) {
+				flags &= ~IMAGE_IA4;
+			}
+			if (GRRLIB_A(color) != p[ro]) {
+				flags &= ~IMAGE_I8;
+			}
+			if (GRRLIB_A(color) != 0xFF) {
+				flags &= ~IMAGE_RGB565;
+			}
+			if ((flags & IMAGE_RGB565) && GRRLIB_UnpackRGB565(GRRLIB_PackRGB565(color)) != color) {
+				flags &= ~IMAGE_RGB565;
+			}
+			v = GRRLIB_PackRGB5A3(color);
+			if ((flags & IMAGE_RGB5A3) && GRRLIB_UnpackRGB5A3(v) != color) {
+				flags &= ~IMAGE_RGB5A3;
+			}
+			if (*colors <= 256 && (used[v >> 3] & (1 << (v & 7))) == 0) {
+				used[v >> 3] |= 1 << (v & 7);
+				(*colors)++;
+			}
+		}
+		if (flags == 0 && *colors > 256) {
+			break;  // Nothing but GX_TF_RGBA8 is left
+		}
+	}
+	return flags;
+}
+
+/**
+ * Choose the format of a texture made from an image.
+ * With GRRLIB_TEXFMT_AUTO, this is the smallest format storing the image without loss:
+ * GX_TF_I8 for gray images whose alpha is the intensity, GX_TF_IA4 for other gray images, GX_TF_CI8 for images of up to 256 colors,
+ * then GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3 and finally GX_TF_RGBA8.
+ * An explicit format is kept, but GX_TF_CI8 becomes GX_TF_RGB5A3 for images of more than 256 colors
+ * and formats without an encoder become GX_TF_RGBA8.
+ * @param src The first pixel of the top row.
+ * @param stride Distance between two source rows in bytes, negative for bottom-up images.
+ * @param layout Layout of the source pixels.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param fmt The format asked for, or GRRLIB_TEXFMT_AUTO.
+ * @return The texture format to give to GRRLIB_TileImage, GRRLIB_TEXFMT_CMPR_HQ is kept.
+ */
+u32  GRRLIB_ChooseTextureFormat (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                                 const u32 width, const u32 height, const u32 fmt) {
+	u8 *used;
+	u32 flags = 0, colors = 0;
+
+	switch (fmt) {
+		case GX_TF_RGBA8:
+		case GX_TF_I8:
+		case GX_TF_IA4:
+		case GX_TF_IA8:
+		case GX_TF_RGB565:
+		case GX_TF_RGB5A3:
+		case GX_TF_CMPR:
+		case GRRLIB_TEXFMT_CMPR_HQ:
+			return fmt;
+		case GX_TF_CI8:
+		case GRRLIB_TEXFMT_AUTO:
+			break;
+		default:
+			return GX_TF_RGBA8;
+	}
+
+	used = GRRLIB_MemCalloc(65536 / 8, GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	if (used == NULL) {
+		return (fmt == GX_TF_CI8) ? GX_TF_RGB5A3 : GX_TF_RGBA8;
+	}
+	switch (layout) {
+		case GRRLIB_LAYOUT_RGB:    flags = AnalyzeImage(src, stride, width, height, used, &colors, 3, 0, 1, 2, -1);  break;
+		case GRRLIB_LAYOUT_RGBA:   flags = AnalyzeImage(src, stride, width, height, used, &colors, 4, 0, 1, 2,  3);  break;
+		case GRRLIB_LAYOUT_BGR:    flags = AnalyzeImage(src, stride, width, height, used, &colors, 3, 2, 1, 0, -1);  break;
+		case GRRLIB_LAYOUT_BGRA:   flags = AnalyzeImage(src, stride, width, height, used, &colors, 4, 2, 1, 0,  3);  break;
+		case GRRLIB_LAYOUT_GRAY:   flags = AnalyzeImage(src, stride, width, height, used, &colors, 1, 0, 0, 0, -1);  break;
+		case GRRLIB_LAYOUT_GRAYA:  flags = AnalyzeImage(src, stride, width, height, used, &colors, 2, 0, 0, 0,  1);  break;
+	}
+	GRRLIB_MemFree(used, 65536 / 8);
+
+	if (fmt == GX_TF_CI8) {
+		return (colors <= 256) ? GX_TF_CI8 : GX_TF_RGB5A3;
+	}
+	if (flags & IMAGE_I8) {
+		return GX_TF_I8;
+	}
+	if (flags & IMAGE_IA4) {
+		return GX_TF_IA4;
+	}
+	// The palette only pays off when it is smaller than the second byte of each pixel
+	if ((flags & IMAGE_RGB5A3) && colors <= 256 &&
+	    GX_GetTexBufferSize(width, height, GX_TF_CI8, GX_FALSE, 0) + 256 * 2 < GX_GetTexBufferSize(width, height, GX_TF_IA8, GX_FALSE, 0)) {
+		return GX_TF_CI8;
+	}
+	if (flags & IMAGE_GRAY) {
+		return GX_TF_IA8;
+	}
+	if (flags & IMAGE_RGB565) {
+		return GX_TF_RGB565;
+	}
+	if (flags & IMAGE_RGB5A3) {
+		return GX_TF_RGB5A3;
+	}
+	return GX_TF_RGBA8;
+}
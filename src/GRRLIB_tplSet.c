@@ -0,0 +1,200 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
+
+/**
+ * Structure to hold a TPL file and its textures, see GRRLIB_OpenTPLSet.
+ */
+struct GRRLIB_tplSet {
+	TPLFile           tdf;       /**< The TPL file. */
+	u8               *data;      /**< The TPL data, 32-byte aligned. */
+	u32               size;      /**< Size of the data. */
+	bool              owned;     /**< The data was allocated by GRRLIB and is freed with the set. */
+	u32               count;     /**< Number of textures in the file. */
+	GRRLIB_texture  **textures;  /**< Textures already handed out, by ID. */
+};
+
+/**
+ * Open a TPL over 32-byte aligned data.
+ * @param data The TPL data.
+ * @param size Size of the data.
+ * @param owned true to free the data with the set, including when the set can not be opened.
+ * @return The set, NULL if the data is not a TPL file.
+ */
+static GRRLIB_tplSet*  TPLSetOpen (u8 *data, const u32 size, const bool owned) {
+	GRRLIB_tplSet *set = GRRLIB_MemCalloc(sizeof(GRRLIB_tplSet), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+
+	if (set == NULL || TPL_OpenTPLFromMemory(&set->tdf, data, size) < 0 || set->tdf.ntextures <= 0) {
+		GRRLIB_MemFree(set, sizeof(GRRLIB_tplSet));
+		if (owned == true) {
+			GRRLIB_MemFree(data, size);
+		}
+		return NULL;
+	}
+	set->data = data;
+	set->size = size;
+	set->owned = owned;
+	set->count = set->tdf.ntextures;
+	set->textures = GRRLIB_MemCalloc(set->count * sizeof(GRRLIB_texture*), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (set->textures == NULL) {
+		GRRLIB_FreeTPLSet(set);
+		return NULL;
+	}
+	return set;
+}
+
+/**
+ * Open a TPL file held in a buffer, to take several textures from it.
+ * A 32-byte aligned buffer is used in place: the textures point into it, so it must stay valid
+ * until the set is freed. libogc rewrites the headers of the file when it opens it, so the buffer
+ * can not be opened a second time. Other buffers are copied once.
+ * @param my_tpl The TPL buffer.
+ * @param my_size Size of the TPL buffer.
+ * @return The set, NULL if the buffer is not a TPL file.
+ * @see GRRLIB_FreeTPLSet
+ */
+GRRLIB_tplSet*  GRRLIB_OpenTPLSet (u8 *my_tpl, const u32 my_size) {
+	u8 *data;
+
+	if (my_tpl == NULL || my_size == 0) {
+		return NULL;
+	}
+	if (((uintptr_t)my_tpl & 31) == 0) {
+		return TPLSetOpen(my_tpl, my_size, false);
+	}
+	data = GRRLIB_MemAlloc(my_size, 32, GRRLIB_MEM_COLD);
+	if (data == NULL) {
+		return NULL;
+	}
+	memcpy(data, my_tpl, my_size);
+	return TPLSetOpen(data, my_size, true);
+}
+
+/**
+ * Open a TPL file, read straight into 32-byte aligned memory which is freed with the set.
+ * @param filename The TPL filename to load.
+ * @return The set, NULL if the file can not be read or is not a TPL file.
+ * @see GRRLIB_FreeTPLSet
+ */
+GRRLIB_tplSet*  GRRLIB_OpenTPLSetFromFile (const char *filename) {
+	FILE *fd = fopen(filename, "rb");
+	u8 *data = NULL;
+	long len = 0;
+
+	if (fd == NULL) {
+		return NULL;
+	}
+	if (fseek(fd, 0, SEEK_END) != 0 || (len = ftell(fd)) <= 0 || fseek(fd, 0, SEEK_SET) != 0 ||
+	    (data = GRRLIB_MemAlloc(len, 32, GRRLIB_MEM_COLD)) == NULL || fread(data, 1, len, fd) != (size_t)len) {
+		fclose(fd);
+		GRRLIB_MemFree(data, len);
+		return NULL;
+	}
+	fclose(fd);
+	return TPLSetOpen(data, len, true);
+}
+
+/**
+ * Return the number of textures in a TPL set.
+ * @param set The set.
+ * @return The number of textures.
+ */
+u32  GRRLIB_GetTPLSetCount (const GRRLIB_tplSet *set) {
+	return set->count;
+}
+
+/**
+ * Return a texture of a TPL set, which uses the data of the set without copying it.
+ * Getting the same texture again returns the same pointer. The texture belongs to the set:
+ * it must not be changed or freed with GRRLIB_FreeTexture, and it is freed with the set.
+ * The texture keeps the wrap modes, filters and levels of detail stored in the file.
+ * @param set The set.
+ * @param id Texture ID to get.
+ * @return The texture, NULL if the ID is out of range or the texture uses a palette.
+ */
+GRRLIB_texture*  GRRLIB_GetTPLSetTexture (GRRLIB_tplSet *set, const s32 id) {
+	GRRLIB_texture *texture;
+	u32 fmt;
+	u16 w, h;
+
+	if (id < 0 || (u32)id >= set->count) {
+		return NULL;
+	}
+	if (set->textures[id] != NULL) {
+		return set->textures[id];
+	}
+	if (TPL_GetTextureInfo(&set->tdf, id, &fmt, &w, &h) < 0 ||
+	    fmt == GX_TF_CI4 || fmt == GX_TF_CI8 || fmt == GX_TF_CI14) {
+		return NULL;
+	}
+	texture = GRRLIB_MemCalloc(sizeof(GRRLIB_texture), GRRLIB_MEM_ALIGN, GRRLIB_MEM_HOT);
+	if (texture == NULL) {
+		return NULL;
+	}
+	if (TPL_GetTexture(&set->tdf, id, &texture->obj) < 0) {
+		GRRLIB_MemFree(texture, sizeof(GRRLIB_texture));
+		return NULL;
+	}
+	texture->data = MEM_PHYSICAL_TO_K0(GX_GetTexObjData(&texture->obj));  // GX keeps the physical address
+	texture->fmt = fmt;
+	texture->width = w;
+	texture->height = h;
+	texture->mipmap = GX_GetTexObjMipMap(&texture->obj);
+	texture->minLod = GX_GetTexObjMinLOD(&texture->obj);
+	texture->maxLod = GX_GetTexObjMaxLOD(&texture->obj);
+	texture->lodBias = GX_GetTexObjLODBias(&texture->obj);
+	texture->maxLevel = (texture->mipmap == true) ? (u8)texture->maxLod : 0;
+	GRRLIB_SetTexturePart(texture);
+
+	set->textures[id] = texture;
+	return texture;
+}
+
+/**
+ * Free a TPL set, its textures, and its data when it was allocated by GRRLIB.
+ * If \a set is a null pointer, the function does nothing.
+ * @param set The set.
+ */
+void  GRRLIB_FreeTPLSet (GRRLIB_tplSet *set) {
+	u32 i;
+
+	if (set == NULL) {
+		return;
+	}
+	if (set->textures != NULL) {
+		for (i = 0; i < set->count; i++) {
+			GRRLIB_MemFree(set->textures[i], sizeof(GRRLIB_texture));
+		}
+		GRRLIB_MemFree(set->textures, set->count * sizeof(GRRLIB_texture*));
+	}
+	TPL_CloseTPLFile(&set->tdf);
+	if (set->owned == true) {
+		GRRLIB_MemFree(set->data, set->size);
+	}
+	GRRLIB_MemFree(set, sizeof(GRRLIB_tplSet));
+}
@@ -20,8 +20,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 ------------------------------------------------------------------------------*/
 
-#include "grrlib-mod/GRRLIB_private.h"
 #include <grrlib-mod.h>
+#include "grrlib-mod/GRRLIB_private.h"
 #include <wchar.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -62,8 +62,13 @@ GRRLIB_ttfFont* GRRLIB_LoadTTF (const u8* file_base, s32 file_size) {
 	if (FT_New_Memory_Face(ftLibrary, file_base, file_size, 0, &Face) != 0) {
 		return NULL;
 	}
-	GRRLIB_ttfFont* myFont = (GRRLIB_ttfFont*)malloc(sizeof(GRRLIB_ttfFont));
+	GRRLIB_ttfFont* myFont = (GRRLIB_ttfFont*)GRRLIB_MemAlloc(sizeof(GRRLIB_ttfFont), GRRLIB_MEM_ALIGN, GRRLIB_MEM_COLD);
+	if (myFont == NULL) {
+		FT_Done_Face(Face);
+		return NULL;
+	}
 	myFont->kerning = FT_HAS_KERNING(Face);
+	myFont->data = NULL;
 /*
 	if (FT_Set_Pixel_Sizes(Face, 0, fontSize) != 0) {
 		FT_Set_Pixel_Sizes(Face, 0, 12);
@@ -82,7 +87,8 @@ GRRLIB_ttfFont* GRRLIB_LoadTTF (const u8* file_base, s32 file_size) {
 void  GRRLIB_FreeTTF (GRRLIB_ttfFont *myFont) {
 	if (myFont != NULL) {
 		FT_Done_Face(myFont->face);
-		free(myFont);
+		free(myFont->data);
+		GRRLIB_MemFree(myFont, sizeof(GRRLIB_ttfFont));
 	}
 }
 
@@ -100,14 +106,15 @@ void GRRLIB_PrintfTTF(int x, int y, GRRLIB_ttfFont *myFont, const char *string,
 	}
 
 	size_t length = strlen(string) + 1;
-	wchar_t *utf32 = (wchar_t*)malloc(length * sizeof(wchar_t));
+	const u32 size = length * sizeof(wchar_t);
+	wchar_t *utf32 = (wchar_t*)GRRLIB_MemAlloc(size, GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
 	if (utf32 != NULL) {
 		length = mbstowcs(utf32, string, length);
 		if (length > 0) {
 			utf32[length] = L'\0';
 			GRRLIB_PrintfTTFW(x, y, myFont, utf32, fontSize);
 		}
-		free(utf32);
+		GRRLIB_MemFree(utf32, size);
 	}
 }
 
@@ -175,9 +182,11 @@ static void DrawBitmap(FT_Bitmap *bitmap, int offset, int top, const u8 cR, cons
 	FT_Int x_max = offset + bitmap->width;
 	FT_Int y_max = top + bitmap->rows;
 
+	GRRLIB_StateRestore();
+
 	for ( i = offset, p = 0; i < x_max; i++, p++ ) {
 		for ( j = top, q = 0; j < y_max; j++, q++ ) {
-			GX_Begin(GX_POINTS, GX_VTXFMT0, 1);
+			GRRLIB_Begin(GX_POINTS, GX_VTXFMT0, 1);
 				GX_Position3f32(i, j, 0);
 				GX_Color4u8(cR, cG, cB,
 							bitmap->buffer[ q * bitmap->width + p ]);
@@ -199,13 +208,17 @@ u32 GRRLIB_WidthTTF(GRRLIB_ttfFont *myFont, const char *string, unsigned int fon
 	}
 	u32 penX;
 	size_t length = strlen(string) + 1;
-	wchar_t *utf32 = (wchar_t*)malloc(length * sizeof(wchar_t));
+	const u32 size = length * sizeof(wchar_t);
+	wchar_t *utf32 = (wchar_t*)GRRLIB_MemAlloc(size, GRRLIB_MEM_ALIGN, GRRLIB_MEM_SCRATCH);
+	if (utf32 == NULL) {
+		return 0;
+	}
 	length = mbstowcs(utf32, string, length);
 	utf32[length] = L'\0';
 
 	penX = GRRLIB_WidthTTFW(myFont, utf32, fontSize);
 
-	free(utf32);
+	GRRLIB_MemFree(utf32, size);
 
 	return penX;
 }
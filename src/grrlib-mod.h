@@ -61,6 +61,7 @@ THE SOFTWARE.
 #define GRRLIB_G(c) (((c) >> 16) & 0xFF) /**< Extract green component of color. */
 #define GRRLIB_B(c) (((c) >>  8) & 0xFF) /**< Extract blue component of color. */
 #define GRRLIB_A(c) ( (c)        & 0xFF) /**< Extract alpha component of color. */
+#define GRRLIB_LUMA(c) ((77 * GRRLIB_R(c) + 150 * GRRLIB_G(c) + 29 * GRRLIB_B(c)) >> 8) /**< Intensity of color, as stored by the GX_TF_I8, GX_TF_IA4 and GX_TF_IA8 formats. */
 
 /**
  * Build an RGB pixel from components.
@@ -104,8 +105,38 @@ typedef  struct GRRLIB_drawSettings {
 	bool              antialias; /**< Anti-alias. */
 	int               deflicker; /**< Deflicker (aka vfilter). */
 	int               lights;    /**< Active lights. */
+	bool              compactVertices; /**< Compact vertex format. */
+	bool              lazyState; /**< Leave the GX state of a draw for the next one instead of restoring the default 2D state. */
 } GRRLIB_drawSettings;
 
+//------------------------------------------------------------------------------
+#define GRRLIB_TEXFMT_AUTO    (0xFF) /**< Texture format chosen by the loaders: the smallest format storing the image without loss. */
+#define GRRLIB_TEXFMT_CMPR_HQ (0xFE) /**< GX_TF_CMPR texture compressed by the loaders in high quality mode, slower than GX_TF_CMPR. */
+
+//------------------------------------------------------------------------------
+#define GRRLIB_MAX_XFB 3 /**< Maximum number of external frame buffers. */
+
+//------------------------------------------------------------------------------
+/**
+ * Vertical sync policies used by GRRLIB_Render.
+ */
+typedef  enum GRRLIB_vsyncMode {
+	GRRLIB_VSYNC_WAIT        = 0,  /**< Show every frame, wait for a vertical retrace when no frame buffer is free. */
+	GRRLIB_VSYNC_NONBLOCKING = 1,  /**< Drop frames waiting to be shown rather than wait for a vertical retrace. */
+} GRRLIB_vsyncMode;
+
+//------------------------------------------------------------------------------
+/**
+ * Structure to hold the options of GRRLIB_InitEx.
+ * A structure filled with zeros gives the same behaviour as GRRLIB_Init.
+ */
+typedef  struct GRRLIB_initOptions {
+	u32               fifoSize;  /**< Size of the GX FIFO in bytes, 0 for the default size (256 KiB). */
+	bool              pipelined; /**< Let the CPU build the next frame while the GPU draws the current one. */
+	GRRLIB_vsyncMode  vsync;     /**< Vertical sync policy. */
+	u8                xfbCount;  /**< Number of external frame buffers, 2 or 3, 0 for the default (2). */
+} GRRLIB_initOptions;
+
 //------------------------------------------------------------------------------
 /**
  * Structure to hold coordinates of a texture.
@@ -125,6 +156,24 @@ typedef  struct GRRLIB_texturePart {
 	f32   textureHeight;
 } GRRLIB_texturePart;
 
+//------------------------------------------------------------------------------
+/**
+ * Filters used by GRRLIB_GenerateMipmaps to build each level from the previous one.
+ */
+typedef  enum GRRLIB_mipFilter {
+	GRRLIB_MIPFILTER_BOX    = 0,  /**< Average of 2x2 pixels, the fastest. */
+	GRRLIB_MIPFILTER_KAISER = 1,  /**< Kaiser-windowed sinc over 8x8 pixels, sharper and with less aliasing. */
+} GRRLIB_mipFilter;
+
+//------------------------------------------------------------------------------
+/**
+ * Filters used by GRRLIB_LoadTextureScaled to shrink images.
+ */
+typedef  enum GRRLIB_scaleFilter {
+	GRRLIB_SCALE_AREA    = 0,  /**< Average of the pixels covered by each texel, smooth. */
+	GRRLIB_SCALE_NEAREST = 1,  /**< Pixel at the center of each texel, the fastest. */
+} GRRLIB_scaleFilter;
+
 //------------------------------------------------------------------------------
 /**
  * Structure to hold texture data and information.
@@ -136,11 +185,148 @@ typedef  struct GRRLIB_texture {
 	u32   width;  /**< The width of the texture in pixels. */
 	u32   height; /**< The height of the texture in pixels. */
 
+	bool  mipmap;   /**< @c true if the data holds a mipmap chain, see GRRLIB_GenerateMipmaps. */
+	u8    maxLevel; /**< Index of the smallest level of the mipmap chain, 0 without mipmaps. */
+	f32   minLod;   /**< Minimum level of detail, see GRRLIB_SetTextureLOD. */
+	f32   maxLod;   /**< Maximum level of detail. */
+	f32   lodBias;  /**< Bias added to the level of detail. */
 
 	GXTexObj             obj;  /**< The texture object. */
+	GXTlutObj            tlut; /**< The palette of a GX_TF_CI8 texture, stored after the texture data. */
 	GRRLIB_texturePart   part; /**< A full part of the texture. */
+
+	u16  *dirtyRows;   /**< First and end tile written in each row of tiles, NULL when writes are not tracked, see GRRLIB_TrackTextureDirty. */
+	u16   dirtyTop;    /**< First row of tiles written since the last flush. */
+	u16   dirtyBottom; /**< Row of tiles after the last one written since the last flush, 0 if none. */
 } GRRLIB_texture;
 
+/**
+ * Structure to walk the tiles of a texture in storage order, see GRRLIB_BeginTextureBlocks.
+ */
+typedef  struct GRRLIB_textureBlock {
+	u32   x;          /**< Left of the tile in pixels. Tiles on the right and bottom edges hold padding pixels outside the texture. */
+	u32   y;          /**< Top of the tile in pixels. */
+	u8   *ar;         /**< For GX_TF_RGBA8, the alpha and red pairs of the 4x4 pixels, row by row. For the other formats, the whole tile. */
+	u8   *gb;         /**< For GX_TF_RGBA8, the green and blue pairs of the 4x4 pixels, row by row. NULL for the other formats. */
+
+	u8   *next;       /**< The next tile. */
+	u32   remaining;  /**< Number of tiles not visited yet. */
+	u32   tileW;      /**< Width of a tile in pixels. */
+	u32   tileH;      /**< Height of a tile in pixels. */
+	u32   tileBytes;  /**< Size of a tile in bytes. */
+	u32   rowWidth;   /**< Width of a row of tiles in pixels. */
+} GRRLIB_textureBlock;
+
+/**
+ * How the pixels of a locked texture are used, see GRRLIB_LockTexture.
+ */
+typedef  enum GRRLIB_lockMode {
+	GRRLIB_LOCK_READ      = 1,  /**< The pixels are read from the texture when locking. */
+	GRRLIB_LOCK_WRITE     = 2,  /**< The pixels are written to the texture when unlocking. */
+	GRRLIB_LOCK_READWRITE = 3,  /**< Both. */
+} GRRLIB_lockMode;
+
+/**
+ * Structure to hold a linear copy of a rectangle of a texture, see GRRLIB_LockTexture.
+ */
+typedef  struct GRRLIB_textureLock {
+	GRRLIB_texture   *texture;  /**< The locked texture. */
+	u32              *pixels;   /**< The colors of the rectangle in RGBA format, row by row. */
+	u32               x;        /**< Left of the rectangle in the texture. */
+	u32               y;        /**< Top of the rectangle in the texture. */
+	u32               width;    /**< Width of the rectangle, also the number of colors of a row of pixels. */
+	u32               height;   /**< Height of the rectangle. */
+	GRRLIB_lockMode   mode;     /**< How the pixels are used. */
+} GRRLIB_textureLock;
+
+//------------------------------------------------------------------------------
+/**
+ * Structure to hold a texture atlas: images packed into one or more large textures, see GRRLIB_CreateAtlas.
+ */
+typedef  struct GRRLIB_atlas {
+	u32                   fmt;        /**< Format of the pages. */
+	u32                   width;      /**< Width of the pages in pixels. */
+	u32                   height;     /**< Height of the pages in pixels. */
+	u8                    padding;    /**< Pixels kept free around each image. */
+	bool                  extrude;    /**< The padding repeats the edges of the images. */
+
+	u32                   pageCount;  /**< Number of pages. */
+	GRRLIB_texture      **pages;      /**< The pages, textures holding the images. */
+	u32                   partCount;  /**< Number of images added. */
+	GRRLIB_texturePart  **parts;      /**< Coordinates of the images in their page, in the order they were added. */
+	u64                   usedPixels; /**< Number of pixels covered by the images. */
+
+	struct GRRLIB_atlasPage  *packing; /**< Free space of each page. */
+	u32                   pageCapacity; /**< Number of pages the arrays of pages can hold. */
+	u32                   partCapacity; /**< Number of images the array of coordinates can hold. */
+} GRRLIB_atlas;
+
+//------------------------------------------------------------------------------
+/**
+ * Cache of textures shared by reference counting, see GRRLIB_CreateAssetCache.
+ */
+typedef  struct GRRLIB_assetCache  GRRLIB_assetCache;
+
+/**
+ * Structure to hold the memory used by an asset cache and its counters, see GRRLIB_GetAssetCacheStats.
+ */
+typedef  struct GRRLIB_assetStats {
+	u32 hits;        /**< Number of requests served by a texture of the cache. */
+	u32 misses;      /**< Number of textures decoded. */
+	u32 evictions;   /**< Number of textures freed to fit in the budget. */
+	u32 entries;     /**< Number of textures in the cache. */
+	u32 referenced;  /**< Number of textures with references. */
+	u32 bytes;       /**< Memory used by the textures of the cache. */
+	u32 idleBytes;   /**< Memory used by the textures without references. */
+} GRRLIB_assetStats;
+
+//------------------------------------------------------------------------------
+/**
+ * Kinds of memory allocated by GRRLIB, given to the allocator as a placement hint.
+ */
+typedef  enum GRRLIB_memHint {
+	GRRLIB_MEM_HOT     = 0,  /**< Structures, display lists and vertex arrays, used every frame: MEM1 on Wii. */
+	GRRLIB_MEM_COLD    = 1,  /**< Texture data and other large assets: can go to MEM2 on Wii. */
+	GRRLIB_MEM_SCRATCH = 2,  /**< Temporary buffers, freed before the function allocating them returns. */
+} GRRLIB_memHint;
+
+/**
+ * Functions GRRLIB allocates its memory with, see GRRLIB_SetAllocator.
+ * They are called one at a time, with a lock held.
+ */
+typedef  struct GRRLIB_allocator {
+	void* (*alloc)(u32 size, u32 align, GRRLIB_memHint hint, void *user);  /**< Allocate \a size bytes aligned to \a align, a power of two. Return NULL if out of memory. */
+	void  (*free)(void *ptr, u32 size, void *user);                        /**< Free memory, \a size is the size it was allocated with. */
+	void  *user;                                                            /**< Pointer given to the functions. */
+} GRRLIB_allocator;
+
+/**
+ * Structure to hold the memory allocated by GRRLIB, see GRRLIB_GetMemStats.
+ */
+typedef  struct GRRLIB_memStats {
+	u32 liveBytes;    /**< Bytes allocated and not freed. */
+	u32 peakBytes;    /**< Largest value of liveBytes since GRRLIB_ResetMemStats. */
+	u32 liveBlocks;   /**< Number of blocks allocated and not freed. */
+	u32 allocations;  /**< Number of allocations since GRRLIB_ResetMemStats. */
+	u32 failures;     /**< Number of allocations which failed since GRRLIB_ResetMemStats. */
+} GRRLIB_memStats;
+
+/**
+ * Memory given out by moving a pointer and taken back all at once, see GRRLIB_CreateArena.
+ */
+typedef  struct GRRLIB_arena  GRRLIB_arena;
+
+/**
+ * Free lists of small blocks of fixed sizes, see GRRLIB_CreatePool.
+ */
+typedef  struct GRRLIB_pool  GRRLIB_pool;
+
+//------------------------------------------------------------------------------
+/**
+ * TPL file whose textures share its data, see GRRLIB_OpenTPLSet.
+ */
+typedef  struct GRRLIB_tplSet  GRRLIB_tplSet;
+
 //------------------------------------------------------------------------------
 /**
  * Structure to hold the texture information. (Deprecated)
@@ -196,8 +382,40 @@ typedef  struct GRRLIB_bytemapFont {
 typedef  struct GRRLIB_Font {
 	void *face;     /**< A TTF face object. */
 	bool kerning;   /**< true whenever a face object contains kerning data that can be accessed with FT_Get_Kerning. */
+	void *data;     /**< The font file when it was loaded by GRRLIB, freed with the font. */
 } GRRLIB_ttfFont;
 
+//------------------------------------------------------------------------------
+/**
+ * Loader of textures and fonts on background threads, see GRRLIB_CreateLoader.
+ */
+typedef  struct GRRLIB_loader  GRRLIB_loader;
+
+/**
+ * Kinds of requests of a loader.
+ */
+typedef  enum GRRLIB_loadType {
+	GRRLIB_LOAD_TEXTURE = 0,  /**< A texture, see GRRLIB_LoaderQueueTexture. */
+	GRRLIB_LOAD_TTF     = 1,  /**< A TTF font, see GRRLIB_LoaderQueueTTF. */
+} GRRLIB_loadType;
+
+/**
+ * Structure to hold a request completed by a loader, see GRRLIB_LoaderPoll.
+ */
+typedef  struct GRRLIB_loadResult {
+	u32              id;        /**< The identifier returned when the request was queued. */
+	GRRLIB_loadType  type;      /**< The kind of request. */
+	void            *userData;  /**< The pointer given when the request was queued. */
+	GRRLIB_texture  *texture;   /**< The texture, NULL for a font or if it could not be loaded. */
+	GRRLIB_ttfFont  *font;      /**< The font, NULL for a texture or if it could not be loaded. */
+} GRRLIB_loadResult;
+
+/**
+ * Function called by GRRLIB_LoaderPoll for a completed request.
+ * The texture or font belongs to the application.
+ */
+typedef  void (*GRRLIB_loadCallback)(const GRRLIB_loadResult *result);
+
 //------------------------------------------------------------------------------
 /**
  * Structure to hold the matrix information.
@@ -206,12 +424,59 @@ typedef  struct GRRLIB_matrix {
 	Mtx matrix;
 } GRRLIB_matrix;
 
+//------------------------------------------------------------------------------
+/**
+ * Structure to hold a recorded display list.
+ */
+typedef  struct GRRLIB_displayList {
+	void *data;     /**< 32-byte aligned buffer holding the GX commands. */
+	u32  size;      /**< Size of the recorded commands in bytes. */
+	u32  capacity;  /**< Size of the buffer in bytes. */
+} GRRLIB_displayList;
+
+//------------------------------------------------------------------------------
+/**
+ * Structure to hold the number of GX state changes sent and skipped by GRRLIB.
+ */
+typedef  struct GRRLIB_stateStats {
+	u32 issued;     /**< Number of state changes sent to GX. */
+	u32 elided;     /**< Number of state changes skipped because GX already had that state. */
+} GRRLIB_stateStats;
+
+//------------------------------------------------------------------------------
+/**
+ * Structure to hold the counters of one frame.
+ */
+typedef  struct GRRLIB_frameCounters {
+	u32 frameTime;     /**< Time between the starts of two calls of GRRLIB_Render, in microseconds. */
+	u32 cpuTime;       /**< Time spent by the application between two calls of GRRLIB_Render, in microseconds. */
+	u32 gpuWait;       /**< Time GRRLIB_Render waited for the GPU to finish drawing, in microseconds. */
+	u32 vsyncWait;     /**< Time GRRLIB_Render waited for a free frame buffer, in microseconds. */
+	u32 begins;        /**< Number of GX_Begin calls made by GRRLIB. */
+	u32 vertices;      /**< Number of vertices sent by GRRLIB. */
+	u32 textureLoads;  /**< Number of textures loaded in GX. */
+	u32 gpMetric0;     /**< Value of the GX_PERF0 counter chosen with GRRLIB_SetFrameStatsMetric. */
+	u32 gpMetric1;     /**< Value of the GX_PERF1 counter chosen with GRRLIB_SetFrameStatsMetric. */
+} GRRLIB_frameCounters;
+
+//------------------------------------------------------------------------------
+/**
+ * Structure to hold the frame counters of the last frames.
+ */
+typedef  struct GRRLIB_frameStats {
+	u32                   frames;  /**< Number of frames measured, at most 60. */
+	GRRLIB_frameCounters  last;    /**< Counters of the last frame. */
+	GRRLIB_frameCounters  min;     /**< Minimum values of the counters. */
+	GRRLIB_frameCounters  avg;     /**< Average values of the counters. */
+	GRRLIB_frameCounters  max;     /**< Maximum values of the counters. */
+} GRRLIB_frameStats;
+
 //==============================================================================
 // Allow general access to screen and frame information
 //==============================================================================
 extern  GRRLIB_drawSettings  GRRLIB_Settings;
 extern  GXRModeObj           *GRRLIB_VideoMode;
-extern  void                 *GRRLIB_XFB[2];
+extern  void                 *GRRLIB_XFB[GRRLIB_MAX_XFB];
 extern  u32                  GRRLIB_FB;
 
 extern  Mtx                  GRRLIB_View2D;
@@ -79,6 +79,14 @@ static inline void  GRRLIB_Polygon  (const guVector v[], const long n,
 
 //------------------------------------------------------------------------------
 // GRRLIB_pixel.h - Pixel manipulation
+static inline u16   GRRLIB_PackRGB565   (const u32 color);
+static inline u32   GRRLIB_UnpackRGB565 (const u16 c);
+static inline u16   GRRLIB_PackRGB5A3   (const u32 color);
+static inline u32   GRRLIB_UnpackRGB5A3 (const u16 c);
+static inline u8*   GRRLIB_GetTexturePalette (const GRRLIB_texture *tex);
+static inline u32   GRRLIB_GetPixelOffset    (const int x, const int y,
+                                              const GRRLIB_texture *tex);
+
 static inline u32   GRRLIB_GetPixelFromTexture (const int x, const int y,
                                                   const GRRLIB_texture *tex);
 
@@ -102,9 +110,14 @@ static inline void              GRRLIB_SetAntiAliasing (const bool aa);
 static inline bool              GRRLIB_GetAntiAliasing (void);
 static inline void              GRRLIB_SetDeflicker    (const bool deflicker);
 static inline bool              GRRLIB_GetDeflicker    (void);
+static inline void              GRRLIB_SetCompactVertices (const bool compact);
+static inline bool              GRRLIB_GetCompactVertices (void);
+static inline void              GRRLIB_SetLazyState    (const bool lazy);
+static inline bool              GRRLIB_GetLazyState    (void);
 
 //------------------------------------------------------------------------------
 // GRRLIB_texSetup.h - Create and setup textures and texture coordinates
+static inline u32             GRRLIB_GetTextureDataSize (const GRRLIB_texture *texture);
 static inline void            GRRLIB_ClearTexture    (GRRLIB_texture *texture);
 static inline void            GRRLIB_SetTexturePart  (GRRLIB_texture *texture);
 static inline void            GRRLIB_FinalizeTexture (GRRLIB_texture *texture);
@@ -43,6 +43,37 @@ THE SOFTWARE.
 // Prototypes for library contained functions
 //==============================================================================
 
+//------------------------------------------------------------------------------
+// GRRLIB_assetCache.c - Shared textures with a memory budget
+GRRLIB_assetCache*  GRRLIB_CreateAssetCache     (const u32 budget, const u32 fmt);
+GRRLIB_texture*     GRRLIB_AssetCacheLoadFile   (GRRLIB_assetCache *cache, const char *filename);
+GRRLIB_texture*     GRRLIB_AssetCacheLoadBuffer (GRRLIB_assetCache *cache, const char *key, const u8 *my_img, const u32 my_size);
+GRRLIB_texture*     GRRLIB_AssetCacheFind       (GRRLIB_assetCache *cache, const char *key);
+void                GRRLIB_AssetCacheRelease    (GRRLIB_assetCache *cache, GRRLIB_texture *texture);
+void                GRRLIB_SetAssetCacheBudget  (GRRLIB_assetCache *cache, const u32 bytes);
+void                GRRLIB_PurgeAssetCache      (GRRLIB_assetCache *cache);
+GRRLIB_assetStats   GRRLIB_GetAssetCacheStats   (const GRRLIB_assetCache *cache);
+void                GRRLIB_ResetAssetCacheStats (GRRLIB_assetCache *cache);
+void                GRRLIB_FreeAssetCache       (GRRLIB_assetCache *cache);
+
+//------------------------------------------------------------------------------
+// GRRLIB_atlas.c - Packing images into texture atlases
+GRRLIB_atlas*        GRRLIB_CreateAtlas       (const u32 width, const u32 height, const u32 fmt,
+                                               const u8 padding, const bool extrude);
+GRRLIB_texturePart*  GRRLIB_AtlasAddTexture   (GRRLIB_atlas *atlas, const GRRLIB_texture *texture, GRRLIB_texture **page);
+GRRLIB_texturePart*  GRRLIB_AtlasAddImage     (GRRLIB_atlas *atlas, const u8 *my_img, const u32 my_size, GRRLIB_texture **page);
+f32                  GRRLIB_GetAtlasOccupancy (const GRRLIB_atlas *atlas);
+void                 GRRLIB_FreeAtlas         (GRRLIB_atlas *atlas);
+
+//------------------------------------------------------------------------------
+// GRRLIB_batch.c - Batched sprite rendering
+void  GRRLIB_SpriteBatchBegin (void);
+void  GRRLIB_SpriteBatchDraw  (const f32 xPos, const f32 yPos, const GRRLIB_texture *tex,
+                               const GRRLIB_texturePart *texPart, const f32 degrees, const f32 scaleX,
+                               const f32 scaleY, const f32 offsetX, const f32 offsetY);
+void  GRRLIB_SpriteBatchFlush (void);
+void  GRRLIB_SpriteBatchEnd   (void);
+
 //------------------------------------------------------------------------------
 // GRRLIB_bmf.c - BitMapFont functions
 GRRLIB_bytemapFont*  GRRLIB_LoadBMF (const u8 my_bmf[] );
@@ -72,6 +103,9 @@ void  GRRLIB_BMFX_Invert    (const GRRLIB_texture *texsrc,
 void  GRRLIB_BMFX_Blur      (const GRRLIB_texture *texsrc,
                              GRRLIB_texture *texdest, const u32 factor);
 
+bool  GRRLIB_BMFX_BoxBlur   (const GRRLIB_texture *texsrc,
+                             GRRLIB_texture *texdest, const u32 radius, const u32 passes);
+
 void  GRRLIB_BMFX_Scatter   (const GRRLIB_texture *texsrc,
                              GRRLIB_texture *texdest, const u32 factor);
 
@@ -81,8 +115,23 @@ void  GRRLIB_BMFX_Pixelate  (const GRRLIB_texture *texsrc,
 //------------------------------------------------------------------------------
 // GRRLIB_core.c - GRRLIB core functions
 int   GRRLIB_Init (void);
+int   GRRLIB_InitEx (const GRRLIB_initOptions *options);
+u32   GRRLIB_GetFramebufferSize (void);
 void  GRRLIB_Exit (void);
 
+//------------------------------------------------------------------------------
+// GRRLIB_dirty.c - Flushing the parts of textures written by the CPU
+bool  GRRLIB_TrackTextureDirty (GRRLIB_texture *texture, const bool track);
+void  GRRLIB_MarkTextureDirty  (GRRLIB_texture *texture, s32 x, s32 y, s32 width, s32 height);
+u32   GRRLIB_FlushTextureDirty (GRRLIB_texture *texture);
+
+//------------------------------------------------------------------------------
+// GRRLIB_displayList.c - Recording and calling display lists
+bool  GRRLIB_BeginDisplayList (const u32 size);
+GRRLIB_displayList*  GRRLIB_EndDisplayList (void);
+void  GRRLIB_CallDisplayList  (const GRRLIB_displayList *list);
+void  GRRLIB_FreeDisplayList  (GRRLIB_displayList *list);
+
 //------------------------------------------------------------------------------
 // GRRLIB_fb.c - Render to framebuffer: Advanced primitives
 void  GRRLIB_GXEngine (const guVector v[], const u32 color[],
@@ -98,6 +147,13 @@ void  GRRLIB_Ellipse  (const f32 x, const f32 y,
                        const f32 radiusX, const f32 radiusY,
                        const bool filled);
 
+//------------------------------------------------------------------------------
+// GRRLIB_frameStats.c - Per-frame performance counters
+GRRLIB_frameStats  GRRLIB_GetFrameStats (void);
+void  GRRLIB_ResetFrameStats     (void);
+void  GRRLIB_SetFrameStatsMetric (const u32 perf0, const u32 perf1);
+void  GRRLIB_DrawFrameStats      (const f32 xpos, const f32 ypos);
+
 //------------------------------------------------------------------------------
 // GRRLIB_fileIO - File I/O (SD Card)
 int              GRRLIB_LoadFile            (const char* filename, u8* *data);
@@ -105,6 +161,51 @@ GRRLIB_texture*  GRRLIB_LoadTextureFromFile (const char* filename);
 GRRLIB_ttfFont*  GRRLIB_LoadTTFFromFile     (const char* filename);
 bool             GRRLIB_ScrShot             (const char* filename);
 
+//------------------------------------------------------------------------------
+// GRRLIB_loader.c - Loading textures and fonts on background threads
+GRRLIB_loader*  GRRLIB_CreateLoader       (const u32 threads);
+u32             GRRLIB_LoaderQueueTexture (GRRLIB_loader *loader, const char *filename, const u32 fmt, const s32 priority,
+                                           GRRLIB_loadCallback callback, void *userData);
+u32             GRRLIB_LoaderQueueTTF     (GRRLIB_loader *loader, const char *filename, const s32 priority,
+                                           GRRLIB_loadCallback callback, void *userData);
+bool            GRRLIB_LoaderCancel       (GRRLIB_loader *loader, const u32 id);
+bool            GRRLIB_LoaderPoll         (GRRLIB_loader *loader, GRRLIB_loadResult *result);
+u32             GRRLIB_LoaderPending      (GRRLIB_loader *loader);
+void            GRRLIB_LoaderWait         (GRRLIB_loader *loader);
+void            GRRLIB_FreeLoader         (GRRLIB_loader *loader);
+
+//------------------------------------------------------------------------------
+// GRRLIB_memory.c - Allocators and memory statistics
+void              GRRLIB_SetAllocator   (const GRRLIB_allocator *alloc);
+GRRLIB_allocator  GRRLIB_GetAllocator   (void);
+void*             GRRLIB_MemAlloc       (const u32 size, const u32 align, const GRRLIB_memHint hint);
+void*             GRRLIB_MemCalloc      (const u32 size, const u32 align, const GRRLIB_memHint hint);
+void*             GRRLIB_MemRealloc     (void *ptr, const u32 oldSize, const u32 newSize, const u32 align, const GRRLIB_memHint hint);
+void              GRRLIB_MemFree        (void *ptr, const u32 size);
+GRRLIB_memStats   GRRLIB_GetMemStats    (void);
+void              GRRLIB_ResetMemStats  (void);
+
+GRRLIB_arena*     GRRLIB_CreateArena    (void *memory, const u32 size);
+GRRLIB_allocator  GRRLIB_ArenaAllocator (GRRLIB_arena *arena);
+u32               GRRLIB_GetArenaUsed   (const GRRLIB_arena *arena);
+void              GRRLIB_ResetArena     (GRRLIB_arena *arena);
+void              GRRLIB_FreeArena      (GRRLIB_arena *arena);
+
+GRRLIB_pool*      GRRLIB_CreatePool     (void);
+GRRLIB_allocator  GRRLIB_PoolAllocator  (GRRLIB_pool *pool);
+void              GRRLIB_FreePool       (GRRLIB_pool *pool);
+
+//------------------------------------------------------------------------------
+// GRRLIB_mesh.c - Cached meshes for 3D primitives
+void  GRRLIB_SetMeshCacheBudget (const u32 bytes);
+u32   GRRLIB_GetMeshCacheMemory (void);
+void  GRRLIB_ClearMeshCache     (void);
+
+//------------------------------------------------------------------------------
+// GRRLIB_mipmap.c - Mipmap chains and levels of detail
+bool  GRRLIB_GenerateMipmaps (GRRLIB_texture *texture, const GRRLIB_mipFilter filter);
+void  GRRLIB_SetTextureLOD   (GRRLIB_texture *texture, const f32 minLod, const f32 maxLod, const f32 lodBias);
+
 //------------------------------------------------------------------------------
 // GRRLIB_print.c - Will someone please tell me what these are :)
 void  GRRLIB_Printf   (const f32 xpos, const f32 ypos,
@@ -152,20 +253,61 @@ void  GRRLIB_Screen2Texture (int posx, int posy, GRRLIB_texture *tex, bool clear
 void  GRRLIB_CompoStart (void);
 void  GRRLIB_CompoEnd(int posx, int posy, GRRLIB_texture *tex);
 
+//------------------------------------------------------------------------------
+// GRRLIB_state.c - Shadowed GX state
+void  GRRLIB_StateInvalidate   (void);
+void  GRRLIB_StateSetTevOp     (const u8 mode);
+void  GRRLIB_StateSetVtxDesc   (const u8 attr, const u8 type);
+void  GRRLIB_StateClearVtxDesc (void);
+void  GRRLIB_StateLoadTexObj   (GXTexObj *obj);
+void  GRRLIB_StateLoadPosMtx   (Mtx mtx);
+void  GRRLIB_StateSetBlendMode (const u8 type, const u8 srcFact, const u8 dstFact, const u8 op);
+void  GRRLIB_StateSetScissor   (const u32 x, const u32 y, const u32 width, const u32 height);
+void  GRRLIB_StateTextured2D   (GXTexObj *obj, Mtx mtx);
+void  GRRLIB_StateRestore      (void);
+
+GRRLIB_stateStats  GRRLIB_GetStateStats (void);
+void  GRRLIB_ResetStateStats   (void);
+
+//------------------------------------------------------------------------------
+// GRRLIB_texAccess.c - Reading and writing many pixels of a texture at once
+void  GRRLIB_ReadTextureSpan    (const GRRLIB_texture *tex, const u32 x, const u32 y, const u32 width, u32 *colors);
+void  GRRLIB_WriteTextureSpan   (GRRLIB_texture *tex, const u32 x, const u32 y, const u32 width, const u32 *colors);
+bool  GRRLIB_BeginTextureBlocks (GRRLIB_texture *tex, GRRLIB_textureBlock *block);
+bool  GRRLIB_NextTextureBlock   (GRRLIB_textureBlock *block);
+bool  GRRLIB_LockTexture        (GRRLIB_texture *tex, s32 x, s32 y, s32 width, s32 height,
+                                 const GRRLIB_lockMode mode, GRRLIB_textureLock *lock);
+void  GRRLIB_UnlockTexture      (GRRLIB_textureLock *lock);
+
 //------------------------------------------------------------------------------
 // GRRLIB_texEdit.c - Modifying the content of a texture and texture coordinates
 GRRLIB_texture*  GRRLIB_CreateEmptyTexture (const u32 width, const u32 height);
+GRRLIB_texture*  GRRLIB_CreateEmptyTextureFmt (const u32 width, const u32 height, const u32 fmt);
 GRRLIB_texture*  GRRLIB_LoadTexture    (const u8 *my_img);
 GRRLIB_texture*  GRRLIB_LoadTextureEx  (const u8 *my_img, const u32 my_size);
+GRRLIB_texture*  GRRLIB_LoadTextureFmt (const u8 *my_img, const u32 my_size, const u32 fmt);
 GRRLIB_texture*  GRRLIB_LoadTexturePNG (const u8 *my_png);
+GRRLIB_texture*  GRRLIB_LoadTexturePNGFmt (const u8 *my_png, const u32 fmt);
 GRRLIB_texture*  GRRLIB_LoadTextureBMP (const u8 *my_bmp);
+GRRLIB_texture*  GRRLIB_LoadTextureBMPFmt (const u8 *my_bmp, const u32 fmt);
 GRRLIB_texture*  GRRLIB_LoadTextureJPG (const u8 *my_jpg);
 GRRLIB_texture*  GRRLIB_LoadTextureJPGEx (const u8 *my_jpg, const u32 my_size);
+GRRLIB_texture*  GRRLIB_LoadTextureJPGFmt (const u8 *my_jpg, const u32 my_size, const u32 fmt);
 GRRLIB_texture*  GRRLIB_LoadTextureTPL (const u8 *my_tpl, const u32 my_size, const s32 my_id);
+GRRLIB_texture*  GRRLIB_LoadTextureScaled (const u8 *my_img, const u32 my_size, const u32 maxWidth, const u32 maxHeight,
+                                           const GRRLIB_scaleFilter filter);
 
 GRRLIB_texturePart*  GRRLIB_CreateTexturePart   (const f32 x, const f32 y, const f32 width, const f32 height, const GRRLIB_texture *texture);
 GRRLIB_texturePart*  GRRLIB_CreateTexturePartEx (const f32 x, const f32 y, const f32 width, const f32 height, const u32 teturexWidth, const u32 textureHeight);
 
+//------------------------------------------------------------------------------
+// GRRLIB_tplSet.c - Textures sharing the data of a TPL file
+GRRLIB_tplSet*   GRRLIB_OpenTPLSet         (u8 *my_tpl, const u32 my_size);
+GRRLIB_tplSet*   GRRLIB_OpenTPLSetFromFile (const char *filename);
+u32              GRRLIB_GetTPLSetCount     (const GRRLIB_tplSet *set);
+GRRLIB_texture*  GRRLIB_GetTPLSetTexture   (GRRLIB_tplSet *set, const s32 id);
+void             GRRLIB_FreeTPLSet         (GRRLIB_tplSet *set);
+
 //------------------------------------------------------------------------------
 // GRRLIB_gecko.c - USB_Gecko output facilities
 bool GRRLIB_GeckoInit();
@@ -184,6 +326,7 @@ void GRRLIB_ObjectViewEnd(void);
 void GRRLIB_ObjectView(f32 posx, f32 posy, f32 posz, f32 angx, f32 angy, f32 angz, f32 scalx, f32 scaly, f32 scalz);
 void GRRLIB_ObjectViewInv(f32 posx, f32 posy, f32 posz, f32 angx, f32 angy, f32 angz, f32 scalx, f32 scaly, f32 scalz);
 void GRRLIB_SetTexture(GRRLIB_texImg *tex, bool rep);
+void GRRLIB_SetTextureEx(const GRRLIB_texture *tex, bool rep);
 void GRRLIB_DrawTorus(f32 r, f32 R, int nsides, int rings, bool filled, u32 col);
 void GRRLIB_DrawSphere(f32 r, int lats, int longs, bool filled, u32 col);
 void GRRLIB_DrawCube(f32 size, bool filled, u32 col);
@@ -29,7 +29,8 @@ THE SOFTWARE.
  * Reset the clipping to normal.
  */
 static inline void  GRRLIB_ResetScissor (void) {
-    GX_SetScissor( 0, 0, GRRLIB_VideoMode->fbWidth, GRRLIB_VideoMode->efbHeight );
+    GRRLIB_SpriteBatchFlush();
+    GRRLIB_StateSetScissor( 0, 0, GRRLIB_VideoMode->fbWidth, GRRLIB_VideoMode->efbHeight );
 }
 
 /**
@@ -41,7 +42,8 @@ static inline void  GRRLIB_ResetScissor (void) {
  */
 static inline void  GRRLIB_SetScissor (const unsigned int x, const unsigned int y,
                                        const unsigned int width, const unsigned int height) {
-    GX_SetScissor( x, y, width, height );
+    GRRLIB_SpriteBatchFlush();
+    GRRLIB_StateSetScissor( x, y, width, height );
 }
 
 /**
@@ -30,8 +30,103 @@ THE SOFTWARE.
 #define _SHIFTR(v, s, w)    \
 	((u32)(((u32)(v) >> (s)) & ((0x01 << (w)) - 1)))
 
+/**
+ * Convert a color to the GX_TF_RGB565 format.
+ * @param color The color in RGBA format.
+ * @return The color in RGB565 format, alpha is dropped.
+ */
+static inline u16  GRRLIB_PackRGB565 (const u32 color) {
+	return ((color >> 16) & 0xF800) | ((color >> 13) & 0x07E0) | ((color >> 11) & 0x001F);
+}
+
+/**
+ * Convert a GX_TF_RGB565 color to RGBA format.
+ * Bits are replicated so that 0x1F gives 0xFF.
+ * @param c The color in RGB565 format.
+ * @return The color in RGBA format.
+ */
+static inline u32  GRRLIB_UnpackRGB565 (const u16 c) {
+	const u32 r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+
+	return GRRLIB_RGBA((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0xFF);
+}
+
+/**
+ * Convert a color to the GX_TF_RGB5A3 format.
+ * Colors with an alpha of 0xE0 or more are stored opaque with 5 bits per component,
+ * the others with 3 bits of alpha and 4 bits per component.
+ * @param color The color in RGBA format.
+ * @return The color in RGB5A3 format.
+ */
+static inline u16  GRRLIB_PackRGB5A3 (const u32 color) {
+	if (GRRLIB_A(color) >= 0xE0) {
+		return 0x8000 | ((color >> 17) & 0x7C00) | ((color >> 14) & 0x03E0) | ((color >> 11) & 0x001F);
+	}
+	return ((color << 7) & 0x7000) | ((color >> 20) & 0x0F00) | ((color >> 16) & 0x00F0) | ((color >> 12) & 0x000F);
+}
+
+/**
+ * Convert a GX_TF_RGB5A3 color to RGBA format.
+ * Bits are replicated so that the largest values give 0xFF.
+ * @param c The color in RGB5A3 format.
+ * @return The color in RGBA format.
+ */
+static inline u32  GRRLIB_UnpackRGB5A3 (const u16 c) {
+	if (c & 0x8000) {
+		const u32 r = (c >> 10) & 0x1F, g = (c >> 5) & 0x1F, b = c & 0x1F;
+
+		return GRRLIB_RGBA((r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2), 0xFF);
+	}
+	else {
+		const u32 a = (c >> 12) & 0x7;
+
+		return GRRLIB_RGBA(((c >> 8) & 0xF) * 0x11, ((c >> 4) & 0xF) * 0x11, (c & 0xF) * 0x11,
+		                   (a << 5) | (a << 2) | (a >> 1));
+	}
+}
+
+/**
+ * Return the palette of a GX_TF_CI8 texture.
+ * It holds 256 big-endian GX_TF_RGB5A3 colors and is stored after the texture data, mipmaps included.
+ * @param tex The texture.
+ * @return The first byte of the palette.
+ */
+static inline u8*  GRRLIB_GetTexturePalette (const GRRLIB_texture *tex) {
+	if (tex->mipmap == true) {
+		return (u8*)tex->data + GX_GetTexBufferSize(tex->width, tex->height, GX_TF_CI8, GX_TRUE, tex->maxLevel + 1);
+	}
+	return (u8*)tex->data + ((((tex->width + 7) >> 3) * ((tex->height + 3) >> 2)) << 5);
+}
+
+/**
+ * Return the offset of a pixel in the data of a texture.
+ * @param x Specifies the x-coordinate of the pixel in the texture.
+ * @param y Specifies the y-coordinate of the pixel in the texture.
+ * @param tex The texture.
+ * @return The offset of the pixel in bytes. For GX_TF_RGBA8, green and blue are 32 bytes further.
+ *         For GX_TF_CMPR, this is the offset of the block holding the pixel.
+ */
+static inline u32  GRRLIB_GetPixelOffset (const int x, const int y, const GRRLIB_texture *tex) {
+	// Rows of tiles are padded to the width of a tile
+	switch (tex->fmt) {
+		case GX_TF_I8:
+		case GX_TF_IA4:
+		case GX_TF_CI8:      // 8x4 tiles of 1 byte per pixel
+			return (((y&(~3))<<3)*((tex->width+7)>>3)) + ((x&(~7))<<2) + ((y&3)<<3) + (x&7);
+		case GX_TF_IA8:
+		case GX_TF_RGB565:
+		case GX_TF_RGB5A3:   // 4x4 tiles of 2 bytes per pixel
+			return (((y&(~3))<<3)*((tex->width+3)>>2)) + ((x&(~3))<<3) + ((((y&3)<<2) + (x&3)) <<1);
+		case GX_TF_CMPR:     // 8x8 tiles of four 8 bytes blocks
+			return (((y&(~7))<<2)*((tex->width+7)>>3)) + ((x&(~7))<<2) + ((y&4)<<2) + ((x&4)<<1);
+		default:             // 4x4 tiles of 4 bytes per pixel, split in AR and GB halves
+			return (((y&(~3))<<2)*((tex->width+3)&(~3))) + ((x&(~3))<<4) + ((((y&3)<<2) + (x&3)) <<1);
+	}
+}
+
 /**
  * Return the color value of a pixel from a GRRLIB_texImg.
+ * Works with the GX_TF_RGBA8, GX_TF_RGB565, GX_TF_RGB5A3, GX_TF_I8, GX_TF_IA8, GX_TF_IA4, GX_TF_CI8 and GX_TF_CMPR formats.
  * @param x Specifies the x-coordinate of the pixel in the texture.
  * @param y Specifies the y-coordinate of the pixel in the texture.
  * @param tex The texture to get the color from.
@@ -39,19 +134,57 @@ THE SOFTWARE.
  */
 static inline u32  GRRLIB_GetPixelFromTexture (const int x, const int y,
 								const GRRLIB_texture *tex) {
-	u32  offs;
-	u32  ar;
-	u8*  bp = (u8*)tex->data;
-
-	offs = (((y&(~3))<<2)*tex->width) + ((x&(~3))<<4) + ((((y&3)<<2) + (x&3)) <<1);
+	const u32  offs = GRRLIB_GetPixelOffset(x, y, tex);
+	const u8*  bp = (const u8*)tex->data + offs;
+	const u8*  pal;
+	u32  ar, c0, c1, i;
 
-	ar =                 (u32)(*((u16*)(bp+offs   )));
-	return (ar<<24) | ( ((u32)(*((u16*)(bp+offs+32)))) <<8) | (ar>>8);  // Wii is big-endian
+	// Read bytes one by one so that this works on any endianness (the compiler merges them on the Wii)
+	switch (tex->fmt) {
+		case GX_TF_I8:
+			return bp[0] * 0x01010101;  // GX samples the intensity as alpha too
+		case GX_TF_IA4:
+			return ((bp[0] & 0xF) * 0x11111100) | ((bp[0] >> 4) * 0x11);
+		case GX_TF_IA8:
+			return (bp[1] * 0x01010100) | bp[0];
+		case GX_TF_RGB565:
+			return GRRLIB_UnpackRGB565(((u16)bp[0] <<8) | bp[1]);
+		case GX_TF_RGB5A3:
+			return GRRLIB_UnpackRGB5A3(((u16)bp[0] <<8) | bp[1]);
+		case GX_TF_CI8:
+			pal = GRRLIB_GetTexturePalette(tex) + (bp[0] <<1);
+			return GRRLIB_UnpackRGB5A3(((u16)pal[0] <<8) | pal[1]);
+		case GX_TF_CMPR:
+			ar = ((u32)bp[0] <<8) | bp[1];
+			c1 = ((u32)bp[2] <<8) | bp[3];
+			i = (bp[4 + (y&3)] >> ((3 - (x&3)) <<1)) & 3;
+			c0 = GRRLIB_UnpackRGB565(ar);
+			c1 = GRRLIB_UnpackRGB565(c1);
+			if (i >= 2) {
+				// Blend as GX does: 5/8 and 3/8 with 4 colors, the average and transparent with 3 colors
+				if (ar > (((u32)bp[2] <<8) | bp[3])) {
+					ar = (i == 2) ? 5 : 3;
+					return GRRLIB_RGBA((GRRLIB_R(c0) * ar + GRRLIB_R(c1) * (8 - ar)) >> 3,
+					                   (GRRLIB_G(c0) * ar + GRRLIB_G(c1) * (8 - ar)) >> 3,
+					                   (GRRLIB_B(c0) * ar + GRRLIB_B(c1) * (8 - ar)) >> 3, 0xFF);
+				}
+				return GRRLIB_RGBA((GRRLIB_R(c0) + GRRLIB_R(c1)) >> 1, (GRRLIB_G(c0) + GRRLIB_G(c1)) >> 1,
+				                   (GRRLIB_B(c0) + GRRLIB_B(c1)) >> 1, (i == 2) ? 0xFF : 0);
+			}
+			return (i == 0) ? c0 : c1;
+		default:
+			ar = ((u32)bp[0] <<8) | bp[1];
+			return (ar<<24) | ((u32)bp[32] <<16) | ((u32)bp[33] <<8) | (ar>>8);
+	}
 }
 
 /**
  * Set the color value of a pixel to a GRRLIB_texImg.
- * @see GRRLIB_FlushTex
+ * Works with the same formats as GRRLIB_GetPixelFromTexture, the color is converted to the format of the texture.
+ * For GX_TF_CI8, the closest color of the palette is used and the palette is not modified.
+ * GX_TF_CMPR textures are not modified.
+ * When the writes of the texture are tracked, the pixel is recorded for GRRLIB_FlushTextureDirty.
+ * @see GRRLIB_FlushTextureDirty
  * @param x Specifies the x-coordinate of the pixel in the texture.
  * @param y Specifies the y-coordinate of the pixel in the texture.
  * @param tex The texture to set the color to.
@@ -59,13 +192,57 @@ static inline u32  GRRLIB_GetPixelFromTexture (const int x, const int y,
  */
 static inline void  GRRLIB_SetPixelToTexture (const int x, const int y,
 							    GRRLIB_texture *tex, const u32 color) {
-	u32  offs;
-	u8*  bp = (u8*)tex->data;
-
-	offs = (((y&(~3))<<2)*tex->width) + ((x&(~3))<<4) + ((((y&3)<<2) + (x&3)) <<1);
+	const u32  offs = GRRLIB_GetPixelOffset(x, y, tex);
+	u8*  bp = (u8*)tex->data + offs;
+	const u8*  pal;
+	u32  i, c, d, best = 0, bestDist = ~0u;
+	s32  dr, dg, db, da;
+	u16  v;
 
-	*((u16*)(bp+offs   )) = (u16)((color <<8) | (color >>24));
-	*((u16*)(bp+offs+32)) = (u16) (color >>8);
+	switch (tex->fmt) {
+		case GX_TF_I8:
+			bp[0] = GRRLIB_LUMA(color);
+			break;
+		case GX_TF_IA4:
+			bp[0] = (GRRLIB_A(color) & 0xF0) | (GRRLIB_LUMA(color) >> 4);
+			break;
+		case GX_TF_IA8:
+			bp[0] = GRRLIB_A(color);
+			bp[1] = GRRLIB_LUMA(color);
+			break;
+		case GX_TF_RGB565:
+		case GX_TF_RGB5A3:
+			v = (tex->fmt == GX_TF_RGB565) ? GRRLIB_PackRGB565(color) : GRRLIB_PackRGB5A3(color);
+			bp[0] = v >> 8;
+			bp[1] = v;
+			break;
+		case GX_TF_CI8:
+			pal = GRRLIB_GetTexturePalette(tex);
+			for (i = 0; i < 256 && bestDist != 0; i++, pal += 2) {
+				c = GRRLIB_UnpackRGB5A3(((u16)pal[0] <<8) | pal[1]);
+				dr = (s32)GRRLIB_R(c) - (s32)GRRLIB_R(color);
+				dg = (s32)GRRLIB_G(c) - (s32)GRRLIB_G(color);
+				db = (s32)GRRLIB_B(c) - (s32)GRRLIB_B(color);
+				da = (s32)GRRLIB_A(c) - (s32)GRRLIB_A(color);
+				d = dr*dr + dg*dg + db*db + da*da;
+				if (d < bestDist) {
+					bestDist = d;
+					best = i;
+				}
+			}
+			bp[0] = best;
+			break;
+		case GX_TF_CMPR:
+			return;
+		default:
+			bp[0 ] = (u8)(color      );  // Alpha
+			bp[1 ] = (u8)(color >>24);  // Red
+			bp[32] = (u8)(color >>16);  // Green
+			bp[33] = (u8)(color >> 8);  // Blue
+	}
+	if (tex->dirtyRows != NULL) {
+		GRRLIB_MarkTextureDirty(tex, x, y, 1, 1);
+	}
 }
 
 /**
@@ -79,7 +256,7 @@ static inline u32 GRRLIB_GetPixelFromFB (int x, int y) {
 
 	regval = 0xc8000000|(_SHIFTL(x,2,10));
 	regval = (regval&~0x3FF000)|(_SHIFTL(y,12,10));
-	val = *(u32*)regval;
+	val = *(u32*)(uintptr_t)regval;
 
 	return GRRLIB_RGBA(_SHIFTR(val,16,8), _SHIFTR(val,8,8), val&0xff, _SHIFTR(val,24,8));
 }
@@ -95,5 +272,5 @@ static inline void GRRLIB_SetPixelToFB (int x, int y, u32 pokeColor) {
 
 	regval = 0xc8000000|(_SHIFTL(x,2,10));
 	regval = (regval&~0x3FF000)|(_SHIFTL(y,12,10));
-	*(u32*)regval = _SHIFTL(GRRLIB_A(pokeColor),24,8) | _SHIFTL(GRRLIB_R(pokeColor),16,8) | _SHIFTL(GRRLIB_G(pokeColor),8,8) | (GRRLIB_B(pokeColor)&0xff);
+	*(u32*)(uintptr_t)regval = _SHIFTL(GRRLIB_A(pokeColor),24,8) | _SHIFTL(GRRLIB_R(pokeColor),16,8) | _SHIFTL(GRRLIB_G(pokeColor),8,8) | (GRRLIB_B(pokeColor)&0xff);
 }
@@ -42,6 +42,193 @@ THE SOFTWARE.
  */
 #define GRRLIB_VERSION(a,b,c) ((a)*65536+(b)*256+(c))
 
+//------------------------------------------------------------------------------
+// GRRLIB_assetCache.c - Shared textures with a memory budget
+void GRRLIB_AssetCacheNextFrame (void);
+
+//------------------------------------------------------------------------------
+// GRRLIB_batch.c - Batched sprite rendering
+bool GRRLIB_SpriteBatchActive (void);
+
+//------------------------------------------------------------------------------
+// GRRLIB_core.c - GRRLIB core functions
+void* GRRLIB_GetFreeFramebuffer (void);
+void  GRRLIB_PresentFrame (void);
+
+//------------------------------------------------------------------------------
+// GRRLIB_displayList.c - Recording and calling display lists
+void GRRLIB_FreeDisplayLists (void);
+bool GRRLIB_DisplayListRecording (void);
+bool GRRLIB_DisplayListUseMesh (void *mesh);
+void GRRLIB_DisplayListsForgetMeshes (void);
+
+//------------------------------------------------------------------------------
+// GRRLIB_frameStats.c - Per-frame performance counters
+extern GRRLIB_frameCounters GRRLIB_FrameCounters;
+
+void GRRLIB_FrameStatsBegin (void);
+void GRRLIB_FrameStatsEnd (void);
+
+/**
+ * Start a GX_Begin/GX_End block and count it in the frame counters.
+ * @param primitive The primitive type.
+ * @param vtxfmt The vertex format.
+ * @param vtxcnt The number of vertices.
+ */
+static inline void GRRLIB_Begin (const u8 primitive, const u8 vtxfmt, const u16 vtxcnt) {
+	GRRLIB_FrameCounters.begins++;
+	GRRLIB_FrameCounters.vertices += vtxcnt;
+	GX_Begin(primitive, vtxfmt, vtxcnt);
+}
+
+//------------------------------------------------------------------------------
+// GRRLIB_memory.c - Allocators and memory statistics
+#define GRRLIB_MEM_ALIGN  (8)  /**< Alignment of the structures allocated by GRRLIB, enough for any member. */
+
+//------------------------------------------------------------------------------
+// GRRLIB_mesh.c - Cached meshes for 3D primitives
+/**
+ * 3D primitives kept in the mesh cache.
+ */
+typedef  enum GRRLIB_meshType {
+	GRRLIB_MESH_TORUS,      /**< GRRLIB_DrawTorus. */
+	GRRLIB_MESH_SPHERE,     /**< GRRLIB_DrawSphere. */
+	GRRLIB_MESH_CYLINDER,   /**< GRRLIB_DrawCylinder. */
+	GRRLIB_MESH_CONE,       /**< GRRLIB_DrawCone. */
+	GRRLIB_MESH_TESSPANEL,  /**< GRRLIB_DrawTessPanel. */
+} GRRLIB_meshType;
+
+void GRRLIB_DrawCachedMesh (const GRRLIB_meshType type, const f32 f0, const f32 f1, const f32 f2, const f32 f3,
+                            const int n0, const int n1, const bool filled, const u32 col);
+void GRRLIB_MeshCacheNextFrame (void);
+void GRRLIB_MeshPin (void *mesh);
+void GRRLIB_MeshUnpin (void *mesh);
+
+//------------------------------------------------------------------------------
+// GRRLIB_state.c - Shadowed GX state
+#define GRRLIB_TEV_KMODULATE  (0x10)  /**< TEV operation like GX_MODULATE, using the constant colour. */
+#define GRRLIB_TEV_KPASSCLR   (0x11)  /**< TEV operation like GX_PASSCLR, using the constant colour. */
+#define GRRLIB_TEXCOORD_FRAC  (15)    /**< Fractional bits of the texture coordinates in the compact vertex format. */
+
+void GRRLIB_StateSetKonstColor     (const u32 color);
+void GRRLIB_StateTextured2DKonst   (GXTexObj *obj, Mtx mtx, const u32 color);
+void GRRLIB_StateUntextured2DKonst (const u32 color);
+void GRRLIB_StateSetMode3D         (const bool enabled);
+bool GRRLIB_StateCompactAllowed    (void);
+void GRRLIB_StateLeave             (void);
+
+/**
+ * Tell if a coordinate can be sent as a 16-bit integer in the compact vertex format.
+ * @param v The coordinate.
+ * @return @c true if the coordinate is an integer between -32768 and 32767, @c false otherwise.
+ */
+static inline bool GRRLIB_CompactPos (const f32 v) {
+	return v >= -32768.0f && v <= 32767.0f && v == (f32)(s16)v;
+}
+
+//------------------------------------------------------------------------------
+// GRRLIB_tiling.c - Converting images to texture tiles
+/**
+ * Layouts of the decoded pixels given to the tiling functions.
+ */
+typedef  enum GRRLIB_pixelLayout {
+	GRRLIB_LAYOUT_RGB,    /**< 3 bytes per pixel: red, green, blue. */
+	GRRLIB_LAYOUT_RGBA,   /**< 4 bytes per pixel: red, green, blue, alpha. */
+	GRRLIB_LAYOUT_BGR,    /**< 3 bytes per pixel: blue, green, red. */
+	GRRLIB_LAYOUT_BGRA,   /**< 4 bytes per pixel: blue, green, red, alpha. */
+	GRRLIB_LAYOUT_GRAY,   /**< 1 byte per pixel: intensity. */
+	GRRLIB_LAYOUT_GRAYA,  /**< 2 bytes per pixel: intensity, alpha. */
+} GRRLIB_pixelLayout;
+
+/**
+ * Get the size of the tiles of a texture format.
+ * @param fmt The format.
+ * @param tileW Set to the width of a tile in pixels.
+ * @param tileH Set to the height of a tile in pixels.
+ * @return The size of a tile in bytes.
+ */
+static inline u32 GRRLIB_TileGeometry (const u32 fmt, u32 *tileW, u32 *tileH) {
+	switch (fmt) {
+		case GX_TF_CMPR:
+			*tileW = 8;  *tileH = 8;  return 32;
+		case GX_TF_I8: case GX_TF_IA4: case GX_TF_CI8:
+			*tileW = 8;  *tileH = 4;  return 32;
+		case GX_TF_RGBA8:
+			*tileW = 4;  *tileH = 4;  return 64;
+		default:
+			*tileW = 4;  *tileH = 4;  return 32;
+	}
+}
+
+void GRRLIB_TileStripeRGBA8 (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                             void *dst, const u32 width, const u32 rows);
+void GRRLIB_TileRGBA8       (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                             void *dst, const u32 width, const u32 height);
+bool GRRLIB_TileImage       (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                             void *dst, const u32 fmt, const u32 width, const u32 height);
+u32  GRRLIB_ChooseTextureFormat (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                                 const u32 width, const u32 height, const u32 fmt);
+
+//------------------------------------------------------------------------------
+// GRRLIB_cmpr.c - Compressing images to GX_TF_CMPR textures
+void GRRLIB_EncodeCMPR (const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout,
+                        void *dst, const u32 width, const u32 height, const bool hq);
+
+//------------------------------------------------------------------------------
+// GRRLIB_bmp.c - Decoding bitmaps
+/**
+ * Structure to hold the state of a bitmap being decoded, see GRRLIB_BMPOpen.
+ */
+typedef  struct GRRLIB_bmpDecoder {
+	u32                  width;         /**< Width of the bitmap. */
+	u32                  height;        /**< Height of the bitmap. */
+	u32                  bits;          /**< Bits per pixel. */
+	u32                  compression;   /**< Compression of the pixels. */
+	const u8            *top;           /**< First byte of the top row, in the buffer or in indices. */
+	s32                  stride;        /**< Distance between two rows from the top in bytes. */
+	bool                 direct;        /**< Rows can be given to the tiling functions as they are stored. */
+	GRRLIB_pixelLayout   layout;        /**< Layout of the stored pixels when direct is set. */
+	u32                  shift[4];      /**< Position of the blue, green, red and alpha masks. */
+	u32                  max[4];        /**< Largest value of each mask once shifted. */
+	u32                  mul[4];        /**< Scale from a mask value to 8 bits, in 16.16 fixed point. */
+	u32                  bias[4];       /**< Rounding, or value of a missing mask, in 16.16 fixed point. */
+	u8                  *indices;       /**< Palette indexes of a run-length encoded bitmap, bottom-up. */
+	u8                  *skipped;       /**< One bit per pixel of a run-length encoded bitmap left transparent, NULL if none. */
+	u8                   palette[256][4];  /**< The palette, in BGRA order. */
+} GRRLIB_bmpDecoder;
+
+bool      GRRLIB_BMPOpen     (GRRLIB_bmpDecoder *bmp, const u8 *my_bmp, const u8 *my_end);
+const u8* GRRLIB_BMPReadRows (const GRRLIB_bmpDecoder *bmp, const u32 y, const u32 rows, u8 *buffer,
+                              s32 *stride, GRRLIB_pixelLayout *layout);
+void      GRRLIB_BMPClose    (GRRLIB_bmpDecoder *bmp);
+
+//------------------------------------------------------------------------------
+// GRRLIB_scale.c - Shrinking images while they are converted to tiles
+/**
+ * Structure to hold the state of an image being shrunk into a texture, see GRRLIB_ScalerInit.
+ */
+typedef  struct GRRLIB_scaler {
+	GRRLIB_texture      *texture;       /**< The destination. */
+	u32                  encoding;      /**< The format given to GRRLIB_TileImage. */
+	GRRLIB_scaleFilter   filter;        /**< The filter. */
+	u32                  srcWidth;      /**< Width of the image. */
+	u32                  srcHeight;     /**< Height of the image. */
+	u32                  srcY;          /**< Number of rows of the image received. */
+	u32                  dstY;          /**< Number of rows of the texture finished. */
+	u32                  stripeHeight;  /**< Height of a row of tiles. */
+	u8                  *stripe;        /**< Rows of the texture not tiled yet, 4 bytes per pixel. */
+	u32                 *column;        /**< Destination pixel of each source pixel, or source pixel of each destination pixel for GRRLIB_SCALE_NEAREST. */
+	u32                 *weight;        /**< Part of each source pixel in its destination pixel. */
+	u32                 *row;           /**< Source row shrunk horizontally. */
+	u64                 *acc;           /**< Sums of the current and next destination rows. */
+} GRRLIB_scaler;
+
+void GRRLIB_FitImageSize (const u32 width, const u32 height, u32 maxWidth, u32 maxHeight, u32 *scaledWidth, u32 *scaledHeight);
+bool GRRLIB_ScalerInit   (GRRLIB_scaler *scaler, GRRLIB_texture *texture, const u32 encoding,
+                          const u32 srcWidth, const u32 srcHeight, const GRRLIB_scaleFilter filter);
+void GRRLIB_ScalerPush   (GRRLIB_scaler *scaler, const u8 *src, const s32 stride, const GRRLIB_pixelLayout layout, const u32 rows);
+void GRRLIB_ScalerFree   (GRRLIB_scaler *scaler);
+
 //------------------------------------------------------------------------------
 // GRRLIB_ttf.c - FreeType function for GRRLIB
 int GRRLIB_InitTTF();
@@ -85,19 +85,19 @@ static inline void GRRLIB_SetBlend(const GRRLIB_blendMode blendmode) {
 	GRRLIB_Settings.blend = blendmode;
 	switch(GRRLIB_Settings.blend) {
 		case GRRLIB_BLEND_ALPHA:
-			GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
+			GRRLIB_StateSetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
 			break;
 		case GRRLIB_BLEND_ADD:
-			GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_DSTALPHA, GX_LO_CLEAR);
+			GRRLIB_StateSetBlendMode(GX_BM_BLEND, GX_BL_SRCALPHA, GX_BL_DSTALPHA, GX_LO_CLEAR);
 			break;
 		case GRRLIB_BLEND_SCREEN:
-			GX_SetBlendMode(GX_BM_BLEND, GX_BL_SRCCLR, GX_BL_DSTALPHA, GX_LO_CLEAR);
+			GRRLIB_StateSetBlendMode(GX_BM_BLEND, GX_BL_SRCCLR, GX_BL_DSTALPHA, GX_LO_CLEAR);
 			break;
 		case GRRLIB_BLEND_MULTI:
-			GX_SetBlendMode(GX_BM_SUBTRACT, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
+			GRRLIB_StateSetBlendMode(GX_BM_SUBTRACT, GX_BL_SRCALPHA, GX_BL_INVSRCALPHA, GX_LO_CLEAR);
 			break;
 		case GRRLIB_BLEND_INV:
-			GX_SetBlendMode(GX_BM_BLEND, GX_BL_INVSRCCLR, GX_BL_INVSRCCLR, GX_LO_CLEAR);
+			GRRLIB_StateSetBlendMode(GX_BM_BLEND, GX_BL_INVSRCCLR, GX_BL_INVSRCCLR, GX_LO_CLEAR);
 			break;
 	}
 }
@@ -145,3 +145,43 @@ static inline void GRRLIB_SetDeflicker(const bool deflicker) {
 static inline bool GRRLIB_GetDeflicker(void) {
 	return GRRLIB_Settings.deflicker;
 }
+
+/**
+ * Turn the compact vertex format on/off.
+ * When enabled, 2D drawing functions send 16-bit coordinates and no vertex colours whenever the values fit.
+ * @param compact Set to @c true to enable the compact vertex format (Default: Enabled).
+ */
+static inline void GRRLIB_SetCompactVertices(const bool compact) {
+	GRRLIB_Settings.compactVertices = compact;
+}
+
+/**
+ * Get current compact vertex format setting.
+ * @return Returns @c true if the compact vertex format is enabled.
+ */
+static inline bool GRRLIB_GetCompactVertices(void) {
+	return GRRLIB_Settings.compactVertices;
+}
+
+/**
+ * Turn the lazy restore of the GX state on/off.
+ * When disabled, every drawing function leaves GX in the default 2D state (GX_PASSCLR, vertex colours,
+ * no texture coordinates, the current matrix), so GX can be used directly between GRRLIB calls.
+ * When enabled, that state is only restored by the next draw needing it, which saves commands between sprites,
+ * and GRRLIB_StateRestore must be called before sending vertices directly with GX.
+ * @param lazy Set to @c true to restore the state lazily (Default: Disabled).
+ */
+static inline void GRRLIB_SetLazyState(const bool lazy) {
+	GRRLIB_Settings.lazyState = lazy;
+	if (lazy == false) {
+		GRRLIB_StateRestore();
+	}
+}
+
+/**
+ * Get current lazy restore setting.
+ * @return Returns @c true if the GX state is restored lazily.
+ */
+static inline bool GRRLIB_GetLazyState(void) {
+	return GRRLIB_Settings.lazyState;
+}
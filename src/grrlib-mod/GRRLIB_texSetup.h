@@ -28,12 +28,26 @@ THE SOFTWARE.
 #include <malloc.h>
 #include <string.h>
 
+/**
+ * Return the size of the data of a texture.
+ * This is the size of the tiles of all the mipmap levels, plus the palette for GX_TF_CI8.
+ * @param texture The texture.
+ * @return The size in bytes.
+ */
+static inline u32  GRRLIB_GetTextureDataSize(const GRRLIB_texture *texture) {
+	const u32 size = GX_GetTexBufferSize(texture->width, texture->height, texture->fmt,
+	                                     texture->mipmap, texture->maxLevel + 1);
+
+	return (texture->fmt == GX_TF_CI8) ? size + 256 * 2 : size;
+}
+
 /**
  * Clear a texture to transparent black.
+ * The palette of a GX_TF_CI8 texture is cleared too.
  * @param texture Texture to clear.
  */
 static inline void  GRRLIB_ClearTexture(GRRLIB_texture *texture) {
-	memset(texture->data, 0, (texture->height * texture->width) << 2);
+	memset(texture->data, 0, GRRLIB_GetTextureDataSize(texture));
 }
 
 /**
@@ -59,13 +73,26 @@ static inline void  GRRLIB_SetTexturePart(GRRLIB_texture *texture) {
  * Write texture data to main memory and create a GXTexObj.
  * For performance, the CPU holds a data cache where modifications are stored before they get written down to main memory.
  * The texture should not be modified after this function is called.
+ * Textures with mipmaps use trilinear filtering and the levels of detail set with GRRLIB_SetTextureLOD.
  * @param texture The texture to finalize.
  */
 static inline void  GRRLIB_FinalizeTexture(GRRLIB_texture *texture) {
-	// TODO: Add support for other texture formats.
-	DCFlushRange(texture->data, texture->width * texture->height * 4);
-	GX_InitTexObj(&texture->obj, texture->data, texture->width, texture->height,
-	              texture->fmt, GX_CLAMP, GX_CLAMP, GX_FALSE);
+	DCFlushRange(texture->data, GRRLIB_GetTextureDataSize(texture));
+	if (texture->fmt == GX_TF_CI8) {
+		// The palette is loaded with the texture, see GRRLIB_StateLoadTexObj
+		GX_InitTlutObj(&texture->tlut, GRRLIB_GetTexturePalette(texture), GX_TL_RGB5A3, 256);
+		GX_InitTexObjCI(&texture->obj, texture->data, texture->width, texture->height,
+		                texture->fmt, GX_CLAMP, GX_CLAMP, texture->mipmap, GX_TLUT0);
+		GX_InitTexObjUserData(&texture->obj, &texture->tlut);
+	}
+	else {
+		GX_InitTexObj(&texture->obj, texture->data, texture->width, texture->height,
+		              texture->fmt, GX_CLAMP, GX_CLAMP, texture->mipmap);
+	}
+	if (texture->mipmap == true) {
+		GX_InitTexObjLOD(&texture->obj, GX_LIN_MIP_LIN, GX_LINEAR, texture->minLod, texture->maxLod,
+		                 texture->lodBias, GX_TRUE, GX_TRUE, GX_ANISO_1);
+	}
 
 	GRRLIB_SetTexturePart(texture);
 }
@@ -78,10 +105,11 @@ static inline void  GRRLIB_FinalizeTexture(GRRLIB_texture *texture) {
  */
 static inline void  GRRLIB_FreeTexture(GRRLIB_texture *texture) {
 	if(texture != NULL) {
-		if (texture->data != NULL) {
-			free(texture->data);
+		if (texture->dirtyRows != NULL) {
+			GRRLIB_TrackTextureDirty(texture, false);
 		}
-		free(texture);
+		GRRLIB_MemFree(texture->data, GRRLIB_GetTextureDataSize(texture));
+		GRRLIB_MemFree(texture, sizeof(GRRLIB_texture));
 	}
 }
 
@@ -92,7 +120,5 @@ static inline void  GRRLIB_FreeTexture(GRRLIB_texture *texture) {
  * @param texturePart A GRRLIB_texturePart structure.
  */
 static inline void  GRRLIB_FreeTexturePart(GRRLIB_texturePart *texturePart) {
-	if(texturePart != NULL) {
-		free(texturePart);
-	}
+	GRRLIB_MemFree(texturePart, sizeof(GRRLIB_texturePart));
 }
@@ -0,0 +1,821 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file grrlib_bench.cpp
+ * Benchmarks of the tiling kernels, the bitmap effects, the texture loaders
+ * and the GX commands sent by the drawing functions.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <grrlib-mod.h>
+#include <gxhost.h>
+extern "C" {
+#include "grrlib-mod/GRRLIB_private.h"
+}
+
+#include "../tests/test_images.h"
+
+/**
+ * Texture filled with the test image, freed at the end of the benchmark.
+ */
+struct TestTexture {
+	GRRLIB_texture *tex;
+
+	TestTexture(u32 width, u32 height) : tex(GRRLIB_CreateEmptyTexture(width, height)) {
+		for (u32 y = 0; y < height; y++) {
+			for (u32 x = 0; x < width; x++) {
+				GRRLIB_SetPixelToTexture(x, y, tex, TestPixel(x, y));
+			}
+		}
+	}
+	~TestTexture() {
+		GRRLIB_FreeTexture(tex);
+	}
+};
+
+/**
+ * Report the GX traffic of one iteration.
+ */
+static void SetGXCounters(benchmark::State &state, u64 items) {
+	state.counters["fifoBytes/item"] = (double)GXHost_GetFifoBytes() / (double)items;
+	state.counters["begins"] = GXHost_CountCommands(GXHOST_BEGIN);
+	state.counters["texLoads"] = GXHost_CountCommands(GXHOST_LOADTEXOBJ);
+	state.counters["mtxLoads"] = GXHost_CountCommands(GXHOST_LOADPOSMTX);
+}
+
+//------------------------------------------------------------------------------
+// Texture conversion
+
+/**
+ * The converter used by the JPEG loader before the tiling kernels, kept as a baseline.
+ */
+static void ReferenceRawTo4x4RGBA(const u8 *src, void *dst, const u32 width, const u32 height) {
+	u8 *p = (u8*)dst;
+
+	for (u32 block = 0; block < height; block += 4) {
+		for (u32 i = 0; i < width; i += 4) {
+			for (u8 c = 0; c < 4; ++c) {
+				for (u8 argb = 0; argb < 4; ++argb) {
+					*p++ = 255;
+					*p++ = src[((i + argb) + ((block + c) * width)) * 3];
+				}
+			}
+			for (u8 c = 0; c < 4; ++c) {
+				for (u8 argb = 0; argb < 4; ++argb) {
+					*p++ = src[(((i + argb) + ((block + c) * width)) * 3) + 1];
+					*p++ = src[(((i + argb) + ((block + c) * width)) * 3) + 2];
+				}
+			}
+		}
+	}
+}
+
+static void BM_ReferenceRawTo4x4RGBA(benchmark::State &state) {
+	const u32 size = state.range(0);
+	std::vector<u8> raw(size * size * 3, 0x5A);
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(size, size);
+
+	for (auto _ : state) {
+		ReferenceRawTo4x4RGBA(raw.data(), tex->data, size, size);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * size * size * 4);
+	GRRLIB_FreeTexture(tex);
+}
+BENCHMARK(BM_ReferenceRawTo4x4RGBA)->Arg(64)->Arg(512);
+
+/**
+ * The per-pixel path used by the BMP loader before the tiling kernels, kept as a baseline.
+ */
+static void BM_ReferenceSetPixelBGR(benchmark::State &state) {
+	const u32 size = state.range(0);
+	std::vector<u8> raw(size * size * 3, 0x5A);
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(size, size);
+
+	for (auto _ : state) {
+		u32 i = 0;
+		for (s32 y = size - 1; y >= 0; y--) {
+			for (u32 x = 0; x < size; x++, i += 3) {
+				GRRLIB_SetPixelToTexture(x, y, tex, GRRLIB_RGBA(raw[i + 2], raw[i + 1], raw[i], 0xFF));
+			}
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * size * size * 4);
+	GRRLIB_FreeTexture(tex);
+}
+BENCHMARK(BM_ReferenceSetPixelBGR)->Arg(64)->Arg(512);
+
+static void BM_TileRGBA8(benchmark::State &state) {
+	static const u32 bpp[] = { 3, 4, 3, 4, 1, 2 };
+	const GRRLIB_pixelLayout layout = (GRRLIB_pixelLayout)state.range(0);
+	const u32 size = state.range(1);
+	std::vector<u8> raw(size * size * bpp[layout], 0x5A);
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(size, size);
+
+	for (auto _ : state) {
+		GRRLIB_TileRGBA8(raw.data(), size * bpp[layout], layout, tex->data, size, size);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * size * size * 4);
+	GRRLIB_FreeTexture(tex);
+}
+BENCHMARK(BM_TileRGBA8)->ArgNames({"layout", "size"})
+	->ArgsProduct({{ GRRLIB_LAYOUT_RGB, GRRLIB_LAYOUT_RGBA, GRRLIB_LAYOUT_BGR,
+	                 GRRLIB_LAYOUT_BGRA, GRRLIB_LAYOUT_GRAY, GRRLIB_LAYOUT_GRAYA }, { 64, 512 }})
+	->Args({ GRRLIB_LAYOUT_RGB, 510 });
+
+//------------------------------------------------------------------------------
+// Bitmap effects
+
+template <void (*Effect)(const GRRLIB_texture*, GRRLIB_texture*)>
+static void BM_Effect(benchmark::State &state) {
+	const u32 size = state.range(0);
+	TestTexture src(size, size), dst(size, size);
+
+	for (auto _ : state) {
+		Effect(src.tex, dst.tex);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK_TEMPLATE(BM_Effect, GRRLIB_BMFX_FlipH)->Arg(256);
+BENCHMARK_TEMPLATE(BM_Effect, GRRLIB_BMFX_FlipV)->Arg(256);
+BENCHMARK_TEMPLATE(BM_Effect, GRRLIB_BMFX_Grayscale)->Arg(256);
+BENCHMARK_TEMPLATE(BM_Effect, GRRLIB_BMFX_Sepia)->Arg(256);
+BENCHMARK_TEMPLATE(BM_Effect, GRRLIB_BMFX_Invert)->Arg(256);
+
+template <void (*Effect)(const GRRLIB_texture*, GRRLIB_texture*, const u32)>
+static void BM_EffectFactor(benchmark::State &state) {
+	const u32 size = state.range(0);
+	TestTexture src(size, size), dst(size, size);
+
+	for (auto _ : state) {
+		Effect(src.tex, dst.tex, state.range(1));
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK_TEMPLATE(BM_EffectFactor, GRRLIB_BMFX_Blur)->Args({256, 1})->Args({256, 4})->Args({256, 8});
+BENCHMARK_TEMPLATE(BM_EffectFactor, GRRLIB_BMFX_Scatter)->Args({256, 4});
+BENCHMARK_TEMPLATE(BM_EffectFactor, GRRLIB_BMFX_Pixelate)->Args({256, 4});
+
+/**
+ * GRRLIB_BMFX_Blur before its running sums, gathering the window of every pixel, kept as a baseline.
+ */
+static void ReferenceBlur(const GRRLIB_texture *texsrc, GRRLIB_texture *texdest, const u32 factor) {
+	const int numba = (1 + (factor << 1)) * (1 + (factor << 1));
+	std::vector<u32> colours(numba);
+
+	for (s32 x = 0; x < (s32)texsrc->width; x++) {
+		for (s32 y = 0; y < (s32)texsrc->height; y++) {
+			const u32 thiscol = GRRLIB_GetPixelFromTexture(x, y, texsrc);
+			int newr = 0, newg = 0, newb = 0, newa = 0, tmp = 0;
+
+			for (s32 k = x - factor; k <= x + (s32)factor; k++) {
+				for (s32 l = y - factor; l <= y + (s32)factor; l++) {
+					if (k < 0 || k >= (s32)texsrc->width || l < 0 || l >= (s32)texsrc->height) {
+						colours[tmp++] = thiscol;
+					}
+					else {
+						colours[tmp++] = GRRLIB_GetPixelFromTexture(k, l, texsrc);
+					}
+				}
+			}
+			for (tmp = 0; tmp < numba; tmp++) {
+				newr += (colours[tmp] >> 24) & 0xFF;
+				newg += (colours[tmp] >> 16) & 0xFF;
+				newb += (colours[tmp] >> 8) & 0xFF;
+				newa += colours[tmp] & 0xFF;
+			}
+			GRRLIB_SetPixelToTexture(x, y, texdest, ((newr / numba) << 24) | ((newg / numba) << 16) | ((newb / numba) << 8) | (newa / numba));
+		}
+	}
+}
+BENCHMARK_TEMPLATE(BM_EffectFactor, ReferenceBlur)->Args({256, 1})->Args({256, 4})->Args({256, 8});
+
+/**
+ * Three passes of GRRLIB_BMFX_BoxBlur, the approximation of a Gaussian blur.
+ */
+static void GaussianBlur(const GRRLIB_texture *texsrc, GRRLIB_texture *texdest, const u32 radius) {
+	GRRLIB_BMFX_BoxBlur(texsrc, texdest, radius, 3);
+}
+BENCHMARK_TEMPLATE(BM_EffectFactor, GaussianBlur)->Args({256, 1})->Args({256, 8});
+
+//------------------------------------------------------------------------------
+// Texture loading
+
+template <std::vector<u8> (*Make)(u32, u32)>
+static void BM_LoadTexture(benchmark::State &state) {
+	const u32 size = state.range(0);
+	const std::vector<u8> file = Make(size, size);
+
+	for (auto _ : state) {
+		GRRLIB_texture *tex = GRRLIB_LoadTexture(file.data());
+		benchmark::DoNotOptimize(tex);
+		GRRLIB_FreeTexture(tex);
+	}
+	state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK_TEMPLATE(BM_LoadTexture, MakePNG)->Arg(256);
+BENCHMARK_TEMPLATE(BM_LoadTexture, MakeJPG)->Arg(256);
+
+static void BM_LoadTextureBMP(benchmark::State &state) {
+	const u32 size = state.range(1);
+	const std::vector<u8> file = MakeBMP(size, size, state.range(0));
+
+	for (auto _ : state) {
+		GRRLIB_texture *tex = GRRLIB_LoadTexture(file.data());
+		benchmark::DoNotOptimize(tex);
+		GRRLIB_FreeTexture(tex);
+	}
+	state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_LoadTextureBMP)->ArgNames({"bits", "size"})->ArgsProduct({{ 1, 4, 8, 24, 32 }, { 256 }});
+
+/**
+ * The BMP loader before the stripe decoder, kept as a baseline: fixed header offsets,
+ * a palette allocated for each load and every pixel written with GRRLIB_SetPixelToTexture.
+ */
+static GRRLIB_texture *ReferenceLoadBMP(const u8 *bmp) {
+	const u32 width = bmp[18] | bmp[19] << 8 | bmp[20] << 16 | bmp[21] << 24;
+	const u32 height = bmp[22] | bmp[23] << 8 | bmp[24] << 16 | bmp[25] << 24;
+	const u32 bits = bmp[28];
+	const u32 colors = (bits <= 8) ? 1 << bits : 0;
+	const u32 stride = ((width * bits + 31) / 32) * 4;
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(width, height);
+	u32 *palette = (u32*)calloc(colors ? colors : 1, sizeof(u32));
+
+	for (u32 i = 0; i < colors; i++) {
+		palette[i] = GRRLIB_RGBA(bmp[54 + i * 4 + 2], bmp[54 + i * 4 + 1], bmp[54 + i * 4], 0xFF);
+	}
+	for (s32 y = height - 1; y >= 0; y--) {
+		const u8 *row = &bmp[54 + colors * 4 + (height - 1 - y) * stride];
+		for (u32 x = 0; x < width; x++) {
+			u32 c;
+			if (bits <= 8) {
+				c = palette[(row[x * bits / 8] >> (8 - bits - (x * bits) % 8)) & (colors - 1)];
+			}
+			else {
+				const u8 *p = &row[x * bits / 8];
+				c = GRRLIB_RGBA(p[2], p[1], p[0], (bits == 32) ? p[3] : 0xFF);
+			}
+			GRRLIB_SetPixelToTexture(x, y, tex, c);
+		}
+	}
+	free(palette);
+	GRRLIB_FinalizeTexture(tex);
+	return tex;
+}
+
+static void BM_ReferenceLoadBMP(benchmark::State &state) {
+	const u32 size = state.range(1);
+	const std::vector<u8> file = MakeBMP(size, size, state.range(0));
+
+	for (auto _ : state) {
+		GRRLIB_texture *tex = ReferenceLoadBMP(file.data());
+		benchmark::DoNotOptimize(tex);
+		GRRLIB_FreeTexture(tex);
+	}
+	state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_ReferenceLoadBMP)->ArgNames({"bits", "size"})->ArgsProduct({{ 1, 4, 8, 24, 32 }, { 256 }});
+
+/**
+ * Loading the bitmap layouts which need a conversion before tiling.
+ */
+static void BM_LoadTextureBMPLayout(benchmark::State &state) {
+	BMPOptions options;
+	options.bits = state.range(0);
+	options.compression = state.range(1);
+	const std::vector<u8> file = MakeBMPEx(256, 256, options);
+
+	for (auto _ : state) {
+		GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(file.data(), file.size(), GX_TF_RGBA8);
+		benchmark::DoNotOptimize(tex);
+		GRRLIB_FreeTexture(tex);
+	}
+	state.SetItemsProcessed(state.iterations() * 256 * 256);
+}
+BENCHMARK(BM_LoadTextureBMPLayout)->ArgNames({"bits", "compression"})->Args({16, 0})->Args({8, 1})->Args({4, 2});
+
+/**
+ * Loading in a given format, the counter shows the size of the texture data.
+ */
+static void BM_LoadTextureFmt(benchmark::State &state) {
+	const u32 fmt = state.range(0);
+	const std::vector<u8> file = MakeBMP(256, 256, 8);
+	u32 bytes = 0;
+
+	for (auto _ : state) {
+		GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(file.data(), file.size(), fmt);
+		benchmark::DoNotOptimize(tex);
+		bytes = GRRLIB_GetTextureDataSize(tex);
+		GRRLIB_FreeTexture(tex);
+	}
+	state.counters["bytes"] = bytes;
+	state.SetItemsProcessed(state.iterations() * 256 * 256);
+}
+BENCHMARK(BM_LoadTextureFmt)->ArgName("fmt")->Arg(GX_TF_RGBA8)->Arg(GX_TF_RGB565)->Arg(GX_TF_I8)
+                            ->Arg(GX_TF_CI8)->Arg(GRRLIB_TEXFMT_AUTO);
+
+/**
+ * Compression of a decoded image to GX_TF_CMPR, the counter shows the PSNR against the RGBA8 source in dB.
+ */
+static void BM_EncodeCMPR(benchmark::State &state) {
+	const u32 size = state.range(1);
+	const bool hq = state.range(0) != 0;
+	std::vector<u8> rgba(size * size * 4);
+	GRRLIB_texture tex = {};
+
+	for (u32 y = 0; y < size; y++) {
+		for (u32 x = 0; x < size; x++) {
+			const u32 c = PhotoPixel(x, y);
+			u8 *p = &rgba[(y * size + x) * 4];
+
+			p[0] = GRRLIB_R(c);
+			p[1] = GRRLIB_G(c);
+			p[2] = GRRLIB_B(c);
+			p[3] = GRRLIB_A(c);
+		}
+	}
+	tex.fmt = GX_TF_CMPR;
+	tex.width = size;
+	tex.height = size;
+	tex.data = memalign(32, GRRLIB_GetTextureDataSize(&tex));
+
+	for (auto _ : state) {
+		GRRLIB_EncodeCMPR(rgba.data(), size * 4, GRRLIB_LAYOUT_RGBA, tex.data, size, size, hq);
+		benchmark::ClobberMemory();
+	}
+	state.counters["PSNR"] = PSNR(&tex, PhotoPixel);
+	state.SetItemsProcessed(state.iterations() * size * size);
+	free(tex.data);
+}
+BENCHMARK(BM_EncodeCMPR)->ArgNames({"hq", "size"})->ArgsProduct({{ 0, 1 }, { 256, 512 }});
+
+/**
+ * Loading a 1024x1024 photo at its full size or shrunk to fit in 256x256, the counter shows the size of the texture data.
+ */
+template <std::vector<u8> (*Make)(u32, u32, u32 (*)(u32, u32))>
+static void BM_LoadTextureScaled(benchmark::State &state) {
+	const u32 box = state.range(0);
+	const std::vector<u8> file = Make(1024, 1024, PhotoPixel);
+	u32 bytes = 0;
+
+	for (auto _ : state) {
+		GRRLIB_texture *tex = box == 0 ? GRRLIB_LoadTexture(file.data())
+		                               : GRRLIB_LoadTextureScaled(file.data(), file.size(), box, box, GRRLIB_SCALE_AREA);
+		benchmark::DoNotOptimize(tex);
+		bytes = GRRLIB_GetTextureDataSize(tex);
+		GRRLIB_FreeTexture(tex);
+	}
+	state.counters["bytes"] = bytes;
+	state.SetItemsProcessed(state.iterations() * 1024 * 1024);
+}
+BENCHMARK_TEMPLATE(BM_LoadTextureScaled, MakePNGFrom)->ArgName("box")->Arg(0)->Arg(256);
+BENCHMARK_TEMPLATE(BM_LoadTextureScaled, MakeJPGFrom)->ArgName("box")->Arg(0)->Arg(256);
+
+/**
+ * A level transition: 16 textures are released and the next level loads them again,
+ * either decoded from scratch or served by an asset cache.
+ */
+static void BM_ReloadAssets(benchmark::State &state) {
+	const bool cached = state.range(0);
+	const std::vector<u8> file = MakePNG(128, 128);
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(16 << 20, GX_TF_RGBA8);
+	GRRLIB_texture *tex[16];
+
+	for (auto _ : state) {
+		for (int i = 0; i < 16; i++) {
+			const std::string key = std::to_string(i);
+			tex[i] = cached ? GRRLIB_AssetCacheLoadBuffer(cache, key.c_str(), file.data(), file.size())
+			                : GRRLIB_LoadTexture(file.data());
+		}
+		benchmark::DoNotOptimize(tex);
+		for (int i = 0; i < 16; i++) {
+			if (cached) GRRLIB_AssetCacheRelease(cache, tex[i]);
+			else        GRRLIB_FreeTexture(tex[i]);
+		}
+	}
+	GRRLIB_FreeAssetCache(cache);
+	state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK(BM_ReloadAssets)->ArgName("cached")->Arg(0)->Arg(1);
+
+/**
+ * Get the 16 sprites of a 1 MiB TPL sprite sheet, one GRRLIB_LoadTextureTPL per sprite or from a set
+ * opened once over the aligned buffer.
+ */
+static void BM_LoadTPLSprites(benchmark::State &state) {
+	const bool set = state.range(0);
+	std::vector<u32> offsets;
+	const std::vector<u8> file = MakeTPL(std::vector<TPLImage>(16, { 128, 128, GX_TF_RGBA8 }), &offsets);
+	u8 *tpl = (u8*)aligned_alloc(32, (file.size() + 31) & ~31);
+	GRRLIB_texture *tex[16];
+
+	for (auto _ : state) {
+		if (set == false) {
+			for (int i = 0; i < 16; i++) {
+				tex[i] = GRRLIB_LoadTextureTPL(file.data(), file.size(), i);
+			}
+			benchmark::DoNotOptimize(tex);
+			for (int i = 0; i < 16; i++) {
+				GRRLIB_FreeTexture(tex[i]);
+			}
+			continue;
+		}
+		memcpy(tpl, file.data(), file.size());  // A fresh file, as read from disc
+		GRRLIB_tplSet *sheet = GRRLIB_OpenTPLSet(tpl, file.size());
+		for (int i = 0; i < 16; i++) {
+			tex[i] = GRRLIB_GetTPLSetTexture(sheet, i);
+		}
+		benchmark::DoNotOptimize(tex);
+		GRRLIB_FreeTPLSet(sheet);
+	}
+	free(tpl);
+	state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK(BM_LoadTPLSprites)->ArgName("set")->Arg(0)->Arg(1);
+
+/**
+ * Time the main thread spends to get 8 textures from files: loading them itself,
+ * or queuing them in a loader and handing them back once loaded.
+ */
+static void BM_MainThreadLoad(benchmark::State &state) {
+	const bool background = state.range(0);
+	const std::string path = "/tmp/grrlib_bench_load.png";
+	const std::vector<u8> file = MakePNG(256, 256);
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(2);
+	GRRLIB_loadResult result;
+	FILE *f = fopen(path.c_str(), "wb");
+
+	fwrite(file.data(), 1, file.size(), f);
+	fclose(f);
+	for (auto _ : state) {
+		if (background == false) {
+			for (int i = 0; i < 8; i++) {
+				GRRLIB_FreeTexture(GRRLIB_LoadTextureFromFile(path.c_str()));
+			}
+			continue;
+		}
+		for (int i = 0; i < 8; i++) {
+			GRRLIB_LoaderQueueTexture(loader, path.c_str(), GX_TF_RGBA8, 0, nullptr, nullptr);
+		}
+		state.PauseTiming();
+		GRRLIB_LoaderWait(loader);
+		state.ResumeTiming();
+		while (GRRLIB_LoaderPoll(loader, &result) == true) {
+			GRRLIB_FreeTexture(result.texture);
+		}
+	}
+	GRRLIB_FreeLoader(loader);
+	remove(path.c_str());
+	state.SetItemsProcessed(state.iterations() * 8);
+}
+BENCHMARK(BM_MainThreadLoad)->ArgName("background")->Arg(0)->Arg(1);
+
+/**
+ * Create and free the coordinates of 1024 sprites, with the default allocator, a pool, or an arena reset at once.
+ */
+static void BM_AllocTextureParts(benchmark::State &state) {
+	const int mode = state.range(0);
+	GRRLIB_pool *pool = GRRLIB_CreatePool();
+	GRRLIB_arena *arena = GRRLIB_CreateArena(nullptr, 1024 * sizeof(GRRLIB_texturePart) * 2);
+	const GRRLIB_allocator alloc = (mode == 1) ? GRRLIB_PoolAllocator(pool) : GRRLIB_ArenaAllocator(arena);
+	GRRLIB_texturePart *parts[1024];
+
+	for (auto _ : state) {
+		if (mode != 0) {
+			GRRLIB_SetAllocator(&alloc);
+		}
+		for (int i = 0; i < 1024; i++) {
+			parts[i] = GRRLIB_CreateTexturePartEx(i & 31, i >> 5, 16, 16, 512, 512);
+		}
+		GRRLIB_SetAllocator(nullptr);
+		benchmark::DoNotOptimize(parts);
+		if (mode == 2) {
+			GRRLIB_ResetArena(arena);
+			continue;
+		}
+		for (int i = 0; i < 1024; i++) {
+			GRRLIB_FreeTexturePart(parts[i]);
+		}
+	}
+	GRRLIB_FreeArena(arena);
+	GRRLIB_FreePool(pool);
+	state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_AllocTextureParts)->ArgName("allocator")->Arg(0)->Arg(1)->Arg(2);
+
+/**
+ * Draw a 16x16 cursor in a 512x512 texture, then flush the whole texture or only its dirty tiles.
+ */
+static void BM_FlushEditedTexture(benchmark::State &state) {
+	const bool dirty = state.range(0);
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(512, 512, GX_TF_RGBA8);
+	u32 pos = 0;
+
+	GRRLIB_TrackTextureDirty(tex, dirty);
+	GXHost_Reset();
+	for (auto _ : state) {
+		pos = (pos + 37) % (512 - 16);
+		for (u32 y = 0; y < 16; y++) {
+			for (u32 x = 0; x < 16; x++) {
+				GRRLIB_SetPixelToTexture(pos + x, pos + y, tex, 0xFFFFFFFF);
+			}
+		}
+		GRRLIB_FlushTextureDirty(tex);
+	}
+	state.counters["flushed"] = benchmark::Counter(GXHost_GetFlushedBytes(), benchmark::Counter::kAvgIterations);
+	GRRLIB_FreeTexture(tex);
+}
+BENCHMARK(BM_FlushEditedTexture)->ArgName("dirty")->Arg(0)->Arg(1);
+
+/**
+ * Copy all the pixels of a 256x256 texture to a linear buffer, one pixel or one row at a time.
+ */
+static void BM_ReadTexturePixels(benchmark::State &state) {
+	const bool spans = state.range(0);
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(256, 256, state.range(1));
+	std::vector<u32> colors(256 * 256);
+
+	for (auto _ : state) {
+		for (u32 y = 0; y < 256; y++) {
+			if (spans == true) {
+				GRRLIB_ReadTextureSpan(tex, 0, y, 256, &colors[y * 256]);
+				continue;
+			}
+			for (u32 x = 0; x < 256; x++) {
+				colors[y * 256 + x] = GRRLIB_GetPixelFromTexture(x, y, tex);
+			}
+		}
+		benchmark::DoNotOptimize(colors.data());
+	}
+	GRRLIB_FreeTexture(tex);
+	state.SetItemsProcessed(state.iterations() * 256 * 256);
+}
+BENCHMARK(BM_ReadTexturePixels)->ArgNames({"spans", "fmt"})
+	->ArgsProduct({{ 0, 1 }, { GX_TF_RGBA8, GX_TF_RGB565, GX_TF_I8 }});
+
+/**
+ * Copy a linear buffer to all the pixels of a 256x256 texture, one pixel or one row at a time.
+ */
+static void BM_WriteTexturePixels(benchmark::State &state) {
+	const bool spans = state.range(0);
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(256, 256, state.range(1));
+	std::vector<u32> colors(256 * 256);
+
+	for (u32 i = 0; i < colors.size(); i++) {
+		colors[i] = PhotoPixel(i & 255, i >> 8);
+	}
+	for (auto _ : state) {
+		for (u32 y = 0; y < 256; y++) {
+			if (spans == true) {
+				GRRLIB_WriteTextureSpan(tex, 0, y, 256, &colors[y * 256]);
+				continue;
+			}
+			for (u32 x = 0; x < 256; x++) {
+				GRRLIB_SetPixelToTexture(x, y, tex, colors[y * 256 + x]);
+			}
+		}
+		benchmark::DoNotOptimize(tex->data);
+	}
+	GRRLIB_FreeTexture(tex);
+	state.SetItemsProcessed(state.iterations() * 256 * 256);
+}
+BENCHMARK(BM_WriteTexturePixels)->ArgNames({"spans", "fmt"})
+	->ArgsProduct({{ 0, 1 }, { GX_TF_RGBA8, GX_TF_RGB565, GX_TF_I8 }});
+
+static void BM_GenerateMipmaps(benchmark::State &state) {
+	const u32 size = state.range(2);
+	const std::vector<u8> png = MakePNGFrom(size, size, PhotoPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), state.range(1));
+
+	for (auto _ : state) {
+		GRRLIB_GenerateMipmaps(tex, (GRRLIB_mipFilter)state.range(0));
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * size * size);
+	GRRLIB_FreeTexture(tex);
+}
+BENCHMARK(BM_GenerateMipmaps)->ArgNames({"kaiser", "fmt", "size"})
+	->Args({GRRLIB_MIPFILTER_BOX, GX_TF_RGBA8, 256})->Args({GRRLIB_MIPFILTER_KAISER, GX_TF_RGBA8, 256})
+	->Args({GRRLIB_MIPFILTER_BOX, GX_TF_RGB565, 256})->Args({GRRLIB_MIPFILTER_BOX, GX_TF_CMPR, 256});
+
+/**
+ * Texture cache model: 32 KB of 32-byte lines, 8-way set associative with LRU replacement,
+ * the size of one of the TMEM caches of the GPU.
+ */
+class TexCache {
+public:
+	u32 misses = 0;
+
+	void Touch(u32 addr) {
+		const u32 line = addr >> 5, set = line & (SETS - 1);
+		u32 *tags = &tag[set * WAYS], *ages = &age[set * WAYS], way = 0;
+
+		clock++;
+		for (u32 i = 0; i < WAYS; i++) {
+			if (tags[i] == line + 1) {
+				ages[i] = clock;
+				return;
+			}
+			if (ages[i] < ages[way]) {
+				way = i;
+			}
+		}
+		misses++;
+		tags[way] = line + 1;
+		ages[way] = clock;
+	}
+
+private:
+	static const u32 WAYS = 8, SETS = 32768 / 32 / WAYS;
+	u32 tag[SETS * WAYS] = {}, age[SETS * WAYS] = {}, clock = 0;
+};
+
+/**
+ * Texture cache misses of a 512x512 GX_TF_RGBA8 texture drawn minified on a 64x64 quad, with bilinear filtering.
+ * Without mipmaps every sample reads the base level 8 texels apart; with mipmaps the 64x64 level is read.
+ * The counters show the misses and the bytes fetched by the second frame, the first one warming the cache.
+ * On the console, GRRLIB_SetFrameStatsMetric(GX_PERF0_NONE, GX_PERF1_TC_MISS) counts the same misses.
+ */
+static void BM_SampleMinified(benchmark::State &state) {
+	const bool mipmap = state.range(0) != 0;
+	const u32 size = 512, quad = 64, level = mipmap ? 3 : 0;
+	const u32 lw = size >> level, step = size / quad >> level;
+	const u32 base = GX_GetTexBufferSize(size, size, GX_TF_RGBA8, GX_TRUE, level);
+	u32 misses = 0;
+
+	for (auto _ : state) {
+		TexCache cache;
+
+		for (u32 frame = 0; frame < 2; frame++) {
+			cache.misses = 0;
+			for (u32 v = 0; v < quad; v++) {
+				for (u32 u = 0; u < quad; u++) {
+					for (u32 t = 0; t < 4; t++) {
+						const u32 x = std::min(u * step + (t & 1), lw - 1), y = std::min(v * step + (t >> 1), lw - 1);
+						const u32 offs = base + (((y&(~3))<<2)*lw) + ((x&(~3))<<4) + ((((y&3)<<2) + (x&3)) <<1);
+
+						cache.Touch(offs);       // Alpha and red
+						cache.Touch(offs + 32);  // Green and blue
+					}
+				}
+			}
+		}
+		misses = cache.misses;
+		benchmark::DoNotOptimize(misses);
+	}
+	state.counters["misses"] = misses;
+	state.counters["missBytes"] = misses * 32;
+}
+BENCHMARK(BM_SampleMinified)->ArgName("mipmap")->Arg(0)->Arg(1);
+
+//------------------------------------------------------------------------------
+// Drawing: the counters show the GX traffic of one iteration
+
+static void BM_DrawTexture(benchmark::State &state) {
+	const u32 sprites = state.range(0);
+	const bool batched = state.range(1) != 0;
+
+	GRRLIB_Init();
+	GRRLIB_Settings.compactVertices = state.range(2) != 0;
+	{
+		TestTexture sprite(32, 32);
+
+		for (auto _ : state) {
+			GXHost_Reset();
+			if (batched) {
+				GRRLIB_SpriteBatchBegin();
+			}
+			for (u32 i = 0; i < sprites; i++) {
+				GRRLIB_DrawTexture(i % 640, i % 480, sprite.tex, i, 1, 1, 0, 0);
+			}
+			if (batched) {
+				GRRLIB_SpriteBatchEnd();
+			}
+		}
+		SetGXCounters(state, sprites);
+		state.SetItemsProcessed(state.iterations() * sprites);
+	}
+	GRRLIB_Exit();
+}
+BENCHMARK(BM_DrawTexture)->ArgNames({"sprites", "batched", "compact"})
+	->Args({256, 0, 0})->Args({256, 0, 1})->Args({256, 1, 0})->Args({256, 1, 1})
+	->Args({10000, 0, 0})->Args({10000, 0, 1})->Args({10000, 1, 0})->Args({10000, 1, 1});
+
+/**
+ * Draw 64 different 24x24 sprites, each from its own texture or from the pages of an atlas, in one sprite batch.
+ */
+static void BM_DrawSprites(benchmark::State &state) {
+	const bool atlased = state.range(0) != 0;
+	const u32 count = 64;
+
+	GRRLIB_Init();
+	{
+		std::vector<GRRLIB_texture*> textures, pages;
+		std::vector<GRRLIB_texturePart*> parts;
+		GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(256, 256, GX_TF_RGBA8, 1, true);
+
+		for (u32 i = 0; i < count; i++) {
+			GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(24, 24), *page = NULL;
+
+			textures.push_back(tex);
+			parts.push_back(GRRLIB_AtlasAddTexture(atlas, tex, &page));
+			pages.push_back(page);
+		}
+		for (auto _ : state) {
+			GXHost_Reset();
+			GRRLIB_SpriteBatchBegin();
+			for (u32 i = 0; i < count; i++) {
+				if (atlased) {
+					GRRLIB_DrawTexturePart(i * 8, i * 4, pages[i], parts[i], 0, 1, 1, 0, 0);
+				}
+				else {
+					GRRLIB_DrawTexture(i * 8, i * 4, textures[i], 0, 1, 1, 0, 0);
+				}
+			}
+			GRRLIB_SpriteBatchEnd();
+		}
+		SetGXCounters(state, count);
+		state.SetItemsProcessed(state.iterations() * count);
+		for (GRRLIB_texture *tex : textures) {
+			GRRLIB_FreeTexture(tex);
+		}
+		GRRLIB_FreeAtlas(atlas);
+	}
+	GRRLIB_Exit();
+}
+BENCHMARK(BM_DrawSprites)->ArgName("atlas")->Arg(0)->Arg(1);
+
+static void BM_Rectangle(benchmark::State &state) {
+	const u32 count = state.range(0);
+
+	GRRLIB_Init();
+	for (auto _ : state) {
+		GXHost_Reset();
+		for (u32 i = 0; i < count; i++) {
+			GRRLIB_Rectangle(i % 640, i % 480, 16, 16, true);
+		}
+	}
+	SetGXCounters(state, count);
+	state.SetItemsProcessed(state.iterations() * count);
+	GRRLIB_Exit();
+}
+BENCHMARK(BM_Rectangle)->Arg(256);
+
+static void BM_DrawCube(benchmark::State &state) {
+	GRRLIB_Init();
+	GRRLIB_3dMode(0.1, 1000, 45, false, false);
+	for (auto _ : state) {
+		GXHost_Reset();
+		GRRLIB_ObjectView(0, 0, -10, 30, 30, 0, 1, 1, 1);
+		GRRLIB_DrawCube(1, true, 0xFFFFFFFF);
+	}
+	SetGXCounters(state, 1);
+	GRRLIB_2dMode();
+	GRRLIB_Exit();
+}
+BENCHMARK(BM_DrawCube);
+
+static void BM_DrawSphere(benchmark::State &state) {
+	GRRLIB_Init();
+	GRRLIB_3dMode(0.1, 1000, 45, false, false);
+	for (auto _ : state) {
+		GXHost_Reset();
+		GRRLIB_ObjectView(0, 0, -10, 30, 30, 0, 1, 1, 1);
+		GRRLIB_DrawSphere(1, 20, 20, true, 0xFFFFFFFF);
+	}
+	SetGXCounters(state, 1);
+	GRRLIB_2dMode();
+	GRRLIB_Exit();
+}
+BENCHMARK(BM_DrawSphere);
@@ -0,0 +1,250 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file gu.c
+ * Host stand-in for the GU matrix and vector functions, following the C versions of libogc.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <gccore.h>
+
+void  guMtxIdentity (Mtx mt) {
+	memset(mt, 0, sizeof(Mtx));
+	mt[0][0] = mt[1][1] = mt[2][2] = 1.0f;
+}
+
+void  guMtxCopy (Mtx src, Mtx dst) {
+	if (src != dst) {
+		memcpy(dst, src, sizeof(Mtx));
+	}
+}
+
+void  guMtxConcat (Mtx a, Mtx b, Mtx ab) {
+	Mtx tmp;
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 4; j++) {
+			tmp[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+		}
+		tmp[i][3] += a[i][3];
+	}
+	memcpy(ab, tmp, sizeof(Mtx));
+}
+
+void  guMtxScale (Mtx mt, f32 xS, f32 yS, f32 zS) {
+	memset(mt, 0, sizeof(Mtx));
+	mt[0][0] = xS;
+	mt[1][1] = yS;
+	mt[2][2] = zS;
+}
+
+void  guMtxScaleApply (Mtx src, Mtx dst, f32 xS, f32 yS, f32 zS) {
+	for (int j = 0; j < 4; j++) {
+		dst[0][j] = src[0][j] * xS;
+		dst[1][j] = src[1][j] * yS;
+		dst[2][j] = src[2][j] * zS;
+	}
+}
+
+void  guMtxTrans (Mtx mt, f32 xT, f32 yT, f32 zT) {
+	guMtxIdentity(mt);
+	mt[0][3] = xT;
+	mt[1][3] = yT;
+	mt[2][3] = zT;
+}
+
+void  guMtxTransApply (Mtx src, Mtx dst, f32 xT, f32 yT, f32 zT) {
+	guMtxCopy(src, dst);
+	dst[0][3] += xT;
+	dst[1][3] += yT;
+	dst[2][3] += zT;
+}
+
+void  guMtxRotAxisRad (Mtx mt, guVector *axis, f32 rad) {
+	const f32 s = sinf(rad), c = cosf(rad), t = 1.0f - c;
+	guVector v = *axis;
+	f32 x, y, z;
+
+	guVecNormalize(&v);
+	x = v.x; y = v.y; z = v.z;
+
+	mt[0][0] = t * x * x + c;
+	mt[0][1] = t * x * y - s * z;
+	mt[0][2] = t * x * z + s * y;
+	mt[0][3] = 0.0f;
+	mt[1][0] = t * x * y + s * z;
+	mt[1][1] = t * y * y + c;
+	mt[1][2] = t * y * z - s * x;
+	mt[1][3] = 0.0f;
+	mt[2][0] = t * x * z - s * y;
+	mt[2][1] = t * y * z + s * x;
+	mt[2][2] = t * z * z + c;
+	mt[2][3] = 0.0f;
+}
+
+void  guMtxRotRad (Mtx mt, const char axis, f32 rad) {
+	const f32 s = sinf(rad), c = cosf(rad);
+
+	guMtxIdentity(mt);
+	switch (axis) {
+		case 'x': case 'X':
+			mt[1][1] = c; mt[1][2] = -s;
+			mt[2][1] = s; mt[2][2] = c;
+			break;
+		case 'y': case 'Y':
+			mt[0][0] = c;  mt[0][2] = s;
+			mt[2][0] = -s; mt[2][2] = c;
+			break;
+		case 'z': case 'Z':
+			mt[0][0] = c; mt[0][1] = -s;
+			mt[1][0] = s; mt[1][1] = c;
+			break;
+		default:
+			break;
+	}
+}
+
+u32  guMtxInverse (Mtx src, Mtx inv) {
+	Mtx m;
+	const f32 det = src[0][0] * src[1][1] * src[2][2] + src[0][1] * src[1][2] * src[2][0] +
+	                src[0][2] * src[1][0] * src[2][1] - src[2][0] * src[1][1] * src[0][2] -
+	                src[1][0] * src[0][1] * src[2][2] - src[0][0] * src[2][1] * src[1][2];
+
+	if (det == 0.0f) {
+		return 0;
+	}
+	const f32 d = 1.0f / det;
+
+	m[0][0] =  (src[1][1] * src[2][2] - src[2][1] * src[1][2]) * d;
+	m[0][1] = -(src[0][1] * src[2][2] - src[2][1] * src[0][2]) * d;
+	m[0][2] =  (src[0][1] * src[1][2] - src[1][1] * src[0][2]) * d;
+	m[1][0] = -(src[1][0] * src[2][2] - src[2][0] * src[1][2]) * d;
+	m[1][1] =  (src[0][0] * src[2][2] - src[2][0] * src[0][2]) * d;
+	m[1][2] = -(src[0][0] * src[1][2] - src[1][0] * src[0][2]) * d;
+	m[2][0] =  (src[1][0] * src[2][1] - src[2][0] * src[1][1]) * d;
+	m[2][1] = -(src[0][0] * src[2][1] - src[2][0] * src[0][1]) * d;
+	m[2][2] =  (src[0][0] * src[1][1] - src[1][0] * src[0][1]) * d;
+
+	m[0][3] = -m[0][0] * src[0][3] - m[0][1] * src[1][3] - m[0][2] * src[2][3];
+	m[1][3] = -m[1][0] * src[0][3] - m[1][1] * src[1][3] - m[1][2] * src[2][3];
+	m[2][3] = -m[2][0] * src[0][3] - m[2][1] * src[1][3] - m[2][2] * src[2][3];
+
+	memcpy(inv, m, sizeof(Mtx));
+	return 1;
+}
+
+void  guMtxTranspose (Mtx src, Mtx xpose) {
+	Mtx m;
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			m[i][j] = src[j][i];
+		}
+		m[i][3] = 0.0f;
+	}
+	memcpy(xpose, m, sizeof(Mtx));
+}
+
+void  guLookAt (Mtx mt, guVector *camPos, guVector *camUp, guVector *target) {
+	guVector look, right, up;
+
+	look.x = camPos->x - target->x;
+	look.y = camPos->y - target->y;
+	look.z = camPos->z - target->z;
+	guVecNormalize(&look);
+
+	guVecCross(camUp, &look, &right);
+	guVecNormalize(&right);
+	guVecCross(&look, &right, &up);
+
+	mt[0][0] = right.x; mt[0][1] = right.y; mt[0][2] = right.z;
+	mt[0][3] = -(camPos->x * right.x + camPos->y * right.y + camPos->z * right.z);
+	mt[1][0] = up.x;    mt[1][1] = up.y;    mt[1][2] = up.z;
+	mt[1][3] = -(camPos->x * up.x + camPos->y * up.y + camPos->z * up.z);
+	mt[2][0] = look.x;  mt[2][1] = look.y;  mt[2][2] = look.z;
+	mt[2][3] = -(camPos->x * look.x + camPos->y * look.y + camPos->z * look.z);
+}
+
+void  guPerspective (Mtx44 mt, f32 fovy, f32 aspect, f32 n, f32 f) {
+	const f32 cot = 1.0f / tanf(DegToRad(fovy * 0.5f));
+	const f32 tmp = 1.0f / (f - n);
+
+	memset(mt, 0, sizeof(Mtx44));
+	mt[0][0] = cot / aspect;
+	mt[1][1] = cot;
+	mt[2][2] = -n * tmp;
+	mt[2][3] = -(f * n) * tmp;
+	mt[3][2] = -1.0f;
+}
+
+void  guOrtho (Mtx44 mt, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f) {
+	memset(mt, 0, sizeof(Mtx44));
+	mt[0][0] = 2.0f / (r - l);
+	mt[0][3] = -(r + l) / (r - l);
+	mt[1][1] = 2.0f / (t - b);
+	mt[1][3] = -(t + b) / (t - b);
+	mt[2][2] = -1.0f / (f - n);
+	mt[2][3] = -f / (f - n);
+	mt[3][3] = 1.0f;
+}
+
+void  guVecMultiply (Mtx mt, guVector *src, guVector *dst) {
+	const guVector v = *src;
+
+	dst->x = mt[0][0] * v.x + mt[0][1] * v.y + mt[0][2] * v.z + mt[0][3];
+	dst->y = mt[1][0] * v.x + mt[1][1] * v.y + mt[1][2] * v.z + mt[1][3];
+	dst->z = mt[2][0] * v.x + mt[2][1] * v.y + mt[2][2] * v.z + mt[2][3];
+}
+
+void  guVecMultiplySR (Mtx mt, guVector *src, guVector *dst) {
+	const guVector v = *src;
+
+	dst->x = mt[0][0] * v.x + mt[0][1] * v.y + mt[0][2] * v.z;
+	dst->y = mt[1][0] * v.x + mt[1][1] * v.y + mt[1][2] * v.z;
+	dst->z = mt[2][0] * v.x + mt[2][1] * v.y + mt[2][2] * v.z;
+}
+
+void  guVecNormalize (guVector *v) {
+	const f32 len = sqrtf(v->x * v->x + v->y * v->y + v->z * v->z);
+
+	if (len != 0.0f) {
+		v->x /= len;
+		v->y /= len;
+		v->z /= len;
+	}
+}
+
+void  guVecCross (guVector *a, guVector *b, guVector *axb) {
+	const guVector v = {
+		a->y * b->z - a->z * b->y,
+		a->z * b->x - a->x * b->z,
+		a->x * b->y - a->y * b->x
+	};
+	*axb = v;
+}
+
+f32  guVecDotProduct (guVector *a, guVector *b) {
+	return a->x * b->x + a->y * b->y + a->z * b->z;
+}
@@ -0,0 +1,976 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file gx.c
+ * Host stand-in for GX: records every call in a command buffer.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gccore.h>
+#include <gxhost.h>
+
+/**
+ * Structure to hold a growing list of command words.
+ */
+typedef  struct GXHost_stream {
+	u32  *words;     /**< Command words. */
+	u32  count;      /**< Number of words used. */
+	u32  capacity;   /**< Number of words allocated. */
+	u64  bytes;      /**< Estimated size in the GX FIFO. */
+} GXHost_stream;
+
+/**
+ * Structure to hold a recorded display list.
+ */
+typedef  struct GXHost_displayList {
+	const void                 *list;    /**< Buffer given to GX_BeginDispList. */
+	GXHost_stream              stream;   /**< Commands of the list. */
+	struct GXHost_displayList  *next;    /**< Next recorded display list. */
+} GXHost_displayList;
+
+static const u8 commandBytes[GXHOST_COMMAND_COUNT] = {
+	0,
+#define GXHOST_COMMAND(name, bytes)  bytes,
+	GXHOST_COMMANDS
+#undef GXHOST_COMMAND
+};
+
+static const char *commandNames[GXHOST_COMMAND_COUNT] = {
+	"NONE",
+#define GXHOST_COMMAND(name, bytes)  #name,
+	GXHOST_COMMANDS
+#undef GXHOST_COMMAND
+};
+
+static GXHost_stream       fifo;                 // Commands sent to the FIFO
+static GXHost_stream       *target = &fifo;      // Stream receiving commands
+static GXHost_displayList  *displayLists = NULL;
+static void                *recordingList = NULL;
+static u32                 recordingSize = 0;
+static GXHost_stream       recording;            // Commands of the display list being recorded
+
+static GXDrawDoneCallback  drawDoneCallback = NULL;
+
+static u8   vtxDesc[GX_VA_MAXATTR];
+static u32  vtxAttrFmt[GX_MAXVTXFMT][GX_VA_MAXATTR][3];
+static u32  scissor[4] = {0, 0, 640, 528};
+static u32  metric[2] = {GX_PERF0_NONE, GX_PERF1_NONE};
+static u32  metricVertices = 0;
+
+/**
+ * Get the bits of a float.
+ * @param f The float.
+ * @return The bits of the float.
+ */
+static inline u32  FloatBits (const f32 f) {
+	u32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+/**
+ * Make room for some words in a stream.
+ * @param stream The stream.
+ * @param words The number of words to add.
+ */
+static void  Reserve (GXHost_stream *stream, const u32 words) {
+	if (stream->count + words > stream->capacity) {
+		stream->capacity = (stream->capacity + words) * 2;
+		stream->words = realloc(stream->words, stream->capacity * sizeof(u32));
+		if (stream->words == NULL) {
+			abort();
+		}
+	}
+}
+
+/**
+ * Record a command.
+ * @param command The command.
+ * @param count The number of arguments.
+ * @param args The arguments.
+ */
+static void  Record (const GXHost_command command, const u32 count, const u32 *args) {
+	Reserve(target, count + 1);
+	target->words[target->count++] = (command << 16) | count;
+	memcpy(&target->words[target->count], args, count * sizeof(u32));
+	target->count += count;
+	target->bytes += commandBytes[command];
+}
+
+/**
+ * Record a command with its arguments given as u32 values.
+ * @param command The command.
+ * @param count The number of arguments.
+ */
+static void  RecordArgs (const GXHost_command command, const u32 count, ...) {
+	u32 args[16];
+	va_list ap;
+
+	va_start(ap, count);
+	for (u32 i = 0; i < count; i++) {
+		args[i] = va_arg(ap, u32);
+	}
+	va_end(ap);
+	Record(command, count, args);
+}
+
+/**
+ * Record a command with a pointer and u32 arguments.
+ * @param command The command.
+ * @param ptr The pointer, stored as two words.
+ * @param a The first u32 argument.
+ * @param b The second u32 argument.
+ */
+static void  RecordPtr (const GXHost_command command, const void *ptr, const u32 a, const u32 b) {
+	const u64 p = (u64)(uintptr_t)ptr;
+	RecordArgs(command, 4, (u32)p, (u32)(p >> 32), a, b);
+}
+
+/**
+ * Record a matrix command.
+ * @param command The command.
+ * @param m The matrix.
+ * @param floats The number of floats in the matrix.
+ * @param a An u32 argument.
+ */
+static void  RecordMtx (const GXHost_command command, const f32 *m, const u32 floats, const u32 a) {
+	u32 args[17];
+
+	for (u32 i = 0; i < floats; i++) {
+		args[i] = FloatBits(m[i]);
+	}
+	args[floats] = a;
+	Record(command, floats + 1, args);
+}
+
+//==============================================================================
+// Inspection
+//==============================================================================
+
+/**
+ * Forget the recorded commands, display lists and flushed ranges.
+ */
+void  GXHost_Reset (void) {
+	GXHost_ResetFlushes();
+	fifo.count = 0;
+	fifo.bytes = 0;
+	while (displayLists != NULL) {
+		GXHost_displayList *next = displayLists->next;
+		free(displayLists->stream.words);
+		free(displayLists);
+		displayLists = next;
+	}
+}
+
+/**
+ * Get the commands recorded since the last reset.
+ * @param words Receives the number of words.
+ * @return The command words.
+ */
+const u32*  GXHost_GetCommands (u32 *words) {
+	*words = fifo.count;
+	return fifo.words;
+}
+
+/**
+ * Count the occurrences of a command since the last reset.
+ * @param command The command to count.
+ * @return The number of occurrences.
+ */
+u32  GXHost_CountCommands (const GXHost_command command) {
+	u32 n = 0;
+
+	for (u32 i = 0; i < fifo.count; i += GXHOST_ARGS(fifo.words[i]) + 1) {
+		if (GXHOST_OP(fifo.words[i]) == command) {
+			n++;
+		}
+	}
+	return n;
+}
+
+/**
+ * Get the estimated number of bytes sent to the GX FIFO since the last reset.
+ * Display lists count when they are called, not when they are recorded.
+ * @return The number of bytes.
+ */
+u64  GXHost_GetFifoBytes (void) {
+	return fifo.bytes;
+}
+
+/**
+ * Get the estimated number of bytes a command takes in the GX FIFO.
+ * @param command The command.
+ * @return The number of bytes.
+ */
+u32  GXHost_GetCommandBytes (const GXHost_command command) {
+	return command < GXHOST_COMMAND_COUNT ? commandBytes[command] : 0;
+}
+
+/**
+ * Get the name of a command.
+ * @param command The command.
+ * @return The name of the command.
+ */
+const char*  GXHost_GetCommandName (const GXHost_command command) {
+	return command < GXHOST_COMMAND_COUNT ? commandNames[command] : "?";
+}
+
+/**
+ * Get the commands recorded in a display list.
+ * @param list The buffer given to GX_BeginDispList.
+ * @param words Receives the number of words.
+ * @return The command words, or NULL if no display list was recorded in this buffer.
+ */
+const u32*  GXHost_GetDisplayList (const void *list, u32 *words) {
+	for (GXHost_displayList *dl = displayLists; dl != NULL; dl = dl->next) {
+		if (dl->list == list) {
+			*words = dl->stream.count;
+			return dl->stream.words;
+		}
+	}
+	*words = 0;
+	return NULL;
+}
+
+/**
+ * Get the format of a vertex attribute.
+ * @param vtxfmt The vertex format.
+ * @param vtxattr The attribute.
+ * @param comptype Receives the component type.
+ * @param compsize Receives the component size.
+ * @param frac Receives the number of fractional bits.
+ */
+void  GXHost_GetVtxAttrFmt (u8 vtxfmt, u32 vtxattr, u32 *comptype, u32 *compsize, u32 *frac) {
+	*comptype = vtxAttrFmt[vtxfmt][vtxattr][0];
+	*compsize = vtxAttrFmt[vtxfmt][vtxattr][1];
+	*frac     = vtxAttrFmt[vtxfmt][vtxattr][2];
+}
+
+//==============================================================================
+// Setup and synchronisation
+//==============================================================================
+
+void*  GX_Init (void *base, u32 size) {
+	memset(vtxDesc, GX_NONE, sizeof(vtxDesc));
+	memset(vtxAttrFmt, 0, sizeof(vtxAttrFmt));
+	drawDoneCallback = NULL;
+	return base;
+}
+
+void  GX_AbortFrame (void) {
+}
+
+void  GX_Flush (void) {
+}
+
+void  GX_DrawDone (void) {
+	GX_SetDrawDone();
+}
+
+void  GX_SetDrawDone (void) {
+	Record(GXHOST_SETDRAWDONE, 0, NULL);
+	// The GPU is infinitely fast: the frame is done as soon as it is sent
+	if (drawDoneCallback != NULL && target == &fifo) {
+		drawDoneCallback();
+	}
+}
+
+void  GX_WaitDrawDone (void) {
+}
+
+GXDrawDoneCallback  GX_SetDrawDoneCallback (GXDrawDoneCallback cb) {
+	GXDrawDoneCallback old = drawDoneCallback;
+	drawDoneCallback = cb;
+	return old;
+}
+
+//==============================================================================
+// Vertices
+//==============================================================================
+
+void  GX_Begin (u8 primitive, u8 vtxfmt, u16 vtxcnt) {
+	RecordArgs(GXHOST_BEGIN, 3, (u32)primitive, (u32)vtxfmt, (u32)vtxcnt);
+	if (target == &fifo) {
+		metricVertices += vtxcnt;
+	}
+}
+
+void  GX_End (void) {
+	Record(GXHOST_END, 0, NULL);
+}
+
+void  GX_Position3f32 (f32 x, f32 y, f32 z) {
+	const u32 args[3] = {FloatBits(x), FloatBits(y), FloatBits(z)};
+	Record(GXHOST_POSITION3F32, 3, args);
+}
+
+void  GX_Position2f32 (f32 x, f32 y) {
+	const u32 args[2] = {FloatBits(x), FloatBits(y)};
+	Record(GXHOST_POSITION2F32, 2, args);
+}
+
+void  GX_Position3s16 (s16 x, s16 y, s16 z) {
+	const u32 args[3] = {(u32)(s32)x, (u32)(s32)y, (u32)(s32)z};
+	Record(GXHOST_POSITION3S16, 3, args);
+}
+
+void  GX_Position2s16 (s16 x, s16 y) {
+	const u32 args[2] = {(u32)(s32)x, (u32)(s32)y};
+	Record(GXHOST_POSITION2S16, 2, args);
+}
+
+void  GX_Position1x16 (u16 index) {
+	const u32 args[1] = {index};
+	Record(GXHOST_POSITION1X16, 1, args);
+}
+
+void  GX_Position1x8 (u8 index) {
+	const u32 args[1] = {index};
+	Record(GXHOST_POSITION1X8, 1, args);
+}
+
+void  GX_Normal3f32 (f32 nx, f32 ny, f32 nz) {
+	const u32 args[3] = {FloatBits(nx), FloatBits(ny), FloatBits(nz)};
+	Record(GXHOST_NORMAL3F32, 3, args);
+}
+
+void  GX_Normal1x16 (u16 index) {
+	const u32 args[1] = {index};
+	Record(GXHOST_NORMAL1X16, 1, args);
+}
+
+void  GX_Color1u32 (u32 clr) {
+	Record(GXHOST_COLOR1U32, 1, &clr);
+}
+
+void  GX_Color4u8 (u8 r, u8 g, u8 b, u8 a) {
+	const u32 args[1] = {((u32)r << 24) | ((u32)g << 16) | ((u32)b << 8) | a};
+	Record(GXHOST_COLOR4U8, 1, args);
+}
+
+void  GX_Color1x16 (u16 index) {
+	const u32 args[1] = {index};
+	Record(GXHOST_COLOR1X16, 1, args);
+}
+
+void  GX_TexCoord2f32 (f32 s, f32 t) {
+	const u32 args[2] = {FloatBits(s), FloatBits(t)};
+	Record(GXHOST_TEXCOORD2F32, 2, args);
+}
+
+void  GX_TexCoord2u16 (u16 s, u16 t) {
+	const u32 args[2] = {s, t};
+	Record(GXHOST_TEXCOORD2U16, 2, args);
+}
+
+void  GX_TexCoord2s16 (s16 s, s16 t) {
+	const u32 args[2] = {(u32)(s32)s, (u32)(s32)t};
+	Record(GXHOST_TEXCOORD2S16, 2, args);
+}
+
+void  GX_TexCoord1x16 (u16 index) {
+	const u32 args[1] = {index};
+	Record(GXHOST_TEXCOORD1X16, 1, args);
+}
+
+//==============================================================================
+// Vertex format
+//==============================================================================
+
+void  GX_SetVtxDesc (u8 attr, u8 type) {
+	if (attr < GX_VA_MAXATTR) {
+		vtxDesc[attr] = type;
+	}
+	RecordArgs(GXHOST_SETVTXDESC, 2, (u32)attr, (u32)type);
+}
+
+void  GX_GetVtxDesc (u8 attr, u8 *type) {
+	*type = attr < GX_VA_MAXATTR ? vtxDesc[attr] : GX_NONE;
+}
+
+void  GX_ClearVtxDesc (void) {
+	memset(vtxDesc, GX_NONE, sizeof(vtxDesc));
+	vtxDesc[GX_VA_POS] = GX_DIRECT;
+	Record(GXHOST_CLEARVTXDESC, 0, NULL);
+}
+
+void  GX_SetVtxAttrFmt (u8 vtxfmt, u32 vtxattr, u32 comptype, u32 compsize, u32 frac) {
+	if (vtxfmt < GX_MAXVTXFMT && vtxattr < GX_VA_MAXATTR) {
+		vtxAttrFmt[vtxfmt][vtxattr][0] = comptype;
+		vtxAttrFmt[vtxfmt][vtxattr][1] = compsize;
+		vtxAttrFmt[vtxfmt][vtxattr][2] = frac;
+	}
+	RecordArgs(GXHOST_SETVTXATTRFMT, 5, (u32)vtxfmt, vtxattr, comptype, compsize, frac);
+}
+
+void  GX_SetArray (u32 attr, void *ptr, u8 stride) {
+	RecordPtr(GXHOST_SETARRAY, ptr, attr, stride);
+}
+
+void  GX_InvVtxCache (void) {
+	Record(GXHOST_INVVTXCACHE, 0, NULL);
+}
+
+//==============================================================================
+// Matrices
+//==============================================================================
+
+void  GX_LoadPosMtxImm (Mtx mt, u32 pnidx) {
+	RecordMtx(GXHOST_LOADPOSMTX, &mt[0][0], 12, pnidx);
+}
+
+void  GX_LoadNrmMtxImm (Mtx mt, u32 pnidx) {
+	const f32 m[9] = {mt[0][0], mt[0][1], mt[0][2], mt[1][0], mt[1][1], mt[1][2], mt[2][0], mt[2][1], mt[2][2]};
+	RecordMtx(GXHOST_LOADNRMMTX, m, 9, pnidx);
+}
+
+void  GX_LoadTexMtxImm (Mtx mt, u32 texidx, u8 type) {
+	RecordMtx(GXHOST_LOADTEXMTX, &mt[0][0], type == GX_MTX2x4 ? 8 : 12, texidx);
+}
+
+void  GX_LoadProjectionMtx (Mtx44 mt, u8 type) {
+	RecordMtx(GXHOST_LOADPROJECTION, &mt[0][0], 16, type);
+}
+
+void  GX_SetCurrentMtx (u32 mtx) {
+	Record(GXHOST_SETCURRENTMTX, 1, &mtx);
+}
+
+//==============================================================================
+// Textures
+//==============================================================================
+
+/*
+ * Layout of a host GXTexObj:
+ * val[0..1] physical image address, val[2] width, val[3] height, val[4] format,
+ * val[5] wrap S | wrap T << 8 | mipmap << 16, val[6] filters | max anisotropy << 16, val[7] TLUT,
+ * val[8..9] user data (not sent to the GPU), val[10] minimum | maximum LOD << 16 in 8.8 fixed point, val[11] LOD bias.
+ * Layout of a host GXTlutObj: val[0..1] table pointer, val[2] format | entries << 16.
+ */
+
+void  GX_InitTexObj (GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap) {
+	const u64 p = (u64)MEM_VIRTUAL_TO_PHYSICAL(img_ptr);
+
+	memset(obj, 0, sizeof(GXTexObj));
+	obj->val[0] = (u32)p;
+	obj->val[1] = (u32)(p >> 32);
+	obj->val[2] = wd;
+	obj->val[3] = ht;
+	obj->val[4] = fmt;
+	obj->val[5] = wrap_s | (wrap_t << 8) | (mipmap << 16);
+	obj->val[6] = mipmap ? (GX_LIN_MIP_LIN | (GX_LINEAR << 8)) : (GX_LINEAR | (GX_LINEAR << 8));
+	if (mipmap) {
+		u32 maxlod = 0;
+
+		while ((wd | ht) >> (maxlod + 1)) {
+			maxlod++;
+		}
+		obj->val[10] = (maxlod * 256) << 16;
+	}
+}
+
+void  GX_InitTexObjCI (GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap, u32 tlut_name) {
+	GX_InitTexObj(obj, img_ptr, wd, ht, fmt, wrap_s, wrap_t, mipmap);
+	obj->val[7] = tlut_name;
+}
+
+void  GX_InitTexObjLOD (GXTexObj *obj, u8 minfilt, u8 magfilt, f32 minlod, f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod, u8 maxaniso) {
+	obj->val[6] = minfilt | (magfilt << 8) | (maxaniso << 16);
+	obj->val[10] = (u32)(minlod * 256.0f) | ((u32)(maxlod * 256.0f) << 16);
+	memcpy(&obj->val[11], &lodbias, sizeof(f32));
+}
+
+void  GX_InitTexObjWrapMode (GXTexObj *obj, u8 wrap_s, u8 wrap_t) {
+	obj->val[5] = (obj->val[5] & 0xFFFF0000) | wrap_s | (wrap_t << 8);
+}
+
+u8  GX_GetTexObjWrapS (GXTexObj *obj) {
+	return obj->val[5] & 0xFF;
+}
+
+u8  GX_GetTexObjWrapT (GXTexObj *obj) {
+	return (obj->val[5] >> 8) & 0xFF;
+}
+
+void  GX_InitTexObjData (GXTexObj *obj, void *img_ptr) {
+	const u64 p = (u64)MEM_VIRTUAL_TO_PHYSICAL(img_ptr);
+
+	obj->val[0] = (u32)p;
+	obj->val[1] = (u32)(p >> 32);
+}
+
+f32  GX_GetTexObjMinLOD (GXTexObj *obj) {
+	return (obj->val[10] & 0xFFFF) / 256.0f;
+}
+
+f32  GX_GetTexObjMaxLOD (GXTexObj *obj) {
+	return (obj->val[10] >> 16) / 256.0f;
+}
+
+f32  GX_GetTexObjLODBias (GXTexObj *obj) {
+	f32 bias;
+
+	memcpy(&bias, &obj->val[11], sizeof(f32));
+	return bias;
+}
+
+u8  GX_GetTexObjMinFilt (GXTexObj *obj) {
+	return obj->val[6] & 0xFF;
+}
+
+void  GX_InitTexObjFilterMode (GXTexObj *obj, u8 minfilt, u8 magfilt) {
+	obj->val[6] = (obj->val[6] & 0xFFFF0000) | minfilt | (magfilt << 8);
+}
+
+void*  GX_GetTexObjData (GXTexObj *obj) {
+	return (void*)(uintptr_t)((u64)obj->val[0] | ((u64)obj->val[1] << 32));
+}
+
+u16  GX_GetTexObjWidth (GXTexObj *obj) {
+	return obj->val[2];
+}
+
+u16  GX_GetTexObjHeight (GXTexObj *obj) {
+	return obj->val[3];
+}
+
+u32  GX_GetTexObjFmt (GXTexObj *obj) {
+	return obj->val[4];
+}
+
+u8  GX_GetTexObjMipMap (GXTexObj *obj) {
+	return (obj->val[5] >> 16) & 0xFF;
+}
+
+void  GX_InitTexObjUserData (GXTexObj *obj, void *userdata) {
+	const u64 p = (u64)(uintptr_t)userdata;
+
+	obj->val[8] = (u32)p;
+	obj->val[9] = (u32)(p >> 32);
+}
+
+void*  GX_GetTexObjUserData (GXTexObj *obj) {
+	return (void*)(uintptr_t)((u64)obj->val[8] | ((u64)obj->val[9] << 32));
+}
+
+u32  GX_GetTexObjTlut (GXTexObj *obj) {
+	return obj->val[7];
+}
+
+u32  GX_GetTexBufferSize (u16 wd, u16 ht, u32 fmt, u8 mipmap, u8 maxlod) {
+	u32 tileW, tileH, tileBytes = 32, size = 0;
+
+	switch (fmt) {
+		case GX_TF_I4: case GX_TF_CI4: case GX_TF_CMPR:
+			tileW = 8; tileH = 8; break;
+		case GX_TF_I8: case GX_TF_IA4: case GX_TF_CI8:
+			tileW = 8; tileH = 4; break;
+		case GX_TF_RGBA8:
+			tileW = 4; tileH = 4; tileBytes = 64; break;
+		default:
+			tileW = 4; tileH = 4; break;
+	}
+	if (mipmap == GX_FALSE) {
+		maxlod = 1;
+	}
+	for (u32 level = 0; level < maxlod; level++) {
+		size += ((wd + tileW - 1) / tileW) * ((ht + tileH - 1) / tileH) * tileBytes;
+		if (wd == 1 && ht == 1) {
+			break;
+		}
+		wd = wd > 1 ? wd >> 1 : 1;
+		ht = ht > 1 ? ht >> 1 : 1;
+	}
+	return size;
+}
+
+void  GX_LoadTexObj (GXTexObj *obj, u8 mapid) {
+	u32 args[11];
+
+	memcpy(args, obj->val, 8 * sizeof(u32));
+	args[8] = obj->val[10];
+	args[9] = obj->val[11];
+	args[10] = mapid;
+	Record(GXHOST_LOADTEXOBJ, 11, args);
+}
+
+void  GX_InitTlutObj (GXTlutObj *obj, void *lut, u8 fmt, u16 entries) {
+	const u64 p = (u64)(uintptr_t)lut;
+
+	obj->val[0] = (u32)p;
+	obj->val[1] = (u32)(p >> 32);
+	obj->val[2] = fmt | ((u32)entries << 16);
+}
+
+void  GX_LoadTlut (GXTlutObj *obj, u32 tlut_name) {
+	const u32 args[4] = { obj->val[0], obj->val[1], obj->val[2], tlut_name };
+
+	Record(GXHOST_LOADTLUT, 4, args);
+}
+
+void  GX_InvalidateTexAll (void) {
+	Record(GXHOST_INVALIDATETEXALL, 0, NULL);
+}
+
+//==============================================================================
+// TEV and lighting
+//==============================================================================
+
+void  GX_SetTevOp (u8 tevstage, u8 mode) {
+	RecordArgs(GXHOST_SETTEVOP, 2, (u32)tevstage, (u32)mode);
+}
+
+void  GX_SetTevOrder (u8 tevstage, u8 texcoord, u32 texmap, u8 color) {
+	RecordArgs(GXHOST_SETTEVORDER, 4, (u32)tevstage, (u32)texcoord, texmap, (u32)color);
+}
+
+void  GX_SetTevColorIn (u8 tevstage, u8 a, u8 b, u8 c, u8 d) {
+	RecordArgs(GXHOST_SETTEVCOLORIN, 5, (u32)tevstage, (u32)a, (u32)b, (u32)c, (u32)d);
+}
+
+void  GX_SetTevAlphaIn (u8 tevstage, u8 a, u8 b, u8 c, u8 d) {
+	RecordArgs(GXHOST_SETTEVALPHAIN, 5, (u32)tevstage, (u32)a, (u32)b, (u32)c, (u32)d);
+}
+
+void  GX_SetTevColorOp (u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid) {
+	RecordArgs(GXHOST_SETTEVCOLOROP, 6, (u32)tevstage, (u32)tevop, (u32)tevbias, (u32)tevscale, (u32)clamp, (u32)tevregid);
+}
+
+void  GX_SetTevAlphaOp (u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid) {
+	RecordArgs(GXHOST_SETTEVALPHAOP, 6, (u32)tevstage, (u32)tevop, (u32)tevbias, (u32)tevscale, (u32)clamp, (u32)tevregid);
+}
+
+void  GX_SetTevKColor (u8 sel, GXColor col) {
+	RecordArgs(GXHOST_SETTEVKCOLOR, 2, (u32)sel, ((u32)col.r << 24) | ((u32)col.g << 16) | ((u32)col.b << 8) | col.a);
+}
+
+void  GX_SetTevKColorSel (u8 tevstage, u8 sel) {
+	RecordArgs(GXHOST_SETTEVKCOLORSEL, 2, (u32)tevstage, (u32)sel);
+}
+
+void  GX_SetTevKAlphaSel (u8 tevstage, u8 sel) {
+	RecordArgs(GXHOST_SETTEVKALPHASEL, 2, (u32)tevstage, (u32)sel);
+}
+
+void  GX_SetNumTevStages (u8 num) {
+	RecordArgs(GXHOST_SETNUMTEVSTAGES, 1, (u32)num);
+}
+
+void  GX_SetNumChans (u8 num) {
+	RecordArgs(GXHOST_SETNUMCHANS, 1, (u32)num);
+}
+
+void  GX_SetNumTexGens (u32 nr) {
+	Record(GXHOST_SETNUMTEXGENS, 1, &nr);
+}
+
+void  GX_SetTexCoordGen (u16 texcoord, u32 tgen_typ, u32 tgen_src, u32 mtxsrc) {
+	RecordArgs(GXHOST_SETTEXCOORDGEN, 4, (u32)texcoord, tgen_typ, tgen_src, mtxsrc);
+}
+
+void  GX_SetChanCtrl (s32 channel, u8 enable, u8 ambsrc, u8 matsrc, u8 litmask, u8 diff_fn, u8 attn_fn) {
+	RecordArgs(GXHOST_SETCHANCTRL, 7, (u32)channel, (u32)enable, (u32)ambsrc, (u32)matsrc, (u32)litmask, (u32)diff_fn, (u32)attn_fn);
+}
+
+void  GX_SetChanAmbColor (s32 channel, GXColor color) {
+	RecordArgs(GXHOST_SETCHANAMBCOLOR, 2, (u32)channel, ((u32)color.r << 24) | ((u32)color.g << 16) | ((u32)color.b << 8) | color.a);
+}
+
+void  GX_SetChanMatColor (s32 channel, GXColor color) {
+	RecordArgs(GXHOST_SETCHANMATCOLOR, 2, (u32)channel, ((u32)color.r << 24) | ((u32)color.g << 16) | ((u32)color.b << 8) | color.a);
+}
+
+void  GX_InitLightPos (GXLightObj *lit_obj, f32 x, f32 y, f32 z) {
+	lit_obj->val[0] = FloatBits(x);
+	lit_obj->val[1] = FloatBits(y);
+	lit_obj->val[2] = FloatBits(z);
+}
+
+void  GX_InitLightPosv (GXLightObj *lit_obj, guVector *pos) {
+	GX_InitLightPos(lit_obj, pos->x, pos->y, pos->z);
+}
+
+void  GX_InitLightDir (GXLightObj *lit_obj, f32 nx, f32 ny, f32 nz) {
+	lit_obj->val[3] = FloatBits(nx);
+	lit_obj->val[4] = FloatBits(ny);
+	lit_obj->val[5] = FloatBits(nz);
+}
+
+void  GX_InitLightDirv (GXLightObj *lit_obj, guVector *dir) {
+	GX_InitLightDir(lit_obj, dir->x, dir->y, dir->z);
+}
+
+void  GX_InitLightColor (GXLightObj *lit_obj, GXColor col) {
+	lit_obj->val[6] = ((u32)col.r << 24) | ((u32)col.g << 16) | ((u32)col.b << 8) | col.a;
+}
+
+void  GX_InitLightAttn (GXLightObj *lit_obj, f32 a0, f32 a1, f32 a2, f32 k0, f32 k1, f32 k2) {
+	lit_obj->val[7]  = FloatBits(a0);
+	lit_obj->val[8]  = FloatBits(a1);
+	lit_obj->val[9]  = FloatBits(a2);
+	lit_obj->val[10] = FloatBits(k0);
+	lit_obj->val[11] = FloatBits(k1);
+	lit_obj->val[12] = FloatBits(k2);
+}
+
+void  GX_InitLightSpot (GXLightObj *lit_obj, f32 cut_off, u8 spotfn) {
+	f32 a0 = 1.0f, a1 = 0.0f, a2 = 0.0f;
+
+	if (cut_off > 0.0f && cut_off <= 90.0f && spotfn != GX_SP_OFF) {
+		const f32 cr = cosf(DegToRad(cut_off));
+		a0 = -1000.0f * cr;
+		a1 = 1000.0f;
+	}
+	lit_obj->val[7] = FloatBits(a0);
+	lit_obj->val[8] = FloatBits(a1);
+	lit_obj->val[9] = FloatBits(a2);
+}
+
+void  GX_InitLightDistAttn (GXLightObj *lit_obj, f32 ref_dist, f32 ref_brite, u8 dist_fn) {
+	f32 k0 = 1.0f, k1 = 0.0f, k2 = 0.0f;
+
+	if (ref_dist > 0.0f && ref_brite > 0.0f && ref_brite < 1.0f) {
+		switch (dist_fn) {
+			case GX_DA_GENTLE: k1 = (1.0f - ref_brite) / (ref_brite * ref_dist); break;
+			case GX_DA_MEDIUM: k1 = 0.5f * (1.0f - ref_brite) / (ref_brite * ref_dist);
+			                   k2 = 0.5f * (1.0f - ref_brite) / (ref_brite * ref_dist * ref_dist); break;
+			case GX_DA_STEEP:  k2 = (1.0f - ref_brite) / (ref_brite * ref_dist * ref_dist); break;
+			default: break;
+		}
+	}
+	lit_obj->val[10] = FloatBits(k0);
+	lit_obj->val[11] = FloatBits(k1);
+	lit_obj->val[12] = FloatBits(k2);
+}
+
+void  GX_InitLightShininess (GXLightObj *lit_obj, f32 shininess) {
+	GX_InitLightAttn(lit_obj, 0.0f, 0.0f, 1.0f, shininess / 2.0f, 0.0f, 1.0f - shininess / 2.0f);
+}
+
+void  GX_InitSpecularDirv (GXLightObj *lit_obj, guVector *vec) {
+	GX_InitLightDirv(lit_obj, vec);
+}
+
+void  GX_LoadLightObj (GXLightObj *lit_obj, u8 lit_id) {
+	u32 args[17];
+
+	memcpy(args, lit_obj->val, sizeof(lit_obj->val));
+	args[16] = lit_id;
+	Record(GXHOST_LOADLIGHTOBJ, 17, args);
+}
+
+//==============================================================================
+// Pixel engine and copies
+//==============================================================================
+
+void  GX_SetBlendMode (u8 type, u8 src_fact, u8 dst_fact, u8 op) {
+	RecordArgs(GXHOST_SETBLENDMODE, 4, (u32)type, (u32)src_fact, (u32)dst_fact, (u32)op);
+}
+
+void  GX_SetZMode (u8 enable, u8 func, u8 update_enable) {
+	RecordArgs(GXHOST_SETZMODE, 3, (u32)enable, (u32)func, (u32)update_enable);
+}
+
+void  GX_SetColorUpdate (u8 enable) {
+	RecordArgs(GXHOST_SETCOLORUPDATE, 1, (u32)enable);
+}
+
+void  GX_SetAlphaUpdate (u8 enable) {
+	RecordArgs(GXHOST_SETALPHAUPDATE, 1, (u32)enable);
+}
+
+void  GX_SetAlphaCompare (u8 comp0, u8 ref0, u8 aop, u8 comp1, u8 ref1) {
+	RecordArgs(GXHOST_SETALPHACOMPARE, 5, (u32)comp0, (u32)ref0, (u32)aop, (u32)comp1, (u32)ref1);
+}
+
+void  GX_SetCullMode (u8 mode) {
+	RecordArgs(GXHOST_SETCULLMODE, 1, (u32)mode);
+}
+
+void  GX_SetClipMode (u8 mode) {
+	RecordArgs(GXHOST_SETCLIPMODE, 1, (u32)mode);
+}
+
+void  GX_SetScissor (u32 xorigin, u32 yorigin, u32 wd, u32 ht) {
+	scissor[0] = xorigin;
+	scissor[1] = yorigin;
+	scissor[2] = wd;
+	scissor[3] = ht;
+	Record(GXHOST_SETSCISSOR, 4, scissor);
+}
+
+void  GX_GetScissor (u32 *xorigin, u32 *yorigin, u32 *wd, u32 *ht) {
+	*xorigin = scissor[0];
+	*yorigin = scissor[1];
+	*wd = scissor[2];
+	*ht = scissor[3];
+}
+
+void  GX_SetViewport (f32 xorig, f32 yorig, f32 wd, f32 ht, f32 nearz, f32 farz) {
+	const u32 args[6] = {FloatBits(xorig), FloatBits(yorig), FloatBits(wd), FloatBits(ht), FloatBits(nearz), FloatBits(farz)};
+	Record(GXHOST_SETVIEWPORT, 6, args);
+}
+
+void  GX_SetPointSize (u8 width, u8 fmt) {
+	RecordArgs(GXHOST_SETPOINTSIZE, 2, (u32)width, (u32)fmt);
+}
+
+void  GX_SetLineWidth (u8 width, u8 fmt) {
+	RecordArgs(GXHOST_SETLINEWIDTH, 2, (u32)width, (u32)fmt);
+}
+
+void  GX_SetCopyClear (GXColor color, u32 zvalue) {
+	RecordArgs(GXHOST_SETCOPYCLEAR, 2, ((u32)color.r << 24) | ((u32)color.g << 16) | ((u32)color.b << 8) | color.a, zvalue);
+}
+
+void  GX_SetPixelFmt (u8 pix_fmt, u8 z_fmt) {
+	RecordArgs(GXHOST_SETPIXELFMT, 2, (u32)pix_fmt, (u32)z_fmt);
+}
+
+void  GX_SetCopyFilter (u8 aa, u8 sample_pattern[12][2], u8 vf, u8 vfilter[7]) {
+	RecordArgs(GXHOST_SETCOPYFILTER, 2, (u32)aa, (u32)vf);
+}
+
+void  GX_SetFieldMode (u8 field_mode, u8 half_aspect_ratio) {
+	RecordArgs(GXHOST_SETFIELDMODE, 2, (u32)field_mode, (u32)half_aspect_ratio);
+}
+
+void  GX_SetDispCopyGamma (u8 gamma) {
+}
+
+void  GX_SetDispCopySrc (u16 left, u16 top, u16 wd, u16 ht) {
+	RecordArgs(GXHOST_SETDISPCOPYSRC, 4, (u32)left, (u32)top, (u32)wd, (u32)ht);
+}
+
+void  GX_SetDispCopyDst (u16 wd, u16 ht) {
+	RecordArgs(GXHOST_SETDISPCOPYDST, 2, (u32)wd, (u32)ht);
+}
+
+u32  GX_SetDispCopyYScale (f32 yscale) {
+	const u32 lines = (u32)(528 * yscale);  // Lines of a 528 lines EFB after scaling
+	RecordArgs(GXHOST_SETDISPCOPYYSCALE, 1, FloatBits(yscale));
+	return lines;
+}
+
+f32  GX_GetYScaleFactor (u16 efbheight, u16 xfbheight) {
+	return (f32)xfbheight / (f32)efbheight;
+}
+
+void  GX_CopyDisp (void *dest, u8 clear) {
+	RecordPtr(GXHOST_COPYDISP, dest, clear, 0);
+}
+
+void  GX_SetTexCopySrc (u16 left, u16 top, u16 wd, u16 ht) {
+	RecordArgs(GXHOST_SETTEXCOPYSRC, 4, (u32)left, (u32)top, (u32)wd, (u32)ht);
+}
+
+void  GX_SetTexCopyDst (u16 wd, u16 ht, u32 fmt, u8 mipmap) {
+	RecordArgs(GXHOST_SETTEXCOPYDST, 4, (u32)wd, (u32)ht, fmt, (u32)mipmap);
+}
+
+void  GX_CopyTex (void *dest, u8 clear) {
+	RecordPtr(GXHOST_COPYTEX, dest, clear, 0);
+}
+
+void  GX_PixModeSync (void) {
+	Record(GXHOST_PIXMODESYNC, 0, NULL);
+}
+
+void  GX_PokeAlphaRead (u8 mode) {
+}
+
+//==============================================================================
+// Display lists
+//==============================================================================
+
+void  GX_BeginDispList (void *list, u32 size) {
+	recordingList = list;
+	recordingSize = size;
+	recording.count = 0;
+	recording.bytes = 0;
+	target = &recording;
+}
+
+u32  GX_EndDispList (void) {
+	GXHost_displayList *dl;
+	const u32 bytes = (recording.bytes + 31) & ~31;  // The list is padded to 32 bytes
+
+	target = &fifo;
+	if (bytes > recordingSize) {
+		return 0;
+	}
+
+	for (dl = displayLists; dl != NULL && dl->list != recordingList; dl = dl->next);
+	if (dl == NULL) {
+		dl = calloc(1, sizeof(GXHost_displayList));
+		dl->list = recordingList;
+		dl->next = displayLists;
+		displayLists = dl;
+	}
+	dl->stream.count = 0;
+	Reserve(&dl->stream, recording.count);
+	memcpy(dl->stream.words, recording.words, recording.count * sizeof(u32));
+	dl->stream.count = recording.count;
+	dl->stream.bytes = recording.bytes;
+	return bytes;
+}
+
+void  GX_CallDispList (void *list, u32 nbytes) {
+	RecordPtr(GXHOST_CALLDISPLIST, list, nbytes, 0);
+
+	// The commands of the list go through the GPU too
+	for (GXHost_displayList *dl = displayLists; dl != NULL; dl = dl->next) {
+		if (dl->list == list) {
+			fifo.bytes += dl->stream.bytes;
+			for (u32 i = 0; i < dl->stream.count; i += GXHOST_ARGS(dl->stream.words[i]) + 1) {
+				if (GXHOST_OP(dl->stream.words[i]) == GXHOST_BEGIN) {
+					metricVertices += dl->stream.words[i + 3];
+				}
+			}
+			break;
+		}
+	}
+}
+
+//==============================================================================
+// Performance metrics
+//==============================================================================
+
+void  GX_SetGPMetric (u32 perf0, u32 perf1) {
+	metric[0] = perf0;
+	metric[1] = perf1;
+	RecordArgs(GXHOST_SETGPMETRIC, 2, perf0, perf1);
+}
+
+void  GX_ReadGPMetric (u32 *cnt0, u32 *cnt1) {
+	// Only the vertex counters are emulated
+	*cnt0 = metric[0] == GX_PERF0_VERTICES ? metricVertices : 0;
+	*cnt1 = metric[1] == GX_PERF1_VERTICES ? metricVertices : 0;
+}
+
+void  GX_ClearGPMetric (void) {
+	metricVertices = 0;
+}
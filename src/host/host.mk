@@ -0,0 +1,70 @@
+#---------------------------------------------------------------------------------
+# Host (Linux) build: compiles the library against the command-recording GX
+# stand-in in host/, and builds the unit tests and benchmarks.
+#
+#   make GRRLIB_PLATFORM=host          build libgrrlib-mod-host.a
+#   make GRRLIB_PLATFORM=host check    build and run the unit tests
+#   make GRRLIB_PLATFORM=host bench    build and run the benchmarks
+#---------------------------------------------------------------------------------
+
+CC		?=	gcc
+CXX		?=	g++
+
+BUILD	:=	host/build
+INCLUDE	:=	-Ihost/include -I. -I/usr/include/freetype2
+CFLAGS	:=	-O2 -g -Wall -MMD -MP $(INCLUDE)
+CXXFLAGS:=	-O2 -g -Wall -MMD -MP $(INCLUDE)
+LIBS	:=	-lpng -ljpeg -lfreetype -lpthread -lm
+
+LIB		:=	grrlib-mod-host
+CFILES	:=	$(wildcard *.c) $(wildcard host/*.c)
+OFILES	:=	$(addprefix $(BUILD)/,$(notdir $(CFILES:.c=.o)))
+ARC		:=	$(BUILD)/lib$(LIB).a
+
+TESTS	:=	$(wildcard host/tests/*.cpp)
+TESTOBJ	:=	$(addprefix $(BUILD)/tests/,$(notdir $(TESTS:.cpp=.o)))
+TESTBIN	:=	$(BUILD)/grrlib-tests
+
+BENCH	:=	$(wildcard host/bench/*.cpp)
+BENCHOBJ:=	$(addprefix $(BUILD)/bench/,$(notdir $(BENCH:.cpp=.o)))
+BENCHBIN:=	$(BUILD)/grrlib-bench
+
+vpath %.c . host
+
+.PHONY: all check bench clean
+
+all : $(ARC)
+
+$(ARC) : $(OFILES)
+	$(AR) rcs $@ $^
+
+$(BUILD)/%.o : %.c | $(BUILD)
+	$(CC) $(CFLAGS) -c $< -o $@
+
+$(BUILD)/tests/%.o : host/tests/%.cpp | $(BUILD)
+	@mkdir -p $(BUILD)/tests
+	$(CXX) $(CXXFLAGS) -c $< -o $@
+
+$(BUILD)/bench/%.o : host/bench/%.cpp | $(BUILD)
+	@mkdir -p $(BUILD)/bench
+	$(CXX) $(CXXFLAGS) -c $< -o $@
+
+$(BUILD) :
+	@mkdir -p $@
+
+$(TESTBIN) : $(TESTOBJ) $(ARC)
+	$(CXX) $^ -o $@ -lgtest_main -lgtest $(LIBS)
+
+$(BENCHBIN) : $(BENCHOBJ) $(BUILD)/tests/test_images.o $(ARC)
+	$(CXX) $^ -o $@ -lbenchmark_main -lbenchmark $(LIBS)
+
+check : $(TESTBIN)
+	./$(TESTBIN)
+
+bench : $(BENCHBIN)
+	./$(BENCHBIN)
+
+clean :
+	rm -rf $(BUILD)
+
+-include $(OFILES:.o=.d) $(TESTOBJ:.o=.d) $(BENCHOBJ:.o=.d)
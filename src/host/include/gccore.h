@@ -0,0 +1,639 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file gccore.h
+ * Host stand-in for the parts of libogc used by GRRLIB.
+ * GX calls are recorded in a command buffer (see gxhost.h) instead of being sent to a GPU,
+ * frame buffers are plain memory and vertical retraces are simulated.
+ * Only used by the host build (make GRRLIB_PLATFORM=host).
+ */
+
+#ifndef __GCCORE_H__
+#define __GCCORE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+
+#ifdef __cplusplus
+   extern "C" {
+#endif /* __cplusplus */
+
+//==============================================================================
+// Types
+//==============================================================================
+typedef uint8_t   u8;
+typedef uint16_t  u16;
+typedef uint32_t  u32;
+typedef uint64_t  u64;
+typedef int8_t    s8;
+typedef int16_t   s16;
+typedef int32_t   s32;
+typedef int64_t   s64;
+typedef float     f32;
+typedef double    f64;
+typedef volatile u8   vu8;
+typedef volatile u16  vu16;
+typedef volatile u32  vu32;
+
+typedef f32  Mtx[3][4];
+typedef f32  (*MtxP)[4];
+typedef f32  Mtx44[4][4];
+typedef f32  (*Mtx44P)[4];
+
+typedef struct _vecf {
+	f32 x, y, z;
+} guVector;
+
+typedef struct _gx_color {
+	u8 r, g, b, a;
+} GXColor;
+
+typedef struct _gx_texobj {
+	u32 val[12];
+} GXTexObj;
+
+typedef struct _gx_tlutobj {
+	u32 val[3];
+} GXTlutObj;
+
+typedef struct _gx_litobj {
+	u32 val[16];
+} GXLightObj;
+
+typedef struct _gx_rmodeobj {
+	u32 viTVMode;
+	u16 fbWidth;
+	u16 efbHeight;
+	u16 xfbHeight;
+	u16 viXOrigin;
+	u16 viYOrigin;
+	u16 viWidth;
+	u16 viHeight;
+	u32 xfbMode;
+	u8  field_rendering;
+	u8  aa;
+	u8  sample_pattern[12][2];
+	u8  vfilter[7];
+} GXRModeObj;
+
+typedef struct _tplfile {
+	int   type;
+	int   ntextures;
+	void *texdesc;
+	void *tpl_file;
+} TPLFile;
+
+typedef void (*GXDrawDoneCallback)(void);
+typedef void (*VIRetraceCallback)(u32 retraceCnt);
+
+typedef u32 lwp_t;
+typedef u32 mutex_t;
+typedef u32 cond_t;
+typedef u32 lwpq_t;
+
+#define LWP_THREAD_NULL   0xffffffff
+#define LWP_MUTEX_NULL    0xffffffff
+#define LWP_COND_NULL     0xffffffff
+#define LWP_TQUEUE_NULL   0xffffffff
+
+#define ATTRIBUTE_ALIGN(v)  __attribute__((aligned(v)))
+#define ATTRIBUTE_PACKED    __attribute__((packed))
+
+#define M_DTOR          (3.14159265358979323846/180.0)
+#define DegToRad(a)     ((a) * 0.01745329252f)
+#define RadToDeg(a)     ((a) * 57.29577951f)
+
+#define MEM_K0_TO_K1(x) ((void*)(x))
+#define MEM_K1_TO_K0(x) ((void*)(x))
+
+// Like the console, GX keeps physical addresses: they are offset from the pointers so that the CPU can not use them
+#define SYS_BASE_CACHED             (0x80000000)
+#define MEM_VIRTUAL_TO_PHYSICAL(x)  ((uintptr_t)(x) - SYS_BASE_CACHED)
+#define MEM_PHYSICAL_TO_K0(x)       ((void*)((uintptr_t)(x) + SYS_BASE_CACHED))
+
+//==============================================================================
+// GX constants
+//==============================================================================
+#define GX_FALSE          0
+#define GX_TRUE           1
+#define GX_DISABLE        0
+#define GX_ENABLE         1
+
+#define GX_FIFO_MINSIZE   (64*1024)
+
+#define GX_NONE           0
+#define GX_DIRECT         1
+#define GX_INDEX8         2
+#define GX_INDEX16        3
+
+#define GX_QUADS          0x80
+#define GX_TRIANGLES      0x90
+#define GX_TRIANGLESTRIP  0x98
+#define GX_TRIANGLEFAN    0xA0
+#define GX_LINES          0xA8
+#define GX_LINESTRIP      0xB0
+#define GX_POINTS         0xB8
+
+#define GX_VTXFMT0        0
+#define GX_VTXFMT1        1
+#define GX_VTXFMT2        2
+#define GX_MAXVTXFMT      8
+
+#define GX_PNMTX0         0
+#define GX_PNMTX1         3
+#define GX_TEXMTX0        30
+#define GX_IDENTITY       60
+#define GX_MTX3x4         0
+#define GX_MTX2x4         1
+
+#define GX_VA_PTNMTXIDX   0
+#define GX_VA_TEX0MTXIDX  1
+#define GX_VA_POS         9
+#define GX_VA_NRM         10
+#define GX_VA_CLR0        11
+#define GX_VA_CLR1        12
+#define GX_VA_TEX0        13
+#define GX_VA_TEX1        14
+#define GX_VA_MAXATTR     26
+#define GX_VA_NULL        0xff
+
+#define GX_POS_XY         0
+#define GX_POS_XYZ        1
+#define GX_NRM_XYZ        0
+#define GX_CLR_RGB        0
+#define GX_CLR_RGBA       1
+#define GX_TEX_S          0
+#define GX_TEX_ST         1
+
+#define GX_U8             0
+#define GX_S8             1
+#define GX_U16            2
+#define GX_S16            3
+#define GX_F32            4
+#define GX_RGB565         0
+#define GX_RGB8           1
+#define GX_RGBX8          2
+#define GX_RGBA4          3
+#define GX_RGBA6          4
+#define GX_RGBA8          5
+
+#define GX_TEVSTAGE0      0
+#define GX_TEVSTAGE1      1
+#define GX_MODULATE       0
+#define GX_DECAL          1
+#define GX_BLEND          2
+#define GX_REPLACE        3
+#define GX_PASSCLR        4
+
+#define GX_TEXCOORD0      0
+#define GX_TEXCOORD1      1
+#define GX_TEXCOORDNULL   0xff
+#define GX_TEXMAP0        0
+#define GX_TEXMAP1        1
+#define GX_TEXMAP_NULL    0xff
+#define GX_COLOR0         0
+#define GX_COLOR1         1
+#define GX_ALPHA0         2
+#define GX_ALPHA1         3
+#define GX_COLOR0A0       4
+#define GX_COLOR1A1       5
+#define GX_COLORZERO      6
+#define GX_COLORNULL      0xff
+
+#define GX_TG_MTX3x4      0
+#define GX_TG_MTX2x4      1
+#define GX_TG_POS         0
+#define GX_TG_NRM         1
+#define GX_TG_TEX0        4
+
+#define GX_TF_I4          0x0
+#define GX_TF_I8          0x1
+#define GX_TF_IA4         0x2
+#define GX_TF_IA8         0x3
+#define GX_TF_RGB565      0x4
+#define GX_TF_RGB5A3      0x5
+#define GX_TF_RGBA8       0x6
+#define GX_TF_CI4         0x8
+#define GX_TF_CI8         0x9
+#define GX_TF_CI14        0xa
+#define GX_TF_CMPR        0xE
+
+#define GX_TL_IA8         0
+#define GX_TL_RGB565      1
+#define GX_TL_RGB5A3      2
+#define GX_TLUT0          0
+
+#define GX_CLAMP          0
+#define GX_REPEAT         1
+#define GX_MIRROR         2
+
+#define GX_NEAR           0
+#define GX_LINEAR         1
+#define GX_NEAR_MIP_NEAR  2
+#define GX_LIN_MIP_NEAR   3
+#define GX_NEAR_MIP_LIN   4
+#define GX_LIN_MIP_LIN    5
+
+#define GX_ANISO_1        0
+#define GX_ANISO_2        1
+#define GX_ANISO_4        2
+
+#define GX_BM_NONE        0
+#define GX_BM_BLEND       1
+#define GX_BM_LOGIC       2
+#define GX_BM_SUBTRACT    3
+
+#define GX_BL_ZERO        0
+#define GX_BL_ONE         1
+#define GX_BL_SRCCLR      2
+#define GX_BL_INVSRCCLR   3
+#define GX_BL_SRCALPHA    4
+#define GX_BL_INVSRCALPHA 5
+#define GX_BL_DSTALPHA    6
+#define GX_BL_INVDSTALPHA 7
+#define GX_BL_DSTCLR      GX_BL_SRCCLR
+#define GX_BL_INVDSTCLR   GX_BL_INVSRCCLR
+
+#define GX_LO_CLEAR       0
+#define GX_LO_SET         15
+
+#define GX_NEVER          0
+#define GX_LESS           1
+#define GX_EQUAL          2
+#define GX_LEQUAL         3
+#define GX_GREATER        4
+#define GX_NEQUAL         5
+#define GX_GEQUAL         6
+#define GX_ALWAYS         7
+
+#define GX_AOP_AND        0
+#define GX_AOP_OR         1
+
+#define GX_CULL_NONE      0
+#define GX_CULL_FRONT     1
+#define GX_CULL_BACK      2
+#define GX_CULL_ALL       3
+
+#define GX_CLIP_ENABLE    0
+#define GX_CLIP_DISABLE   1
+
+#define GX_PF_RGB8_Z24    0
+#define GX_PF_RGBA6_Z24   1
+#define GX_PF_RGB565_Z16  2
+#define GX_ZC_LINEAR      0
+#define GX_MAX_Z24        0x00ffffff
+
+#define GX_GM_1_0         0
+#define GX_PERSPECTIVE    0
+#define GX_ORTHOGRAPHIC   1
+#define GX_TO_ZERO        0
+
+#define GX_SRC_REG        0
+#define GX_SRC_VTX        1
+#define GX_DF_NONE        0
+#define GX_DF_SIGNED      1
+#define GX_DF_CLAMP       2
+#define GX_AF_SPEC        0
+#define GX_AF_SPOT        1
+#define GX_AF_NONE        2
+#define GX_LIGHTNULL      0x000
+#define GX_LIGHT0         0x001
+#define GX_LIGHT1         0x002
+#define GX_LIGHT2         0x004
+#define GX_LIGHT3         0x008
+#define GX_LIGHT4         0x010
+#define GX_LIGHT5         0x020
+#define GX_LIGHT6         0x040
+#define GX_LIGHT7         0x080
+#define GX_SP_OFF         0
+#define GX_SP_FLAT        1
+#define GX_SP_COS         2
+#define GX_SP_COS2        3
+#define GX_SP_SHARP       4
+#define GX_SP_RING1       5
+#define GX_SP_RING2       6
+#define GX_DA_OFF         0
+#define GX_DA_GENTLE      1
+#define GX_DA_MEDIUM      2
+#define GX_DA_STEEP       3
+
+#define GX_TEV_ADD        0
+#define GX_TEV_SUB        1
+#define GX_TB_ZERO        0
+#define GX_CS_SCALE_1     0
+#define GX_TEVPREV        0
+#define GX_CC_CPREV       0
+#define GX_CC_APREV       1
+#define GX_CC_TEXC        8
+#define GX_CC_TEXA        9
+#define GX_CC_RASC        10
+#define GX_CC_RASA        11
+#define GX_CC_ONE         12
+#define GX_CC_HALF        13
+#define GX_CC_KONST       14
+#define GX_CC_ZERO        15
+#define GX_CA_APREV       0
+#define GX_CA_TEXA        4
+#define GX_CA_RASA        5
+#define GX_CA_KONST       6
+#define GX_CA_ZERO        7
+#define GX_KCOLOR0        0
+#define GX_TEV_KCSEL_K0   0x0C
+#define GX_TEV_KASEL_K0_A 0x1C
+
+#define GX_READ_00        0
+#define GX_READ_FF        1
+#define GX_READ_NONE      2
+
+#define GX_PERF0_VERTICES 0
+#define GX_PERF0_CLOCKS   34
+#define GX_PERF0_NONE     35
+#define GX_PERF1_TC_MISS  9
+#define GX_PERF1_VERTICES 11
+#define GX_PERF1_CLOCKS   22
+#define GX_PERF1_NONE     23
+
+//==============================================================================
+// VIDEO constants
+//==============================================================================
+#define VI_INTERLACE      0
+#define VI_NON_INTERLACE  1
+#define VI_PROGRESSIVE    2
+#define VI_NTSC           0
+#define VI_PAL            1
+#define VI_MPAL           2
+#define VI_DEBUG          3
+#define VI_DEBUG_PAL      4
+#define VI_EURGB60        5
+#define VI_TVMODE(fmt, mode)  (((fmt) << 2) + (mode))
+#define VI_TVMODE_NTSC_INT    VI_TVMODE(VI_NTSC, VI_INTERLACE)
+#define VI_TVMODE_NTSC_PROG   VI_TVMODE(VI_NTSC, VI_PROGRESSIVE)
+#define VI_TVMODE_PAL_INT     VI_TVMODE(VI_PAL,  VI_INTERLACE)
+#define VI_XFBMODE_SF     0
+#define VI_XFBMODE_DF     1
+#define VI_MAX_WIDTH_NTSC 720
+#define VI_MAX_WIDTH_PAL  720
+
+#define CONF_ASPECT_4_3   0
+#define CONF_ASPECT_16_9  1
+
+#define EXI_CHANNEL_0     0
+#define EXI_CHANNEL_1     1
+
+extern GXRModeObj TVNtsc480IntDf;
+extern GXRModeObj TVNtsc480Prog;
+extern GXRModeObj TVPal528IntDf;
+
+//==============================================================================
+// GX
+//==============================================================================
+void *GX_Init (void *base, u32 size);
+void  GX_AbortFrame (void);
+void  GX_Flush (void);
+void  GX_DrawDone (void);
+void  GX_SetDrawDone (void);
+void  GX_WaitDrawDone (void);
+GXDrawDoneCallback GX_SetDrawDoneCallback (GXDrawDoneCallback cb);
+
+void  GX_Begin (u8 primitive, u8 vtxfmt, u16 vtxcnt);
+void  GX_End (void);
+void  GX_Position3f32 (f32 x, f32 y, f32 z);
+void  GX_Position2f32 (f32 x, f32 y);
+void  GX_Position3s16 (s16 x, s16 y, s16 z);
+void  GX_Position2s16 (s16 x, s16 y);
+void  GX_Position1x16 (u16 index);
+void  GX_Position1x8 (u8 index);
+void  GX_Normal3f32 (f32 nx, f32 ny, f32 nz);
+void  GX_Normal1x16 (u16 index);
+void  GX_Color1u32 (u32 clr);
+void  GX_Color4u8 (u8 r, u8 g, u8 b, u8 a);
+void  GX_Color1x16 (u16 index);
+void  GX_TexCoord2f32 (f32 s, f32 t);
+void  GX_TexCoord2u16 (u16 s, u16 t);
+void  GX_TexCoord2s16 (s16 s, s16 t);
+void  GX_TexCoord1x16 (u16 index);
+
+void  GX_SetVtxDesc (u8 attr, u8 type);
+void  GX_GetVtxDesc (u8 attr, u8 *type);
+void  GX_ClearVtxDesc (void);
+void  GX_SetVtxAttrFmt (u8 vtxfmt, u32 vtxattr, u32 comptype, u32 compsize, u32 frac);
+void  GX_SetArray (u32 attr, void *ptr, u8 stride);
+void  GX_InvVtxCache (void);
+
+void  GX_LoadPosMtxImm (Mtx mt, u32 pnidx);
+void  GX_LoadNrmMtxImm (Mtx mt, u32 pnidx);
+void  GX_LoadTexMtxImm (Mtx mt, u32 texidx, u8 type);
+void  GX_LoadProjectionMtx (Mtx44 mt, u8 type);
+void  GX_SetCurrentMtx (u32 mtx);
+
+void  GX_InitTexObj (GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap);
+void  GX_InitTexObjCI (GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap, u32 tlut_name);
+void  GX_InitTexObjLOD (GXTexObj *obj, u8 minfilt, u8 magfilt, f32 minlod, f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod, u8 maxaniso);
+void  GX_InitTexObjFilterMode (GXTexObj *obj, u8 minfilt, u8 magfilt);
+void *GX_GetTexObjData (GXTexObj *obj);
+u16   GX_GetTexObjWidth (GXTexObj *obj);
+u16   GX_GetTexObjHeight (GXTexObj *obj);
+u32   GX_GetTexObjFmt (GXTexObj *obj);
+u8    GX_GetTexObjMipMap (GXTexObj *obj);
+void  GX_InitTexObjWrapMode (GXTexObj *obj, u8 wrap_s, u8 wrap_t);
+u8    GX_GetTexObjWrapS (GXTexObj *obj);
+u8    GX_GetTexObjWrapT (GXTexObj *obj);
+void  GX_InitTexObjData (GXTexObj *obj, void *img_ptr);
+f32   GX_GetTexObjMinLOD (GXTexObj *obj);
+f32   GX_GetTexObjMaxLOD (GXTexObj *obj);
+f32   GX_GetTexObjLODBias (GXTexObj *obj);
+u8    GX_GetTexObjMinFilt (GXTexObj *obj);
+void  GX_InitTexObjUserData (GXTexObj *obj, void *userdata);
+void *GX_GetTexObjUserData (GXTexObj *obj);
+u32   GX_GetTexObjTlut (GXTexObj *obj);
+u32   GX_GetTexBufferSize (u16 wd, u16 ht, u32 fmt, u8 mipmap, u8 maxlod);
+void  GX_LoadTexObj (GXTexObj *obj, u8 mapid);
+void  GX_InitTlutObj (GXTlutObj *obj, void *lut, u8 fmt, u16 entries);
+void  GX_LoadTlut (GXTlutObj *obj, u32 tlut_name);
+void  GX_InvalidateTexAll (void);
+
+void  GX_SetTevOp (u8 tevstage, u8 mode);
+void  GX_SetTevOrder (u8 tevstage, u8 texcoord, u32 texmap, u8 color);
+void  GX_SetTevColorIn (u8 tevstage, u8 a, u8 b, u8 c, u8 d);
+void  GX_SetTevAlphaIn (u8 tevstage, u8 a, u8 b, u8 c, u8 d);
+void  GX_SetTevColorOp (u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid);
+void  GX_SetTevAlphaOp (u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid);
+void  GX_SetTevKColor (u8 sel, GXColor col);
+void  GX_SetTevKColorSel (u8 tevstage, u8 sel);
+void  GX_SetTevKAlphaSel (u8 tevstage, u8 sel);
+void  GX_SetNumTevStages (u8 num);
+void  GX_SetNumChans (u8 num);
+void  GX_SetNumTexGens (u32 nr);
+void  GX_SetTexCoordGen (u16 texcoord, u32 tgen_typ, u32 tgen_src, u32 mtxsrc);
+void  GX_SetChanCtrl (s32 channel, u8 enable, u8 ambsrc, u8 matsrc, u8 litmask, u8 diff_fn, u8 attn_fn);
+void  GX_SetChanAmbColor (s32 channel, GXColor color);
+void  GX_SetChanMatColor (s32 channel, GXColor color);
+
+void  GX_SetBlendMode (u8 type, u8 src_fact, u8 dst_fact, u8 op);
+void  GX_SetZMode (u8 enable, u8 func, u8 update_enable);
+void  GX_SetColorUpdate (u8 enable);
+void  GX_SetAlphaUpdate (u8 enable);
+void  GX_SetAlphaCompare (u8 comp0, u8 ref0, u8 aop, u8 comp1, u8 ref1);
+void  GX_SetCullMode (u8 mode);
+void  GX_SetClipMode (u8 mode);
+void  GX_SetScissor (u32 xorigin, u32 yorigin, u32 wd, u32 ht);
+void  GX_GetScissor (u32 *xorigin, u32 *yorigin, u32 *wd, u32 *ht);
+void  GX_SetViewport (f32 xorig, f32 yorig, f32 wd, f32 ht, f32 nearz, f32 farz);
+void  GX_SetPointSize (u8 width, u8 fmt);
+void  GX_SetLineWidth (u8 width, u8 fmt);
+
+void  GX_SetCopyClear (GXColor color, u32 zvalue);
+void  GX_SetPixelFmt (u8 pix_fmt, u8 z_fmt);
+void  GX_SetCopyFilter (u8 aa, u8 sample_pattern[12][2], u8 vf, u8 vfilter[7]);
+void  GX_SetFieldMode (u8 field_mode, u8 half_aspect_ratio);
+void  GX_SetDispCopyGamma (u8 gamma);
+void  GX_SetDispCopySrc (u16 left, u16 top, u16 wd, u16 ht);
+void  GX_SetDispCopyDst (u16 wd, u16 ht);
+u32   GX_SetDispCopyYScale (f32 yscale);
+f32   GX_GetYScaleFactor (u16 efbheight, u16 xfbheight);
+void  GX_CopyDisp (void *dest, u8 clear);
+void  GX_SetTexCopySrc (u16 left, u16 top, u16 wd, u16 ht);
+void  GX_SetTexCopyDst (u16 wd, u16 ht, u32 fmt, u8 mipmap);
+void  GX_CopyTex (void *dest, u8 clear);
+void  GX_PixModeSync (void);
+void  GX_PokeAlphaRead (u8 mode);
+
+void  GX_BeginDispList (void *list, u32 size);
+u32   GX_EndDispList (void);
+void  GX_CallDispList (void *list, u32 nbytes);
+
+void  GX_SetGPMetric (u32 perf0, u32 perf1);
+void  GX_ReadGPMetric (u32 *cnt0, u32 *cnt1);
+void  GX_ClearGPMetric (void);
+
+void  GX_InitLightPos (GXLightObj *lit_obj, f32 x, f32 y, f32 z);
+void  GX_InitLightPosv (GXLightObj *lit_obj, guVector *pos);
+void  GX_InitLightDir (GXLightObj *lit_obj, f32 nx, f32 ny, f32 nz);
+void  GX_InitLightDirv (GXLightObj *lit_obj, guVector *dir);
+void  GX_InitLightColor (GXLightObj *lit_obj, GXColor col);
+void  GX_InitLightSpot (GXLightObj *lit_obj, f32 cut_off, u8 spotfn);
+void  GX_InitLightDistAttn (GXLightObj *lit_obj, f32 ref_dist, f32 ref_brite, u8 dist_fn);
+void  GX_InitLightAttn (GXLightObj *lit_obj, f32 a0, f32 a1, f32 a2, f32 k0, f32 k1, f32 k2);
+void  GX_InitLightShininess (GXLightObj *lit_obj, f32 shininess);
+void  GX_InitSpecularDirv (GXLightObj *lit_obj, guVector *vec);
+void  GX_LoadLightObj (GXLightObj *lit_obj, u8 lit_id);
+
+//==============================================================================
+// GU
+//==============================================================================
+#define guMtxRotAxisDeg(mt, axis, deg)  guMtxRotAxisRad(mt, axis, DegToRad(deg))
+#define guMtxRotDeg(mt, axis, deg)      guMtxRotRad(mt, axis, DegToRad(deg))
+
+void  guMtxIdentity (Mtx mt);
+void  guMtxCopy (Mtx src, Mtx dst);
+void  guMtxConcat (Mtx a, Mtx b, Mtx ab);
+void  guMtxScale (Mtx mt, f32 xS, f32 yS, f32 zS);
+void  guMtxScaleApply (Mtx src, Mtx dst, f32 xS, f32 yS, f32 zS);
+void  guMtxTrans (Mtx mt, f32 xT, f32 yT, f32 zT);
+void  guMtxTransApply (Mtx src, Mtx dst, f32 xT, f32 yT, f32 zT);
+void  guMtxRotAxisRad (Mtx mt, guVector *axis, f32 rad);
+void  guMtxRotRad (Mtx mt, const char axis, f32 rad);
+u32   guMtxInverse (Mtx src, Mtx inv);
+void  guMtxTranspose (Mtx src, Mtx xpose);
+void  guLookAt (Mtx mt, guVector *camPos, guVector *camUp, guVector *target);
+void  guPerspective (Mtx44 mt, f32 fovy, f32 aspect, f32 n, f32 f);
+void  guOrtho (Mtx44 mt, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f);
+void  guVecMultiply (Mtx mt, guVector *src, guVector *dst);
+void  guVecMultiplySR (Mtx mt, guVector *src, guVector *dst);
+void  guVecNormalize (guVector *v);
+void  guVecCross (guVector *a, guVector *b, guVector *axb);
+f32   guVecDotProduct (guVector *a, guVector *b);
+
+//==============================================================================
+// VIDEO, SYS, CONF and cache
+//==============================================================================
+void  VIDEO_Init (void);
+void  VIDEO_SetBlack (bool black);
+GXRModeObj *VIDEO_GetPreferredMode (GXRModeObj *mode);
+void  VIDEO_Configure (GXRModeObj *rmode);
+void  VIDEO_SetNextFramebuffer (void *fb);
+void *VIDEO_GetCurrentFramebuffer (void);
+void  VIDEO_Flush (void);
+void  VIDEO_WaitVSync (void);
+u32   VIDEO_GetRetraceCount (void);
+u32   VIDEO_GetFrameBufferSize (GXRModeObj *rmode);
+u32   VIDEO_GetCurrentTvMode (void);
+u32   VIDEO_HaveComponentCable (void);
+VIRetraceCallback VIDEO_SetPreRetraceCallback (VIRetraceCallback callback);
+VIRetraceCallback VIDEO_SetPostRetraceCallback (VIRetraceCallback callback);
+
+void *SYS_AllocateFramebuffer (GXRModeObj *rmode);
+s32   CONF_GetAspectRatio (void);
+
+void  DCFlushRange (void *startaddress, u32 len);
+void  DCStoreRange (void *startaddress, u32 len);
+void  DCInvalidateRange (void *startaddress, u32 len);
+
+//==============================================================================
+// LWP
+//==============================================================================
+#define LWP_PRIO_NORMAL   64
+#define LWP_PRIO_HIGHEST  127
+
+s32   LWP_CreateThread (lwp_t *thethread, void *(*entry)(void *), void *arg, void *stackbase, u32 stack_size, u8 prio);
+s32   LWP_JoinThread (lwp_t thethread, void **value_ptr);
+void  LWP_YieldThread (void);
+s32   LWP_MutexInit (mutex_t *mutex, bool use_recursive);
+s32   LWP_MutexDestroy (mutex_t mutex);
+s32   LWP_MutexLock (mutex_t mutex);
+s32   LWP_MutexUnlock (mutex_t mutex);
+s32   LWP_CondInit (cond_t *cond);
+s32   LWP_CondWait (cond_t cond, mutex_t mutex);
+s32   LWP_CondSignal (cond_t cond);
+s32   LWP_CondBroadcast (cond_t cond);
+s32   LWP_CondDestroy (cond_t cond);
+s32   LWP_InitQueue (lwpq_t *thequeue);
+void  LWP_CloseQueue (lwpq_t thequeue);
+s32   LWP_ThreadSleep (lwpq_t thequeue);
+void  LWP_ThreadSignal (lwpq_t thequeue);
+void  LWP_ThreadBroadcast (lwpq_t thequeue);
+
+//==============================================================================
+// TPL
+//==============================================================================
+s32   TPL_OpenTPLFromMemory (TPLFile *tdf, void *memory, u32 len);
+s32   TPL_GetTexture (TPLFile *tdf, s32 id, GXTexObj *texObj);
+s32   TPL_GetTextureInfo (TPLFile *tdf, s32 id, u32 *fmt, u16 *width, u16 *height);
+void  TPL_CloseTPLFile (TPLFile *tdf);
+
+//==============================================================================
+// USB Gecko
+//==============================================================================
+s32   usb_isgeckoalive (s32 chn);
+void  usb_flush (s32 chn);
+int   usb_sendbuffer_safe (s32 chn, const void *buffer, int size);
+
+#ifdef __cplusplus
+   }
+#endif /* __cplusplus */
+
+#include <ogc/lwp_watchdog.h>
+
+#endif // __GCCORE_H__
@@ -0,0 +1,160 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file gxhost.h
+ * Inspection of the GX commands recorded by the host stand-in for libogc.
+ * Each GX call that would write to the FIFO is recorded as one word holding the command
+ * and the number of argument words, followed by the arguments (f32 values are stored as their bits).
+ * Only used by the host build.
+ */
+
+#ifndef __GXHOST_H__
+#define __GXHOST_H__
+
+#include <gccore.h>
+
+#ifdef __cplusplus
+   extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * List of the recorded commands with the number of bytes they take in the real GX FIFO.
+ * Sizes of state commands are estimates of the register writes libogc sends.
+ */
+#define GXHOST_COMMANDS \
+	GXHOST_COMMAND(BEGIN,            3) \
+	GXHOST_COMMAND(END,              0) \
+	GXHOST_COMMAND(POSITION3F32,    12) \
+	GXHOST_COMMAND(POSITION2F32,     8) \
+	GXHOST_COMMAND(POSITION3S16,     6) \
+	GXHOST_COMMAND(POSITION2S16,     4) \
+	GXHOST_COMMAND(POSITION1X16,     2) \
+	GXHOST_COMMAND(POSITION1X8,      1) \
+	GXHOST_COMMAND(NORMAL3F32,      12) \
+	GXHOST_COMMAND(NORMAL1X16,       2) \
+	GXHOST_COMMAND(COLOR1U32,        4) \
+	GXHOST_COMMAND(COLOR4U8,         4) \
+	GXHOST_COMMAND(COLOR1X16,        2) \
+	GXHOST_COMMAND(TEXCOORD2F32,     8) \
+	GXHOST_COMMAND(TEXCOORD2U16,     4) \
+	GXHOST_COMMAND(TEXCOORD2S16,     4) \
+	GXHOST_COMMAND(TEXCOORD1X16,     2) \
+	GXHOST_COMMAND(SETVTXDESC,       6) \
+	GXHOST_COMMAND(CLEARVTXDESC,    12) \
+	GXHOST_COMMAND(SETVTXATTRFMT,    6) \
+	GXHOST_COMMAND(SETARRAY,        12) \
+	GXHOST_COMMAND(INVVTXCACHE,      1) \
+	GXHOST_COMMAND(LOADPOSMTX,      53) \
+	GXHOST_COMMAND(LOADNRMMTX,      41) \
+	GXHOST_COMMAND(LOADTEXMTX,      53) \
+	GXHOST_COMMAND(LOADPROJECTION,  33) \
+	GXHOST_COMMAND(SETCURRENTMTX,   11) \
+	GXHOST_COMMAND(LOADTEXOBJ,      20) \
+	GXHOST_COMMAND(INVALIDATETEXALL,10) \
+	GXHOST_COMMAND(LOADTLUT,        20) \
+	GXHOST_COMMAND(SETTEVOP,        10) \
+	GXHOST_COMMAND(SETTEVORDER,      5) \
+	GXHOST_COMMAND(SETTEVCOLORIN,    5) \
+	GXHOST_COMMAND(SETTEVALPHAIN,    5) \
+	GXHOST_COMMAND(SETTEVCOLOROP,    5) \
+	GXHOST_COMMAND(SETTEVALPHAOP,    5) \
+	GXHOST_COMMAND(SETTEVKCOLOR,    10) \
+	GXHOST_COMMAND(SETTEVKCOLORSEL,  5) \
+	GXHOST_COMMAND(SETTEVKALPHASEL,  5) \
+	GXHOST_COMMAND(SETNUMTEVSTAGES,  5) \
+	GXHOST_COMMAND(SETNUMCHANS,      5) \
+	GXHOST_COMMAND(SETNUMTEXGENS,    5) \
+	GXHOST_COMMAND(SETTEXCOORDGEN,   5) \
+	GXHOST_COMMAND(SETCHANCTRL,      5) \
+	GXHOST_COMMAND(SETCHANAMBCOLOR,  5) \
+	GXHOST_COMMAND(SETCHANMATCOLOR,  5) \
+	GXHOST_COMMAND(LOADLIGHTOBJ,    69) \
+	GXHOST_COMMAND(SETBLENDMODE,     5) \
+	GXHOST_COMMAND(SETZMODE,         5) \
+	GXHOST_COMMAND(SETCOLORUPDATE,   5) \
+	GXHOST_COMMAND(SETALPHAUPDATE,   5) \
+	GXHOST_COMMAND(SETALPHACOMPARE,  5) \
+	GXHOST_COMMAND(SETCULLMODE,      5) \
+	GXHOST_COMMAND(SETCLIPMODE,      5) \
+	GXHOST_COMMAND(SETSCISSOR,      10) \
+	GXHOST_COMMAND(SETVIEWPORT,     29) \
+	GXHOST_COMMAND(SETPOINTSIZE,     5) \
+	GXHOST_COMMAND(SETLINEWIDTH,     5) \
+	GXHOST_COMMAND(SETCOPYCLEAR,    15) \
+	GXHOST_COMMAND(SETPIXELFMT,      5) \
+	GXHOST_COMMAND(SETCOPYFILTER,   30) \
+	GXHOST_COMMAND(SETFIELDMODE,     5) \
+	GXHOST_COMMAND(SETDISPCOPYSRC,  10) \
+	GXHOST_COMMAND(SETDISPCOPYDST,   5) \
+	GXHOST_COMMAND(SETDISPCOPYYSCALE,5) \
+	GXHOST_COMMAND(COPYDISP,        10) \
+	GXHOST_COMMAND(SETTEXCOPYSRC,   10) \
+	GXHOST_COMMAND(SETTEXCOPYDST,   10) \
+	GXHOST_COMMAND(COPYTEX,         10) \
+	GXHOST_COMMAND(PIXMODESYNC,      5) \
+	GXHOST_COMMAND(SETDRAWDONE,      5) \
+	GXHOST_COMMAND(CALLDISPLIST,     9) \
+	GXHOST_COMMAND(SETGPMETRIC,     10)
+
+/**
+ * Commands recorded by the host GX stand-in.
+ */
+typedef  enum GXHost_command {
+	GXHOST_NONE = 0,
+#define GXHOST_COMMAND(name, bytes)  GXHOST_##name,
+	GXHOST_COMMANDS
+#undef GXHOST_COMMAND
+	GXHOST_COMMAND_COUNT
+} GXHost_command;
+
+/**
+ * A range of memory written back from the data cache with DCFlushRange.
+ */
+typedef  struct GXHost_flush {
+	const void  *start;  /**< First byte of the range. */
+	u32          len;    /**< Size of the range. */
+} GXHost_flush;
+
+#define HOST_MAX_FLUSHES  (4096)  /**< Number of flushed ranges kept by the host stand-in. */
+
+#define GXHOST_OP(word)     ((word) >> 16)     /**< Command of a command header word. */
+#define GXHOST_ARGS(word)   ((word) & 0xFFFF)  /**< Number of argument words following a command header word. */
+
+void        GXHost_Reset (void);
+const u32*  GXHost_GetCommands (u32 *words);
+u32         GXHost_CountCommands (const GXHost_command command);
+u64         GXHost_GetFifoBytes (void);
+u32         GXHost_GetCommandBytes (const GXHost_command command);
+const char* GXHost_GetCommandName (const GXHost_command command);
+const u32*  GXHost_GetDisplayList (const void *list, u32 *words);
+void        GXHost_GetVtxAttrFmt (u8 vtxfmt, u32 vtxattr, u32 *comptype, u32 *compsize, u32 *frac);
+void*       GXHost_GetDisplayedFramebuffer (void);
+const GXHost_flush*  GXHost_GetFlushes (u32 *count);
+u64         GXHost_GetFlushedBytes (void);
+void        GXHost_ResetFlushes (void);
+
+#ifdef __cplusplus
+   }
+#endif /* __cplusplus */
+
+#endif // __GXHOST_H__
@@ -0,0 +1,9 @@
+/* Host stand-in for <ogc/libversion.h>, reports the libogc version GRRLIB is written against. */
+#ifndef __LIBVERSION_H__
+#define __LIBVERSION_H__
+
+#define _V_MAJOR_  2
+#define _V_MINOR_  4
+#define _V_PATCH_  0
+
+#endif // __LIBVERSION_H__
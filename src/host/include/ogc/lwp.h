@@ -0,0 +1,2 @@
+/* Host stand-in for <ogc/lwp.h>, everything is declared in gccore.h. */
+#include <gccore.h>
@@ -0,0 +1,32 @@
+/* Host stand-in for <ogc/lwp_watchdog.h>, a tick is one nanosecond of CLOCK_MONOTONIC. */
+#ifndef __LWP_WATCHDOG_H__
+#define __LWP_WATCHDOG_H__
+
+#include <gccore.h>
+
+#ifdef __cplusplus
+   extern "C" {
+#endif /* __cplusplus */
+
+#define TB_TIMER_CLOCK             1000000  /**< Ticks per millisecond. */
+#define ticks_to_secs(ticks)       ((u64)(ticks) / 1000000000)
+#define ticks_to_millisecs(ticks)  ((u64)(ticks) / 1000000)
+#define ticks_to_microsecs(ticks)  ((u64)(ticks) / 1000)
+#define ticks_to_nanosecs(ticks)   ((u64)(ticks))
+#define secs_to_ticks(sec)         ((u64)(sec) * 1000000000)
+#define millisecs_to_ticks(msec)   ((u64)(msec) * 1000000)
+#define microsecs_to_ticks(usec)   ((u64)(usec) * 1000)
+#define nanosecs_to_ticks(nsec)    ((u64)(nsec))
+#define diff_ticks(tick0, tick1)   ((u64)(tick1) - (u64)(tick0))
+
+u64   gettime (void);
+u32   gettick (void);
+u32   diff_sec (u64 start, u64 end);
+u32   diff_msec (u64 start, u64 end);
+u32   diff_usec (u64 start, u64 end);
+
+#ifdef __cplusplus
+   }
+#endif /* __cplusplus */
+
+#endif // __LWP_WATCHDOG_H__
@@ -0,0 +1,14 @@
+/* Host stand-in for <ogc/machine/processor.h>. Interrupts are simulated synchronously, so masking them does nothing. */
+#ifndef __PROCESSOR_H__
+#define __PROCESSOR_H__
+
+#include <gccore.h>
+
+#define _CPU_ISR_Disable(level)  ((level) = 0)
+#define _CPU_ISR_Restore(level)  ((void)(level))
+
+#define read32(addr)             (0U)
+#define write32(addr, val)       ((void)(addr), (void)(val))
+#define mask32(addr, clr, set)   ((void)(addr), (void)(clr), (void)(set))
+
+#endif // __PROCESSOR_H__
@@ -0,0 +1,2 @@
+/* Host stand-in for <ogc/system.h>, everything is declared in gccore.h. */
+#include <gccore.h>
@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file pngu-mod.h
+ * Host stand-in for the PNGU-mod interface, backed by libpng.
+ */
+
+#ifndef __PNGU_MOD_H__
+#define __PNGU_MOD_H__
+
+#include <gccore.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PNGU_OK                          0
+#define PNGU_ODD_WIDTH                   1
+#define PNGU_ODD_STRIDE                  2
+#define PNGU_INVALID_WIDTH_OR_HEIGHT     3
+#define PNGU_FILE_IS_NOT_PNG             4
+#define PNGU_UNSUPPORTED_COLOR_TYPE      5
+#define PNGU_NO_FILE_SELECTED            6
+#define PNGU_CANT_OPEN_FILE              7
+#define PNGU_CANT_READ_FILE              8
+#define PNGU_LIB_ERROR                   9
+
+typedef struct _IMGCTX *IMGCTX;
+
+typedef struct {
+	u32 imgWidth;
+	u32 imgHeight;
+	u32 imgBitDepth;
+	u32 imgColorType;
+	u32 validBckgrnd;
+	u32 bckgrnd;
+	u32 numTrans;
+	void *trans;
+} PNGUPROP;
+
+IMGCTX  PNGU_SelectImageFromBuffer (const void *buffer);
+IMGCTX  PNGU_SelectImageFromDevice (const char *filename);
+void    PNGU_ReleaseImageContext (IMGCTX ctx);
+int     PNGU_GetImageProperties (IMGCTX ctx, PNGUPROP *fileproperties);
+void*   PNGU_DecodeTo4x4RGBA8 (IMGCTX ctx, u32 width, u32 height, int *dstWidth, int *dstHeight, void *dstPtr);
+void*   PNGU_DecodeToRGBA8 (IMGCTX ctx, u32 width, u32 height, int *dstWidth, int *dstHeight, void *dstPtr);
+int     PNGU_EncodeFromEFB (IMGCTX ctx, u32 width, u32 height, u32 stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PNGU_MOD_H__
@@ -0,0 +1,202 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file pngu.c
+ * Host stand-in for PNGU-mod, decoding with the libpng simplified API.
+ */
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+
+#include <pngu-mod.h>
+
+struct _IMGCTX {
+	png_image image;
+	u8  *file;   /**< Copy of the file when selected from a device. */
+	bool valid;
+};
+
+/**
+ * Return the size of an in-memory PNG by walking its chunks up to IEND.
+ * PNGU only receives a pointer, so the size has to be recovered from the stream itself.
+ */
+static size_t  PNGSize (const u8 *p) {
+	size_t offs = 8;
+
+	if (png_sig_cmp(p, 0, 8) != 0) {
+		return 0;
+	}
+	for (;;) {
+		const u32 len = ((u32)p[offs] << 24) | ((u32)p[offs + 1] << 16) | ((u32)p[offs + 2] << 8) | p[offs + 3];
+		const bool end = memcmp(p + offs + 4, "IEND", 4) == 0;
+
+		offs += 12 + (size_t)len;
+		if (end) {
+			return offs;
+		}
+	}
+}
+
+static IMGCTX  SelectImage (const u8 *data, u8 *owned) {
+	IMGCTX ctx;
+	size_t size;
+
+	if (data == NULL || (size = PNGSize(data)) == 0) {
+		free(owned);
+		return NULL;
+	}
+	ctx = calloc(1, sizeof(struct _IMGCTX));
+	ctx->image.version = PNG_IMAGE_VERSION;
+	ctx->file = owned;
+	ctx->valid = png_image_begin_read_from_memory(&ctx->image, data, size) != 0;
+	if (ctx->valid == false) {
+		PNGU_ReleaseImageContext(ctx);
+		return NULL;
+	}
+	return ctx;
+}
+
+IMGCTX  PNGU_SelectImageFromBuffer (const void *buffer) {
+	return SelectImage(buffer, NULL);
+}
+
+IMGCTX  PNGU_SelectImageFromDevice (const char *filename) {
+	FILE *fd = fopen(filename, "rb");
+	u8 *data;
+	long size;
+
+	if (fd == NULL) {
+		return NULL;
+	}
+	fseek(fd, 0, SEEK_END);
+	size = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+	data = malloc(size > 0 ? (size_t)size : 1);
+	if (size <= 0 || fread(data, 1, (size_t)size, fd) != (size_t)size) {
+		size = 0;
+	}
+	fclose(fd);
+	if (size == 0) {
+		free(data);
+		return NULL;
+	}
+	return SelectImage(data, data);
+}
+
+void  PNGU_ReleaseImageContext (IMGCTX ctx) {
+	if (ctx == NULL) {
+		return;
+	}
+	png_image_free(&ctx->image);
+	free(ctx->file);
+	free(ctx);
+}
+
+int  PNGU_GetImageProperties (IMGCTX ctx, PNGUPROP *fileproperties) {
+	if (ctx == NULL || ctx->valid == false) {
+		return PNGU_NO_FILE_SELECTED;
+	}
+	memset(fileproperties, 0, sizeof(PNGUPROP));
+	fileproperties->imgWidth = ctx->image.width;
+	fileproperties->imgHeight = ctx->image.height;
+	fileproperties->imgBitDepth = PNG_IMAGE_SAMPLE_COMPONENT_SIZE(ctx->image.format) * 8;
+	fileproperties->imgColorType = ctx->image.format;
+	return PNGU_OK;
+}
+
+/**
+ * Decode the selected image to linear RGBA8, consuming the context's read state.
+ * @return A malloc'd buffer, NULL on error.
+ */
+static u8*  DecodeLinear (IMGCTX ctx) {
+	u8 *buf;
+
+	if (ctx == NULL || ctx->valid == false) {
+		return NULL;
+	}
+	ctx->image.format = PNG_FORMAT_RGBA;
+	buf = malloc(PNG_IMAGE_SIZE(ctx->image));
+	if (png_image_finish_read(&ctx->image, NULL, buf, 0, NULL) == 0) {
+		free(buf);
+		buf = NULL;
+	}
+	ctx->valid = false;
+	return buf;
+}
+
+void*  PNGU_DecodeToRGBA8 (IMGCTX ctx, u32 width, u32 height, int *dstWidth, int *dstHeight, void *dstPtr) {
+	u8 *rgba = DecodeLinear(ctx);
+	void *dst;
+
+	(void)width; (void)height;
+	if (rgba == NULL) {
+		return NULL;
+	}
+	dst = dstPtr != NULL ? dstPtr : memalign(32, ctx->image.width * ctx->image.height * 4);
+	memcpy(dst, rgba, ctx->image.width * ctx->image.height * 4);
+	free(rgba);
+	if (dstWidth  != NULL) *dstWidth  = (int)ctx->image.width;
+	if (dstHeight != NULL) *dstHeight = (int)ctx->image.height;
+	return dst;
+}
+
+void*  PNGU_DecodeTo4x4RGBA8 (IMGCTX ctx, u32 width, u32 height, int *dstWidth, int *dstHeight, void *dstPtr) {
+	u8 *rgba = DecodeLinear(ctx);
+	u32 w, h, pw, ph;
+	u8 *dst;
+
+	(void)width; (void)height;
+	if (rgba == NULL) {
+		return NULL;
+	}
+	w = ctx->image.width;
+	h = ctx->image.height;
+	pw = (w + 3) & ~3u;
+	ph = (h + 3) & ~3u;
+	dst = dstPtr != NULL ? dstPtr : memalign(32, pw * ph * 4);
+
+	// Each 4x4 tile is 32 bytes of AR pairs followed by 32 bytes of GB pairs; padding is transparent
+	for (u32 y = 0; y < ph; y++) {
+		for (u32 x = 0; x < pw; x++) {
+			const u32 offs = (((y >> 2) * (pw >> 2) + (x >> 2)) << 6) + (((y & 3) << 2) + (x & 3)) * 2;
+			const u8 *s = (x < w && y < h) ? &rgba[(y * w + x) * 4] : NULL;
+
+			dst[offs]      = s != NULL ? s[3] : 0;
+			dst[offs + 1]  = s != NULL ? s[0] : 0;
+			dst[offs + 32] = s != NULL ? s[1] : 0;
+			dst[offs + 33] = s != NULL ? s[2] : 0;
+		}
+	}
+	free(rgba);
+	if (dstWidth  != NULL) *dstWidth  = (int)pw;
+	if (dstHeight != NULL) *dstHeight = (int)ph;
+	return dst;
+}
+
+int  PNGU_EncodeFromEFB (IMGCTX ctx, u32 width, u32 height, u32 stride) {
+	// There is no embedded frame buffer to read back on the host
+	(void)ctx; (void)width; (void)height; (void)stride;
+	return PNGU_LIB_ERROR;
+}
@@ -0,0 +1,241 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "grrlib_test.h"
+
+/** Test image with every component changing. */
+static u32 NoisyPixel(u32 x, u32 y) {
+	return TestPixel(x, y) ^ ((x * 13 + y * 7) & 0xFF) ^ (((x ^ y) & 0x3F) << 26);
+}
+
+/**
+ * Create an RGBA8 texture filled by a function.
+ */
+static GRRLIB_texture *MakeTexture(u32 width, u32 height, u32 (*pixel)(u32 x, u32 y)) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(width, height, GX_TF_RGBA8);
+
+	for (u32 y = 0; y < height; y++) {
+		for (u32 x = 0; x < width; x++) {
+			GRRLIB_SetPixelToTexture(x, y, tex, pixel(x, y));
+		}
+	}
+	return tex;
+}
+
+/**
+ * The window average GRRLIB_BMFX_Blur computed pixel by pixel before its running sums.
+ */
+static u32 ReferenceBlurPixel(const GRRLIB_texture *tex, s32 x, s32 y, s32 factor, bool clamp) {
+	const u32 center = GRRLIB_GetPixelFromTexture(x, y, tex);
+	const u32 n = (2 * factor + 1) * (2 * factor + 1);
+	u32 sum[4] = { 0, 0, 0, 0 };
+
+	for (s32 k = x - factor; k <= x + factor; k++) {
+		for (s32 l = y - factor; l <= y + factor; l++) {
+			u32 c = center;
+
+			if (clamp) {
+				c = GRRLIB_GetPixelFromTexture(std::min(std::max(k, 0), (s32)tex->width - 1),
+				                               std::min(std::max(l, 0), (s32)tex->height - 1), tex);
+			}
+			else if (k >= 0 && k < (s32)tex->width && l >= 0 && l < (s32)tex->height) {
+				c = GRRLIB_GetPixelFromTexture(k, l, tex);
+			}
+			sum[0] += GRRLIB_R(c);  sum[1] += GRRLIB_G(c);  sum[2] += GRRLIB_B(c);  sum[3] += GRRLIB_A(c);
+		}
+	}
+	if (clamp) {
+		for (u32 &s : sum) {
+			s += n / 2;
+		}
+	}
+	return GRRLIB_RGBA(sum[0] / n, sum[1] / n, sum[2] / n, sum[3] / n);
+}
+
+class Blur : public ::testing::TestWithParam<u32> {};
+
+TEST_P(Blur, MatchesWindowAverage) {
+	const u32 factor = GetParam();
+	GRRLIB_texture *src = MakeTexture(23, 13, NoisyPixel);
+	GRRLIB_texture *dst = GRRLIB_CreateEmptyTextureFmt(23, 13, GX_TF_RGBA8);
+	GRRLIB_texture *box = GRRLIB_CreateEmptyTextureFmt(23, 13, GX_TF_RGBA8);
+
+	GRRLIB_BMFX_Blur(src, dst, factor);
+	ASSERT_TRUE(GRRLIB_BMFX_BoxBlur(src, box, factor, 1));
+	for (u32 y = 0; y < 13; y++) {
+		for (u32 x = 0; x < 23; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, dst), ReferenceBlurPixel(src, x, y, factor, false)) << x << "," << y;
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, box), ReferenceBlurPixel(src, x, y, factor, true)) << x << "," << y;
+		}
+	}
+
+	// In place, the result is the same
+	GRRLIB_BMFX_Blur(src, src, factor);
+	EXPECT_EQ(memcmp(src->data, dst->data, GRRLIB_GetTextureDataSize(src)), 0);
+	GRRLIB_FreeTexture(src);
+	GRRLIB_FreeTexture(dst);
+	GRRLIB_FreeTexture(box);
+}
+
+INSTANTIATE_TEST_SUITE_P(Factors, Blur, ::testing::Values(0, 1, 3, 6, 20));
+
+TEST(Blur, PassesRepeatTheBox) {
+	GRRLIB_texture *src = MakeTexture(32, 24, PhotoPixel);
+	GRRLIB_texture *once = GRRLIB_CreateEmptyTextureFmt(32, 24, GX_TF_RGBA8);
+	GRRLIB_texture *thrice = GRRLIB_CreateEmptyTextureFmt(32, 24, GX_TF_RGBA8);
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+
+	ASSERT_TRUE(GRRLIB_BMFX_BoxBlur(src, thrice, 2, 3));
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBytes, before.liveBytes);
+	for (int i = 0; i < 3; i++) {
+		GRRLIB_BMFX_BoxBlur((i == 0) ? src : once, once, 2, 1);
+	}
+	EXPECT_EQ(memcmp(once->data, thrice->data, GRRLIB_GetTextureDataSize(once)), 0);
+	GRRLIB_FreeTexture(src);
+	GRRLIB_FreeTexture(once);
+	GRRLIB_FreeTexture(thrice);
+}
+
+TEST(Blur, KeepsFlatColors) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(9, 7, GX_TF_RGB565);
+	const u32 color = GRRLIB_UnpackRGB565(0x7BEF);
+
+	for (u32 y = 0; y < 7; y++) {
+		for (u32 x = 0; x < 9; x++) {
+			GRRLIB_SetPixelToTexture(x, y, tex, color);
+		}
+	}
+	GRRLIB_BMFX_Blur(tex, tex, 4);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(0, 0, tex), color);
+	ASSERT_TRUE(GRRLIB_BMFX_BoxBlur(tex, tex, 3, 3));
+	for (u32 y = 0; y < 7; y++) {
+		for (u32 x = 0; x < 9; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), color);
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+/** The color filters as computed pixel by pixel before their tile kernels. */
+static u32 ReferenceGrayscale(u32 color) {
+	const u8 gray = (GRRLIB_R(color) * 77 + GRRLIB_G(color) * 150 + GRRLIB_B(color) * 28) / 255;
+	return (gray << 24) | (gray << 16) | (gray << 8) | GRRLIB_A(color);
+}
+static u32 ReferenceSepia(u32 color) {
+	u16 sr = GRRLIB_R(color) * 0.393 + GRRLIB_G(color) * 0.769 + GRRLIB_B(color) * 0.189;
+	u16 sg = GRRLIB_R(color) * 0.349 + GRRLIB_G(color) * 0.686 + GRRLIB_B(color) * 0.168;
+	u16 sb = GRRLIB_R(color) * 0.272 + GRRLIB_G(color) * 0.534 + GRRLIB_B(color) * 0.131;
+	return GRRLIB_RGBA(std::min<u16>(sr, 255), std::min<u16>(sg, 255), sb, GRRLIB_A(color));
+}
+static u32 ReferenceInvert(u32 color) {
+	return ((0xFFFFFF - (color >> 8 & 0xFFFFFF)) << 8) | (color & 0xFF);
+}
+
+/** Every red and green value, with varied blue and alpha. */
+static u32 PaletteSweepPixel(u32 x, u32 y) {
+	return GRRLIB_RGBA(x, y, (x * 7 + y * 13) & 0xFF, x ^ y);
+}
+
+struct FilterCase {
+	void (*filter)(const GRRLIB_texture*, GRRLIB_texture*);
+	u32 (*reference)(u32 color);
+};
+
+class ColorFilter : public ::testing::TestWithParam<FilterCase> {};
+
+TEST_P(ColorFilter, MatchesReference) {
+	const FilterCase &param = GetParam();
+	GRRLIB_texture *src = MakeTexture(256, 256, PaletteSweepPixel);
+	GRRLIB_texture *tiles = GRRLIB_CreateEmptyTextureFmt(256, 256, GX_TF_RGBA8);
+	GRRLIB_texture *spans = GRRLIB_CreateEmptyTextureFmt(260, 256, GX_TF_RGBA8);
+
+	// Tile kernel between textures of the same size, spans otherwise
+	param.filter(src, tiles);
+	param.filter(src, spans);
+	for (u32 y = 0; y < 256; y++) {
+		for (u32 x = 0; x < 256; x++) {
+			const u32 color = PaletteSweepPixel(x, y);
+			const u32 expected = param.reference(color);
+
+			if (param.filter == GRRLIB_BMFX_Sepia && GRRLIB_GetPixelFromTexture(x, y, tiles) != expected) {
+				// Where the exact mix is a whole number, floating point gave one less
+				const u32 r = GRRLIB_R(color), g = GRRLIB_G(color), b = GRRLIB_B(color);
+				const u32 mix[3] = { r * 393 + g * 769 + b * 189, r * 349 + g * 686 + b * 168, r * 272 + g * 534 + b * 131 };
+				const u32 got = GRRLIB_GetPixelFromTexture(x, y, tiles);
+
+				for (int c = 0; c < 3; c++) {
+					const u32 shift = 24 - 8 * c;
+					const u32 e = (expected >> shift) & 0xFF, v = (got >> shift) & 0xFF;
+
+					ASSERT_TRUE(e == v || (v == e + 1 && mix[c] % 1000 == 0 && mix[c] / 1000 == v)) << x << "," << y;
+				}
+				ASSERT_EQ(got & 0xFF, expected & 0xFF);
+			}
+			else {
+				ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tiles), expected) << x << "," << y;
+			}
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, spans), GRRLIB_GetPixelFromTexture(x, y, tiles)) << x << "," << y;
+		}
+	}
+
+	// In place
+	param.filter(src, src);
+	EXPECT_EQ(memcmp(src->data, tiles->data, GRRLIB_GetTextureDataSize(src)), 0);
+	GRRLIB_FreeTexture(src);
+	GRRLIB_FreeTexture(tiles);
+	GRRLIB_FreeTexture(spans);
+}
+
+INSTANTIATE_TEST_SUITE_P(Filters, ColorFilter, ::testing::Values(
+	FilterCase{ GRRLIB_BMFX_Grayscale, ReferenceGrayscale },
+	FilterCase{ GRRLIB_BMFX_Sepia,     ReferenceSepia },
+	FilterCase{ GRRLIB_BMFX_Invert,    ReferenceInvert }
+));
+
+TEST(ColorFilter, ConvertsOtherFormats) {
+	GRRLIB_texture *src = GRRLIB_CreateEmptyTextureFmt(13, 9, GX_TF_RGB5A3);
+	GRRLIB_texture *dst = GRRLIB_CreateEmptyTextureFmt(13, 9, GX_TF_IA8);
+
+	for (u32 y = 0; y < 9; y++) {
+		for (u32 x = 0; x < 13; x++) {
+			GRRLIB_SetPixelToTexture(x, y, src, NoisyPixel(x, y));
+		}
+	}
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(dst, true));
+	GRRLIB_BMFX_Invert(src, dst);
+	for (u32 y = 0; y < 9; y++) {
+		for (u32 x = 0; x < 13; x++) {
+			GRRLIB_texture *expected = GRRLIB_CreateEmptyTextureFmt(1, 1, GX_TF_IA8);
+
+			GRRLIB_SetPixelToTexture(0, 0, expected, ReferenceInvert(GRRLIB_GetPixelFromTexture(x, y, src)));
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, dst), GRRLIB_GetPixelFromTexture(0, 0, expected)) << x << "," << y;
+			GRRLIB_FreeTexture(expected);
+		}
+	}
+	EXPECT_EQ(dst->dirtyBottom, 3);
+	GRRLIB_FreeTexture(src);
+	GRRLIB_FreeTexture(dst);
+}
@@ -0,0 +1,55 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file grrlib_test.h
+ * Fixture and helpers shared by the host unit tests.
+ */
+
+#ifndef __GRRLIB_TEST_H__
+#define __GRRLIB_TEST_H__
+
+#include <gtest/gtest.h>
+
+#include <grrlib-mod.h>
+#include <gxhost.h>
+extern "C" {
+#include "grrlib-mod/GRRLIB_private.h"
+}
+
+#include "test_images.h"
+
+/**
+ * Fixture initialising GRRLIB around each test.
+ */
+class GRRLIBTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		ASSERT_EQ(GRRLIB_Init(), 0);
+		GXHost_Reset();
+	}
+	void TearDown() override {
+		GRRLIB_Exit();
+	}
+};
+
+#endif // __GRRLIB_TEST_H__
@@ -0,0 +1,249 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "grrlib_test.h"
+
+/**
+ * Write a file to the temporary directory and return its path.
+ */
+static std::string WriteTempFile(const std::string &name, const std::vector<u8> &data) {
+	const std::string path = ::testing::TempDir() + name;
+	FILE *f = fopen(path.c_str(), "wb");
+	EXPECT_NE(f, nullptr);
+	fwrite(data.data(), 1, data.size(), f);
+	fclose(f);
+	return path;
+}
+
+/**
+ * Hand back every loaded request of a loader.
+ */
+static std::vector<GRRLIB_loadResult> PollAll(GRRLIB_loader *loader) {
+	std::vector<GRRLIB_loadResult> results;
+	GRRLIB_loadResult result;
+
+	while (GRRLIB_LoaderPoll(loader, &result) == true) {
+		results.push_back(result);
+	}
+	return results;
+}
+
+TEST(Loader, LoadsTextures) {
+	const std::string png = WriteTempFile("loader.png", MakePNG(40, 24));
+	const std::string bmp = WriteTempFile("loader.bmp", MakeBMP(13, 7, 8));
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(2);
+	int tag;
+
+	ASSERT_NE(loader, nullptr);
+	EXPECT_EQ(GRRLIB_CreateLoader(0), nullptr);
+	const u32 a = GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 0, nullptr, &tag);
+	const u32 b = GRRLIB_LoaderQueueTexture(loader, bmp.c_str(), GX_TF_RGB565, 0, nullptr, nullptr);
+	const u32 c = GRRLIB_LoaderQueueTexture(loader, "/nonexistent/file.png", GX_TF_RGBA8, 0, nullptr, nullptr);
+	EXPECT_NE(a, 0u);
+	EXPECT_NE(a, b);
+	EXPECT_NE(b, c);
+	GRRLIB_LoaderWait(loader);
+	EXPECT_EQ(GRRLIB_LoaderPending(loader), 3u);
+
+	std::vector<GRRLIB_loadResult> results = PollAll(loader);
+	ASSERT_EQ(results.size(), 3u);
+	EXPECT_EQ(GRRLIB_LoaderPending(loader), 0u);
+	for (const GRRLIB_loadResult &r : results) {
+		EXPECT_EQ(r.type, GRRLIB_LOAD_TEXTURE);
+		EXPECT_EQ(r.font, nullptr);
+		if (r.id == a) {
+			ASSERT_NE(r.texture, nullptr);
+			EXPECT_EQ(r.userData, &tag);
+			EXPECT_EQ(r.texture->width, 40u);
+			EXPECT_EQ(GRRLIB_GetPixelFromTexture(5, 17, r.texture), TestPixel(5, 17));
+		}
+		else if (r.id == b) {
+			ASSERT_NE(r.texture, nullptr);
+			EXPECT_EQ(r.texture->fmt, (u32)GX_TF_RGB565);
+			EXPECT_EQ(r.texture->height, 7u);
+		}
+		else {
+			EXPECT_EQ(r.id, c);
+			EXPECT_EQ(r.texture, nullptr);
+		}
+		GRRLIB_FreeTexture(r.texture);
+	}
+	EXPECT_FALSE(GRRLIB_LoaderPoll(loader, nullptr));
+	GRRLIB_FreeLoader(loader);
+	remove(png.c_str());
+	remove(bmp.c_str());
+}
+
+TEST(Loader, LoadsHigherPrioritiesFirst) {
+	const std::string png = WriteTempFile("loader_priority.png", MakePNG(64, 64));
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(1);
+	std::vector<u32> ids;
+
+	// The first request may start before the others are queued
+	ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 0, nullptr, nullptr));
+	ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 0, nullptr, nullptr));
+	ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 5, nullptr, nullptr));
+	ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 10, nullptr, nullptr));
+	ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 5, nullptr, nullptr));
+	GRRLIB_LoaderWait(loader);
+
+	std::vector<u32> order;
+	for (const GRRLIB_loadResult &r : PollAll(loader)) {
+		if (r.id != ids[0]) {
+			order.push_back(r.id);
+		}
+		GRRLIB_FreeTexture(r.texture);
+	}
+	EXPECT_EQ(order, std::vector<u32>({ ids[3], ids[2], ids[4], ids[1] }));
+	GRRLIB_FreeLoader(loader);
+	remove(png.c_str());
+}
+
+static std::vector<GRRLIB_loadResult> callbackResults;
+
+static void RecordResult(const GRRLIB_loadResult *result) {
+	callbackResults.push_back(*result);
+}
+
+TEST(Loader, CallsCallbacksWhenPolled) {
+	const std::string png = WriteTempFile("loader_callback.png", MakePNG(8, 8));
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(4);
+	std::vector<u32> ids;
+	int tag;
+
+	callbackResults.clear();
+	for (int i = 0; i < 32; i++) {
+		ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, i % 3, RecordResult, &tag));
+	}
+	GRRLIB_LoaderWait(loader);
+	EXPECT_TRUE(callbackResults.empty());
+	while (GRRLIB_LoaderPoll(loader, nullptr) == true) {
+	}
+
+	ASSERT_EQ(callbackResults.size(), 32u);
+	std::vector<u32> handed;
+	for (const GRRLIB_loadResult &r : callbackResults) {
+		EXPECT_NE(r.texture, nullptr);
+		EXPECT_EQ(r.userData, &tag);
+		handed.push_back(r.id);
+		GRRLIB_FreeTexture(r.texture);
+	}
+	std::sort(handed.begin(), handed.end());
+	EXPECT_EQ(handed, ids);
+	GRRLIB_FreeLoader(loader);
+	remove(png.c_str());
+}
+
+TEST(Loader, CancelsRequests) {
+	const std::string png = WriteTempFile("loader_cancel.png", MakePNG(256, 256));
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(1);
+	std::vector<u32> ids;
+
+	for (int i = 0; i < 8; i++) {
+		ids.push_back(GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 0, nullptr, nullptr));
+	}
+	EXPECT_TRUE(GRRLIB_LoaderCancel(loader, ids[7]));  // Queued
+	EXPECT_FALSE(GRRLIB_LoaderCancel(loader, ids[7]));
+	EXPECT_TRUE(GRRLIB_LoaderCancel(loader, ids[0]));  // Queued or being loaded
+	EXPECT_FALSE(GRRLIB_LoaderCancel(loader, 0));
+	EXPECT_EQ(GRRLIB_LoaderPending(loader), 6u);
+	GRRLIB_LoaderWait(loader);
+	EXPECT_TRUE(GRRLIB_LoaderCancel(loader, ids[3]));  // Loaded
+
+	GRRLIB_loadResult result;
+	ASSERT_TRUE(GRRLIB_LoaderPoll(loader, &result));
+	EXPECT_EQ(result.id, ids[1]);
+	EXPECT_FALSE(GRRLIB_LoaderCancel(loader, ids[1]));  // Handed back
+	GRRLIB_FreeTexture(result.texture);
+
+	std::vector<u32> handed;
+	for (const GRRLIB_loadResult &r : PollAll(loader)) {
+		handed.push_back(r.id);
+		GRRLIB_FreeTexture(r.texture);
+	}
+	EXPECT_EQ(handed, std::vector<u32>({ ids[2], ids[4], ids[5], ids[6] }));
+	GRRLIB_FreeLoader(loader);
+	remove(png.c_str());
+}
+
+TEST(Loader, FreesPendingRequests) {
+	const std::string png = WriteTempFile("loader_free.png", MakePNG(128, 128));
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(2);
+
+	for (int i = 0; i < 16; i++) {
+		GRRLIB_LoaderQueueTexture(loader, png.c_str(), GX_TF_RGBA8, 0, RecordResult, nullptr);
+	}
+	callbackResults.clear();
+	GRRLIB_FreeLoader(loader);
+	EXPECT_TRUE(callbackResults.empty());
+	GRRLIB_FreeLoader(nullptr);
+	remove(png.c_str());
+}
+
+TEST_F(GRRLIBTest, LoaderOpensFontsWhenPolled) {
+	const std::string notFont = WriteTempFile("loader_font.ttf", MakePNG(8, 8));
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(1);
+
+	const u32 a = GRRLIB_LoaderQueueTTF(loader, notFont.c_str(), 0, nullptr, nullptr);
+	const u32 b = GRRLIB_LoaderQueueTTF(loader, "/nonexistent/font.ttf", 0, nullptr, nullptr);
+	GRRLIB_LoaderWait(loader);
+
+	std::vector<GRRLIB_loadResult> results = PollAll(loader);
+	ASSERT_EQ(results.size(), 2u);
+	EXPECT_EQ(results[0].id, a);
+	EXPECT_EQ(results[1].id, b);
+	for (const GRRLIB_loadResult &r : results) {
+		EXPECT_EQ(r.type, GRRLIB_LOAD_TTF);
+		EXPECT_EQ(r.font, nullptr);
+		EXPECT_EQ(r.texture, nullptr);
+	}
+	GRRLIB_FreeLoader(loader);
+	remove(notFont.c_str());
+}
+
+TEST_F(GRRLIBTest, LoaderKeepsFontFiles) {
+	const char *path = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+	FILE *f = fopen(path, "rb");
+	if (f == nullptr) {
+		GTEST_SKIP() << "No TrueType font installed";
+	}
+	fclose(f);
+	GRRLIB_loader *loader = GRRLIB_CreateLoader(1);
+	int tag;
+
+	const u32 id = GRRLIB_LoaderQueueTTF(loader, path, 0, nullptr, &tag);
+	GRRLIB_LoaderWait(loader);
+	GRRLIB_loadResult result;
+	ASSERT_TRUE(GRRLIB_LoaderPoll(loader, &result));
+	EXPECT_EQ(result.id, id);
+	EXPECT_EQ(result.userData, &tag);
+	ASSERT_NE(result.font, nullptr);
+	EXPECT_NE(result.font->data, nullptr);
+	EXPECT_GT(GRRLIB_WidthTTF(result.font, "Loaded", 16), 0u);
+	GRRLIB_FreeTTF(result.font);
+	GRRLIB_FreeLoader(loader);
+}
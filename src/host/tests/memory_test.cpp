@@ -0,0 +1,259 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <cstring>
+#include <vector>
+
+#include "grrlib_test.h"
+
+/**
+ * Allocator counting its calls by hint, on top of the default one.
+ */
+struct CountingAllocator {
+	GRRLIB_allocator  backing;
+	u32               allocs[3] = { 0, 0, 0 };
+	u32               bytes[3] = { 0, 0, 0 };
+	u32               frees = 0;
+	u32               freedBytes = 0;
+
+	static void* Alloc(u32 size, u32 align, GRRLIB_memHint hint, void *user) {
+		CountingAllocator *self = static_cast<CountingAllocator*>(user);
+
+		self->allocs[hint]++;
+		self->bytes[hint] += size;
+		return self->backing.alloc(size, align, hint, self->backing.user);
+	}
+	static void Free(void *ptr, u32 size, void *user) {
+		CountingAllocator *self = static_cast<CountingAllocator*>(user);
+
+		self->frees++;
+		self->freedBytes += size;
+		self->backing.free(ptr, size, self->backing.user);
+	}
+	GRRLIB_allocator Install() {
+		const GRRLIB_allocator alloc = { Alloc, Free, this };
+
+		backing = GRRLIB_GetAllocator();
+		GRRLIB_SetAllocator(&alloc);
+		return alloc;
+	}
+};
+
+TEST(Memory, StatsReturnToBaselineAfterFree) {
+	const std::vector<u8> png = MakePNG(40, 24);
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+
+	for (u32 fmt : { (u32)GX_TF_RGBA8, (u32)GX_TF_RGB565, (u32)GX_TF_CI8, (u32)GRRLIB_TEXFMT_CMPR_HQ }) {
+		GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), fmt);
+		ASSERT_NE(tex, nullptr);
+		ASSERT_NE(tex->data, nullptr);
+		EXPECT_GE(GRRLIB_GetMemStats().liveBytes, before.liveBytes + GRRLIB_GetTextureDataSize(tex) + sizeof(GRRLIB_texture));
+		GRRLIB_FreeTexture(tex);
+	}
+
+	const GRRLIB_memStats after = GRRLIB_GetMemStats();
+	EXPECT_EQ(after.liveBytes, before.liveBytes);
+	EXPECT_EQ(after.liveBlocks, before.liveBlocks);
+	EXPECT_GT(after.peakBytes, before.liveBytes);
+	EXPECT_GT(after.allocations, before.allocations);
+}
+
+TEST(Memory, CustomAllocatorSeesHints) {
+	const std::vector<u8> png = MakePNG(40, 24);
+	CountingAllocator counting;
+
+	counting.Install();
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GX_TF_I8);
+	ASSERT_NE(tex, nullptr);
+	GRRLIB_FreeTexture(tex);
+	GRRLIB_SetAllocator(nullptr);
+
+	// The texture structure is hot, its data cold, the decoded pixels scratch
+	EXPECT_GE(counting.allocs[GRRLIB_MEM_HOT], 1u);
+	EXPECT_EQ(counting.bytes[GRRLIB_MEM_COLD], GX_GetTexBufferSize(40, 24, GX_TF_I8, GX_FALSE, 0));
+	EXPECT_GE(counting.bytes[GRRLIB_MEM_SCRATCH], 40u * 24u * 4u);
+	EXPECT_EQ(counting.frees, counting.allocs[0] + counting.allocs[1] + counting.allocs[2]);
+	EXPECT_EQ(counting.freedBytes, counting.bytes[0] + counting.bytes[1] + counting.bytes[2]);
+}
+
+TEST(Memory, ArenaFreesLevelInOneReset) {
+	const std::vector<u8> png = MakePNG(32, 32);
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+	CountingAllocator counting;
+	std::vector<GRRLIB_texture*> textures;
+
+	counting.Install();
+	GRRLIB_arena *arena = GRRLIB_CreateArena(nullptr, 64 * 1024);
+	ASSERT_NE(arena, nullptr);
+	const GRRLIB_allocator alloc = GRRLIB_ArenaAllocator(arena);
+	GRRLIB_SetAllocator(&alloc);
+	for (int i = 0; i < 8; i++) {
+		textures.push_back(GRRLIB_LoadTextureFmt(png.data(), png.size(), GX_TF_RGB565));
+		ASSERT_NE(textures.back(), nullptr);
+	}
+	GRRLIB_SetAllocator(nullptr);
+
+	// The textures are in the arena, the decoded pixels were not
+	const u8 *base = static_cast<const u8*>(textures[0]->data);
+	EXPECT_GE(GRRLIB_GetArenaUsed(arena), 8 * (GRRLIB_GetTextureDataSize(textures[0]) + sizeof(GRRLIB_texture)));
+	EXPECT_LT(GRRLIB_GetArenaUsed(arena), 64u * 1024u);
+	for (GRRLIB_texture *tex : textures) {
+		EXPECT_EQ((uintptr_t)tex->data & 31, 0u);
+		EXPECT_LT(std::abs(static_cast<const u8*>(tex->data) - base), 64 * 1024);
+	}
+	EXPECT_EQ(counting.bytes[GRRLIB_MEM_COLD], 64u * 1024u);  // Only the memory of the arena
+	EXPECT_GE(counting.bytes[GRRLIB_MEM_SCRATCH], 8u * 32u * 32u * 4u);
+	EXPECT_GT(GRRLIB_GetMemStats().liveBytes, before.liveBytes + GRRLIB_GetArenaUsed(arena) / 2);
+
+	// Freeing the last texture gives its memory back, the others go with the reset
+	const u32 used = GRRLIB_GetArenaUsed(arena);
+	GRRLIB_FreeTexture(textures.back());
+	EXPECT_LT(GRRLIB_GetArenaUsed(arena), used);
+	GRRLIB_ResetArena(arena);
+	EXPECT_EQ(GRRLIB_GetArenaUsed(arena), 0u);
+	GRRLIB_FreeArena(arena);
+
+	const GRRLIB_memStats after = GRRLIB_GetMemStats();
+	EXPECT_EQ(after.liveBytes, before.liveBytes);
+	EXPECT_EQ(after.liveBlocks, before.liveBlocks);
+	EXPECT_EQ(counting.freedBytes, counting.bytes[0] + counting.bytes[1] + counting.bytes[2]);
+}
+
+TEST(Memory, ArenaTakesOutsideMemory) {
+	alignas(32) static u8 memory[16 * 1024];
+	GRRLIB_arena *arena = GRRLIB_CreateArena(memory, sizeof(memory));
+	ASSERT_NE(arena, nullptr);
+	const GRRLIB_allocator alloc = GRRLIB_ArenaAllocator(arena);
+
+	GRRLIB_SetAllocator(&alloc);
+	GRRLIB_texture *inside = GRRLIB_CreateEmptyTextureFmt(32, 32, GX_TF_RGB565);
+	GRRLIB_texture *outside = GRRLIB_CreateEmptyTextureFmt(128, 128, GX_TF_RGBA8);  // Larger than the arena
+	GRRLIB_SetAllocator(nullptr);
+	ASSERT_NE(inside, nullptr);
+	ASSERT_NE(outside, nullptr);
+
+	EXPECT_GE((u8*)inside->data, memory);
+	EXPECT_LT((u8*)inside->data, memory + sizeof(memory));
+	EXPECT_TRUE((u8*)outside->data < memory || (u8*)outside->data >= memory + sizeof(memory));
+
+	// Each block goes back to where it came from, whichever allocator is installed
+	GRRLIB_FreeTexture(outside);
+	GRRLIB_FreeTexture(inside);
+	EXPECT_EQ(GRRLIB_GetArenaUsed(arena), 0u);
+	GRRLIB_FreeArena(arena);
+}
+
+TEST(Memory, PoolServesSmallStructures) {
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+	GRRLIB_pool *pool = GRRLIB_CreatePool();
+	ASSERT_NE(pool, nullptr);
+	const GRRLIB_allocator alloc = GRRLIB_PoolAllocator(pool);
+	std::vector<GRRLIB_texturePart*> parts;
+
+	GRRLIB_SetAllocator(&alloc);
+	for (int i = 0; i < 1000; i++) {
+		parts.push_back(GRRLIB_CreateTexturePartEx(i % 64, i / 64, 8, 8, 64, 64));
+		ASSERT_NE(parts.back(), nullptr);
+	}
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(64, 64, GX_TF_RGBA8);  // Data too large for the pool
+	GRRLIB_SetAllocator(nullptr);
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBlocks, before.liveBlocks + 1000 + 2);
+
+	// Blocks of one size are packed together
+	u32 close = 0;
+	for (size_t i = 1; i < parts.size(); i++) {
+		close += (std::abs((u8*)parts[i] - (u8*)parts[i - 1]) <= 64);
+	}
+	EXPECT_GT(close, 900u);
+
+	// Freed blocks are reused
+	GRRLIB_texturePart *freed = parts[500];
+	GRRLIB_FreeTexturePart(freed);
+	GRRLIB_SetAllocator(&alloc);
+	parts[500] = GRRLIB_CreateTexturePartEx(0, 0, 8, 8, 64, 64);
+	GRRLIB_SetAllocator(nullptr);
+	EXPECT_EQ(parts[500], freed);
+
+	for (GRRLIB_texturePart *part : parts) {
+		GRRLIB_FreeTexturePart(part);
+	}
+	GRRLIB_FreeTexture(tex);
+	GRRLIB_FreePool(pool);
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBytes, before.liveBytes);
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBlocks, before.liveBlocks);
+}
+
+TEST(Memory, ReallocKeepsContents) {
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+	u8 *p = static_cast<u8*>(GRRLIB_MemAlloc(16, 8, GRRLIB_MEM_HOT));
+	ASSERT_NE(p, nullptr);
+
+	for (int i = 0; i < 16; i++) {
+		p[i] = i;
+	}
+	p = static_cast<u8*>(GRRLIB_MemRealloc(p, 16, 4096, 32, GRRLIB_MEM_COLD));
+	ASSERT_NE(p, nullptr);
+	EXPECT_EQ((uintptr_t)p & 31, 0u);
+	for (int i = 0; i < 16; i++) {
+		EXPECT_EQ(p[i], i);
+	}
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBytes, before.liveBytes + 4096);
+	GRRLIB_MemFree(p, 4096);
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBytes, before.liveBytes);
+}
+
+TEST_F(GRRLIBTest, AtlasAndDisplayListsReleaseTheirMemory) {
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+	const std::vector<u8> png = MakePNG(24, 20);
+	GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(64, 64, GX_TF_RGBA8, 1, true);
+
+	ASSERT_NE(atlas, nullptr);
+	for (int i = 0; i < 12; i++) {
+		EXPECT_NE(GRRLIB_AtlasAddImage(atlas, png.data(), png.size(), nullptr), nullptr);
+	}
+	EXPECT_GT(atlas->pageCount, 1u);
+	ASSERT_TRUE(GRRLIB_BeginDisplayList(4096));
+	GRRLIB_Rectangle(0, 0, 10, 10, true);
+	GRRLIB_FreeDisplayList(GRRLIB_EndDisplayList());
+	GRRLIB_FreeAtlas(atlas);
+
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBytes, before.liveBytes);
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBlocks, before.liveBlocks);
+}
+
+TEST_F(GRRLIBTest, AssetCacheReleasesEditedTextures) {
+	const GRRLIB_memStats before = GRRLIB_GetMemStats();
+	const std::vector<u8> png = MakePNG(32, 32);
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(1 << 20, GX_TF_RGBA8);
+
+	ASSERT_NE(cache, nullptr);
+	GRRLIB_texture *tex = GRRLIB_AssetCacheLoadBuffer(cache, "sprite", png.data(), png.size());
+	ASSERT_NE(tex, nullptr);
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(tex, true));
+	ASSERT_TRUE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_BOX));
+	GRRLIB_AssetCacheRelease(cache, tex);
+	GRRLIB_FreeAssetCache(cache);
+
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBytes, before.liveBytes);
+	EXPECT_EQ(GRRLIB_GetMemStats().liveBlocks, before.liveBlocks);
+}
@@ -0,0 +1,460 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "grrlib_test.h"
+
+/**
+ * Draw a run of sprites and return the number of FIFO bytes they took, state excluded.
+ */
+static u64 SpriteBytes(GRRLIB_texture *tex, u32 count) {
+	GRRLIB_DrawTexture(0, 0, tex, 0, 1, 1, 0, 0);  // Set up the state
+	GXHost_Reset();
+	for (u32 i = 0; i < count; i++) {
+		GRRLIB_DrawTexture(i, i, tex, 0, 1, 1, 0, 0);
+	}
+	return GXHost_GetFifoBytes();
+}
+
+/**
+ * Get the arguments of the last recorded command of a kind, among those whose first argument is first when given.
+ */
+static std::vector<u32> LastArgs(GXHost_command command, s64 first = -1) {
+	std::vector<u32> last;
+	u32 words;
+	const u32 *cmds = GXHost_GetCommands(&words);
+
+	for (u32 i = 0; i < words; i += 1 + GXHOST_ARGS(cmds[i])) {
+		const u32 count = GXHOST_ARGS(cmds[i]);
+
+		if (GXHOST_OP(cmds[i]) == (u32)command && (first < 0 || (count > 0 && cmds[i + 1] == first))) {
+			last.assign(cmds + i + 1, cmds + i + 1 + count);
+		}
+	}
+	return last;
+}
+
+/**
+ * Check that a draw left GX in the default 2D state: GX_PASSCLR, vertex colours and no texture coordinates.
+ * The state cache skips what the draw did not change, so a missing command means the default was kept.
+ */
+static void ExpectDefault2DState() {
+	const std::vector<u32> tex0 = LastArgs(GXHOST_SETVTXDESC, GX_VA_TEX0);
+	const std::vector<u32> clr0 = LastArgs(GXHOST_SETVTXDESC, GX_VA_CLR0);
+
+	EXPECT_EQ(LastArgs(GXHOST_SETTEVOP), (std::vector<u32>{ GX_TEVSTAGE0, GX_PASSCLR }));
+	if (!tex0.empty()) {
+		EXPECT_EQ(tex0, (std::vector<u32>{ GX_VA_TEX0, GX_NONE }));
+	}
+	if (!clr0.empty()) {
+		EXPECT_EQ(clr0, (std::vector<u32>{ GX_VA_CLR0, GX_DIRECT }));
+	}
+}
+
+TEST_F(GRRLIBTest, TexturedDrawsRestoreDefaultState) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(16, 16);
+
+	ASSERT_FALSE(GRRLIB_GetLazyState());
+	GRRLIB_DrawTexture(10, 10, tex, 0, 1, 1, 0, 0);
+	EXPECT_EQ(LastArgs(GXHOST_SETVTXDESC, GX_VA_TEX0), (std::vector<u32>{ GX_VA_TEX0, GX_NONE }));
+	ExpectDefault2DState();
+	GXHost_Reset();
+	GRRLIB_SetCompactVertices(false);
+	GRRLIB_DrawTexture(10.5f, 10, tex, 30, 2, 2, 0, 0);
+	ExpectDefault2DState();
+	GXHost_Reset();
+	GRRLIB_SpriteBatchBegin();
+	GRRLIB_DrawTexture(10, 10, tex, 0, 1, 1, 0, 0);
+	GRRLIB_SpriteBatchEnd();
+	ExpectDefault2DState();
+
+	// The lazy state leaves the textured state for the next draw
+	GRRLIB_SetLazyState(true);
+	GXHost_Reset();
+	GRRLIB_DrawTexture(10, 10, tex, 0, 1, 1, 0, 0);
+	EXPECT_EQ(LastArgs(GXHOST_SETTEVOP), (std::vector<u32>{ GX_TEVSTAGE0, GX_MODULATE }));
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, CompactShapesRestoreDefaultState) {
+	const guVector v[3] = { { 10, 10, 0 }, { 40, 10, 0 }, { 10, 40, 0 } };
+
+	ASSERT_TRUE(GRRLIB_GetCompactVertices());
+	GRRLIB_Line(10, 10, 50, 50);
+	EXPECT_EQ(LastArgs(GXHOST_SETVTXDESC, GX_VA_CLR0), (std::vector<u32>{ GX_VA_CLR0, GX_DIRECT }));
+	ExpectDefault2DState();
+	GXHost_Reset();
+	GRRLIB_Rectangle(10, 10, 40, 20, true);
+	EXPECT_EQ(LastArgs(GXHOST_SETVTXDESC, GX_VA_CLR0), (std::vector<u32>{ GX_VA_CLR0, GX_DIRECT }));
+	ExpectDefault2DState();
+	GXHost_Reset();
+	GRRLIB_Rectangle(10, 10, 40, 20, false);
+	ExpectDefault2DState();
+	GXHost_Reset();
+	GRRLIB_GXEngine(v, NULL, 3, GX_TRIANGLES);
+	ExpectDefault2DState();
+}
+
+TEST_F(GRRLIBTest, SpriteBatchUsesOneBegin) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(16, 16);
+
+	GRRLIB_SpriteBatchBegin();
+	for (int i = 0; i < 100; i++) {
+		GRRLIB_DrawTexture(i, i * 2, tex, i, 1, 1, 0, 0);
+	}
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_BEGIN), 0u);
+	GRRLIB_SpriteBatchEnd();
+
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_BEGIN), 1u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADTEXOBJ), 1u);
+	GRRLIB_FreeTexture(tex);
+}
+
+/**
+ * A vertex sent with f32 positions and texture coordinates, its position transformed by the loaded matrix.
+ */
+struct SpriteVertex {
+	f32 x, y, s, t;
+	u32 color;
+};
+
+/**
+ * Get the vertices recorded since the last reset, in the order they were sent.
+ */
+static std::vector<SpriteVertex> RecordedVertices() {
+	std::vector<SpriteVertex> vertices;
+	f32 m[12] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };
+	u32 words;
+	const u32 *cmds = GXHost_GetCommands(&words);
+	auto f = [](u32 bits) { f32 v; memcpy(&v, &bits, sizeof(v)); return v; };
+
+	for (u32 i = 0; i < words; i += 1 + GXHOST_ARGS(cmds[i])) {
+		const u32 *a = cmds + i + 1;
+
+		switch (GXHOST_OP(cmds[i])) {
+			case GXHOST_LOADPOSMTX:
+				for (u32 k = 0; k < 12; k++) {
+					m[k] = f(a[k]);
+				}
+				break;
+			case GXHOST_POSITION3F32:
+				vertices.push_back({ m[0] * f(a[0]) + m[1] * f(a[1]) + m[2] * f(a[2]) + m[3],
+				                     m[4] * f(a[0]) + m[5] * f(a[1]) + m[6] * f(a[2]) + m[7], 0, 0, 0 });
+				break;
+			case GXHOST_COLOR1U32:
+				vertices.back().color = a[0];
+				break;
+			case GXHOST_TEXCOORD2F32:
+				vertices.back().s = f(a[0]);
+				vertices.back().t = f(a[1]);
+				break;
+		}
+	}
+	return vertices;
+}
+
+TEST_F(GRRLIBTest, SpriteBatchMatchesDirectDrawing) {
+	struct Sprite { f32 x, y, degrees, scaleX, scaleY, offsetX, offsetY; u32 color; };
+	const Sprite sprites[] = {
+		{ 10, 20, 0, 1, 1, 0, 0, 0xFFFFFFFF },
+		{ 100.5f, 50.25f, 30, 2, -1.5f, 3, 4, 0x80FF4020 },
+		{ -20, 300, 275, 0.5f, 0.75f, 10, 5, 0x102030FF },
+		{ 320, 240, -90, -1, 1, 12.5f, 6, 0xFFFFFF40 },
+	};
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(32, 16);
+	GRRLIB_texturePart *part = GRRLIB_CreateTexturePart(4, 2, 20, 10, tex);
+
+	// The batch always sends f32 vertices, compare it with the f32 path of the direct drawing
+	GRRLIB_SetCompactVertices(false);
+	for (const Sprite &sprite : sprites) {
+		GRRLIB_Settings.color = sprite.color;
+		GRRLIB_DrawTexturePart(sprite.x, sprite.y, tex, part, sprite.degrees, sprite.scaleX, sprite.scaleY, sprite.offsetX, sprite.offsetY);
+	}
+	const std::vector<SpriteVertex> direct = RecordedVertices();
+
+	GXHost_Reset();
+	GRRLIB_SpriteBatchBegin();
+	for (const Sprite &sprite : sprites) {
+		GRRLIB_Settings.color = sprite.color;
+		GRRLIB_DrawTexturePart(sprite.x, sprite.y, tex, part, sprite.degrees, sprite.scaleX, sprite.scaleY, sprite.offsetX, sprite.offsetY);
+	}
+	GRRLIB_SpriteBatchEnd();
+	const std::vector<SpriteVertex> batched = RecordedVertices();
+
+	ASSERT_EQ(direct.size(), 4 * std::size(sprites));
+	ASSERT_EQ(batched.size(), direct.size());
+	for (size_t i = 0; i < direct.size(); i++) {
+		EXPECT_NEAR(batched[i].x, direct[i].x, 1e-3f) << i;
+		EXPECT_NEAR(batched[i].y, direct[i].y, 1e-3f) << i;
+		EXPECT_FLOAT_EQ(batched[i].s, direct[i].s) << i;
+		EXPECT_FLOAT_EQ(batched[i].t, direct[i].t) << i;
+		EXPECT_EQ(batched[i].color, direct[i].color) << i;
+	}
+	GRRLIB_FreeTexturePart(part);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, DirectSpritesUseOneBeginEach) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(16, 16);
+
+	for (int i = 0; i < 10; i++) {
+		GRRLIB_DrawTexture(i, i, tex, 0, 1, 1, 0, 0);
+	}
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_BEGIN), 10u);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, CompactVerticesAreSmaller) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(16, 16);
+
+	GRRLIB_SetLazyState(true);  // Count the vertices only
+
+	GRRLIB_Settings.compactVertices = false;
+	const u64 direct = SpriteBytes(tex, 10);
+	GRRLIB_Settings.compactVertices = true;
+	const u64 compact = SpriteBytes(tex, 10);
+
+	// A vertex takes 8 bytes (s16 position, u16 texture coordinates, konst color)
+	// instead of 24 (f32 position and texture coordinates, vertex color)
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_POSITION2S16), 40u);
+	EXPECT_EQ(direct - compact, 10u * 4 * (24 - 8));
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, CompactTexCoordsAreExact) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(24, 24);
+	GRRLIB_texturePart half = tex->part;
+	GRRLIB_texturePart *part = GRRLIB_CreateTexturePart(8, 0, 8, 8, tex);
+
+	// 0.5 is exact in 1.15 fixed point
+	half.x = 0.5f;
+	half.realWidth = 12;
+	GRRLIB_DrawTexturePart(10, 10, tex, &half, 0, 1, 1, 0, 0);
+	EXPECT_EQ(LastArgs(GXHOST_BEGIN), (std::vector<u32>{ GX_QUADS, GX_VTXFMT1, 4 }));
+
+	// 8/24 is not, so the part keeps f32 texture coordinates instead of being rounded
+	GXHost_Reset();
+	GRRLIB_DrawTexturePart(10, 10, tex, part, 0, 1, 1, 0, 0);
+	EXPECT_EQ(LastArgs(GXHOST_BEGIN), (std::vector<u32>{ GX_QUADS, GX_VTXFMT0, 4 }));
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_POSITION2S16), 0u);
+	GRRLIB_FreeTexturePart(part);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, StateCacheSkipsRedundantChanges) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(16, 16);
+
+	GRRLIB_SetLazyState(true);
+
+	GRRLIB_DrawTexture(0, 0, tex, 0, 1, 1, 0, 0);
+	GRRLIB_ResetStateStats();
+	GXHost_Reset();
+	GRRLIB_DrawTexture(10, 10, tex, 0, 1, 1, 0, 0);
+
+	const GRRLIB_stateStats stats = GRRLIB_GetStateStats();
+	// Only the position matrix changes
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADTEXOBJ), 0u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_SETTEVOP), 0u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADPOSMTX), 1u);
+	EXPECT_EQ(stats.issued, 1u);
+	EXPECT_GT(stats.elided, 0u);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, PaletteLoadedWithCI8Texture) {
+	GRRLIB_texture *a = GRRLIB_CreateEmptyTextureFmt(16, 16, GX_TF_CI8);
+	GRRLIB_texture *b = GRRLIB_CreateEmptyTextureFmt(16, 16, GX_TF_CI8);
+	GRRLIB_texture *rgba = GRRLIB_CreateEmptyTexture(16, 16);
+
+	GRRLIB_DrawTexture(0, 0, a, 0, 1, 1, 0, 0);
+	GRRLIB_DrawTexture(0, 0, rgba, 0, 1, 1, 0, 0);
+	GRRLIB_DrawTexture(0, 0, a, 0, 1, 1, 0, 0);  // The palette is still loaded
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADTLUT), 1u);
+	GRRLIB_DrawTexture(0, 0, b, 0, 1, 1, 0, 0);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADTLUT), 2u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADTEXOBJ), 4u);
+
+	GRRLIB_FreeTexture(a);
+	GRRLIB_FreeTexture(b);
+	GRRLIB_FreeTexture(rgba);
+}
+
+TEST_F(GRRLIBTest, DisplayListMatchesDirectDrawing) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(16, 16);
+	auto draw = [tex]() {
+		GRRLIB_Rectangle(5, 5, 50, 20, true);
+		GRRLIB_DrawTexture(10, 20, tex, 45, 2, 2, 0, 0);
+		GRRLIB_Line(0, 0, 100, 100);
+	};
+
+	ASSERT_TRUE(GRRLIB_BeginDisplayList(4096));
+	draw();
+	GRRLIB_displayList *list = GRRLIB_EndDisplayList();
+	ASSERT_NE(list, nullptr);
+
+	u32 listWords;
+	const u32 *listCmds = GXHost_GetDisplayList(list->data, &listWords);
+	ASSERT_NE(listCmds, nullptr);
+	const std::vector<u32> recorded(listCmds, listCmds + listWords);
+
+	GRRLIB_StateRestore();
+	GRRLIB_StateInvalidate();
+	GXHost_Reset();
+	draw();
+
+	u32 words;
+	const u32 *cmds = GXHost_GetCommands(&words);
+	EXPECT_EQ(std::vector<u32>(cmds, cmds + words), recorded);
+
+	GXHost_Reset();
+	GRRLIB_CallDisplayList(list);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_CALLDISPLIST), 1u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_BEGIN), 0u);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_F(GRRLIBTest, FreedDisplayListsUnpinMeshes) {
+	GRRLIB_3dMode(0.1, 1000, 45, false, false);
+	GRRLIB_DrawSphere(1, 10, 10, true, 0xFFFFFFFF);
+	const u32 small = GRRLIB_GetMeshCacheMemory();
+	GRRLIB_ClearMeshCache();
+	GRRLIB_DrawSphere(1, 20, 20, true, 0xFFFFFFFF);
+	const u32 large = GRRLIB_GetMeshCacheMemory();
+	GRRLIB_ClearMeshCache();
+
+	// Room for the large mesh only
+	ASSERT_GT(large, small);
+	GRRLIB_SetMeshCacheBudget(large + 64);
+	ASSERT_TRUE(GRRLIB_BeginDisplayList(1 << 16));
+	GRRLIB_DrawSphere(1, 10, 10, true, 0xFFFFFFFF);
+	GRRLIB_DrawSphere(1, 10, 10, true, 0xFFFFFFFF);
+	GRRLIB_displayList *list = GRRLIB_EndDisplayList();
+	ASSERT_NE(list, nullptr);
+	GRRLIB_Render();
+	GRRLIB_Render();
+
+	// The mesh of the display list is kept, the large mesh is drawn without being cached
+	GRRLIB_DrawSphere(1, 20, 20, true, 0xFFFFFFFF);
+	EXPECT_EQ(GRRLIB_GetMeshCacheMemory(), small);
+
+	// Once the display list is freed, the mesh can be evicted
+	GRRLIB_FreeDisplayList(list);
+	GRRLIB_Render();
+	GRRLIB_Render();
+	GRRLIB_DrawSphere(1, 20, 20, true, 0xFFFFFFFF);
+	EXPECT_EQ(GRRLIB_GetMeshCacheMemory(), large);
+
+	GRRLIB_ClearMeshCache();
+	GRRLIB_SetMeshCacheBudget(512 * 1024);
+	GRRLIB_2dMode();
+}
+
+TEST_F(GRRLIBTest, RenderCountsFrames) {
+	GRRLIB_ResetFrameStats();
+	for (int frame = 0; frame < 5; frame++) {
+		GRRLIB_Rectangle(0, 0, 10, 10, true);
+		GRRLIB_Rectangle(20, 0, 10, 10, true);
+		GRRLIB_Render();
+	}
+
+	const GRRLIB_frameStats stats = GRRLIB_GetFrameStats();
+	EXPECT_EQ(stats.frames, 5u);
+	EXPECT_EQ(stats.last.begins, 2u);
+	EXPECT_EQ(stats.last.vertices, 8u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_COPYDISP), 5u);
+}
+
+TEST_F(GRRLIBTest, FrameStatsBarsStayInTheGraph) {
+	GRRLIB_Render();
+	std::this_thread::sleep_for(std::chrono::milliseconds(60));
+	GRRLIB_Render();
+	ASSERT_GT(GRRLIB_GetFrameStats().last.cpuTime, 40000u);
+
+	// The application time alone is longer than the 256 pixels of 2 frames
+	GXHost_Reset();
+	GRRLIB_DrawFrameStats(10, 20);
+	u32 words;
+	const u32 *cmds = GXHost_GetCommands(&words);
+	u32 positions = 0;
+	for (u32 i = 0; i < words; i += 1 + GXHOST_ARGS(cmds[i])) {
+		if (GXHOST_OP(cmds[i]) == GXHOST_POSITION2S16) {
+			EXPECT_GE((s16)cmds[i + 1], 10);
+			EXPECT_LE((s16)cmds[i + 1], 10 + 256);
+			positions++;
+		}
+	}
+	EXPECT_GT(positions, 0u);
+}
+
+TEST(Framebuffers, TripleBufferedRenderShowsEveryFrame) {
+	GRRLIB_initOptions options = {};
+	options.pipelined = true;
+	options.xfbCount = 3;
+
+	ASSERT_EQ(GRRLIB_InitEx(&options), 0);
+	ASSERT_NE(GRRLIB_XFB[2], nullptr);
+
+	std::vector<void*> shown;
+	for (int frame = 0; frame < 12; frame++) {
+		GRRLIB_FillScreen(GRRLIB_RGBA(frame, 0, 0, 0xFF));
+		GRRLIB_Render();
+		shown.push_back(GXHost_GetDisplayedFramebuffer());
+	}
+	for (void *fb : shown) {
+		EXPECT_TRUE(fb == GRRLIB_XFB[0] || fb == GRRLIB_XFB[1] || fb == GRRLIB_XFB[2]);
+	}
+	std::sort(shown.begin(), shown.end());
+	EXPECT_EQ(std::unique(shown.begin(), shown.end()) - shown.begin(), 3);
+
+	// Every frame buffer is cleared on exit
+	GXHost_Reset();
+	GRRLIB_Exit();
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_COPYDISP), 3u);
+}
+
+TEST_F(GRRLIBTest, AtlasSpritesShareTexture) {
+	GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(256, 256, GX_TF_RGBA8, 1, true);
+	std::vector<const GRRLIB_texturePart*> parts;
+	GRRLIB_texture *page = nullptr;
+
+	for (u32 i = 0; i < 20; i++) {
+		GRRLIB_texture *sprite = GRRLIB_CreateEmptyTexture(8 + i, 24 - i);
+		parts.push_back(GRRLIB_AtlasAddTexture(atlas, sprite, &page));
+		GRRLIB_FreeTexture(sprite);
+	}
+	ASSERT_EQ(atlas->pageCount, 1u);
+	GXHost_Reset();
+	GRRLIB_SpriteBatchBegin();
+	for (u32 i = 0; i < parts.size(); i++) {
+		GRRLIB_DrawTexturePart(i * 10, i * 5, page, parts[i], 0, 1, 1, 0, 0);
+	}
+	GRRLIB_SpriteBatchEnd();
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_LOADTEXOBJ), 1u);
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_BEGIN), 1u);
+	GRRLIB_FreeAtlas(atlas);
+}
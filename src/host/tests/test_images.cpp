@@ -0,0 +1,368 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <png.h>
+#include <jpeglib.h>
+
+#include "test_images.h"
+
+std::vector<u8> MakePNG(u32 width, u32 height) {
+	return MakePNGFrom(width, height, TestPixel);
+}
+
+std::vector<u8> MakePNGFrom(u32 width, u32 height, u32 (*pixel)(u32 x, u32 y)) {
+	std::vector<u8> rgba(width * height * 4);
+	png_image image = {};
+	png_alloc_size_t size = 0;
+
+	for (u32 y = 0; y < height; y++) {
+		for (u32 x = 0; x < width; x++) {
+			const u32 c = pixel(x, y);
+			rgba[(y * width + x) * 4 + 0] = GRRLIB_R(c);
+			rgba[(y * width + x) * 4 + 1] = GRRLIB_G(c);
+			rgba[(y * width + x) * 4 + 2] = GRRLIB_B(c);
+			rgba[(y * width + x) * 4 + 3] = GRRLIB_A(c);
+		}
+	}
+	image.version = PNG_IMAGE_VERSION;
+	image.width = width;
+	image.height = height;
+	image.format = PNG_FORMAT_RGBA;
+	png_image_write_to_memory(&image, NULL, &size, 0, rgba.data(), 0, NULL);
+	std::vector<u8> png(size);
+	png_image_write_to_memory(&image, png.data(), &size, 0, rgba.data(), 0, NULL);
+	return png;
+}
+
+std::vector<u8> MakeJPG(u32 width, u32 height) {
+	return MakeJPGFrom(width, height, TestPixel);
+}
+
+std::vector<u8> MakeJPGFrom(u32 width, u32 height, u32 (*pixel)(u32 x, u32 y)) {
+	jpeg_compress_struct cinfo;
+	jpeg_error_mgr jerr;
+	unsigned char *out = NULL;
+	unsigned long size = 0;
+	std::vector<u8> row(width * 3);
+
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &out, &size);
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 100, TRUE);
+	cinfo.comp_info[0].h_samp_factor = 1;  // No chroma subsampling, the test image is noisy
+	cinfo.comp_info[0].v_samp_factor = 1;
+	jpeg_start_compress(&cinfo, TRUE);
+	while (cinfo.next_scanline < height) {
+		for (u32 x = 0; x < width; x++) {
+			const u32 c = pixel(x, cinfo.next_scanline);
+			row[x * 3 + 0] = GRRLIB_R(c);
+			row[x * 3 + 1] = GRRLIB_G(c);
+			row[x * 3 + 2] = GRRLIB_B(c);
+		}
+		JSAMPROW rows[1] = { row.data() };
+		jpeg_write_scanlines(&cinfo, rows, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	std::vector<u8> jpg(out, out + size);
+	free(out);
+	return jpg;
+}
+
+u32 BMPPixel(u32 x, u32 y, u32 bits) {
+	if (bits > 8) {
+		return TestPixel(x, y);
+	}
+	const u32 i = (x + y * 3) % (1 << bits);
+	return GRRLIB_RGBA(i * 17, i * 5, 255 - i, 0xFF);
+}
+
+std::vector<u8> MakeBMP(u32 width, u32 height, u32 bits) {
+	BMPOptions options;
+
+	options.bits = bits;
+	return MakeBMPEx(width, height, options);
+}
+
+/**
+ * Number of palette entries of a bitmap made by MakeBMPEx.
+ */
+static u32 BMPColors(const BMPOptions &options) {
+	if (options.bits > 8) {
+		return 0;
+	}
+	return (options.colors != 0) ? options.colors : 1 << options.bits;
+}
+
+/**
+ * Palette index of a pixel of a bitmap made by MakeBMPEx.
+ */
+static u32 BMPIndex(u32 x, u32 y, const BMPOptions &options) {
+	return ((options.index != nullptr) ? options.index(x, y) : x + y * 3) % BMPColors(options);
+}
+
+/**
+ * Color of a pixel of a bitmap with color masks, before it is reduced to the bits of the masks.
+ */
+static u32 BMPMaskedColor(u32 x, u32 y, const BMPOptions &options) {
+	const u32 alpha = (options.masks[3] != 0) ? (x * 29 + y * 11) & 0xFF : 0xFF;
+	return (TestPixel(x, y) & ~0xFFu) | alpha;
+}
+
+/**
+ * Value of one channel of a bitmap with color masks.
+ */
+static u32 BMPMaskValue(u32 c8, u32 mask) {
+	u32 shift = 0, bits = 0;
+	if (mask == 0) {
+		return 0;
+	}
+	while (((mask >> shift) & 1) == 0) shift++;
+	while (((u64)mask >> (shift + bits)) != 0) bits++;
+	return (c8 >> (8 - bits)) << shift;
+}
+
+u32 BMPExPixel(u32 x, u32 y, const BMPOptions &options) {
+	if (options.bits <= 8) {
+		return BMPPixel(BMPIndex(x, y, options), 0, 8);
+	}
+	if (options.bits == 24 || (options.bits == 32 && options.compression == 0)) {
+		return TestPixel(x, y);
+	}
+	const u32 c = BMPMaskedColor(x, y, options);
+	const u32 masks[4] = {
+		options.masks[0], options.masks[1], options.masks[2], options.masks[3]
+	};
+	const u32 channels[4] = { GRRLIB_R(c), GRRLIB_G(c), GRRLIB_B(c), GRRLIB_A(c) };
+	u32 out[4];
+	for (u32 i = 0; i < 4; i++) {
+		u32 shift = 0, bits = 0;
+		if (masks[i] == 0) {
+			out[i] = (i == 3) ? 0xFF : 0;
+			continue;
+		}
+		while (((masks[i] >> shift) & 1) == 0) shift++;
+		while (((u64)masks[i] >> (shift + bits)) != 0) bits++;
+		const u32 max = (1 << bits) - 1, v = channels[i] >> (8 - bits);
+		out[i] = (v * 255 + max / 2) / max;
+	}
+	return GRRLIB_RGBA(out[0], out[1], out[2], out[3]);
+}
+
+/**
+ * Run-length encode a row of palette indexes, 8 or 4 bits per index.
+ */
+static void EncodeRLERow(std::vector<u8> &out, const std::vector<u8> &row, bool rle4) {
+	const u32 width = row.size();
+	u32 x = 0;
+
+	while (x < width) {
+		u32 run = 1;
+		while (x + run < width && run < 255 && row[x + run] == row[x]) run++;
+		if (run >= 2 || width - x < 3) {
+			out.push_back(run);
+			out.push_back(rle4 ? row[x] << 4 | row[x] : row[x]);
+			x += run;
+			continue;
+		}
+		// Absolute run up to the next repeated index
+		u32 n = 0;
+		while (x + n < width && n < 255 && !(x + n + 1 < width && row[x + n] == row[x + n + 1])) n++;
+		if (n < 3) {
+			out.push_back(1);
+			out.push_back(rle4 ? row[x] << 4 | row[x] : row[x]);
+			x++;
+			continue;
+		}
+		out.push_back(0);
+		out.push_back(n);
+		const size_t start = out.size();
+		for (u32 i = 0; i < n; i++) {
+			if (!rle4) {
+				out.push_back(row[x + i]);
+			}
+			else if (i & 1) {
+				out.back() |= row[x + i];
+			}
+			else {
+				out.push_back(row[x + i] << 4);
+			}
+		}
+		if ((out.size() - start) & 1) {
+			out.push_back(0);  // Padded to 16 bits
+		}
+		x += n;
+	}
+}
+
+std::vector<u8> MakeBMPEx(u32 width, u32 height, const BMPOptions &options) {
+	const u32 bits = options.bits;
+	const u32 colors = BMPColors(options);
+	const bool core = options.headerSize == 12;
+	const bool bitfields = options.compression == 3;
+	const bool alphaBitfields = bitfields && options.headerSize == 40 && options.masks[3] != 0;
+	const u32 maskBytes = (bitfields && options.headerSize == 40) ? (alphaBitfields ? 16 : 12) : 0;
+	const u32 entrySize = core ? 3 : 4;
+	const u32 offs = 14 + options.headerSize + maskBytes + colors * entrySize + options.gap;
+	const u32 stride = ((width * bits + 31) / 32) * 4;
+	std::vector<u8> bmp(offs, 0);
+	auto put16 = [&](u32 at, u32 v) {
+		bmp[at] = v; bmp[at + 1] = v >> 8;
+	};
+	auto put32 = [&](u32 at, u32 v) {
+		bmp[at] = v; bmp[at + 1] = v >> 8; bmp[at + 2] = v >> 16; bmp[at + 3] = v >> 24;
+	};
+
+	bmp[0] = 'B';
+	bmp[1] = 'M';
+	put32(10, offs);
+	put32(14, options.headerSize);
+	if (core) {
+		put16(18, width);
+		put16(20, height);
+		put16(22, 1);
+		put16(24, bits);
+	}
+	else {
+		put32(18, width);
+		put32(22, options.topDown ? -(s32)height : height);
+		put16(26, 1);
+		put16(28, bits);
+		put32(30, alphaBitfields ? 6 : options.compression);
+		put32(46, colors);
+		const u32 masks = 14 + 40;
+		if (bitfields) {
+			for (u32 i = 0; i < ((options.headerSize == 40) ? maskBytes / 4 : 4); i++) {
+				put32(masks + i * 4, options.masks[i]);
+			}
+		}
+	}
+	for (u32 i = 0; i < colors; i++) {
+		const u32 c = BMPPixel(i, 0, 8);
+		u8 *p = &bmp[14 + options.headerSize + maskBytes + i * entrySize];
+		p[0] = GRRLIB_B(c);
+		p[1] = GRRLIB_G(c);
+		p[2] = GRRLIB_R(c);
+	}
+	std::fill(bmp.begin() + offs - options.gap, bmp.end(), 0xEE);
+
+	if (options.compression == 1 || options.compression == 2) {
+		std::vector<u8> out;
+		for (u32 y = height; y-- > 0; ) {  // Bottom-up
+			std::vector<u8> row(width);
+			for (u32 x = 0; x < width; x++) {
+				row[x] = BMPIndex(x, y, options);
+			}
+			EncodeRLERow(out, row, options.compression == 2);
+			out.push_back(0);
+			out.push_back(y == 0 ? 1 : 0);  // End of bitmap after the top row
+		}
+		bmp.insert(bmp.end(), out.begin(), out.end());
+	}
+	else {
+		bmp.resize(offs + stride * height, 0);
+		for (u32 y = 0; y < height; y++) {
+			u8 *row = &bmp[offs + (options.topDown ? y : height - 1 - y) * stride];
+			for (u32 x = 0; x < width; x++) {
+				u8 *p = &row[x * bits / 8];
+				if (bits <= 8) {
+					row[x * bits / 8] |= BMPIndex(x, y, options) << (8 - bits - (x * bits) % 8);
+				}
+				else if (bitfields || bits == 16) {
+					const u32 c = BMPMaskedColor(x, y, options);
+					const u32 v = BMPMaskValue(GRRLIB_R(c), options.masks[0]) | BMPMaskValue(GRRLIB_G(c), options.masks[1]) |
+					              BMPMaskValue(GRRLIB_B(c), options.masks[2]) | BMPMaskValue(GRRLIB_A(c), options.masks[3]);
+					for (u32 i = 0; i < bits / 8; i++) {
+						p[i] = v >> (i * 8);
+					}
+				}
+				else {
+					const u32 c = TestPixel(x, y);
+					p[0] = GRRLIB_B(c);
+					p[1] = GRRLIB_G(c);
+					p[2] = GRRLIB_R(c);
+					if (bits == 32) {
+						p[3] = 0xFF;
+					}
+				}
+			}
+		}
+	}
+	put32(2, bmp.size());
+	if (!core) {
+		put32(34, bmp.size() - offs);
+	}
+	return bmp;
+}
+
+std::vector<u8> MakeTPL(const std::vector<TPLImage> &images, std::vector<u32> *offsets) {
+	const u32 count = images.size();
+	u32 offs = (12 + count * 8 + count * 36 + 31) & ~31;
+	std::vector<u8> tpl(offs, 0);
+	auto put32 = [&tpl](u32 at, u32 v) {
+		tpl[at] = v >> 24; tpl[at + 1] = v >> 16; tpl[at + 2] = v >> 8; tpl[at + 3] = v;
+	};
+
+	put32(0, 0x0020AF30);
+	put32(4, count);
+	put32(8, 12);
+	for (u32 i = 0; i < count; i++) {
+		const u32 header = 12 + count * 8 + i * 36;
+		const u32 size = GX_GetTexBufferSize(images[i].width, images[i].height, images[i].fmt, GX_FALSE, 0);
+
+		put32(12 + i * 8, header);
+		put32(header, images[i].height << 16 | images[i].width);
+		put32(header + 4, images[i].fmt);
+		put32(header + 8, offs);
+		offsets->push_back(offs);
+		tpl.resize(offs + size, i + 1);
+		offs = (offs + size + 31) & ~31;
+		tpl.resize(offs, 0);
+	}
+	return tpl;
+}
+
+double PSNR(const GRRLIB_texture *tex, u32 (*pixel)(u32 x, u32 y)) {
+	double sum = 0;
+
+	for (u32 y = 0; y < tex->height; y++) {
+		for (u32 x = 0; x < tex->width; x++) {
+			const u32 got = GRRLIB_GetPixelFromTexture(x, y, tex);
+			const u32 want = pixel(x, y);
+			const int dr = (int)GRRLIB_R(got) - (int)GRRLIB_R(want);
+			const int dg = (int)GRRLIB_G(got) - (int)GRRLIB_G(want);
+			const int db = (int)GRRLIB_B(got) - (int)GRRLIB_B(want);
+			sum += dr * dr + dg * dg + db * db;
+		}
+	}
+	if (sum == 0) {
+		return INFINITY;
+	}
+	return 10 * std::log10(255.0 * 255.0 * 3 * tex->width * tex->height / sum);
+}
@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file test_images.h
+ * Images generated in memory for the host unit tests and benchmarks.
+ */
+
+#ifndef __TEST_IMAGES_H__
+#define __TEST_IMAGES_H__
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <grrlib-mod.h>
+
+/**
+ * Pixel of the test images, in RGBA format.
+ */
+static inline u32 TestPixel(u32 x, u32 y) {
+	return GRRLIB_RGBA((x * 37) & 0xFF, (y * 53) & 0xFF, (x * y) & 0xFF, 0xFF);
+}
+
+/**
+ * Pixel of a smooth image with a few sharp edges, closer to a photo than TestPixel.
+ */
+static inline u32 PhotoPixel(u32 x, u32 y) {
+	const int edge = (((x / 40) + (y / 40)) & 1) ? 24 : -24;
+	const int r = 128 + (int)(90 * std::sin(x * 0.05) + 20 * std::cos(y * 0.11)) + edge;
+	const int g = 128 + (int)(100 * std::sin((x + y) * 0.03));
+	const int b = 128 + (int)(90 * std::cos(y * 0.04) * std::sin(x * 0.02)) - edge;
+	return GRRLIB_RGBA(std::min(std::max(r, 0), 255), g, std::min(std::max(b, 0), 255), 0xFF);
+}
+
+std::vector<u8> MakePNG(u32 width, u32 height);
+std::vector<u8> MakePNGFrom(u32 width, u32 height, u32 (*pixel)(u32 x, u32 y));
+std::vector<u8> MakeJPG(u32 width, u32 height);
+std::vector<u8> MakeJPGFrom(u32 width, u32 height, u32 (*pixel)(u32 x, u32 y));
+std::vector<u8> MakeBMP(u32 width, u32 height, u32 bits = 24);
+
+/**
+ * Pixel of the bitmaps made by MakeBMP, palettized bitmaps use their own colors.
+ */
+u32 BMPPixel(u32 x, u32 y, u32 bits);
+
+/**
+ * Layout of the bitmaps made by MakeBMPEx.
+ */
+struct BMPOptions {
+	u32 bits = 24;                          ///< 1, 4, 8, 16, 24 or 32.
+	u32 compression = 0;                    ///< 0 (BI_RGB), 1 (BI_RLE8), 2 (BI_RLE4) or 3 (BI_BITFIELDS).
+	u32 headerSize = 40;                    ///< 12 (OS/2), 40, 108 or 124.
+	bool topDown = false;                   ///< Rows stored from the top.
+	u32 gap = 0;                            ///< Bytes between the palette and the pixels.
+	u32 colors = 0;                         ///< Entries of the palette, 0 for 1 << bits.
+	u32 masks[4] = { 0x7C00, 0x03E0, 0x001F, 0 };  ///< Red, green, blue and alpha masks, used by BI_BITFIELDS and 16 bits.
+	u32 (*index)(u32 x, u32 y) = nullptr;   ///< Palette index of the pixels, nullptr for the indexes of BMPPixel.
+};
+
+std::vector<u8> MakeBMPEx(u32 width, u32 height, const BMPOptions &options);
+
+/**
+ * Pixel of the bitmaps made by MakeBMPEx.
+ */
+u32 BMPExPixel(u32 x, u32 y, const BMPOptions &options);
+
+/**
+ * Image of a TPL file made by MakeTPL.
+ */
+struct TPLImage {
+	u32 width, height, fmt;
+};
+
+/**
+ * Build a TPL file, the data of image i is filled with i + 1 and aligned to 32 bytes.
+ * @param offsets Receives the offset of the data of each image.
+ */
+std::vector<u8> MakeTPL(const std::vector<TPLImage> &images, std::vector<u32> *offsets);
+
+/**
+ * Peak signal-to-noise ratio of the red, green and blue of a texture against an image, in dB.
+ */
+double PSNR(const GRRLIB_texture *tex, u32 (*pixel)(u32 x, u32 y));
+
+#endif // __TEST_IMAGES_H__
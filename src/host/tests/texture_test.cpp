@@ -0,0 +1,1539 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "grrlib_test.h"
+
+static void ExpectTestImage(const GRRLIB_texture *tex, u32 width, u32 height, int tolerance) {
+	for (u32 y = 0; y < height; y++) {
+		for (u32 x = 0; x < width; x++) {
+			const u32 got = GRRLIB_GetPixelFromTexture(x, y, tex);
+			const u32 want = TestPixel(x, y);
+			ASSERT_NEAR(GRRLIB_R(got), GRRLIB_R(want), tolerance) << x << "," << y;
+			ASSERT_NEAR(GRRLIB_G(got), GRRLIB_G(want), tolerance) << x << "," << y;
+			ASSERT_NEAR(GRRLIB_B(got), GRRLIB_B(want), tolerance) << x << "," << y;
+			ASSERT_EQ(GRRLIB_A(got), 0xFFu) << x << "," << y;
+		}
+	}
+}
+
+TEST(Pixel, RoundTrip) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(8, 8);
+
+	ASSERT_NE(tex, nullptr);
+	for (u32 y = 0; y < 8; y++) {
+		for (u32 x = 0; x < 8; x++) {
+			GRRLIB_SetPixelToTexture(x, y, tex, GRRLIB_RGBA(x, y, x + y, 0x80 | x));
+		}
+	}
+	for (u32 y = 0; y < 8; y++) {
+		for (u32 x = 0; x < 8; x++) {
+			EXPECT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), GRRLIB_RGBA(x, y, x + y, 0x80 | x));
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Pixel, TiledLayout) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(8, 4);
+	const u8 *p = (const u8*)tex->data;
+
+	// Pixel (5,1) is in the second 4x4 tile, at index 5 of the tile
+	GRRLIB_SetPixelToTexture(5, 1, tex, 0x11223344);
+	EXPECT_EQ(p[64 + 10], 0x44);
+	EXPECT_EQ(p[64 + 11], 0x11);
+	EXPECT_EQ(p[64 + 42], 0x22);
+	EXPECT_EQ(p[64 + 43], 0x33);
+	GRRLIB_FreeTexture(tex);
+}
+
+/**
+ * Source image with the given channel order, 0 for red, 1 green, 2 blue, 3 alpha, 4 gray.
+ */
+static std::vector<u8> MakeRaw(u32 width, u32 height, const std::vector<int> &channels) {
+	std::vector<u8> raw;
+
+	for (u32 y = 0; y < height; y++) {
+		for (u32 x = 0; x < width; x++) {
+			const u32 c = TestPixel(x, y);
+			const u8 values[5] = { (u8)GRRLIB_R(c), (u8)GRRLIB_G(c), (u8)GRRLIB_B(c), (u8)((x + y) * 7), (u8)GRRLIB_R(c) };
+			for (int ch : channels) {
+				raw.push_back(values[ch]);
+			}
+		}
+	}
+	return raw;
+}
+
+struct TilingCase {
+	GRRLIB_pixelLayout layout;
+	std::vector<int> channels;
+};
+
+class Tiling : public ::testing::TestWithParam<TilingCase> {};
+
+TEST_P(Tiling, MatchesSetPixel) {
+	const TilingCase &param = GetParam();
+	const bool alpha = std::find(param.channels.begin(), param.channels.end(), 3) != param.channels.end();
+	const bool gray = param.channels[0] == 4;
+
+	for (u32 width : { 1u, 4u, 7u, 16u, 18u }) {
+		for (u32 height : { 1u, 3u, 4u, 9u }) {
+			const std::vector<u8> raw = MakeRaw(width, height, param.channels);
+			GRRLIB_texture *want = GRRLIB_CreateEmptyTexture(width, height);
+			GRRLIB_texture *got = GRRLIB_CreateEmptyTexture(width, height);
+			const u32 size = GX_GetTexBufferSize(width, height, GX_TF_RGBA8, GX_FALSE, 0);
+
+			for (u32 y = 0; y < height; y++) {
+				for (u32 x = 0; x < width; x++) {
+					const u32 c = TestPixel(x, y);
+					const u8 r = GRRLIB_R(c);
+					GRRLIB_SetPixelToTexture(x, y, want, GRRLIB_RGBA(r, gray ? r : GRRLIB_G(c), gray ? r : GRRLIB_B(c),
+					                                                 alpha ? (x + y) * 7 : 0xFF));
+				}
+			}
+			memset(got->data, 0xCD, size);
+			GRRLIB_TileRGBA8(raw.data(), raw.size() / height, param.layout, got->data, width, height);
+			EXPECT_EQ(memcmp(got->data, want->data, size), 0) << width << "x" << height;
+
+			GRRLIB_FreeTexture(want);
+			GRRLIB_FreeTexture(got);
+		}
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, Tiling, ::testing::Values(
+	TilingCase{ GRRLIB_LAYOUT_RGB,   { 0, 1, 2 } },
+	TilingCase{ GRRLIB_LAYOUT_RGBA,  { 0, 1, 2, 3 } },
+	TilingCase{ GRRLIB_LAYOUT_BGR,   { 2, 1, 0 } },
+	TilingCase{ GRRLIB_LAYOUT_BGRA,  { 2, 1, 0, 3 } },
+	TilingCase{ GRRLIB_LAYOUT_GRAY,  { 4 } },
+	TilingCase{ GRRLIB_LAYOUT_GRAYA, { 4, 3 } }
+));
+
+TEST(Texture, TilingBottomUp) {
+	const std::vector<u8> raw = MakeRaw(6, 5, { 0, 1, 2 });
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(6, 5);
+
+	// Start from the last row with a negative stride: the image is flipped
+	GRRLIB_TileRGBA8(&raw[4 * 6 * 3], -6 * 3, GRRLIB_LAYOUT_RGB, tex->data, 6, 5);
+	for (u32 y = 0; y < 5; y++) {
+		for (u32 x = 0; x < 6; x++) {
+			EXPECT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), TestPixel(x, 4 - y));
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Texture, LoadPNG) {
+	const std::vector<u8> png = MakePNG(12, 8);
+	GRRLIB_texture *tex = GRRLIB_LoadTexture(png.data());
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->width, 12u);
+	EXPECT_EQ(tex->height, 8u);
+	EXPECT_EQ(tex->fmt, (u32)GX_TF_RGBA8);
+	ExpectTestImage(tex, 12, 8, 0);
+	GRRLIB_FreeTexture(tex);
+}
+
+class LoadBMP : public ::testing::TestWithParam<u32> {};
+
+TEST_P(LoadBMP, Decodes) {
+	const u32 bits = GetParam();
+	const std::vector<u8> bmp = MakeBMP(13, 7, bits);
+	GRRLIB_texture *tex = GRRLIB_LoadTexture(bmp.data());
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->width, 13u);
+	EXPECT_EQ(tex->height, 7u);
+	for (u32 y = 0; y < 7; y++) {
+		for (u32 x = 0; x < 13; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), BMPPixel(x, y, bits)) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+INSTANTIATE_TEST_SUITE_P(Depths, LoadBMP, ::testing::Values(1, 4, 8, 24, 32));
+
+struct BMPCase {
+	const char *name;
+	u32 width, height;
+	BMPOptions options;
+};
+
+static u32 RunIndex(u32 x, u32 y) {
+	return x / 5 + y;
+}
+
+static BMPCase MakeCase(const char *name, u32 width, u32 height, u32 bits, u32 compression = 0) {
+	BMPCase c = { name, width, height, {} };
+	c.options.bits = bits;
+	c.options.compression = compression;
+	return c;
+}
+
+static std::vector<BMPCase> BMPCases() {
+	std::vector<BMPCase> cases;
+	BMPCase c;
+
+	c = MakeCase("TopDown24", 13, 7, 24);            c.options.topDown = true;                      cases.push_back(c);
+	c = MakeCase("TopDown32", 13, 7, 32);            c.options.topDown = true;                      cases.push_back(c);
+	c = MakeCase("V5Header", 13, 7, 8);              c.options.headerSize = 124;  c.options.gap = 10;  c.options.colors = 100;  cases.push_back(c);
+	c = MakeCase("ShortPalette", 13, 7, 4);          c.options.colors = 5;                          cases.push_back(c);
+	c = MakeCase("OS2Indexed8", 13, 7, 8);           c.options.headerSize = 12;                     cases.push_back(c);
+	c = MakeCase("OS2Indexed1", 13, 7, 1);           c.options.headerSize = 12;                     cases.push_back(c);
+	c = MakeCase("RGB555", 13, 7, 16);                                                              cases.push_back(c);
+	c = MakeCase("Bitfields565", 13, 7, 16, 3);
+	c.options.masks[0] = 0xF800;  c.options.masks[1] = 0x07E0;  c.options.masks[2] = 0x001F;        cases.push_back(c);
+	c = MakeCase("Bitfields4444", 13, 7, 16, 3);     c.options.topDown = true;
+	c.options.masks[0] = 0x0F00;  c.options.masks[1] = 0x00F0;  c.options.masks[2] = 0x000F;  c.options.masks[3] = 0xF000;  cases.push_back(c);
+	c = MakeCase("BitfieldsABGR", 13, 7, 32, 3);     c.options.headerSize = 108;
+	c.options.masks[0] = 0x000000FF;  c.options.masks[1] = 0x0000FF00;  c.options.masks[2] = 0x00FF0000;  c.options.masks[3] = 0xFF000000;  cases.push_back(c);
+	c = MakeCase("BitfieldsBGRA", 13, 7, 32, 3);
+	c.options.masks[0] = 0x00FF0000;  c.options.masks[1] = 0x0000FF00;  c.options.masks[2] = 0x000000FF;  c.options.masks[3] = 0xFF000000;  cases.push_back(c);
+	c = MakeCase("BitfieldsNoAlpha", 13, 7, 32, 3);  c.options.headerSize = 56;
+	c.options.masks[0] = 0x00FF0000;  c.options.masks[1] = 0x0000FF00;  c.options.masks[2] = 0x000000FF;  cases.push_back(c);
+	c = MakeCase("RLE8", 37, 9, 8, 1);                                                              cases.push_back(c);
+	c = MakeCase("RLE8Runs", 37, 9, 8, 1);           c.options.index = RunIndex;                    cases.push_back(c);
+	c = MakeCase("RLE4", 37, 9, 4, 2);                                                              cases.push_back(c);
+	c = MakeCase("RLE4Runs", 37, 9, 4, 2);           c.options.index = RunIndex;                    cases.push_back(c);
+	return cases;
+}
+
+class BMPLayouts : public ::testing::TestWithParam<BMPCase> {};
+
+TEST_P(BMPLayouts, Decodes) {
+	const BMPCase &c = GetParam();
+	const std::vector<u8> bmp = MakeBMPEx(c.width, c.height, c.options);
+
+	for (const bool sized : { false, true }) {
+		GRRLIB_texture *tex = sized ? GRRLIB_LoadTextureFmt(bmp.data(), bmp.size(), GX_TF_RGBA8) : GRRLIB_LoadTextureBMP(bmp.data());
+
+		ASSERT_NE(tex, nullptr);
+		ASSERT_EQ(tex->width, c.width);
+		ASSERT_EQ(tex->height, c.height);
+		for (u32 y = 0; y < c.height; y++) {
+			for (u32 x = 0; x < c.width; x++) {
+				ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), BMPExPixel(x, y, c.options)) << x << "," << y;
+			}
+		}
+		GRRLIB_FreeTexture(tex);
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(Variants, BMPLayouts, ::testing::ValuesIn(BMPCases()),
+                         [](const ::testing::TestParamInfo<BMPCase> &info) { return std::string(info.param.name); });
+
+static const BMPOptions *stripeOptions;
+
+static u32 StripePixel(u32 x, u32 y) {
+	return BMPExPixel(x, y, *stripeOptions);
+}
+
+TEST(BMPStripes, MatchWholeImageConversion) {
+	for (const BMPCase &c : BMPCases()) {
+		const std::vector<u8> bmp = MakeBMPEx(c.width, c.height, c.options);
+		stripeOptions = &c.options;
+		const std::vector<u8> png = MakePNGFrom(c.width, c.height, StripePixel);
+
+		for (const u32 fmt : { (u32)GX_TF_RGB565, (u32)GX_TF_RGB5A3, (u32)GX_TF_I8, (u32)GX_TF_IA8, (u32)GX_TF_IA4,
+		                       (u32)GX_TF_CMPR, (u32)GX_TF_CI8, (u32)GRRLIB_TEXFMT_AUTO }) {
+			GRRLIB_texture *got = GRRLIB_LoadTextureFmt(bmp.data(), bmp.size(), fmt);
+			GRRLIB_texture *want = GRRLIB_LoadTextureFmt(png.data(), png.size(), fmt);
+
+			ASSERT_NE(got, nullptr);
+			ASSERT_NE(want, nullptr);
+			ASSERT_EQ(got->fmt, want->fmt) << c.name << " " << fmt;
+			ASSERT_EQ(GRRLIB_GetTextureDataSize(got), GRRLIB_GetTextureDataSize(want));
+			EXPECT_EQ(memcmp(got->data, want->data, GRRLIB_GetTextureDataSize(got)), 0) << c.name << " " << fmt;
+			GRRLIB_FreeTexture(got);
+			GRRLIB_FreeTexture(want);
+		}
+	}
+}
+
+TEST(Texture, RLESkippedPixelsAreTransparent) {
+	BMPOptions options;
+	options.bits = 8;
+	options.colors = 4;
+	std::vector<u8> bmp = MakeBMPEx(4, 3, options);
+	const u32 offs = bmp[10];
+	const u8 rle[] = {
+		2, 1, 0, 0,                      // Bottom row: 2 pixels, end of line
+		0, 2, 1, 0, 0, 3, 2, 3, 1, 0,    // Delta of one pixel, 3 absolute pixels
+		0, 0, 1, 3, 0, 1                 // End of line, top row: 1 pixel, end of bitmap
+	};
+
+	bmp.resize(offs);
+	bmp.insert(bmp.end(), rle, rle + sizeof(rle));
+	bmp[30] = 1;  // BI_RLE8
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(bmp.data(), bmp.size(), GX_TF_RGBA8);
+
+	ASSERT_NE(tex, nullptr);
+	const int want[3][4] = { { 3, -1, -1, -1 }, { -1, 2, 3, 1 }, { 1, 1, -1, -1 } };
+	for (u32 y = 0; y < 3; y++) {
+		for (u32 x = 0; x < 4; x++) {
+			const u32 color = (want[y][x] < 0) ? 0 : BMPPixel(want[y][x], 0, 8);
+			EXPECT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), color) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Texture, BMPErrorsReturnNull) {
+	BMPOptions options;
+	std::vector<u8> bmp = MakeBMPEx(13, 7, options);
+	const u8 notBMP[64] = { 'B', 'A' };
+
+	// Pixels missing
+	EXPECT_EQ(GRRLIB_LoadTextureFmt(bmp.data(), bmp.size() - 1, GX_TF_RGBA8), nullptr);
+	// Header missing
+	EXPECT_EQ(GRRLIB_LoadTextureFmt(bmp.data(), 30, GX_TF_RGBA8), nullptr);
+	EXPECT_EQ(GRRLIB_LoadTextureBMP(notBMP), nullptr);
+	// Unsupported depth
+	bmp[28] = 2;
+	EXPECT_EQ(GRRLIB_LoadTextureBMP(bmp.data()), nullptr);
+	bmp[28] = 24;
+	bmp[18] = bmp[19] = 0;  // No width
+	EXPECT_EQ(GRRLIB_LoadTextureBMP(bmp.data()), nullptr);
+
+	// Run-length encoded bitmaps cut short or stored top-down
+	options.bits = 8;
+	options.compression = 1;
+	bmp = MakeBMPEx(37, 9, options);
+	EXPECT_EQ(GRRLIB_LoadTextureFmt(bmp.data(), bmp.size() - 3, GX_TF_RGBA8), nullptr);
+	options.topDown = true;
+	bmp = MakeBMPEx(37, 9, options);
+	EXPECT_EQ(GRRLIB_LoadTextureFmt(bmp.data(), bmp.size(), GX_TF_RGBA8), nullptr);
+}
+
+TEST(Texture, LoadJPG) {
+	const std::vector<u8> jpg = MakeJPG(16, 8);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureJPGEx(jpg.data(), jpg.size());
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->width, 16u);
+	EXPECT_EQ(tex->height, 8u);
+	ExpectTestImage(tex, 16, 8, 24);  // Lossy even at quality 100
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Texture, LoadTPL) {
+	// One 4x4 RGBA8 image, big-endian headers
+	std::vector<u8> tpl(64 + 64, 0);
+	const u8 header[] = {
+		0x00, 0x20, 0xAF, 0x30,  0, 0, 0, 1,  0, 0, 0, 0x0C,   // Magic, count, table
+		0, 0, 0, 0x14,  0, 0, 0, 0,                            // Image header, no palette
+		0, 4, 0, 4,  0, 0, 0, GX_TF_RGBA8,  0, 0, 0, 64,        // Height, width, format, data
+	};
+	memcpy(tpl.data(), header, sizeof(header));
+	tpl[64] = 0xFF;
+	tpl[65] = 0x12;
+
+	GRRLIB_texture *tex = GRRLIB_LoadTextureEx(tpl.data(), tpl.size());
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->width, 4u);
+	EXPECT_EQ(tex->height, 4u);
+	EXPECT_EQ(tex->fmt, (u32)GX_TF_RGBA8);
+	EXPECT_EQ(GX_GetTexObjWidth(&tex->obj), 4);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(0, 0, tex), 0x120000FFu);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(1, 0, tex), 0u);
+	EXPECT_TRUE(tex->data < (void*)tpl.data() || tex->data >= (void*)(tpl.data() + tpl.size()));  // A copy
+	GRRLIB_FreeTexture(tex);
+
+	// No texture 1, not a TPL
+	EXPECT_EQ(GRRLIB_LoadTextureTPL(tpl.data(), tpl.size(), 1), nullptr);
+	tpl[1] = 0;
+	EXPECT_EQ(GRRLIB_LoadTextureTPL(tpl.data(), tpl.size(), 0), nullptr);
+}
+
+TEST(Texture, LoadTPLKeepsWrapModes) {
+	std::vector<u32> offsets;
+	std::vector<u8> tpl = MakeTPL({ { 8, 8, GX_TF_RGB565 } }, &offsets);
+
+	// Wrap S and T follow the data offset in the header of the image
+	tpl[12 + 8 + 12 + 3] = GX_REPEAT;
+	tpl[12 + 8 + 16 + 3] = GX_MIRROR;
+	GRRLIB_texture *tex = GRRLIB_LoadTextureTPL(tpl.data(), tpl.size(), 0);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(GX_GetTexObjWrapS(&tex->obj), GX_REPEAT);
+	EXPECT_EQ(GX_GetTexObjWrapT(&tex->obj), GX_MIRROR);
+	EXPECT_EQ((uintptr_t)GX_GetTexObjData(&tex->obj), MEM_VIRTUAL_TO_PHYSICAL(tex->data));
+	EXPECT_TRUE(tex->data < (void*)tpl.data() || tex->data >= (void*)(tpl.data() + tpl.size()));
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(7, 7, tex), GRRLIB_UnpackRGB565(0x0101));
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(TPLSet, SharesAlignedBuffers) {
+	std::vector<u32> offsets;
+	const std::vector<u8> file = MakeTPL({ { 4, 4, GX_TF_RGBA8 }, { 16, 8, GX_TF_I8 }, { 8, 8, GX_TF_RGB565 } }, &offsets);
+	u8 *tpl = (u8*)aligned_alloc(32, (file.size() + 31) & ~31);
+	memcpy(tpl, file.data(), file.size());
+
+	GRRLIB_tplSet *set = GRRLIB_OpenTPLSet(tpl, file.size());
+	ASSERT_NE(set, nullptr);
+	EXPECT_EQ(GRRLIB_GetTPLSetCount(set), 3u);
+
+	GRRLIB_texture *i8 = GRRLIB_GetTPLSetTexture(set, 1);
+	ASSERT_NE(i8, nullptr);
+	EXPECT_EQ(i8->data, tpl + offsets[1]);
+	EXPECT_EQ(i8->width, 16u);
+	EXPECT_EQ(i8->height, 8u);
+	EXPECT_EQ(i8->fmt, (u32)GX_TF_I8);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(15, 7, i8), 0x02020202u);  // GX samples the intensity as alpha
+	EXPECT_EQ(GRRLIB_GetTPLSetTexture(set, 1), i8);
+
+	GRRLIB_texture *rgb565 = GRRLIB_GetTPLSetTexture(set, 2);
+	ASSERT_NE(rgb565, nullptr);
+	EXPECT_EQ(rgb565->data, tpl + offsets[2]);
+	EXPECT_EQ((uintptr_t)GX_GetTexObjData(&rgb565->obj), MEM_VIRTUAL_TO_PHYSICAL(tpl + offsets[2]));
+	EXPECT_EQ(rgb565->part.realWidth, 8.0f);
+	EXPECT_EQ(GRRLIB_GetTPLSetTexture(set, 0)->data, tpl + offsets[0]);
+
+	EXPECT_EQ(GRRLIB_GetTPLSetTexture(set, 3), nullptr);
+	EXPECT_EQ(GRRLIB_GetTPLSetTexture(set, -1), nullptr);
+	GRRLIB_FreeTPLSet(set);
+	GRRLIB_FreeTPLSet(nullptr);
+	free(tpl);
+}
+
+TEST(TPLSet, ReadsPixelsOfTheFile) {
+	std::vector<u32> offsets;
+	std::vector<u8> file = MakeTPL({ { 8, 8, GX_TF_RGB565 } }, &offsets);
+	for (u32 i = 0; i < 8 * 8 * 2; i++) {
+		file[offsets[0] + i] = i * 37 + 11;
+	}
+	u8 *tpl = (u8*)aligned_alloc(32, (file.size() + 31) & ~31);
+	memcpy(tpl, file.data(), file.size());
+
+	GRRLIB_tplSet *set = GRRLIB_OpenTPLSet(tpl, file.size());
+	ASSERT_NE(set, nullptr);
+	GRRLIB_texture *shared = GRRLIB_GetTPLSetTexture(set, 0);
+	GRRLIB_texture *copy = GRRLIB_LoadTextureTPL(file.data(), file.size(), 0);
+	ASSERT_NE(shared, nullptr);
+	ASSERT_NE(copy, nullptr);
+	for (u32 y = 0; y < 8; y++) {
+		for (u32 x = 0; x < 8; x++) {
+			const u8 *p = &file[offsets[0] + GRRLIB_GetPixelOffset(x, y, shared)];
+			const u32 want = GRRLIB_UnpackRGB565(p[0] << 8 | p[1]);
+
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, shared), want) << x << "," << y;
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, copy), want) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(copy);
+	GRRLIB_FreeTPLSet(set);
+	free(tpl);
+}
+
+TEST(TPLSet, CopiesUnalignedBuffers) {
+	std::vector<u32> offsets;
+	const std::vector<u8> file = MakeTPL({ { 8, 4, GX_TF_IA8 }, { 8, 8, GX_TF_CI8 } }, &offsets);
+	std::vector<u8> buffer(file.size() + 64);
+	u8 *tpl = buffer.data() + (32 - ((uintptr_t)buffer.data() & 31)) + 1;
+	memcpy(tpl, file.data(), file.size());
+
+	GRRLIB_tplSet *set = GRRLIB_OpenTPLSet(tpl, file.size());
+	ASSERT_NE(set, nullptr);
+	GRRLIB_texture *ia8 = GRRLIB_GetTPLSetTexture(set, 0);
+	ASSERT_NE(ia8, nullptr);
+	EXPECT_EQ((uintptr_t)ia8->data & 31, 0u);
+	EXPECT_TRUE(ia8->data < (void*)tpl || ia8->data >= (void*)(tpl + file.size()));
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(3, 2, ia8), 0x01010101u);
+	EXPECT_EQ(GRRLIB_GetTPLSetTexture(set, 1), nullptr);  // Palettes are not supported
+	GRRLIB_FreeTPLSet(set);
+
+	EXPECT_EQ(GRRLIB_OpenTPLSet(tpl + 4, file.size() - 4), nullptr);
+}
+
+TEST(TPLSet, OpensFiles) {
+	std::vector<u32> offsets;
+	const std::vector<u8> file = MakeTPL({ { 4, 4, GX_TF_RGB5A3 }, { 4, 4, GX_TF_RGBA8 } }, &offsets);
+	const std::string path = ::testing::TempDir() + "grrlib_set.tpl";
+	FILE *f = fopen(path.c_str(), "wb");
+	ASSERT_NE(f, nullptr);
+	fwrite(file.data(), 1, file.size(), f);
+	fclose(f);
+
+	GRRLIB_tplSet *set = GRRLIB_OpenTPLSetFromFile(path.c_str());
+	ASSERT_NE(set, nullptr);
+	EXPECT_EQ(GRRLIB_GetTPLSetCount(set), 2u);
+	GRRLIB_texture *rgba8 = GRRLIB_GetTPLSetTexture(set, 1);
+	ASSERT_NE(rgba8, nullptr);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(2, 3, rgba8), 0x02020202u);
+	GRRLIB_FreeTPLSet(set);
+	remove(path.c_str());
+
+	EXPECT_EQ(GRRLIB_OpenTPLSetFromFile(path.c_str()), nullptr);
+}
+
+TEST(Pixel, FormatLayouts) {
+	GRRLIB_texture *i8 = GRRLIB_CreateEmptyTextureFmt(16, 8, GX_TF_I8);
+	GRRLIB_texture *rgb565 = GRRLIB_CreateEmptyTextureFmt(8, 8, GX_TF_RGB565);
+	const u8 *p;
+
+	// Pixel (9,5) of an I8 texture is in the fourth 8x4 tile (two per row), at index 9 of the tile
+	GRRLIB_SetPixelToTexture(9, 5, i8, 0x808080FF);
+	p = (const u8*)i8->data;
+	EXPECT_EQ(p[3 * 32 + 9], 0x80);
+	EXPECT_EQ(GX_GetTexBufferSize(16, 8, GX_TF_I8, GX_FALSE, 0), 128u);
+
+	// Pixel (5,1) of an RGB565 texture is in the second 4x4 tile, big-endian
+	GRRLIB_SetPixelToTexture(5, 1, rgb565, 0xFF00FFFF);
+	p = (const u8*)rgb565->data;
+	EXPECT_EQ(p[32 + 10], 0xF8);
+	EXPECT_EQ(p[32 + 11], 0x1F);
+
+	GRRLIB_FreeTexture(i8);
+	GRRLIB_FreeTexture(rgb565);
+}
+
+/**
+ * Get the ranges flushed since the last reset, as offsets in the data of a texture.
+ */
+static std::vector<std::pair<u32, u32>> FlushedRanges(const GRRLIB_texture *tex) {
+	std::vector<std::pair<u32, u32>> ranges;
+	u32 count;
+	const GXHost_flush *flushes = GXHost_GetFlushes(&count);
+
+	for (u32 i = 0; i < count; i++) {
+		ranges.emplace_back((const u8*)flushes[i].start - (const u8*)tex->data, flushes[i].len);
+	}
+	return ranges;
+}
+
+TEST(DirtyFlush, FlushesOnlyWrittenTiles) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(64, 64, GX_TF_RGBA8);
+	typedef std::vector<std::pair<u32, u32>> Ranges;
+
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(tex, true));
+	// Rows of 16 tiles of 64 bytes: (5,9) and (6,10) share tile 1 of row 2, (60,40) is tile 15 of row 10
+	GRRLIB_SetPixelToTexture(5, 9, tex, 0xFF0000FF);
+	GRRLIB_SetPixelToTexture(6, 10, tex, 0x00FF00FF);
+	GRRLIB_SetPixelToTexture(60, 40, tex, 0x0000FFFF);
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(tex), 128u);
+	EXPECT_EQ(FlushedRanges(tex), (Ranges{ { 2 * 1024 + 64, 64 }, { 10 * 1024 + 15 * 64, 64 } }));
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_INVALIDATETEXALL), 1u);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(6, 10, tex), 0x00FF00FFu);
+
+	// Nothing written since
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(tex), 0u);
+	EXPECT_EQ(FlushedRanges(tex), Ranges{});
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_INVALIDATETEXALL), 0u);
+
+	// Consecutive rows dirty up to their end make a single range, the rectangle is clipped
+	GRRLIB_MarkTextureDirty(tex, 0, 8, 64, 8);
+	GRRLIB_MarkTextureDirty(tex, 0, 16, 8, 1);
+	GRRLIB_MarkTextureDirty(tex, 62, -10, 12, 12);
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(tex), 64u + 2 * 1024 + 128);
+	EXPECT_EQ(FlushedRanges(tex), (Ranges{ { 15 * 64, 64 }, { 2 * 1024, 2 * 1024 + 128 } }));
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(DirtyFlush, FollowsTileGeometry) {
+	GRRLIB_texture *i8 = GRRLIB_CreateEmptyTextureFmt(40, 12, GX_TF_I8);
+	GRRLIB_texture *rgb565 = GRRLIB_CreateEmptyTextureFmt(10, 10, GX_TF_RGB565);
+	typedef std::vector<std::pair<u32, u32>> Ranges;
+
+	// I8 rows hold 5 tiles of 8x4 pixels, RGB565 rows 3 tiles of 4x4 pixels, 32 bytes each
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(i8, true));
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(rgb565, true));
+	GRRLIB_SetPixelToTexture(17, 5, i8, 0xFFFFFFFF);
+	GRRLIB_SetPixelToTexture(23, 6, i8, 0xFFFFFFFF);
+	GRRLIB_SetPixelToTexture(9, 9, rgb565, 0xFFFFFFFF);
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(i8), 32u);
+	EXPECT_EQ(FlushedRanges(i8), (Ranges{ { 5 * 32 + 2 * 32, 32 } }));
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(rgb565), 32u);
+	EXPECT_EQ(FlushedRanges(rgb565), (Ranges{ { 2 * 3 * 32 + 2 * 32, 32 } }));
+	GRRLIB_FreeTexture(i8);
+	GRRLIB_FreeTexture(rgb565);
+}
+
+TEST(DirtyFlush, FinalizesUntrackedTextures) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(32, 32, GX_TF_RGB5A3);
+	typedef std::vector<std::pair<u32, u32>> Ranges;
+
+	GRRLIB_SetPixelToTexture(3, 3, tex, 0xFFFFFFFF);
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(tex), GRRLIB_GetTextureDataSize(tex));
+	EXPECT_EQ(FlushedRanges(tex), (Ranges{ { 0, GRRLIB_GetTextureDataSize(tex) } }));
+
+	// Tracking stops and starts clean
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(tex, true));
+	GRRLIB_SetPixelToTexture(3, 3, tex, 0xFFFFFFFF);
+	GRRLIB_TrackTextureDirty(tex, false);
+	EXPECT_EQ(tex->dirtyRows, nullptr);
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(tex, true));
+	GXHost_Reset();
+	EXPECT_EQ(GRRLIB_FlushTextureDirty(tex), 0u);
+	GRRLIB_FreeTexture(tex);
+}
+
+class TextureAccess : public ::testing::TestWithParam<u32> {};
+
+TEST_P(TextureAccess, SpansMatchPixels) {
+	const std::vector<u8> png = MakePNGFrom(21, 13, PhotoPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GetParam());
+	u32 colors[21];
+
+	ASSERT_NE(tex, nullptr);
+	for (u32 y = 0; y < 13; y++) {
+		for (u32 x = 0; x < 21; x += 5) {
+			const u32 width = std::min(21 - x, 2 + y);
+
+			GRRLIB_ReadTextureSpan(tex, x, y, width, colors);
+			for (u32 i = 0; i < width; i++) {
+				ASSERT_EQ(colors[i], GRRLIB_GetPixelFromTexture(x + i, y, tex)) << x + i << "," << y;
+			}
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_P(TextureAccess, SpansWriteLikePixels) {
+	GRRLIB_texture *pixels = GRRLIB_CreateEmptyTextureFmt(21, 13, GetParam());
+	GRRLIB_texture *spans = GRRLIB_CreateEmptyTextureFmt(21, 13, GetParam());
+	u32 colors[21];
+
+	for (u32 y = 0; y < 13; y++) {
+		for (u32 x = 0; x < 21; x++) {
+			colors[x] = PhotoPixel(x, y) ^ (x * 0x1F);
+			GRRLIB_SetPixelToTexture(x, y, pixels, colors[x]);
+		}
+		// Odd starts and lengths, across tiles
+		GRRLIB_WriteTextureSpan(spans, 0, y, 3, colors);
+		GRRLIB_WriteTextureSpan(spans, 3, y, 13, colors + 3);
+		GRRLIB_WriteTextureSpan(spans, 16, y, 5, colors + 16);
+	}
+	EXPECT_EQ(memcmp(pixels->data, spans->data, GRRLIB_GetTextureDataSize(pixels)), 0);
+	GRRLIB_FreeTexture(pixels);
+	GRRLIB_FreeTexture(spans);
+}
+
+TEST_P(TextureAccess, BlocksFollowStorageOrder) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(21, 13, GetParam());
+	GRRLIB_textureBlock block;
+	u32 count = 0, x = 0, y = 0;
+
+	ASSERT_TRUE(GRRLIB_BeginTextureBlocks(tex, &block));
+	while (GRRLIB_NextTextureBlock(&block)) {
+		if (count > 0) {
+			x += block.tileW;
+			if (x >= 21) {
+				x = 0;
+				y += block.tileH;
+			}
+		}
+		ASSERT_EQ(block.x, x);
+		ASSERT_EQ(block.y, y);
+		EXPECT_EQ(block.ar, (u8*)tex->data + count * block.tileBytes);
+		if (GetParam() != GX_TF_CMPR) {
+			EXPECT_EQ(block.ar, (u8*)tex->data + GRRLIB_GetPixelOffset(x, y, tex));
+		}
+		EXPECT_EQ(block.gb, (GetParam() == GX_TF_RGBA8) ? block.ar + 32 : nullptr);
+		count++;
+	}
+	EXPECT_EQ(count * block.tileBytes, GRRLIB_GetTextureDataSize(tex) - ((GetParam() == GX_TF_CI8) ? 512 : 0));
+	EXPECT_FALSE(GRRLIB_NextTextureBlock(&block));
+	GRRLIB_FreeTexture(tex);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, TextureAccess, ::testing::Values(
+	GX_TF_RGBA8, GX_TF_RGB565, GX_TF_RGB5A3, GX_TF_I8, GX_TF_IA8, GX_TF_IA4, GX_TF_CI8, GX_TF_CMPR));
+
+TEST(TextureAccess, LockEditsRectangle) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTextureFmt(21, 13, GX_TF_RGBA8);
+	GRRLIB_textureLock lock;
+
+	for (u32 y = 0; y < 13; y++) {
+		for (u32 x = 0; x < 21; x++) {
+			GRRLIB_SetPixelToTexture(x, y, tex, PhotoPixel(x, y));
+		}
+	}
+	ASSERT_TRUE(GRRLIB_TrackTextureDirty(tex, true));
+	// Clipped to the texture
+	ASSERT_TRUE(GRRLIB_LockTexture(tex, -2, 3, 10, 20, GRRLIB_LOCK_READWRITE, &lock));
+	EXPECT_EQ(lock.x, 0u);
+	EXPECT_EQ(lock.y, 3u);
+	EXPECT_EQ(lock.width, 8u);
+	EXPECT_EQ(lock.height, 10u);
+	for (u32 y = 0; y < lock.height; y++) {
+		for (u32 x = 0; x < lock.width; x++) {
+			ASSERT_EQ(lock.pixels[y * lock.width + x], PhotoPixel(x, y + 3));
+			lock.pixels[y * lock.width + x] ^= 0xFFFFFF00;
+		}
+	}
+	// Nothing is written before unlocking
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(0, 3, tex), PhotoPixel(0, 3));
+	EXPECT_EQ(tex->dirtyBottom, 0);
+	GRRLIB_UnlockTexture(&lock);
+	EXPECT_EQ(lock.pixels, nullptr);
+	for (u32 y = 0; y < 13; y++) {
+		for (u32 x = 0; x < 21; x++) {
+			const bool inside = x < 8 && y >= 3;
+
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), PhotoPixel(x, y) ^ (inside ? 0xFFFFFF00 : 0)) << x << "," << y;
+		}
+	}
+	EXPECT_EQ(tex->dirtyTop, 0);
+	EXPECT_EQ(tex->dirtyBottom, 4);
+
+	// A read-only lock leaves the texture as it is
+	GRRLIB_FlushTextureDirty(tex);
+	ASSERT_TRUE(GRRLIB_LockTexture(tex, 10, 0, 4, 4, GRRLIB_LOCK_READ, &lock));
+	lock.pixels[0] = 0;
+	GRRLIB_UnlockTexture(&lock);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(10, 0, tex), PhotoPixel(10, 0));
+	EXPECT_EQ(tex->dirtyBottom, 0);
+
+	EXPECT_FALSE(GRRLIB_LockTexture(tex, 21, 0, 4, 4, GRRLIB_LOCK_READ, &lock));
+	GRRLIB_UnlockTexture(&lock);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Pixel, PackedColors) {
+	EXPECT_EQ(GRRLIB_PackRGB565(0xFF8000FF), 0xFC00);
+	EXPECT_EQ(GRRLIB_UnpackRGB565(0xFC00), 0xFF8200FFu);
+	EXPECT_EQ(GRRLIB_PackRGB5A3(0x0000FFE0), 0x801F);  // Alpha 0xE0 and more is opaque
+	EXPECT_EQ(GRRLIB_PackRGB5A3(0xFF000080), 0x4F00);
+	EXPECT_EQ(GRRLIB_UnpackRGB5A3(0x4F00), 0xFF000092u);
+	EXPECT_EQ(GRRLIB_UnpackRGB5A3(0xFFFF), 0xFFFFFFFFu);
+}
+
+/** Test images, each stored without loss by one format. */
+static u32 GrayPixel(u32 x, u32 y) {
+	const u8 v = (x * 37 + y * 53) & 0xFF;
+	return GRRLIB_RGBA(v, v, v, 0xFF);
+}
+static u32 MaskPixel(u32 x, u32 y) {
+	const u8 v = (x * 37 + y * 53) & 0xFF;
+	return GRRLIB_RGBA(v, v, v, v);
+}
+static u32 IA4Pixel(u32 x, u32 y) {
+	const u8 v = ((x + y) & 15) * 0x11;
+	return GRRLIB_RGBA(v, v, v, ((x * 3 + y) & 15) * 0x11);
+}
+static u32 IndexedPixel(u32 x, u32 y) {
+	const u32 k = (x / 4 + y) % 20;
+	return GRRLIB_UnpackRGB5A3(0x8000 | (k << 10) | ((19 - k) << 5) | ((k * 3) & 31));
+}
+static u32 IA8Pixel(u32 x, u32 y) {
+	const u8 v = (x * 37 + y * 53) & 0xFF;
+	return GRRLIB_RGBA(v, v, v, (x * 7 + y * 13) & 0xFF);
+}
+static u32 RGB565Pixel(u32 x, u32 y) {
+	return GRRLIB_UnpackRGB565((x * 997 + y * 4099) & 0xFFFF);
+}
+static u32 RGB5A3Pixel(u32 x, u32 y) {
+	return GRRLIB_UnpackRGB5A3((x * 997 + y * 4099) % 0x7000);  // Alpha below 0xE0 keeps 4 bits per component
+}
+static u32 RGBA8Pixel(u32 x, u32 y) {
+	return TestPixel(x, y) ^ ((x + y) * 7);
+}
+
+struct AutoCase {
+	u32 (*pixel)(u32 x, u32 y);
+	u32 width, height;
+	u32 fmt;
+};
+
+class AutoFormat : public ::testing::TestWithParam<AutoCase> {};
+
+TEST_P(AutoFormat, ChoosesSmallestLossless) {
+	const AutoCase &param = GetParam();
+	const std::vector<u8> png = MakePNGFrom(param.width, param.height, param.pixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GRRLIB_TEXFMT_AUTO);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->fmt, param.fmt);
+	EXPECT_EQ(GX_GetTexObjFmt(&tex->obj), param.fmt);
+	for (u32 y = 0; y < param.height; y++) {
+		for (u32 x = 0; x < param.width; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), param.pixel(x, y)) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+INSTANTIATE_TEST_SUITE_P(Images, AutoFormat, ::testing::Values(
+	AutoCase{ MaskPixel,    13, 9,  GX_TF_I8 },
+	AutoCase{ GrayPixel,    13, 9,  GX_TF_IA8 },     // GX_TF_I8 would be sampled with alpha from the intensity
+	AutoCase{ IA4Pixel,     13, 9,  GX_TF_IA4 },
+	AutoCase{ IndexedPixel, 64, 64, GX_TF_CI8 },
+	AutoCase{ IndexedPixel, 8,  4,  GX_TF_RGB5A3 },  // Too small for the palette to pay off
+	AutoCase{ IA8Pixel,     32, 32, GX_TF_IA8 },
+	AutoCase{ RGB565Pixel,  32, 32, GX_TF_RGB565 },
+	AutoCase{ RGB5A3Pixel,  32, 31, GX_TF_RGB5A3 },
+	AutoCase{ RGBA8Pixel,   17, 5,  GX_TF_RGBA8 }
+));
+
+TEST(Texture, LoadFmtConverts) {
+	const std::vector<u8> bmp = MakeBMP(13, 7, 24);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(bmp.data(), bmp.size(), GX_TF_RGB565);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->fmt, (u32)GX_TF_RGB565);
+	for (u32 y = 0; y < 7; y++) {
+		for (u32 x = 0; x < 13; x++) {
+			const u32 want = GRRLIB_UnpackRGB565(GRRLIB_PackRGB565(BMPPixel(x, y, 24)));
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), want) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Texture, CI8FallsBackBeyond256Colors) {
+	const std::vector<u8> png = MakePNGFrom(32, 32, RGB5A3Pixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GX_TF_CI8);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->fmt, (u32)GX_TF_RGB5A3);
+	GRRLIB_FreeTexture(tex);
+}
+
+class CMPR : public ::testing::TestWithParam<u32> {};
+
+/** 8x8 image of four solid quadrants, exact in RGB565. */
+static u32 QuadrantPixel(u32 x, u32 y) {
+	static const u32 colors[4] = { 0xFF0000FF, 0x00FF00FF, 0x0000FFFF, 0x8410 };
+	return GRRLIB_UnpackRGB565(GRRLIB_PackRGB565(colors[(y / 4) * 2 + x / 4] | 0xFF));
+}
+
+TEST_P(CMPR, SolidBlocksAreExact) {
+	const std::vector<u8> png = MakePNGFrom(8, 8, QuadrantPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GetParam());
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->fmt, (u32)GX_TF_CMPR);
+	EXPECT_EQ(GRRLIB_GetTextureDataSize(tex), 32u);
+	for (u32 y = 0; y < 8; y++) {
+		for (u32 x = 0; x < 8; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), QuadrantPixel(x, y)) << x << "," << y;
+		}
+	}
+	// The blocks of a tile are stored top left, top right, bottom left, bottom right
+	const u8 *p = (const u8*)tex->data;
+	EXPECT_EQ((p[8] << 8 | p[9]) | (p[10] << 8 | p[11]), GRRLIB_PackRGB565(0x00FF00FF));
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST_P(CMPR, KeepsQualityOnPhotos) {
+	const std::vector<u8> png = MakePNGFrom(100, 60, PhotoPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GetParam());
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(GRRLIB_GetTextureDataSize(tex), 104u * 64 / 2);
+	EXPECT_GT(PSNR(tex, PhotoPixel), GetParam() == GRRLIB_TEXFMT_CMPR_HQ ? 38.0 : 34.0);
+	GRRLIB_FreeTexture(tex);
+}
+
+/** Left half transparent. */
+static u32 HalfClearPixel(u32 x, u32 y) {
+	return (x < 6) ? 0 : PhotoPixel(x, y);
+}
+
+TEST_P(CMPR, TransparentPixels) {
+	const std::vector<u8> png = MakePNGFrom(12, 4, HalfClearPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GetParam());
+
+	ASSERT_NE(tex, nullptr);
+	for (u32 y = 0; y < 4; y++) {
+		for (u32 x = 0; x < 12; x++) {
+			ASSERT_EQ(GRRLIB_A(GRRLIB_GetPixelFromTexture(x, y, tex)), (x < 6) ? 0u : 0xFFu) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, CMPR, ::testing::Values(GX_TF_CMPR, GRRLIB_TEXFMT_CMPR_HQ));
+
+/** Pixel of a level of a mipmapped texture, read through a texture describing the level alone. */
+static u32 LevelPixel(const GRRLIB_texture *tex, u32 level, u32 x, u32 y) {
+	GRRLIB_texture view = *tex;
+
+	view.data = (u8*)tex->data + GX_GetTexBufferSize(tex->width, tex->height, tex->fmt, GX_TRUE, level);
+	view.width = std::max(tex->width >> level, 1u);
+	view.height = std::max(tex->height >> level, 1u);
+	view.mipmap = false;
+	return GRRLIB_GetPixelFromTexture(x, y, &view);
+}
+
+/** Black and white checker. */
+static u32 CheckerPixel(u32 x, u32 y) {
+	return ((x ^ y) & 1) ? 0xFFFFFFFF : 0x000000FF;
+}
+
+class Mipmap : public ::testing::TestWithParam<u32> {};
+
+TEST_P(Mipmap, BoxAveragesChecker) {
+	const std::vector<u8> png = MakePNGFrom(16, 8, CheckerPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GetParam());
+
+	ASSERT_NE(tex, nullptr);
+	ASSERT_TRUE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_BOX));
+	EXPECT_TRUE(tex->mipmap);
+	EXPECT_EQ(tex->maxLevel, 4);
+	EXPECT_EQ(GRRLIB_GetTextureDataSize(tex), GX_GetTexBufferSize(16, 8, tex->fmt, GX_TRUE, 5));
+	for (u32 level = 1; level <= 4; level++) {
+		for (u32 y = 0; y < std::max(8u >> level, 1u); y++) {
+			for (u32 x = 0; x < (16u >> level); x++) {
+				const u32 c = LevelPixel(tex, level, x, y);
+				ASSERT_NEAR(GRRLIB_R(c), 0x80, 8) << level << ":" << x << "," << y;
+				ASSERT_NEAR(GRRLIB_G(c), 0x80, 8) << level << ":" << x << "," << y;
+				ASSERT_NEAR(GRRLIB_B(c), 0x80, 8) << level << ":" << x << "," << y;
+				ASSERT_EQ(GRRLIB_A(c), (GetParam() == GX_TF_I8) ? GRRLIB_R(c) : 0xFFu) << level << ":" << x << "," << y;
+			}
+		}
+	}
+	// The base level is kept
+	EXPECT_NEAR(GRRLIB_R(GRRLIB_GetPixelFromTexture(1, 0, tex)), 0xFF, 16);
+	EXPECT_NEAR(GRRLIB_R(GRRLIB_GetPixelFromTexture(0, 0, tex)), 0x00, 16);
+	GRRLIB_FreeTexture(tex);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, Mipmap, ::testing::Values(
+	GX_TF_RGBA8, GX_TF_I8, GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3, GX_TF_CMPR
+));
+
+TEST(Mipmap, KaiserKeepsFlatColor) {
+	const std::vector<u8> png = MakePNGFrom(32, 32, [](u32, u32) -> u32 { return 0x336699FF; });
+	GRRLIB_texture *tex = GRRLIB_LoadTexturePNG(png.data());
+
+	ASSERT_NE(tex, nullptr);
+	ASSERT_TRUE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_KAISER));
+	for (u32 level = 1; level <= 5; level++) {
+		EXPECT_EQ(LevelPixel(tex, level, 0, 0), 0x336699FFu) << level;
+		EXPECT_EQ(LevelPixel(tex, level, (32 >> level) - 1, 0), 0x336699FFu) << level;
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Mipmap, KeepsCI8Palette) {
+	const std::vector<u8> png = MakePNGFrom(64, 64, IndexedPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureFmt(png.data(), png.size(), GRRLIB_TEXFMT_AUTO);
+
+	ASSERT_NE(tex, nullptr);
+	ASSERT_EQ(tex->fmt, (u32)GX_TF_CI8);
+	const std::vector<u8> palette(GRRLIB_GetTexturePalette(tex), GRRLIB_GetTexturePalette(tex) + 512);
+	ASSERT_TRUE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_BOX));
+	EXPECT_EQ(GRRLIB_GetTexturePalette(tex), (u8*)tex->data + GX_GetTexBufferSize(64, 64, GX_TF_CI8, GX_TRUE, 7));
+	EXPECT_EQ(std::memcmp(GRRLIB_GetTexturePalette(tex), palette.data(), 512), 0);
+	for (u32 y = 0; y < 64; y++) {
+		for (u32 x = 0; x < 64; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), IndexedPixel(x, y)) << x << "," << y;
+		}
+	}
+	// Four columns of the same color give two columns of the same index
+	const u8 *level1 = (const u8*)tex->data + GX_GetTexBufferSize(64, 64, GX_TF_CI8, GX_TRUE, 1);
+	for (u32 y = 0; y < 32; y++) {
+		ASSERT_EQ(level1[(y / 4) * 32 * 4 + (y & 3) * 8], level1[(y / 4) * 32 * 4 + (y & 3) * 8 + 1]) << y;
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Mipmap, RejectsNonPowerOfTwo) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(12, 8);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_FALSE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_BOX));
+	EXPECT_FALSE(tex->mipmap);
+	EXPECT_EQ(GRRLIB_GetTextureDataSize(tex), 12u * 8 * 4);
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Mipmap, ConfiguresLevelsOfDetail) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(64, 16);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_FALSE(GX_GetTexObjMipMap(&tex->obj));
+	ASSERT_TRUE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_BOX));
+	EXPECT_TRUE(GX_GetTexObjMipMap(&tex->obj));
+	EXPECT_EQ(GX_GetTexObjMinFilt(&tex->obj), GX_LIN_MIP_LIN);
+	EXPECT_FLOAT_EQ(GX_GetTexObjMinLOD(&tex->obj), 0.0f);
+	EXPECT_FLOAT_EQ(GX_GetTexObjMaxLOD(&tex->obj), 6.0f);
+
+	GRRLIB_SetTextureLOD(tex, 1.0f, 10.0f, -0.5f);
+	EXPECT_FLOAT_EQ(GX_GetTexObjMinLOD(&tex->obj), 1.0f);
+	EXPECT_FLOAT_EQ(GX_GetTexObjMaxLOD(&tex->obj), 6.0f);
+	EXPECT_FLOAT_EQ(GX_GetTexObjLODBias(&tex->obj), -0.5f);
+
+	// Generating again keeps the levels of detail
+	ASSERT_TRUE(GRRLIB_GenerateMipmaps(tex, GRRLIB_MIPFILTER_KAISER));
+	EXPECT_FLOAT_EQ(GX_GetTexObjMinLOD(&tex->obj), 1.0f);
+	EXPECT_FLOAT_EQ(GX_GetTexObjLODBias(&tex->obj), -0.5f);
+	GRRLIB_FreeTexture(tex);
+}
+
+/** Texture of a given size filled with a pixel function offset by a seed. */
+static GRRLIB_texture *MakeSprite(u32 width, u32 height, u32 seed) {
+	GRRLIB_texture *tex = GRRLIB_CreateEmptyTexture(width, height);
+
+	for (u32 y = 0; y < height; y++) {
+		for (u32 x = 0; x < width; x++) {
+			GRRLIB_SetPixelToTexture(x, y, tex, TestPixel(x + seed, y + seed * 3));
+		}
+	}
+	return tex;
+}
+
+TEST(Atlas, PacksImagesWithoutOverlap) {
+	GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(128, 128, GX_TF_RGBA8, 1, true);
+	std::vector<GRRLIB_texture*> pages;
+
+	ASSERT_NE(atlas, nullptr);
+	for (u32 i = 0; i < 60; i++) {
+		const u32 w = 5 + (i * 7) % 36, h = 3 + (i * 11) % 29;
+		GRRLIB_texture *sprite = MakeSprite(w, h, i);
+		GRRLIB_texture *page = nullptr;
+		const GRRLIB_texturePart *part = GRRLIB_AtlasAddTexture(atlas, sprite, &page);
+
+		ASSERT_NE(part, nullptr) << i;
+		ASSERT_NE(page, nullptr) << i;
+		pages.push_back(page);
+		EXPECT_EQ(part->realWidth, w);
+		EXPECT_EQ(part->realHeight, h);
+		EXPECT_FLOAT_EQ(part->x, (part->realX + 0.001f) / 128);
+		EXPECT_FLOAT_EQ(part->height, (part->realY + h - 0.001f) / 128);
+		EXPECT_EQ((u32)part->realX % 4, 0u);
+		EXPECT_EQ((u32)part->realY % 4, 0u);
+		GRRLIB_FreeTexture(sprite);
+	}
+	// The slots of the images, rounded to tiles with their padding, cover 2.3 pages
+	EXPECT_EQ(atlas->pageCount, 3u);
+	EXPECT_EQ(atlas->partCount, 60u);
+	EXPECT_FLOAT_EQ(GRRLIB_GetAtlasOccupancy(atlas), atlas->usedPixels / (3.0f * 128 * 128));
+
+	// Every image is intact, so none overlaps another with its padding
+	for (u32 i = 0; i < 60; i++) {
+		const GRRLIB_texturePart *part = atlas->parts[i];
+
+		for (u32 y = 0; y < part->realHeight; y++) {
+			for (u32 x = 0; x < part->realWidth; x++) {
+				ASSERT_EQ(GRRLIB_GetPixelFromTexture(part->realX + x, part->realY + y, pages[i]), TestPixel(x + i, y + i * 3))
+				    << i << ":" << x << "," << y;
+			}
+		}
+	}
+	GRRLIB_FreeAtlas(atlas);
+}
+
+TEST(Atlas, ExtrudesEdges) {
+	GRRLIB_texture *sprite = MakeSprite(6, 5, 0);
+
+	for (const bool extrude : { false, true }) {
+		GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(64, 64, GX_TF_RGBA8, 2, extrude);
+		GRRLIB_texture *page = nullptr, *wide = MakeSprite(60, 4, 1), *small = MakeSprite(4, 4, 2);
+
+		// Fill the top of the page and its left so that the padding of the image is inside the page
+		ASSERT_NE(GRRLIB_AtlasAddTexture(atlas, wide, nullptr), nullptr);
+		ASSERT_NE(GRRLIB_AtlasAddTexture(atlas, small, nullptr), nullptr);
+		GRRLIB_FreeTexture(wide);
+		GRRLIB_FreeTexture(small);
+		const GRRLIB_texturePart *part = GRRLIB_AtlasAddTexture(atlas, sprite, &page);
+
+		ASSERT_NE(part, nullptr);
+		EXPECT_EQ(part->realX, 8.0f);
+		EXPECT_EQ(part->realY, 8.0f);
+		for (s32 y = -2; y < 7; y++) {
+			for (s32 x = -2; x < 8; x++) {
+				const u32 want = TestPixel(std::min(std::max(x, 0), 5), std::min(std::max(y, 0), 4));
+				const bool inside = x >= 0 && x < 6 && y >= 0 && y < 5;
+
+				ASSERT_EQ(GRRLIB_GetPixelFromTexture(part->realX + x, part->realY + y, page),
+				          (extrude || inside) ? want : 0u) << extrude << ":" << x << "," << y;
+			}
+		}
+		GRRLIB_FreeAtlas(atlas);
+	}
+	GRRLIB_FreeTexture(sprite);
+}
+
+TEST(Atlas, PadsCMPRPages) {
+	GRRLIB_texture *sprite = GRRLIB_CreateEmptyTexture(6, 5);
+
+	// A colour exact in RGB565, so the compressed blocks decode to it
+	for (u32 y = 0; y < 5; y++) {
+		for (u32 x = 0; x < 6; x++) {
+			GRRLIB_SetPixelToTexture(x, y, sprite, 0xFF0000FF);
+		}
+	}
+	for (const bool extrude : { false, true }) {
+		GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(64, 64, GX_TF_CMPR, 2, extrude);
+		GRRLIB_texture *page = nullptr, *wide = MakeSprite(50, 4, 1);
+
+		ASSERT_NE(GRRLIB_AtlasAddTexture(atlas, wide, nullptr), nullptr);
+		GRRLIB_FreeTexture(wide);
+		const GRRLIB_texturePart *part = GRRLIB_AtlasAddTexture(atlas, sprite, &page);
+
+		ASSERT_NE(part, nullptr);
+		EXPECT_EQ((u32)part->realX % 4, 0u);
+		EXPECT_EQ((u32)part->realY % 4, 0u);
+		EXPECT_GE(part->realY, 8.0f + 2);  // Below the slot of the first image, after its own padding
+		for (s32 y = -2; y < 7; y++) {
+			for (s32 x = -2; x < 8; x++) {
+				const bool inside = x >= 0 && x < 6 && y >= 0 && y < 5;
+				const u32 c = GRRLIB_GetPixelFromTexture(part->realX + x, part->realY + y, page);
+
+				if (extrude || inside) {
+					ASSERT_EQ(c, 0xFF0000FFu) << extrude << ":" << x << "," << y;
+				}
+				else {
+					ASSERT_EQ(GRRLIB_A(c), 0u) << x << "," << y;
+				}
+			}
+		}
+		GRRLIB_FreeAtlas(atlas);
+	}
+	GRRLIB_FreeTexture(sprite);
+}
+
+TEST(Atlas, KeepsCMPRBlocks) {
+	const std::vector<u8> png = MakePNG(8, 8);
+	GRRLIB_texture *sprite = GRRLIB_LoadTextureFmt(png.data(), png.size(), GX_TF_CMPR);
+	GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(32, 32, GX_TF_CMPR, 1, true);
+	GRRLIB_texture *page = nullptr;
+
+	ASSERT_NE(sprite, nullptr);
+	const GRRLIB_texturePart *part = GRRLIB_AtlasAddTexture(atlas, sprite, &page);
+	ASSERT_NE(part, nullptr);
+	for (u32 y = 0; y < 8; y++) {
+		for (u32 x = 0; x < 8; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(part->realX + x, part->realY + y, page),
+			          GRRLIB_GetPixelFromTexture(x, y, sprite)) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeAtlas(atlas);
+	GRRLIB_FreeTexture(sprite);
+}
+
+TEST(Atlas, ConvertsToPageFormat) {
+	const std::vector<u8> png = MakePNG(13, 9);
+	GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(64, 32, GX_TF_RGB565, 0, false);
+	GRRLIB_texture *sprite = MakeSprite(10, 10, 5);
+	GRRLIB_texture *page = nullptr;
+
+	ASSERT_NE(atlas, nullptr);
+	const GRRLIB_texturePart *a = GRRLIB_AtlasAddImage(atlas, png.data(), png.size(), &page);
+	ASSERT_NE(a, nullptr);
+	const GRRLIB_texturePart *b = GRRLIB_AtlasAddTexture(atlas, sprite, nullptr);
+	ASSERT_NE(b, nullptr);
+	EXPECT_EQ(atlas->pageCount, 1u);
+	EXPECT_EQ(page->fmt, (u32)GX_TF_RGB565);
+	for (u32 y = 0; y < 9; y++) {
+		for (u32 x = 0; x < 13; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(a->realX + x, a->realY + y, page),
+			          GRRLIB_UnpackRGB565(GRRLIB_PackRGB565(TestPixel(x, y)))) << x << "," << y;
+		}
+	}
+	for (u32 y = 0; y < 10; y++) {
+		for (u32 x = 0; x < 10; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(b->realX + x, b->realY + y, page),
+			          GRRLIB_UnpackRGB565(GRRLIB_PackRGB565(TestPixel(x + 5, y + 15)))) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(sprite);
+	GRRLIB_FreeAtlas(atlas);
+}
+
+TEST(Atlas, RejectsUnsupported) {
+	GRRLIB_atlas *atlas = GRRLIB_CreateAtlas(32, 32, GX_TF_RGBA8, 1, true);
+	GRRLIB_texture *sprite = MakeSprite(31, 8, 0);
+
+	EXPECT_EQ(GRRLIB_CreateAtlas(32, 32, GX_TF_CI8, 0, false), nullptr);
+	EXPECT_EQ(GRRLIB_CreateAtlas(30, 32, GX_TF_RGBA8, 0, false), nullptr);
+	ASSERT_NE(atlas, nullptr);
+	EXPECT_EQ(GRRLIB_AtlasAddTexture(atlas, sprite, nullptr), nullptr);  // Too wide with its padding
+	EXPECT_EQ(atlas->pageCount, 0u);
+	EXPECT_EQ(GRRLIB_GetAtlasOccupancy(atlas), 0.0f);
+	GRRLIB_FreeTexture(sprite);
+	GRRLIB_FreeAtlas(atlas);
+}
+
+class JPGStream : public ::testing::TestWithParam<u32> {};
+
+TEST_P(JPGStream, MatchesWholeImageDecoding) {
+	const std::vector<u8> jpg = MakeJPG(45, 27);
+	GRRLIB_texture *streamed = GRRLIB_LoadTextureJPGFmt(jpg.data(), jpg.size(), GetParam());
+	GRRLIB_texture *rgba = GRRLIB_LoadTextureJPGEx(jpg.data(), jpg.size());
+
+	ASSERT_NE(streamed, nullptr);
+	ASSERT_NE(rgba, nullptr);
+	ASSERT_EQ(streamed->width, 45u);
+	ASSERT_EQ(streamed->height, 27u);
+
+	// Encoding the whole decoded image gives the same tiles
+	std::vector<u8> pixels(45 * 27 * 4);
+	for (u32 y = 0; y < 27; y++) {
+		for (u32 x = 0; x < 45; x++) {
+			const u32 c = GRRLIB_GetPixelFromTexture(x, y, rgba);
+			pixels[(y * 45 + x) * 4 + 0] = GRRLIB_R(c);
+			pixels[(y * 45 + x) * 4 + 1] = GRRLIB_G(c);
+			pixels[(y * 45 + x) * 4 + 2] = GRRLIB_B(c);
+			pixels[(y * 45 + x) * 4 + 3] = GRRLIB_A(c);
+		}
+	}
+	std::vector<u8> tiles(GRRLIB_GetTextureDataSize(streamed));
+	ASSERT_TRUE(GRRLIB_TileImage(pixels.data(), 45 * 4, GRRLIB_LAYOUT_RGBA, tiles.data(), GetParam(), 45, 27));
+	EXPECT_EQ(std::memcmp(tiles.data(), streamed->data, tiles.size()), 0);
+	GRRLIB_FreeTexture(streamed);
+	GRRLIB_FreeTexture(rgba);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, JPGStream, ::testing::Values(
+	GX_TF_RGBA8, GX_TF_RGB565, GX_TF_I8, GX_TF_IA4, GX_TF_CMPR, GRRLIB_TEXFMT_CMPR_HQ
+));
+
+TEST(Texture, JPGErrorsReturnNull) {
+	std::vector<u8> jpg = MakeJPG(32, 32);
+
+	EXPECT_EQ(GRRLIB_LoadTextureJPGEx(jpg.data(), jpg.size() / 2), nullptr);  // Truncated
+	EXPECT_EQ(GRRLIB_LoadTextureJPGFmt(jpg.data(), jpg.size() / 2, GRRLIB_TEXFMT_AUTO), nullptr);
+	EXPECT_EQ(GRRLIB_LoadTextureJPGEx(jpg.data(), 3), nullptr);
+
+	// Only the end of image marker missing
+	GRRLIB_texture *tex = GRRLIB_LoadTextureJPGEx(jpg.data(), jpg.size() - 2);
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->height, 32u);
+	GRRLIB_FreeTexture(tex);
+
+	// Without the size, the decoder stops at the end of image marker
+	tex = GRRLIB_LoadTextureJPG(jpg.data());
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->width, 32u);
+	GRRLIB_FreeTexture(tex);
+
+	jpg[1] = 0x00;  // Not a JPEG
+	EXPECT_EQ(GRRLIB_LoadTextureJPGEx(jpg.data(), jpg.size()), nullptr);
+}
+
+TEST(Scale, FitsInBox) {
+	u32 w, h;
+
+	GRRLIB_FitImageSize(2048, 1024, 0, 0, &w, &h);
+	EXPECT_EQ(w, 1024u);
+	EXPECT_EQ(h, 512u);
+	GRRLIB_FitImageSize(100, 50, 64, 64, &w, &h);
+	EXPECT_EQ(w, 64u);
+	EXPECT_EQ(h, 32u);
+	GRRLIB_FitImageSize(10, 10, 64, 64, &w, &h);  // Never enlarged
+	EXPECT_EQ(w, 10u);
+	EXPECT_EQ(h, 10u);
+	GRRLIB_FitImageSize(3000, 2, 0, 0, &w, &h);
+	EXPECT_EQ(w, 1024u);
+	EXPECT_EQ(h, 1u);
+}
+
+/** Image of 2x2 blocks of one color. */
+static u32 BlockPixel(u32 x, u32 y) {
+	return TestPixel(x / 2, y / 2);
+}
+
+TEST(Scale, HalvesBlocksExactly) {
+	const std::vector<u8> png = MakePNGFrom(64, 40, BlockPixel);
+
+	for (const GRRLIB_scaleFilter filter : { GRRLIB_SCALE_AREA, GRRLIB_SCALE_NEAREST }) {
+		GRRLIB_texture *tex = GRRLIB_LoadTextureScaled(png.data(), png.size(), 32, 32, filter);
+
+		ASSERT_NE(tex, nullptr);
+		ASSERT_EQ(tex->width, 32u);
+		ASSERT_EQ(tex->height, 20u);
+		for (u32 y = 0; y < 20; y++) {
+			for (u32 x = 0; x < 32; x++) {
+				ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), TestPixel(x, y)) << filter << ":" << x << "," << y;
+			}
+		}
+		GRRLIB_FreeTexture(tex);
+	}
+}
+
+TEST(Scale, AveragesBMP) {
+	for (const u32 bits : { 4u, 24u, 32u }) {
+		const std::vector<u8> bmp = MakeBMP(30, 18, bits);
+		GRRLIB_texture *tex = GRRLIB_LoadTextureScaled(bmp.data(), bmp.size(), 15, 15, GRRLIB_SCALE_AREA);
+
+		ASSERT_NE(tex, nullptr);
+		ASSERT_EQ(tex->width, 15u);
+		ASSERT_EQ(tex->height, 9u);
+		for (u32 y = 0; y < 9; y++) {
+			for (u32 x = 0; x < 15; x++) {
+				u32 sum[4] = { 2, 2, 2, 2 };
+				for (u32 i = 0; i < 4; i++) {
+					const u32 c = BMPPixel(2 * x + (i & 1), 2 * y + (i >> 1), bits);
+					sum[0] += GRRLIB_R(c);
+					sum[1] += GRRLIB_G(c);
+					sum[2] += GRRLIB_B(c);
+					sum[3] += GRRLIB_A(c);
+				}
+				ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), GRRLIB_RGBA(sum[0] / 4, sum[1] / 4, sum[2] / 4, sum[3] / 4))
+				    << bits << ":" << x << "," << y;
+			}
+		}
+		GRRLIB_FreeTexture(tex);
+	}
+}
+
+TEST(Scale, KeepsFlatColorAtAnyRatio) {
+	const std::vector<u8> png = MakePNGFrom(97, 61, [](u32, u32) -> u32 { return 0x20A0C0FF; });
+	GRRLIB_texture *tex = GRRLIB_LoadTextureScaled(png.data(), png.size(), 40, 40, GRRLIB_SCALE_AREA);
+
+	ASSERT_NE(tex, nullptr);
+	ASSERT_EQ(tex->width, 40u);
+	ASSERT_EQ(tex->height, 25u);
+	for (u32 y = 0; y < 25; y++) {
+		for (u32 x = 0; x < 40; x++) {
+			ASSERT_EQ(GRRLIB_GetPixelFromTexture(x, y, tex), 0x20A0C0FFu) << x << "," << y;
+		}
+	}
+	GRRLIB_FreeTexture(tex);
+}
+
+TEST(Scale, ShrinksJPGWhileDecoding) {
+	const std::vector<u8> jpg = MakeJPGFrom(400, 240, PhotoPixel);
+
+	for (const u32 size : { 200u, 100u, 64u }) {
+		GRRLIB_texture *tex = GRRLIB_LoadTextureScaled(jpg.data(), jpg.size(), size, size, GRRLIB_SCALE_AREA);
+
+		ASSERT_NE(tex, nullptr);
+		ASSERT_EQ(tex->width, size);
+		ASSERT_EQ(tex->height, size * 240 / 400);
+		// Compare with the image shrunk by sampling it at the center of each texel
+		const double scale = 400.0 / size;
+		double err = 0;
+		for (u32 y = 0; y < tex->height; y++) {
+			for (u32 x = 0; x < tex->width; x++) {
+				const u32 got = GRRLIB_GetPixelFromTexture(x, y, tex);
+				const u32 want = PhotoPixel((x + 0.5) * scale, (y + 0.5) * scale);
+				err += std::abs((int)GRRLIB_G(got) - (int)GRRLIB_G(want));
+			}
+		}
+		EXPECT_LT(err / (tex->width * tex->height), 6.0) << size;
+		GRRLIB_FreeTexture(tex);
+	}
+}
+
+TEST(Scale, LimitsToGXMaximum) {
+	const std::vector<u8> png = MakePNGFrom(2050, 8, TestPixel);
+	GRRLIB_texture *tex = GRRLIB_LoadTextureScaled(png.data(), png.size(), 0, 0, GRRLIB_SCALE_NEAREST);
+
+	ASSERT_NE(tex, nullptr);
+	EXPECT_EQ(tex->width, 1024u);
+	EXPECT_EQ(tex->height, 3u);
+	GRRLIB_FreeTexture(tex);
+}
+
+/** CRC of a PNG chunk. */
+static u32 ChunkCRC(const u8 *data, size_t size) {
+	u32 crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < size; i++) {
+		crc ^= data[i];
+		for (int k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+TEST(Scale, RejectsPNGLargerThanMemory) {
+	std::vector<u8> png = MakePNG(4, 4);
+
+	// 65536x16385 RGBA pixels take 256 kB more than 4 GB: patch the IHDR chunk, which follows the 8 bytes signature
+	for (const auto &[offset, size] : { std::pair<u32, u32>{ 16, 65536 }, std::pair<u32, u32>{ 20, 16385 } }) {
+		png[offset] = size >> 24;
+		png[offset + 1] = size >> 16;
+		png[offset + 2] = size >> 8;
+		png[offset + 3] = size;
+	}
+	const u32 crc = ChunkCRC(&png[12], 17);
+	png[29] = crc >> 24;
+	png[30] = crc >> 16;
+	png[31] = crc >> 8;
+	png[32] = crc;
+
+	// The size of the pixels is not truncated to 32 bits, the image is rejected before allocating them
+	GRRLIB_ResetMemStats();
+	EXPECT_EQ(GRRLIB_LoadTextureScaled(png.data(), png.size(), 64, 64, GRRLIB_SCALE_AREA), nullptr);
+	EXPECT_EQ(GRRLIB_GetMemStats().allocations, 0u);
+}
+
+TEST(AssetCache, SharesDecodedTextures) {
+	const std::vector<u8> png = MakePNG(16, 16);
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(1 << 20, GX_TF_RGB565);
+
+	ASSERT_NE(cache, nullptr);
+	GRRLIB_texture *a = GRRLIB_AssetCacheLoadBuffer(cache, "sprite", png.data(), png.size());
+	GRRLIB_texture *b = GRRLIB_AssetCacheLoadBuffer(cache, "sprite", nullptr, 0);  // Not read on a hit
+	ASSERT_NE(a, nullptr);
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(a->fmt, (u32)GX_TF_RGB565);
+	EXPECT_EQ(GRRLIB_AssetCacheFind(cache, "other"), nullptr);
+
+	GRRLIB_assetStats stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.hits, 1u);
+	EXPECT_EQ(stats.misses, 1u);
+	EXPECT_EQ(stats.entries, 1u);
+	EXPECT_EQ(stats.referenced, 1u);
+	EXPECT_EQ(stats.bytes, 16u * 16 * 2);
+	EXPECT_EQ(stats.idleBytes, 0u);
+
+	GRRLIB_AssetCacheRelease(cache, a);
+	EXPECT_EQ(GRRLIB_GetAssetCacheStats(cache).referenced, 1u);
+	GRRLIB_AssetCacheRelease(cache, b);
+	stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.referenced, 0u);
+	EXPECT_EQ(stats.entries, 1u);  // Kept within the budget
+	EXPECT_EQ(stats.idleBytes, 16u * 16 * 2);
+	EXPECT_EQ(GRRLIB_AssetCacheFind(cache, "sprite"), a);
+
+	GRRLIB_ResetAssetCacheStats(cache);
+	stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.hits, 0u);
+	EXPECT_EQ(stats.entries, 1u);
+	GRRLIB_FreeAssetCache(cache);
+}
+
+TEST(AssetCache, LoadsFilesOnce) {
+	const std::string path = ::testing::TempDir() + "grrlib_asset.bmp";
+	const std::vector<u8> bmp = MakeBMP(13, 7, 24);
+	FILE *f = fopen(path.c_str(), "wb");
+	ASSERT_NE(f, nullptr);
+	fwrite(bmp.data(), 1, bmp.size(), f);
+	fclose(f);
+
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(1 << 20, GX_TF_RGBA8);
+	GRRLIB_texture *a = GRRLIB_AssetCacheLoadFile(cache, path.c_str());
+	ASSERT_NE(a, nullptr);
+	EXPECT_EQ(GRRLIB_GetPixelFromTexture(3, 2, a), BMPPixel(3, 2, 24));
+	remove(path.c_str());
+	EXPECT_EQ(GRRLIB_AssetCacheLoadFile(cache, path.c_str()), a);  // Served without reading the file
+	EXPECT_EQ(GRRLIB_AssetCacheLoadFile(cache, "/nonexistent/file.png"), nullptr);
+
+	const GRRLIB_assetStats stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.hits, 1u);
+	EXPECT_EQ(stats.misses, 1u);
+	EXPECT_EQ(stats.entries, 1u);
+	GRRLIB_FreeAssetCache(cache);
+}
+
+TEST(AssetCache, EvictsLeastRecentlyUsed) {
+	const std::vector<u8> png = MakePNG(16, 16);
+	const u32 size = 16 * 16 * 4;
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(size * 5 / 2, GX_TF_RGBA8);
+	GRRLIB_texture *a = GRRLIB_AssetCacheLoadBuffer(cache, "a", png.data(), png.size());
+	GRRLIB_texture *b = GRRLIB_AssetCacheLoadBuffer(cache, "b", png.data(), png.size());
+
+	GRRLIB_AssetCacheRelease(cache, a);
+	GRRLIB_AssetCacheRelease(cache, b);
+	GRRLIB_AssetCacheRelease(cache, GRRLIB_AssetCacheFind(cache, "a"));  // "a" is now the most recently used
+
+	// "c" does not fit with "a" and "b": "b" goes
+	GRRLIB_texture *c = GRRLIB_AssetCacheLoadBuffer(cache, "c", png.data(), png.size());
+	ASSERT_NE(c, nullptr);
+	GRRLIB_assetStats stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.evictions, 1u);
+	EXPECT_EQ(stats.entries, 2u);
+	EXPECT_EQ(stats.bytes, 2 * size);
+	EXPECT_EQ(GRRLIB_AssetCacheFind(cache, "b"), nullptr);
+	GRRLIB_texture *a2 = GRRLIB_AssetCacheFind(cache, "a");
+	EXPECT_NE(a2, nullptr);
+
+	// Referenced textures are kept over the budget
+	GRRLIB_texture *d = GRRLIB_AssetCacheLoadBuffer(cache, "d", png.data(), png.size());
+	ASSERT_NE(d, nullptr);
+	stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.entries, 3u);
+	EXPECT_EQ(stats.bytes, 3 * size);
+	EXPECT_EQ(stats.evictions, 1u);
+
+	// Released textures go when they do not fit
+	GRRLIB_AssetCacheRelease(cache, d);
+	EXPECT_EQ(GRRLIB_GetAssetCacheStats(cache).entries, 2u);
+	EXPECT_EQ(GRRLIB_AssetCacheFind(cache, "d"), nullptr);
+
+	GRRLIB_AssetCacheRelease(cache, a2);
+	GRRLIB_AssetCacheRelease(cache, c);
+	GRRLIB_PurgeAssetCache(cache);
+	stats = GRRLIB_GetAssetCacheStats(cache);
+	EXPECT_EQ(stats.entries, 0u);
+	EXPECT_EQ(stats.bytes, 0u);
+	EXPECT_EQ(stats.evictions, 4u);
+	GRRLIB_FreeAssetCache(cache);
+}
+
+TEST(AssetCache, FindsManyKeys) {
+	const std::vector<u8> png = MakePNG(4, 4);
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(1 << 20, GX_TF_RGBA8);
+	std::vector<GRRLIB_texture*> textures;
+
+	for (int i = 0; i < 300; i++) {
+		textures.push_back(GRRLIB_AssetCacheLoadBuffer(cache, std::to_string(i).c_str(), png.data(), png.size()));
+		ASSERT_NE(textures.back(), nullptr);
+	}
+	for (int i = 0; i < 300; i++) {
+		ASSERT_EQ(GRRLIB_AssetCacheFind(cache, std::to_string(i).c_str()), textures[i]) << i;
+	}
+	EXPECT_EQ(GRRLIB_GetAssetCacheStats(cache).entries, 300u);
+	GRRLIB_FreeAssetCache(cache);
+}
+
+TEST_F(GRRLIBTest, AssetCacheWaitsForRecentTextures) {
+	const std::vector<u8> png = MakePNG(16, 16);
+	GRRLIB_assetCache *cache = GRRLIB_CreateAssetCache(16 * 16 * 4, GX_TF_RGBA8);
+	GRRLIB_texture *a = GRRLIB_AssetCacheLoadBuffer(cache, "a", png.data(), png.size());
+	GRRLIB_texture *b;
+
+	// Released during the frame it may be drawn in
+	GRRLIB_DrawTexture(0, 0, a, 0, 1, 1, 0, 0);
+	GRRLIB_AssetCacheRelease(cache, a);
+	GXHost_Reset();
+	b = GRRLIB_AssetCacheLoadBuffer(cache, "b", png.data(), png.size());
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_SETDRAWDONE), 1u);
+	EXPECT_EQ(GRRLIB_AssetCacheFind(cache, "a"), nullptr);
+
+	// Released two frames before it is evicted
+	GRRLIB_DrawTexture(0, 0, b, 0, 1, 1, 0, 0);
+	GRRLIB_AssetCacheRelease(cache, b);
+	GRRLIB_Render();
+	GRRLIB_Render();
+	GXHost_Reset();
+	a = GRRLIB_AssetCacheLoadBuffer(cache, "a", png.data(), png.size());
+	EXPECT_EQ(GXHost_CountCommands(GXHOST_SETDRAWDONE), 0u);
+	EXPECT_EQ(GRRLIB_GetAssetCacheStats(cache).evictions, 2u);
+	GRRLIB_AssetCacheRelease(cache, a);
+	GRRLIB_FreeAssetCache(cache);
+}
@@ -0,0 +1,108 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file tpl.c
+ * Host stand-in for the libogc TPL reader, parsing the big-endian file in place.
+ */
+
+#include <gccore.h>
+
+#define TPL_MAGIC  0x0020AF30
+
+static u32  ReadBE32 (const u8 *p) {
+	return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+}
+
+static u16  ReadBE16 (const u8 *p) {
+	return (u16)((p[0] << 8) | p[1]);
+}
+
+/**
+ * Locate the image header of a texture, bounds-checked against the file size.
+ * @return A pointer to the 36 byte image header, NULL if it is out of range.
+ */
+static const u8*  GetImageHeader (const TPLFile *tdf, s32 id) {
+	const u8 *base = tdf->tpl_file;
+	const u32 size = (u32)(uintptr_t)tdf->texdesc;
+	u32 table, offs;
+
+	if (base == NULL || id < 0 || id >= tdf->ntextures) {
+		return NULL;
+	}
+	table = ReadBE32(base + 8) + (u32)id * 8;
+	if (table + 8 > size) {
+		return NULL;
+	}
+	offs = ReadBE32(base + table);
+	if (offs + 36 > size) {
+		return NULL;
+	}
+	return base + offs;
+}
+
+s32  TPL_OpenTPLFromMemory (TPLFile *tdf, void *memory, u32 len) {
+	const u8 *p = memory;
+
+	if (tdf == NULL || p == NULL || len < 12 || ReadBE32(p) != TPL_MAGIC) {
+		return -1;
+	}
+	tdf->type = 1;
+	tdf->ntextures = (int)ReadBE32(p + 4);
+	tdf->texdesc = (void*)(uintptr_t)len; // File size, used for bounds checks
+	tdf->tpl_file = memory;
+	return 1;
+}
+
+s32  TPL_GetTextureInfo (TPLFile *tdf, s32 id, u32 *fmt, u16 *width, u16 *height) {
+	const u8 *hdr = GetImageHeader(tdf, id);
+
+	if (hdr == NULL) {
+		return -1;
+	}
+	if (height != NULL) *height = ReadBE16(hdr);
+	if (width  != NULL) *width  = ReadBE16(hdr + 2);
+	if (fmt    != NULL) *fmt    = ReadBE32(hdr + 4);
+	return 0;
+}
+
+s32  TPL_GetTexture (TPLFile *tdf, s32 id, GXTexObj *texObj) {
+	const u8 *hdr = GetImageHeader(tdf, id);
+	const u8 *base;
+
+	if (hdr == NULL || texObj == NULL) {
+		return -1;
+	}
+	base = tdf->tpl_file;
+	GX_InitTexObj(texObj, (void*)(base + ReadBE32(hdr + 8)),
+	              ReadBE16(hdr + 2), ReadBE16(hdr), (u8)ReadBE32(hdr + 4),
+	              (u8)ReadBE32(hdr + 12), (u8)ReadBE32(hdr + 16), GX_FALSE);
+	return 0;
+}
+
+void  TPL_CloseTPLFile (TPLFile *tdf) {
+	if (tdf != NULL) {
+		tdf->ntextures = 0;
+		tdf->tpl_file = NULL;
+		tdf->texdesc = NULL;
+	}
+}
@@ -0,0 +1,391 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2009-2022 The GRRLIB Team and HTV04
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+------------------------------------------------------------------------------*/
+
+/*
+ * @file video.c
+ * Host stand-in for VIDEO, SYS, CONF, the cache, timers, threads and the USB Gecko.
+ * Vertical retraces only happen when the application waits for one.
+ */
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <gccore.h>
+#include <gxhost.h>
+
+#define HOST_MAX_OBJECTS  (64)  /**< Maximum number of threads, mutexes and condition variables. */
+
+GXRModeObj TVNtsc480IntDf = {
+	VI_TVMODE_NTSC_INT, 640, 480, 480, (VI_MAX_WIDTH_NTSC - 640) / 2, (480 - 480) / 2, 640, 480, VI_XFBMODE_DF,
+	GX_FALSE, GX_FALSE,
+	{{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6}},
+	{0, 0, 21, 22, 21, 0, 0}
+};
+
+GXRModeObj TVNtsc480Prog = {
+	VI_TVMODE_NTSC_PROG, 640, 480, 480, (VI_MAX_WIDTH_NTSC - 640) / 2, (480 - 480) / 2, 640, 480, VI_XFBMODE_SF,
+	GX_FALSE, GX_FALSE,
+	{{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6}},
+	{0, 0, 21, 22, 21, 0, 0}
+};
+
+GXRModeObj TVPal528IntDf = {
+	VI_TVMODE_PAL_INT, 640, 528, 528, (VI_MAX_WIDTH_PAL - 640) / 2, (574 - 528) / 2, 640, 528, VI_XFBMODE_DF,
+	GX_FALSE, GX_FALSE,
+	{{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6},{6,6}},
+	{0, 0, 21, 22, 21, 0, 0}
+};
+
+static GXRModeObj        *videoMode = &TVNtsc480IntDf;
+static void              *nextFramebuffer = NULL;
+static void              *currentFramebuffer = NULL;
+static bool              flushPending = false;
+static u32               retraceCount = 0;
+static VIRetraceCallback preRetraceCallback = NULL;
+static VIRetraceCallback postRetraceCallback = NULL;
+
+static pthread_t         threads[HOST_MAX_OBJECTS];
+static pthread_mutex_t   mutexes[HOST_MAX_OBJECTS];
+static pthread_cond_t    conds[HOST_MAX_OBJECTS];
+static bool              threadUsed[HOST_MAX_OBJECTS];
+static bool              mutexUsed[HOST_MAX_OBJECTS];
+static bool              condUsed[HOST_MAX_OBJECTS];
+static pthread_mutex_t   objectLock = PTHREAD_MUTEX_INITIALIZER;
+static GXHost_flush      flushes[HOST_MAX_FLUSHES];
+static u32               flushCount = 0;
+static u64               flushBytes = 0;
+static pthread_mutex_t   flushLock = PTHREAD_MUTEX_INITIALIZER;
+
+//==============================================================================
+// VIDEO
+//==============================================================================
+
+/**
+ * Get the frame buffer on screen.
+ * @return The frame buffer on screen.
+ */
+void*  GXHost_GetDisplayedFramebuffer (void) {
+	return currentFramebuffer;
+}
+
+void  VIDEO_Init (void) {
+	retraceCount = 0;
+	nextFramebuffer = currentFramebuffer = NULL;
+	flushPending = false;
+	preRetraceCallback = postRetraceCallback = NULL;
+}
+
+void  VIDEO_SetBlack (bool black) {
+}
+
+GXRModeObj*  VIDEO_GetPreferredMode (GXRModeObj *mode) {
+	return mode != NULL ? mode : &TVNtsc480IntDf;
+}
+
+void  VIDEO_Configure (GXRModeObj *rmode) {
+	videoMode = rmode;
+}
+
+void  VIDEO_SetNextFramebuffer (void *fb) {
+	nextFramebuffer = fb;
+}
+
+void*  VIDEO_GetCurrentFramebuffer (void) {
+	return currentFramebuffer;
+}
+
+void  VIDEO_Flush (void) {
+	flushPending = true;
+}
+
+void  VIDEO_WaitVSync (void) {
+	// Simulate a vertical retrace
+	retraceCount++;
+	if (preRetraceCallback != NULL) {
+		preRetraceCallback(retraceCount);
+	}
+	if (flushPending == true) {
+		currentFramebuffer = nextFramebuffer;
+		flushPending = false;
+	}
+	if (postRetraceCallback != NULL) {
+		postRetraceCallback(retraceCount);
+	}
+}
+
+u32  VIDEO_GetRetraceCount (void) {
+	return retraceCount;
+}
+
+u32  VIDEO_GetFrameBufferSize (GXRModeObj *rmode) {
+	return ((rmode->fbWidth + 15) & ~15) * rmode->xfbHeight * 2;
+}
+
+u32  VIDEO_GetCurrentTvMode (void) {
+	return videoMode->viTVMode >> 2;
+}
+
+u32  VIDEO_HaveComponentCable (void) {
+	return 0;
+}
+
+VIRetraceCallback  VIDEO_SetPreRetraceCallback (VIRetraceCallback callback) {
+	VIRetraceCallback old = preRetraceCallback;
+	preRetraceCallback = callback;
+	return old;
+}
+
+VIRetraceCallback  VIDEO_SetPostRetraceCallback (VIRetraceCallback callback) {
+	VIRetraceCallback old = postRetraceCallback;
+	postRetraceCallback = callback;
+	return old;
+}
+
+//==============================================================================
+// SYS, CONF and cache
+//==============================================================================
+
+void*  SYS_AllocateFramebuffer (GXRModeObj *rmode) {
+	return memalign(32, VIDEO_GetFrameBufferSize(rmode));
+}
+
+s32  CONF_GetAspectRatio (void) {
+	return CONF_ASPECT_4_3;
+}
+
+/**
+ * Get the ranges flushed with DCFlushRange since the last reset, in order.
+ * @param count Receives the number of ranges, at most HOST_MAX_FLUSHES are kept.
+ * @return The ranges.
+ */
+const GXHost_flush*  GXHost_GetFlushes (u32 *count) {
+	*count = (flushCount < HOST_MAX_FLUSHES) ? flushCount : HOST_MAX_FLUSHES;
+	return flushes;
+}
+
+/**
+ * Get the number of bytes flushed with DCFlushRange since the last reset, including ranges not kept.
+ * @return The number of bytes.
+ */
+u64  GXHost_GetFlushedBytes (void) {
+	return flushBytes;
+}
+
+/**
+ * Forget the flushed ranges, also done by GXHost_Reset.
+ */
+void  GXHost_ResetFlushes (void) {
+	pthread_mutex_lock(&flushLock);
+	flushCount = 0;
+	flushBytes = 0;
+	pthread_mutex_unlock(&flushLock);
+}
+
+void  DCFlushRange (void *startaddress, u32 len) {
+	// Loader threads finalize textures too
+	pthread_mutex_lock(&flushLock);
+	if (flushCount < HOST_MAX_FLUSHES) {
+		flushes[flushCount].start = startaddress;
+		flushes[flushCount].len = len;
+	}
+	flushCount++;
+	flushBytes += len;
+	pthread_mutex_unlock(&flushLock);
+}
+
+void  DCStoreRange (void *startaddress, u32 len) {
+}
+
+void  DCInvalidateRange (void *startaddress, u32 len) {
+}
+
+//==============================================================================
+// Timers
+//==============================================================================
+
+u64  gettime (void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+u32  gettick (void) {
+	return (u32)gettime();
+}
+
+u32  diff_sec (u64 start, u64 end) {
+	return ticks_to_secs(diff_ticks(start, end));
+}
+
+u32  diff_msec (u64 start, u64 end) {
+	return ticks_to_millisecs(diff_ticks(start, end));
+}
+
+u32  diff_usec (u64 start, u64 end) {
+	return ticks_to_microsecs(diff_ticks(start, end));
+}
+
+//==============================================================================
+// LWP
+//==============================================================================
+
+/**
+ * Find a free slot in a table of host objects.
+ * @param used The table of used slots.
+ * @return The slot, or -1 if the table is full.
+ */
+static s32  AllocSlot (bool used[HOST_MAX_OBJECTS]) {
+	s32 slot = -1;
+
+	pthread_mutex_lock(&objectLock);
+	for (s32 i = 0; i < HOST_MAX_OBJECTS; i++) {
+		if (used[i] == false) {
+			used[i] = true;
+			slot = i;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&objectLock);
+	return slot;
+}
+
+s32  LWP_CreateThread (lwp_t *thethread, void *(*entry)(void *), void *arg, void *stackbase, u32 stack_size, u8 prio) {
+	const s32 slot = AllocSlot(threadUsed);
+
+	if (slot < 0 || pthread_create(&threads[slot], NULL, entry, arg) != 0) {
+		return -1;
+	}
+	*thethread = slot;
+	return 0;
+}
+
+s32  LWP_JoinThread (lwp_t thethread, void **value_ptr) {
+	if (thethread >= HOST_MAX_OBJECTS || threadUsed[thethread] == false) {
+		return -1;
+	}
+	pthread_join(threads[thethread], value_ptr);
+	threadUsed[thethread] = false;
+	return 0;
+}
+
+void  LWP_YieldThread (void) {
+	sched_yield();
+}
+
+s32  LWP_MutexInit (mutex_t *mutex, bool use_recursive) {
+	const s32 slot = AllocSlot(mutexUsed);
+	pthread_mutexattr_t attr;
+
+	if (slot < 0) {
+		return -1;
+	}
+	pthread_mutexattr_init(&attr);
+	if (use_recursive == true) {
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	}
+	pthread_mutex_init(&mutexes[slot], &attr);
+	pthread_mutexattr_destroy(&attr);
+	*mutex = slot;
+	return 0;
+}
+
+s32  LWP_MutexDestroy (mutex_t mutex) {
+	pthread_mutex_destroy(&mutexes[mutex]);
+	mutexUsed[mutex] = false;
+	return 0;
+}
+
+s32  LWP_MutexLock (mutex_t mutex) {
+	return pthread_mutex_lock(&mutexes[mutex]);
+}
+
+s32  LWP_MutexUnlock (mutex_t mutex) {
+	return pthread_mutex_unlock(&mutexes[mutex]);
+}
+
+s32  LWP_CondInit (cond_t *cond) {
+	const s32 slot = AllocSlot(condUsed);
+
+	if (slot < 0) {
+		return -1;
+	}
+	pthread_cond_init(&conds[slot], NULL);
+	*cond = slot;
+	return 0;
+}
+
+s32  LWP_CondWait (cond_t cond, mutex_t mutex) {
+	return pthread_cond_wait(&conds[cond], &mutexes[mutex]);
+}
+
+s32  LWP_CondSignal (cond_t cond) {
+	return pthread_cond_signal(&conds[cond]);
+}
+
+s32  LWP_CondBroadcast (cond_t cond) {
+	return pthread_cond_broadcast(&conds[cond]);
+}
+
+s32  LWP_CondDestroy (cond_t cond) {
+	pthread_cond_destroy(&conds[cond]);
+	condUsed[cond] = false;
+	return 0;
+}
+
+s32  LWP_InitQueue (lwpq_t *thequeue) {
+	*thequeue = 0;
+	return 0;
+}
+
+void  LWP_CloseQueue (lwpq_t thequeue) {
+}
+
+s32  LWP_ThreadSleep (lwpq_t thequeue) {
+	// GRRLIB only sleeps until a frame is done or shown, both of which happen at a retrace
+	VIDEO_WaitVSync();
+	return 0;
+}
+
+void  LWP_ThreadSignal (lwpq_t thequeue) {
+}
+
+void  LWP_ThreadBroadcast (lwpq_t thequeue) {
+}
+
+//==============================================================================
+// USB Gecko
+//==============================================================================
+
+s32  usb_isgeckoalive (s32 chn) {
+	return 0;
+}
+
+void  usb_flush (s32 chn) {
+}
+
+int  usb_sendbuffer_safe (s32 chn, const void *buffer, int size) {
+	return size;
+}